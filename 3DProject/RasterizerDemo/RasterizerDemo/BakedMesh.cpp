@@ -0,0 +1,640 @@
+#include "BakedMesh.h"
+#include "OBJParser.h"
+#include "ContentHash.h"
+#include "BakedTexture.h"
+#include "IndexCompression.h"
+#include "OBJStreamingParser.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace
+{
+	constexpr uint32_t BAKED_MESH_MAGIC = 0x48534D42; // "BMSH"
+	constexpr uint32_t BAKED_MESH_FORMAT_VERSION = 7;
+	constexpr std::size_t BLOB_ALIGNMENT = 16;
+
+	enum class IndexEncoding : uint32_t
+	{
+		Raw = 0,
+		Varint = 1,
+	};
+
+	struct BakedString
+	{
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	struct BakedSubMesh
+	{
+		uint64_t startIndexValue;
+		uint64_t nrOfIndicesInSubMesh;
+		uint64_t materialIndex;
+	};
+
+	// A MeshLOD, its ranges a slice of the LOD range section
+	struct BakedLOD
+	{
+		float error;
+		uint32_t firstRange;
+		uint32_t nrOfRanges;
+	};
+
+	// A MeshPart with its name in the string table
+	struct BakedPart
+	{
+		BakedString name;
+		uint32_t firstSubMesh;
+		uint32_t nrOfSubMeshes;
+		uint32_t firstMeshlet;
+		uint32_t nrOfMeshlets;
+		DirectX::XMFLOAT3 boxCenter;
+		DirectX::XMFLOAT3 boxExtents;
+		DirectX::XMFLOAT3 sphereCenter;
+		float sphereRadius;
+	};
+
+	// PackedVertexFormat without its padding
+	struct BakedPackedFormat
+	{
+		uint32_t quantizedPositions;
+		uint32_t unormTexCoords;
+		DirectX::XMFLOAT3 positionOffset;
+		DirectX::XMFLOAT3 positionScale;
+		float maxAbsTexCoord;
+	};
+
+	struct BakedMaterial
+	{
+		DirectX::XMFLOAT3 ambient;
+		DirectX::XMFLOAT3 diffuse;
+		DirectX::XMFLOAT3 specular;
+		float specularPower;
+
+		BakedString name;
+		BakedString mapKa;
+		BakedString mapKd;
+		BakedString mapKs;
+		BakedString mapBump;
+	};
+
+	// Every section is addressed by an offset from the start of the file
+	struct BakedMeshHeader
+	{
+		uint32_t magic;
+		uint32_t formatVersion;
+		uint32_t parserVersion;
+		uint32_t sizeOfVertex;
+		uint64_t sourceHash;
+
+		uint64_t nrOfVertices;
+		uint64_t nrOfIndices;
+		// 0 or nrOfVertices
+		uint64_t nrOfTangents;
+		// 0 or nrOfVertices
+		uint64_t nrOfPackedVertices;
+		BakedPackedFormat packedFormat;
+		uint32_t nrOfSubMeshes;
+		uint32_t nrOfMaterials;
+		uint32_t nrOfMaterialLibraries;
+		uint32_t sizeOfIndex;
+		IndexEncoding indexEncoding;
+		uint32_t nrOfMeshlets;
+		uint32_t nrOfLODs;
+		uint32_t nrOfLODRanges;
+		uint32_t nrOfParts;
+
+		DirectX::XMFLOAT3 boundsCenter;
+		DirectX::XMFLOAT3 boundsExtents;
+
+		uint64_t vertexOffset;
+		uint64_t tangentOffset;
+		uint64_t packedVertexOffset;
+		uint64_t indexOffset;
+		uint64_t indexSize;
+		uint64_t subMeshOffset;
+		uint64_t meshletOffset;
+		uint64_t lodOffset;
+		uint64_t lodRangeOffset;
+		uint64_t partOffset;
+		uint64_t materialOffset;
+		uint64_t materialLibraryOffset;
+		uint64_t stringOffset;
+		uint64_t stringSize;
+		uint64_t fileSize;
+	};
+
+	std::size_t AlignUp(std::size_t value)
+	{
+		return (value + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1);
+	}
+
+	bool SectionFits(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize)
+	{
+		return offset <= fileSize && count <= (fileSize - offset) / elementSize;
+	}
+
+	class StringTable
+	{
+	private:
+		std::string contents;
+
+	public:
+		BakedString Add(const std::string& value)
+		{
+			BakedString entry = { static_cast<uint32_t>(contents.size()), static_cast<uint32_t>(value.size()) };
+			contents += value;
+			return entry;
+		}
+
+		const std::string& GetContents() const { return contents; }
+	};
+
+	std::string ReadString(const BakedString& entry, const char* strings, uint64_t stringSize)
+	{
+		if (static_cast<uint64_t>(entry.offset) + entry.length > stringSize)
+			return {};
+
+		return std::string(strings + entry.offset, entry.length);
+	}
+}
+
+uint64_t HashImportSettings()
+{
+	// Import settings that change the parsed output are part of the key
+	uint32_t weldEpsilonBits = 0;
+	std::memcpy(&weldEpsilonBits, &objImportSettings.weldEpsilon, sizeof(weldEpsilonBits));
+	const uint32_t settings[9] = { OBJ_PARSER_VERSION, objImportSettings.optimizeMeshes ? 1u : 0u,
+		objImportSettings.generateLODs ? 1u : 0u, objImportSettings.generateTangents ? 1u : 0u,
+		objImportSettings.cleanMeshes ? 1u : 0u, weldEpsilonBits, objImportSettings.packVertices ? 1u : 0u,
+		objImportSettings.vertexPacking.quantizePositions ? 1u : 0u, objImportSettings.vertexPacking.unormTexCoords ? 1u : 0u };
+	return HashBytes(std::string_view(reinterpret_cast<const char*>(settings), sizeof(settings)));
+}
+
+uint64_t HashMeshSource(std::string_view objContents, const std::vector<std::string>& materialLibraries)
+{
+	return HashMeshSource(HashBytes(objContents, HashImportSettings()), materialLibraries);
+}
+
+uint64_t HashMeshSource(uint64_t objHash, const std::vector<std::string>& materialLibraries)
+{
+	uint64_t hash = objHash;
+	for (const std::string& library : materialLibraries)
+	{
+		// A missing MTL hashes as empty, so the cache is rebuilt once it appears
+		MemoryMappedFile mtlFile(defaultDirectory + library);
+		hash = HashBytes(library, hash);
+		hash = HashBytes(mtlFile.GetView(), hash);
+	}
+
+	return hash;
+}
+
+std::string GetBakedMeshPath(const std::string& objPath)
+{
+	return std::filesystem::path(objPath).replace_extension(".bmesh").string();
+}
+
+bool WriteBakedMesh(const std::string& path, const ParseData& data, uint64_t sourceHash)
+{
+	BakedMeshHeader header = {};
+	header.magic = BAKED_MESH_MAGIC;
+	header.formatVersion = BAKED_MESH_FORMAT_VERSION;
+	header.parserVersion = OBJ_PARSER_VERSION;
+	header.sizeOfVertex = sizeof(Vertex);
+	header.sourceHash = sourceHash;
+	header.nrOfVertices = data.vertices.size();
+	header.nrOfIndices = data.indexData.size();
+	header.nrOfTangents = data.tangents.size();
+	header.nrOfPackedVertices = data.packedVertices.empty() ? 0 : data.vertices.size();
+	header.packedFormat.quantizedPositions = data.packedFormat.quantizedPositions ? 1u : 0u;
+	header.packedFormat.unormTexCoords = data.packedFormat.unormTexCoords ? 1u : 0u;
+	header.packedFormat.positionOffset = data.packedFormat.positionOffset;
+	header.packedFormat.positionScale = data.packedFormat.positionScale;
+	header.packedFormat.maxAbsTexCoord = data.packedFormat.maxAbsTexCoord;
+	header.nrOfSubMeshes = static_cast<uint32_t>(data.finishedSubMeshes.size());
+	header.nrOfMaterials = static_cast<uint32_t>(data.parsedMaterials.size());
+	header.nrOfMaterialLibraries = static_cast<uint32_t>(data.materialLibraries.size());
+	header.nrOfMeshlets = static_cast<uint32_t>(data.meshlets.size());
+
+	// Indices in the width the GPU buffer will use, then optionally encoded
+	const DXGI_FORMAT indexFormat = IndexCompression::ChooseFormat(data.vertices.size());
+	header.sizeOfIndex = static_cast<uint32_t>(IndexCompression::GetIndexSize(indexFormat));
+
+	std::vector<unsigned char> indexBlob;
+	if (objImportSettings.compressBakedIndices)
+	{
+		header.indexEncoding = IndexEncoding::Varint;
+		IndexCompression::Encode(data.indexData.data(), data.indexData.size(), indexBlob);
+	}
+	else
+	{
+		header.indexEncoding = IndexEncoding::Raw;
+		if (indexFormat == DXGI_FORMAT_R16_UINT)
+		{
+			std::vector<uint16_t> narrowed;
+			IndexCompression::Narrow(data.indexData.data(), data.indexData.size(), narrowed);
+			indexBlob.resize(narrowed.size() * sizeof(uint16_t));
+			std::memcpy(indexBlob.data(), narrowed.data(), indexBlob.size());
+		}
+		else
+		{
+			indexBlob.resize(data.indexData.size() * sizeof(unsigned int));
+			std::memcpy(indexBlob.data(), data.indexData.data(), indexBlob.size());
+		}
+	}
+	header.indexSize = indexBlob.size();
+
+	// Same bounds MeshD3D11 would compute from the vertices
+	if (!data.vertices.empty())
+	{
+		DirectX::BoundingBox bounds;
+		DirectX::BoundingBox::CreateFromPoints(bounds, data.vertices.size(), &data.vertices[0].Position, sizeof(Vertex));
+		header.boundsCenter = bounds.Center;
+		header.boundsExtents = bounds.Extents;
+	}
+
+	StringTable strings;
+	std::vector<BakedSubMesh> subMeshes;
+	for (const SubMeshInfo& sub : data.finishedSubMeshes)
+	{
+		subMeshes.push_back({ sub.startIndexValue, sub.nrOfIndicesInSubMesh, sub.currentSubMeshMaterial });
+	}
+
+	std::vector<BakedLOD> lods;
+	std::vector<MeshDrawRange> lodRanges;
+	for (const MeshLOD& lod : data.lods)
+	{
+		lods.push_back({ lod.error, static_cast<uint32_t>(lodRanges.size()), static_cast<uint32_t>(lod.ranges.size()) });
+		lodRanges.insert(lodRanges.end(), lod.ranges.begin(), lod.ranges.end());
+	}
+	header.nrOfLODs = static_cast<uint32_t>(lods.size());
+	header.nrOfLODRanges = static_cast<uint32_t>(lodRanges.size());
+
+	std::vector<BakedPart> parts;
+	for (const MeshPart& part : data.parts)
+	{
+		parts.push_back({ strings.Add(part.name), part.firstSubMesh, part.nrOfSubMeshes, part.firstMeshlet, part.nrOfMeshlets,
+			part.boundingBox.Center, part.boundingBox.Extents, part.boundingSphere.Center, part.boundingSphere.Radius });
+	}
+	header.nrOfParts = static_cast<uint32_t>(parts.size());
+
+	std::vector<BakedMaterial> materials;
+	for (const MaterialInfo& material : data.parsedMaterials)
+	{
+		BakedMaterial baked = {};
+		baked.ambient = material.ambient;
+		baked.diffuse = material.diffuse;
+		baked.specular = material.specular;
+		baked.specularPower = material.specularPower;
+		baked.name = strings.Add(material.name);
+		baked.mapKa = strings.Add(material.mapKa);
+		baked.mapKd = strings.Add(material.mapKd);
+		baked.mapKs = strings.Add(material.mapKs);
+		baked.mapBump = strings.Add(material.mapBump);
+		materials.push_back(baked);
+	}
+
+	std::vector<BakedString> materialLibraries;
+	for (const std::string& library : data.materialLibraries)
+	{
+		materialLibraries.push_back(strings.Add(library));
+	}
+
+	// Lay out the sections, keeping the GPU blobs aligned
+	header.vertexOffset = AlignUp(sizeof(BakedMeshHeader));
+	header.tangentOffset = AlignUp(header.vertexOffset + data.vertices.size() * sizeof(Vertex));
+	header.packedVertexOffset = AlignUp(header.tangentOffset + data.tangents.size() * sizeof(DirectX::XMFLOAT4));
+	header.indexOffset = AlignUp(header.packedVertexOffset + data.packedVertices.size());
+	header.subMeshOffset = AlignUp(header.indexOffset + indexBlob.size());
+	header.meshletOffset = AlignUp(header.subMeshOffset + subMeshes.size() * sizeof(BakedSubMesh));
+	header.lodOffset = AlignUp(header.meshletOffset + data.meshlets.size() * sizeof(Meshlet));
+	header.lodRangeOffset = AlignUp(header.lodOffset + lods.size() * sizeof(BakedLOD));
+	header.partOffset = AlignUp(header.lodRangeOffset + lodRanges.size() * sizeof(MeshDrawRange));
+	header.materialOffset = AlignUp(header.partOffset + parts.size() * sizeof(BakedPart));
+	header.materialLibraryOffset = AlignUp(header.materialOffset + materials.size() * sizeof(BakedMaterial));
+	header.stringOffset = AlignUp(header.materialLibraryOffset + materialLibraries.size() * sizeof(BakedString));
+	header.stringSize = strings.GetContents().size();
+	header.fileSize = header.stringOffset + header.stringSize;
+
+	std::ofstream output(path, std::ios::binary | std::ios::trunc);
+	if (!output.is_open())
+		return false;
+
+	// Sections go out in offset order straight from the parse data, so a large mesh is never
+	// staged a second time in memory
+	uint64_t written = 0;
+	auto WriteSection = [&](uint64_t offset, const void* source, std::size_t size)
+		{
+			static constexpr char PADDING[BLOB_ALIGNMENT] = {};
+			output.write(PADDING, static_cast<std::streamsize>(offset - written));
+			output.write(static_cast<const char*>(source), static_cast<std::streamsize>(size));
+			written = offset + size;
+		};
+
+	WriteSection(0, &header, sizeof(header));
+	WriteSection(header.vertexOffset, data.vertices.data(), data.vertices.size() * sizeof(Vertex));
+	WriteSection(header.tangentOffset, data.tangents.data(), data.tangents.size() * sizeof(DirectX::XMFLOAT4));
+	WriteSection(header.packedVertexOffset, data.packedVertices.data(), data.packedVertices.size());
+	WriteSection(header.indexOffset, indexBlob.data(), indexBlob.size());
+	WriteSection(header.subMeshOffset, subMeshes.data(), subMeshes.size() * sizeof(BakedSubMesh));
+	WriteSection(header.meshletOffset, data.meshlets.data(), data.meshlets.size() * sizeof(Meshlet));
+	WriteSection(header.lodOffset, lods.data(), lods.size() * sizeof(BakedLOD));
+	WriteSection(header.lodRangeOffset, lodRanges.data(), lodRanges.size() * sizeof(MeshDrawRange));
+	WriteSection(header.partOffset, parts.data(), parts.size() * sizeof(BakedPart));
+	WriteSection(header.materialOffset, materials.data(), materials.size() * sizeof(BakedMaterial));
+	WriteSection(header.materialLibraryOffset, materialLibraries.data(), materialLibraries.size() * sizeof(BakedString));
+	WriteSection(header.stringOffset, strings.GetContents().data(), strings.GetContents().size());
+
+	return output.good();
+}
+
+bool BakedMesh::Load(const std::string& path, std::string_view objContents, MeshImport& import)
+{
+	return Load(path, HashBytes(objContents, HashImportSettings()), import);
+}
+
+bool BakedMesh::Load(const std::string& path, uint64_t objHash, MeshImport& import)
+{
+	if (!file.Open(path) || file.GetSize() < sizeof(BakedMeshHeader))
+		return false;
+
+	const char* fileData = file.GetData();
+	const uint64_t fileSize = file.GetSize();
+
+	BakedMeshHeader header;
+	std::memcpy(&header, fileData, sizeof(header));
+
+	if (header.magic != BAKED_MESH_MAGIC ||
+		header.formatVersion != BAKED_MESH_FORMAT_VERSION ||
+		header.parserVersion != OBJ_PARSER_VERSION ||
+		header.sizeOfVertex != sizeof(Vertex) ||
+		(header.sizeOfIndex != sizeof(uint16_t) && header.sizeOfIndex != sizeof(uint32_t)) ||
+		(header.indexEncoding != IndexEncoding::Raw && header.indexEncoding != IndexEncoding::Varint) ||
+		header.fileSize != fileSize)
+	{
+		return false;
+	}
+
+	PackedVertexFormat packedFormat;
+	packedFormat.quantizedPositions = header.packedFormat.quantizedPositions != 0;
+	packedFormat.unormTexCoords = header.packedFormat.unormTexCoords != 0;
+	packedFormat.positionOffset = header.packedFormat.positionOffset;
+	packedFormat.positionScale = header.packedFormat.positionScale;
+	packedFormat.maxAbsTexCoord = header.packedFormat.maxAbsTexCoord;
+
+	if (!SectionFits(header.vertexOffset, header.nrOfVertices, sizeof(Vertex), fileSize) ||
+		(header.nrOfTangents != 0 && header.nrOfTangents != header.nrOfVertices) ||
+		!SectionFits(header.tangentOffset, header.nrOfTangents, sizeof(DirectX::XMFLOAT4), fileSize) ||
+		(header.nrOfPackedVertices != 0 && header.nrOfPackedVertices != header.nrOfVertices) ||
+		!SectionFits(header.packedVertexOffset, header.nrOfPackedVertices, packedFormat.GetStride(), fileSize) ||
+		!SectionFits(header.indexOffset, header.indexSize, 1, fileSize) ||
+		header.nrOfIndices > header.indexSize ||	// every encoding spends at least a byte per index
+		(header.indexEncoding == IndexEncoding::Raw && header.indexSize != header.nrOfIndices * header.sizeOfIndex) ||
+		!SectionFits(header.subMeshOffset, header.nrOfSubMeshes, sizeof(BakedSubMesh), fileSize) ||
+		!SectionFits(header.meshletOffset, header.nrOfMeshlets, sizeof(Meshlet), fileSize) ||
+		!SectionFits(header.lodOffset, header.nrOfLODs, sizeof(BakedLOD), fileSize) ||
+		!SectionFits(header.lodRangeOffset, header.nrOfLODRanges, sizeof(MeshDrawRange), fileSize) ||
+		!SectionFits(header.partOffset, header.nrOfParts, sizeof(BakedPart), fileSize) ||
+		!SectionFits(header.materialOffset, header.nrOfMaterials, sizeof(BakedMaterial), fileSize) ||
+		!SectionFits(header.materialLibraryOffset, header.nrOfMaterialLibraries, sizeof(BakedString), fileSize) ||
+		!SectionFits(header.stringOffset, header.stringSize, 1, fileSize))
+	{
+		return false;
+	}
+
+	const char* strings = fileData + header.stringOffset;
+	const BakedString* libraryEntries = reinterpret_cast<const BakedString*>(fileData + header.materialLibraryOffset);
+
+	std::vector<std::string> materialLibraries;
+	for (uint32_t i = 0; i < header.nrOfMaterialLibraries; ++i)
+	{
+		materialLibraries.push_back(ReadString(libraryEntries[i], strings, header.stringSize));
+	}
+
+	if (HashMeshSource(objHash, materialLibraries) != header.sourceHash)
+		return false;
+
+	const BakedMaterial* materials = reinterpret_cast<const BakedMaterial*>(fileData + header.materialOffset);
+	import.materials.clear();
+	for (uint32_t i = 0; i < header.nrOfMaterials; ++i)
+	{
+		const BakedMaterial& baked = materials[i];
+
+		MaterialInfo material;
+		material.name = ReadString(baked.name, strings, header.stringSize);
+		material.ambient = baked.ambient;
+		material.diffuse = baked.diffuse;
+		material.specular = baked.specular;
+		material.specularPower = baked.specularPower;
+		material.mapKa = ReadString(baked.mapKa, strings, header.stringSize);
+		material.mapKd = ReadString(baked.mapKd, strings, header.stringSize);
+		material.mapKs = ReadString(baked.mapKs, strings, header.stringSize);
+		material.mapBump = ReadString(baked.mapBump, strings, header.stringSize);
+		import.materials.push_back(material);
+	}
+
+	const BakedSubMesh* subMeshes = reinterpret_cast<const BakedSubMesh*>(fileData + header.subMeshOffset);
+	import.subMeshes.clear();
+	for (uint32_t i = 0; i < header.nrOfSubMeshes; ++i)
+	{
+		const BakedSubMesh& baked = subMeshes[i];
+		if (baked.materialIndex >= header.nrOfMaterials ||
+			baked.startIndexValue + baked.nrOfIndicesInSubMesh > header.nrOfIndices)
+		{
+			return false;
+		}
+
+		SubMeshInfo sub;
+		sub.startIndexValue = static_cast<std::size_t>(baked.startIndexValue);
+		sub.nrOfIndicesInSubMesh = static_cast<std::size_t>(baked.nrOfIndicesInSubMesh);
+		sub.currentSubMeshMaterial = static_cast<std::size_t>(baked.materialIndex);
+		import.subMeshes.push_back(sub);
+	}
+
+	// Meshlets must stay inside their submesh, the draw ranges culling produces come from them
+	const Meshlet* meshlets = reinterpret_cast<const Meshlet*>(fileData + header.meshletOffset);
+	for (uint32_t i = 0; i < header.nrOfMeshlets; ++i)
+	{
+		const Meshlet& meshlet = meshlets[i];
+		if (meshlet.subMeshIndex >= import.subMeshes.size())
+			return false;
+
+		const SubMeshInfo& sub = import.subMeshes[meshlet.subMeshIndex];
+		if (meshlet.startIndex < sub.startIndexValue ||
+			static_cast<uint64_t>(meshlet.startIndex) + meshlet.nrOfIndices > sub.startIndexValue + sub.nrOfIndicesInSubMesh)
+		{
+			return false;
+		}
+	}
+	import.meshlets = meshlets;
+	import.nrOfMeshlets = header.nrOfMeshlets;
+
+	// LOD ranges are drawn directly, so each must name a submesh and stay inside the index buffer
+	const BakedLOD* lods = reinterpret_cast<const BakedLOD*>(fileData + header.lodOffset);
+	const MeshDrawRange* lodRanges = reinterpret_cast<const MeshDrawRange*>(fileData + header.lodRangeOffset);
+	import.lods.clear();
+	for (uint32_t i = 0; i < header.nrOfLODs; ++i)
+	{
+		const BakedLOD& baked = lods[i];
+		if (static_cast<uint64_t>(baked.firstRange) + baked.nrOfRanges > header.nrOfLODRanges)
+			return false;
+
+		MeshLOD lod;
+		lod.error = baked.error;
+		lod.ranges.assign(lodRanges + baked.firstRange, lodRanges + baked.firstRange + baked.nrOfRanges);
+		for (const MeshDrawRange& range : lod.ranges)
+		{
+			if (range.subMeshIndex >= import.subMeshes.size() ||
+				static_cast<uint64_t>(range.startIndex) + range.nrOfIndices > header.nrOfIndices)
+			{
+				return false;
+			}
+		}
+		import.lods.push_back(std::move(lod));
+	}
+
+	// Culled parts skip their submeshes and meshlets, so both ranges must exist
+	const BakedPart* parts = reinterpret_cast<const BakedPart*>(fileData + header.partOffset);
+	import.parts.clear();
+	for (uint32_t i = 0; i < header.nrOfParts; ++i)
+	{
+		const BakedPart& baked = parts[i];
+		if (static_cast<uint64_t>(baked.firstSubMesh) + baked.nrOfSubMeshes > header.nrOfSubMeshes ||
+			static_cast<uint64_t>(baked.firstMeshlet) + baked.nrOfMeshlets > header.nrOfMeshlets)
+		{
+			return false;
+		}
+
+		MeshPart part;
+		part.name = ReadString(baked.name, strings, header.stringSize);
+		part.firstSubMesh = baked.firstSubMesh;
+		part.nrOfSubMeshes = baked.nrOfSubMeshes;
+		part.firstMeshlet = baked.firstMeshlet;
+		part.nrOfMeshlets = baked.nrOfMeshlets;
+		part.boundingBox = DirectX::BoundingBox(baked.boxCenter, baked.boxExtents);
+		part.boundingSphere = DirectX::BoundingSphere(baked.sphereCenter, baked.sphereRadius);
+		import.parts.push_back(std::move(part));
+	}
+
+	import.indexFormat = header.sizeOfIndex == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	if (header.indexEncoding == IndexEncoding::Varint)
+	{
+		decodedIndices.resize(static_cast<std::size_t>(header.nrOfIndices * header.sizeOfIndex));
+		if (!IndexCompression::Decode(reinterpret_cast<const unsigned char*>(fileData + header.indexOffset),
+			static_cast<std::size_t>(header.indexSize), static_cast<std::size_t>(header.nrOfIndices),
+			static_cast<std::size_t>(header.nrOfVertices), import.indexFormat, decodedIndices.data()))
+		{
+			return false;
+		}
+		import.indices = decodedIndices.data();
+	}
+	else
+	{
+		decodedIndices.clear();
+		import.indices = fileData + header.indexOffset;
+	}
+
+	// The vertex blob is used in place, the mapping backs the import
+	import.vertices = reinterpret_cast<const Vertex*>(fileData + header.vertexOffset);
+	import.nrOfVertices = static_cast<std::size_t>(header.nrOfVertices);
+	import.tangents = header.nrOfTangents > 0 ? reinterpret_cast<const DirectX::XMFLOAT4*>(fileData + header.tangentOffset) : nullptr;
+	import.packedVertices = header.nrOfPackedVertices > 0 ? reinterpret_cast<const unsigned char*>(fileData + header.packedVertexOffset) : nullptr;
+	import.packedFormat = packedFormat;
+	import.nrOfIndices = static_cast<std::size_t>(header.nrOfIndices);
+	import.hasLocalBoundingBox = header.nrOfVertices > 0;
+	import.localBoundingBox.Center = header.boundsCenter;
+	import.localBoundingBox.Extents = header.boundsExtents;
+
+	return true;
+}
+
+std::size_t BakeDirectory(const std::string& directory)
+{
+	const std::string previousDirectory = defaultDirectory;
+	defaultDirectory = directory;
+	if (!defaultDirectory.empty() && defaultDirectory.back() != '/' && defaultDirectory.back() != '\\')
+	{
+		defaultDirectory += '/';
+	}
+
+	std::size_t nrOfBaked = 0;
+	std::unordered_set<std::string> bakedTextures;
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(defaultDirectory, error))
+	{
+		if (!entry.is_regular_file() || entry.path().extension() != ".obj")
+			continue;
+
+		const std::string objPath = entry.path().string();
+		try
+		{
+			ParseData data;
+			uint64_t sourceHash = 0;
+			if (UseStreamingImport(static_cast<std::size_t>(entry.file_size())))
+			{
+				OBJFileScan scan;
+				if (!ScanOBJFile(objPath, scan))
+				{
+					throw std::runtime_error("Failed to open file: " + objPath);
+				}
+
+				ParseOBJStreaming(objPath, scan, data);
+				sourceHash = HashMeshSource(scan.contentHash, data.materialLibraries);
+			}
+			else
+			{
+				MemoryMappedFile objFile(objPath);
+				if (!objFile.IsOpen())
+				{
+					throw std::runtime_error("Failed to open file: " + objPath);
+				}
+
+				ParseOBJContents(objFile.GetView(), data);
+				sourceHash = HashMeshSource(objFile.GetView(), data.materialLibraries);
+			}
+
+			const std::string bakedPath = GetBakedMeshPath(objPath);
+			if (WriteBakedMesh(bakedPath, data, sourceHash))
+			{
+				OutputDebugStringA(("Baked " + bakedPath + "\n").c_str());
+				++nrOfBaked;
+			}
+			else
+			{
+				OutputDebugStringA(("Could not write baked mesh: " + bakedPath + "\n").c_str());
+			}
+
+			// Textures are baked with the texture cache's default filter, so startup finds them current
+			for (const MaterialInfo& material : data.parsedMaterials)
+			{
+				for (const std::string* texPath : { &material.mapKa, &material.mapKd, &material.mapKs, &material.mapBump })
+				{
+					if (texPath->empty())
+						continue;
+
+					const MipContent content = texPath == &material.mapBump ? GetBumpMapContent(*texPath) : MipContent::Color;
+					if (!bakedTextures.insert(GetBakedTexturePath(defaultDirectory + *texPath, content)).second)
+						continue;
+
+					ImageData image;
+					if (!ImportTexture(defaultDirectory + *texPath, content, MipFilter::Lanczos, image))
+					{
+						OutputDebugStringA(("Could not bake texture: " + *texPath + "\n").c_str());
+					}
+				}
+			}
+		}
+		catch (const std::exception& e)
+		{
+			OutputDebugStringA((std::string("Bake failed: ") + e.what() + "\n").c_str());
+		}
+	}
+
+	defaultDirectory = previousDirectory;
+	return nrOfBaked;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MemoryMappedFile.h"
+
+struct ParseData;
+struct MeshImport;
+
+// Binary cache of an imported OBJ, written as "<name>.bmesh" next to the source.
+// The file holds the vertex, tangent and packed vertex blobs exactly as the GPU buffers expect
+// them, so loading is a mapping plus a header check with no per-vertex work. Indices are 16-bit
+// when the vertex count allows and either raw, used in place, or IndexCompression-encoded and
+// decoded once.
+class BakedMesh
+{
+private:
+	MemoryMappedFile file;
+	std::vector<unsigned char> decodedIndices;
+
+public:
+	BakedMesh() = default;
+	~BakedMesh() = default;
+	BakedMesh(const BakedMesh& other) = delete;
+	BakedMesh& operator=(const BakedMesh& other) = delete;
+	BakedMesh(BakedMesh&& other) = default;
+	BakedMesh& operator=(BakedMesh&& other) = default;
+
+	// Maps the baked file and fills import with views into it. Returns false if the file is
+	// missing, malformed, from another format or parser version, or was baked from different
+	// OBJ/MTL contents. The import is only valid while this object keeps the file mapped.
+	bool Load(const std::string& path, std::string_view objContents, MeshImport& import);
+	// Same, for an OBJ hashed block by block (see HashMeshSource)
+	bool Load(const std::string& path, uint64_t objHash, MeshImport& import);
+};
+
+// Seed of the OBJ part of the cache key, covering the import settings that change the result
+uint64_t HashImportSettings();
+
+// Cache key over the OBJ text, every MTL it references (resolved against defaultDirectory)
+// and the import settings that change the result
+uint64_t HashMeshSource(std::string_view objContents, const std::vector<std::string>& materialLibraries);
+// Same, for OBJ text already folded into objHash with HashBytes, starting from HashImportSettings
+uint64_t HashMeshSource(uint64_t objHash, const std::vector<std::string>& materialLibraries);
+
+// "objects/cube.obj" -> "objects/cube.bmesh"
+std::string GetBakedMeshPath(const std::string& objPath);
+
+// Serializes parsed data; returns false if the file could not be written
+bool WriteBakedMesh(const std::string& path, const ParseData& data, uint64_t sourceHash);
+
+// Parses and bakes every .obj in directory, which also becomes defaultDirectory, along with
+// the textures its materials reference. Returns the number of meshes written.
+std::size_t BakeDirectory(const std::string& directory);
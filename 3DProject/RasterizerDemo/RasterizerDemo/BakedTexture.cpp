@@ -0,0 +1,170 @@
+#include "BakedTexture.h"
+#include "BlockCompression.h"
+#include "ContentHash.h"
+#include "MemoryMappedFile.h"
+
+#include <Windows.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	constexpr uint32_t BAKED_TEXTURE_MAGIC = 0x58455442; // "BTEX"
+	constexpr uint32_t BAKED_TEXTURE_FORMAT_VERSION = 1;
+	constexpr std::size_t BLOB_ALIGNMENT = 16;
+
+	struct BakedTextureHeader
+	{
+		uint32_t magic;
+		uint32_t formatVersion;
+		uint32_t encoderVersion;
+		uint32_t format;
+		uint64_t sourceHash;
+
+		uint32_t width;
+		uint32_t height;
+		uint32_t mipLevels;
+		uint32_t padding;
+
+		uint64_t pixelOffset;
+		uint64_t pixelSize;
+		uint64_t fileSize;
+	};
+
+	std::size_t AlignUp(std::size_t value)
+	{
+		return (value + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1);
+	}
+
+	bool IsSupportedFormat(uint32_t format)
+	{
+		return format == DXGI_FORMAT_R8G8B8A8_UNORM || format == DXGI_FORMAT_BC1_UNORM ||
+			format == DXGI_FORMAT_BC3_UNORM || format == DXGI_FORMAT_BC5_UNORM;
+	}
+
+	const char* GetContentName(MipContent content)
+	{
+		switch (content)
+		{
+		case MipContent::Normal: return "normal";
+		case MipContent::Data: return "data";
+		default: return "color";
+		}
+	}
+}
+
+std::string GetBakedTexturePath(const std::string& imagePath, MipContent content)
+{
+	return std::filesystem::path(imagePath).replace_extension(std::string(".") + GetContentName(content) + ".btex").string();
+}
+
+uint64_t HashTextureSource(std::string_view imageContents, MipContent content, MipFilter filter)
+{
+	const uint32_t settings[3] = { BLOCK_COMPRESSION_VERSION, static_cast<uint32_t>(content), static_cast<uint32_t>(filter) };
+	uint64_t hash = HashBytes(std::string_view(reinterpret_cast<const char*>(settings), sizeof(settings)));
+	return HashBytes(imageContents, hash);
+}
+
+bool WriteBakedTexture(const std::string& path, const ImageData& image, uint64_t sourceHash)
+{
+	if (!image.IsValid())
+		return false;
+
+	BakedTextureHeader header = {};
+	header.magic = BAKED_TEXTURE_MAGIC;
+	header.formatVersion = BAKED_TEXTURE_FORMAT_VERSION;
+	header.encoderVersion = BLOCK_COMPRESSION_VERSION;
+	header.format = static_cast<uint32_t>(image.format);
+	header.sourceHash = sourceHash;
+	header.width = static_cast<uint32_t>(image.width);
+	header.height = static_cast<uint32_t>(image.height);
+	header.mipLevels = static_cast<uint32_t>(image.mipLevels);
+	header.pixelOffset = AlignUp(sizeof(BakedTextureHeader));
+	header.pixelSize = image.pixels.size();
+	header.fileSize = header.pixelOffset + header.pixelSize;
+
+	std::vector<char> fileData(header.fileSize, 0);
+	std::memcpy(fileData.data(), &header, sizeof(header));
+	std::memcpy(fileData.data() + header.pixelOffset, image.pixels.data(), image.pixels.size());
+
+	std::ofstream output(path, std::ios::binary | std::ios::trunc);
+	if (!output.is_open())
+		return false;
+
+	output.write(fileData.data(), static_cast<std::streamsize>(fileData.size()));
+	return output.good();
+}
+
+bool LoadBakedTexture(const std::string& path, uint64_t sourceHash, ImageData& image)
+{
+	MemoryMappedFile file;
+	if (!file.Open(path) || file.GetSize() < sizeof(BakedTextureHeader))
+		return false;
+
+	const char* fileData = file.GetData();
+	const uint64_t fileSize = file.GetSize();
+
+	BakedTextureHeader header;
+	std::memcpy(&header, fileData, sizeof(header));
+
+	if (header.magic != BAKED_TEXTURE_MAGIC ||
+		header.formatVersion != BAKED_TEXTURE_FORMAT_VERSION ||
+		header.encoderVersion != BLOCK_COMPRESSION_VERSION ||
+		header.sourceHash != sourceHash ||
+		header.fileSize != fileSize ||
+		!IsSupportedFormat(header.format) ||
+		header.width == 0 || header.width > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION ||
+		header.height == 0 || header.height > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION ||
+		header.mipLevels == 0 || header.mipLevels > static_cast<uint32_t>(MipGenerator::GetFullMipCount(header.width, header.height)))
+	{
+		return false;
+	}
+
+	ImageData loaded;
+	loaded.width = static_cast<int>(header.width);
+	loaded.height = static_cast<int>(header.height);
+	loaded.mipLevels = static_cast<int>(header.mipLevels);
+	loaded.format = static_cast<DXGI_FORMAT>(header.format);
+
+	if (header.pixelSize != loaded.GetLevelOffset(loaded.mipLevels) ||
+		header.pixelOffset > fileSize || header.pixelSize > fileSize - header.pixelOffset)
+	{
+		return false;
+	}
+
+	// One copy straight from the mapping, no decode
+	const unsigned char* pixels = reinterpret_cast<const unsigned char*>(fileData + header.pixelOffset);
+	loaded.pixels.assign(pixels, pixels + header.pixelSize);
+	image = std::move(loaded);
+	return true;
+}
+
+bool ImportTexture(const std::string& imagePath, MipContent content, MipFilter filter, ImageData& image)
+{
+	// Hashing the encoded file is far cheaper than decoding it. A missing file hashes as empty
+	// and fails the decode below, so it is never baked.
+	MemoryMappedFile imageFile(imagePath);
+	const uint64_t sourceHash = HashTextureSource(imageFile.GetView(), content, filter);
+	imageFile.Close();
+
+	const std::string bakedPath = GetBakedTexturePath(imagePath, content);
+	if (LoadBakedTexture(bakedPath, sourceHash, image))
+		return true;
+
+	if (!TextureLoader::DecodeImage(imagePath, image))
+		return false;
+
+	MipGenerator::GenerateMips(image, content, filter);
+
+	// Sizes that are not a multiple of 4 cannot be block-compressed and stay RGBA8,
+	// the baked copy still saves the decode and the mip chain
+	BlockCompression::CompressImage(image, BlockCompression::ChooseFormat(image, content));
+
+	if (!WriteBakedTexture(bakedPath, image, sourceHash))
+	{
+		OutputDebugStringA(("Could not write baked texture: " + bakedPath + "\n").c_str());
+	}
+
+	return true;
+}
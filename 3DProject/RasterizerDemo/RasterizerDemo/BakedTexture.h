@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "TextureLoader.h"
+#include "MipGenerator.h"
+
+// Binary cache of an imported texture, written as "<name>.<content>.btex" next to the source image.
+// The file holds every mip level already block-compressed (BC1/BC3/BC5) exactly as the GPU
+// texture expects it, so loading skips the JPEG decode, the mip chain and the encoder.
+
+// "textures/crate_1.jpg" -> "textures/crate_1.color.btex"; the content is part of the name
+// because the same image can be both a color and a data map
+std::string GetBakedTexturePath(const std::string& imagePath, MipContent content);
+
+// Cache key over the encoded image file, how its mips are built and the encoder version
+uint64_t HashTextureSource(std::string_view imageContents, MipContent content, MipFilter filter);
+
+// Serializes an image with all its levels; returns false if the file could not be written
+bool WriteBakedTexture(const std::string& path, const ImageData& image, uint64_t sourceHash);
+
+// Reads a baked texture into image. Returns false if the file is missing, malformed, from
+// another format version or was baked from a different source.
+bool LoadBakedTexture(const std::string& path, uint64_t sourceHash, ImageData& image);
+
+// Any thread. Loads the baked copy of imagePath if it is current, otherwise decodes the image,
+// builds its mip chain, compresses it and writes the baked copy for next time.
+// Returns false if the image cannot be loaded.
+bool ImportTexture(const std::string& imagePath, MipContent content, MipFilter filter, ImageData& image);
@@ -0,0 +1,2119 @@
+#include "Benchmarks.h"
+#include "OBJParser.h"
+#include "OBJStreamingParser.h"
+#include "GLBParser.h"
+#include "BakedMesh.h"
+#include "MemoryMappedFile.h"
+#include "VertexCacheTable.h"
+#include "MeshOptimizer.h"
+#include "MeshCleanup.h"
+#include "IndexCompression.h"
+#include "Meshlets.h"
+#include "MeshSimplifier.h"
+#include "MeshParts.h"
+#include "TangentGenerator.h"
+#include "VertexPacking.h"
+#include "MipGenerator.h"
+#include "BlockCompression.h"
+#include "BakedTexture.h"
+#include "QuadTree.h"
+#include "LooseQuadTree.h"
+#include "FrustumCulling.h"
+
+#include <Windows.h>
+#include <Psapi.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	std::ofstream resultFile;
+
+	void Report(const std::string& line)
+	{
+		std::string msg = line + "\n";
+		OutputDebugStringA(msg.c_str());
+		if (resultFile.is_open())
+		{
+			resultFile << msg;
+			resultFile.flush();
+		}
+	}
+
+	double SecondsSince(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	std::string FormatRate(const char* label, double count, double seconds, const char* unit)
+	{
+		char buffer[256];
+		std::snprintf(buffer, sizeof(buffer), "  %-28s %10.2f M%s/s (%.1f ms)",
+			label, count / seconds / 1.0e6, unit, seconds * 1000.0);
+		return buffer;
+	}
+
+	// Face corners of an N x N grid of quads split into two triangles each,
+	// sharing positions and UVs the way a scan export does
+	std::vector<VertexData> MakeGridCorners(int quadsPerSide)
+	{
+		std::vector<VertexData> corners;
+		corners.reserve(static_cast<size_t>(quadsPerSide) * quadsPerSide * 6);
+
+		const int rowLength = quadsPerSide + 1;
+		for (int z = 0; z < quadsPerSide; ++z)
+		{
+			for (int x = 0; x < quadsPerSide; ++x)
+			{
+				int a = z * rowLength + x + 1;
+				int b = a + 1;
+				int c = a + rowLength + 1;
+				int d = a + rowLength;
+				for (int corner : { a, b, c, a, c, d })
+				{
+					corners.push_back({ corner, corner, 1 });
+				}
+			}
+		}
+		return corners;
+	}
+
+	// OBJ text for an N x N grid of quads, the shape of a large scan or terrain export
+	std::string MakeGridOBJ(int quadsPerSide)
+	{
+		std::string text;
+		text.reserve(static_cast<size_t>(quadsPerSide + 1) * (quadsPerSide + 1) * 64 +
+			static_cast<size_t>(quadsPerSide) * quadsPerSide * 48);
+
+		char line[128];
+		const int rowLength = quadsPerSide + 1;
+		for (int z = 0; z < rowLength; ++z)
+		{
+			for (int x = 0; x < rowLength; ++x)
+			{
+				float u = static_cast<float>(x) / quadsPerSide;
+				float v = static_cast<float>(z) / quadsPerSide;
+				std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\n", u * 100.0f, 0.0f, v * 100.0f, u, v);
+				text += line;
+			}
+		}
+		text += "vn 0 1 0\n";
+
+		for (int z = 0; z < quadsPerSide; ++z)
+		{
+			for (int x = 0; x < quadsPerSide; ++x)
+			{
+				int a = z * rowLength + x + 1;
+				int b = a + 1;
+				int c = a + rowLength + 1;
+				int d = a + rowLength;
+				std::snprintf(line, sizeof(line), "f %d/%d/1 %d/%d/1 %d/%d/1 %d/%d/1\n", a, a, b, b, c, c, d, d);
+				text += line;
+			}
+		}
+		return text;
+	}
+
+	constexpr const char* SAMPLE_GRID_LABEL = "generated 300x300 grid";
+
+	// Runs visit on every OBJ in objects/, reporting the files it throws on as skipped
+	void ForEachObjectFile(const std::function<void(const std::filesystem::path&)>& visit)
+	{
+		for (const auto& entry : std::filesystem::directory_iterator(defaultDirectory))
+		{
+			if (entry.path().extension() != ".obj")
+				continue;
+
+			try
+			{
+				visit(entry.path());
+			}
+			catch (const std::exception& e)
+			{
+				Report(std::string("  skipped ") + entry.path().filename().string() + ": " + e.what());
+			}
+		}
+	}
+
+	// Runs visit on the mapped contents of every OBJ in objects/, labelled by file name, then on
+	// a generated 300x300 grid labelled SAMPLE_GRID_LABEL
+	void ForEachSampleOBJ(const std::function<void(const std::string&, std::string_view)>& visit)
+	{
+		ForEachObjectFile([&](const std::filesystem::path& path)
+			{
+				MemoryMappedFile objFile(path.string());
+				visit(path.filename().string(), objFile.GetView());
+			});
+
+		visit(SAMPLE_GRID_LABEL, MakeGridOBJ(300));
+	}
+
+	void BenchmarkVertexDedup()
+	{
+		Report("Vertex deduplication (ParseFace corner lookup)");
+
+		const std::vector<VertexData> corners = MakeGridCorners(1000);
+		const double nrOfCorners = static_cast<double>(corners.size());
+
+		// Previous approach: string key per corner, find followed by operator[]
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+
+			std::unordered_map<std::string, unsigned int> cache;
+			std::vector<unsigned int> indices;
+			indices.reserve(corners.size());
+			unsigned int nrOfVertices = 0;
+
+			for (const VertexData& corner : corners)
+			{
+				std::string token = std::to_string(corner.vInd) + "/" +
+					std::to_string(corner.tInd) + "/" +
+					std::to_string(corner.nInd);
+
+				if (cache.find(token) != cache.end())
+				{
+					indices.push_back(cache[token]);
+					continue;
+				}
+				indices.push_back(nrOfVertices);
+				cache[token] = nrOfVertices++;
+			}
+
+			Report(FormatRate("string-keyed unordered_map", nrOfCorners, SecondsSince(start), "corners"));
+		}
+
+		// Flat open-addressing table keyed on the integer triple, pre-sized like ParseOBJ does
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+
+			VertexCacheTable cache;
+			cache.Reserve(corners.size() / 6);
+			std::vector<unsigned int> indices;
+			indices.reserve(corners.size());
+			unsigned int nrOfVertices = 0;
+
+			for (const VertexData& corner : corners)
+			{
+				bool inserted = false;
+				indices.push_back(cache.FindOrInsert(corner.vInd, corner.tInd, corner.nInd, nrOfVertices, inserted));
+				if (inserted)
+					nrOfVertices++;
+			}
+
+			Report(FormatRate("VertexCacheTable", nrOfCorners, SecondsSince(start), "corners"));
+		}
+	}
+
+	void BenchmarkParallelParse()
+	{
+		Report("OBJ parsing (serial vs chunked parallel)");
+
+		const std::string text = MakeGridOBJ(1000);
+		const double nrOfBytes = static_cast<double>(text.size());
+		const OBJImportSettings previousSettings = objImportSettings;
+
+		ParseData serial;
+		{
+			objImportSettings.parallelParseMinBytes = SIZE_MAX;
+			auto start = std::chrono::high_resolution_clock::now();
+			ParseOBJContents(text, serial);
+			Report(FormatRate("serial", nrOfBytes, SecondsSince(start), "B"));
+		}
+
+		ParseData parallel;
+		{
+			objImportSettings.parallelParseMinBytes = 0;
+			auto start = std::chrono::high_resolution_clock::now();
+			ParseOBJContents(text, parallel);
+
+			char label[64];
+			std::snprintf(label, sizeof(label), "parallel (%u threads)", (std::max)(1u, std::thread::hardware_concurrency()));
+			Report(FormatRate(label, nrOfBytes, SecondsSince(start), "B"));
+		}
+
+		objImportSettings = previousSettings;
+
+		bool matches = serial.indexData == parallel.indexData &&
+			serial.vertices.size() == parallel.vertices.size() &&
+			std::memcmp(serial.vertices.data(), parallel.vertices.data(), serial.vertices.size() * sizeof(Vertex)) == 0;
+		Report(matches ? "  parallel output matches serial" : "  MISMATCH between serial and parallel output");
+	}
+
+	std::size_t GetWorkingSetBytes()
+	{
+		PROCESS_MEMORY_COUNTERS counters = {};
+		counters.cb = sizeof(counters);
+		return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.WorkingSetSize : 0;
+	}
+
+	// Bytes the mapped import holds once parsing is done, the figure streaming is compared to
+	std::size_t ParseDataBytes(const ParseData& data, std::size_t fileSize)
+	{
+		return fileSize + data.positions.capacity() * sizeof(XMFLOAT3) + data.normals.capacity() * sizeof(XMFLOAT3) +
+			data.texCoords.capacity() * sizeof(XMFLOAT2) + data.vertexCache.GetMemoryUsage() +
+			data.vertices.capacity() * sizeof(Vertex) + data.indexData.capacity() * sizeof(unsigned int) +
+			data.tangents.capacity() * sizeof(XMFLOAT4);
+	}
+
+	// Streaming import against the mapped one. With the per-submesh passes off, both must produce
+	// the same corners and submesh ranges, and the cache key must not depend on the block size.
+	// The generated grid is written to a temporary file large enough to span many blocks.
+	void BenchmarkStreamingImport()
+	{
+		Report("Streaming OBJ import (mapped vs 1 MB blocks, memory held and working set)");
+
+		const OBJImportSettings previousSettings = objImportSettings;
+		objImportSettings.streamingImportMinBytes = 1;
+		objImportSettings.streamingBlockBytes = 1;
+
+		auto Compare = [&](const std::string& label, const std::string& path, bool checkOutput)
+			{
+				MemoryMappedFile objFile(path);
+				if (!objFile.IsOpen())
+					return;
+
+				// Working set growth over the import; the mapped one is sampled while the file is still mapped
+				std::size_t workingSetBefore = GetWorkingSetBytes();
+				ParseData mapped;
+				auto start = std::chrono::high_resolution_clock::now();
+				ParseOBJContents(objFile.GetView(), mapped);
+				const double mappedSeconds = SecondsSince(start);
+				const std::size_t mappedWorkingSet = GetWorkingSetBytes() - (std::min)(workingSetBefore, GetWorkingSetBytes());
+				const std::size_t mappedBytes = ParseDataBytes(mapped, objFile.GetSize());
+				objFile.Close();
+
+				workingSetBefore = GetWorkingSetBytes();
+				OBJFileScan scan;
+				OBJStreamingStatistics statistics;
+				ParseData streamed;
+				start = std::chrono::high_resolution_clock::now();
+				ScanOBJFile(path, scan);
+				ParseOBJStreaming(path, scan, streamed, &statistics);
+				const double streamedSeconds = SecondsSince(start);
+				const std::size_t streamedWorkingSet = statistics.peakWorkingSetBytes - (std::min)(workingSetBefore, statistics.peakWorkingSetBytes);
+
+				objImportSettings.streamingBlockBytes = 8 * 1024 * 1024;
+				OBJFileScan largeBlockScan;
+				ScanOBJFile(path, largeBlockScan);
+				objImportSettings.streamingBlockBytes = 1;
+
+				std::size_t fullDetailIndices = 0;
+				for (const SubMeshInfo& subMesh : streamed.finishedSubMeshes)
+				{
+					fullDetailIndices += subMesh.nrOfIndicesInSubMesh;
+				}
+
+				bool matches = scan.contentHash == largeBlockScan.contentHash && scan.nrOfTriangles * 3 == fullDetailIndices;
+				if (checkOutput)
+				{
+					matches = matches && mapped.indexData.size() == streamed.indexData.size() &&
+						mapped.finishedSubMeshes.size() == streamed.finishedSubMeshes.size();
+					for (std::size_t i = 0; matches && i < mapped.indexData.size(); ++i)
+					{
+						matches = std::memcmp(&mapped.vertices[mapped.indexData[i]], &streamed.vertices[streamed.indexData[i]], sizeof(Vertex)) == 0;
+					}
+					for (std::size_t i = 0; matches && i < mapped.finishedSubMeshes.size(); ++i)
+					{
+						const SubMeshInfo& a = mapped.finishedSubMeshes[i];
+						const SubMeshInfo& b = streamed.finishedSubMeshes[i];
+						matches = a.startIndexValue == b.startIndexValue && a.nrOfIndicesInSubMesh == b.nrOfIndicesInSubMesh &&
+							a.currentSubMeshMaterial == b.currentSubMeshMaterial;
+					}
+				}
+
+				char line[320];
+				std::snprintf(line, sizeof(line), "  %-28s mapped %.1f ms, %.1f MB held, +%.1f MB working set; streamed %.1f ms, "
+					"%zu blocks, %zu submeshes, %.1f MB held, +%.1f MB working set%s",
+					label.c_str(), mappedSeconds * 1000.0, mappedBytes / 1048576.0, mappedWorkingSet / 1048576.0,
+					streamedSeconds * 1000.0, statistics.nrOfBlocks, statistics.nrOfFlushedSubMeshes,
+					statistics.peakTrackedBytes / 1048576.0, streamedWorkingSet / 1048576.0, matches ? "" : " MISMATCH");
+				Report(line);
+			};
+
+		// Per-submesh optimization, tangents and welding change vertices differently from the
+		// whole-mesh passes, and removed triangles would not match the scan's count
+		objImportSettings.cleanMeshes = false;
+		objImportSettings.optimizeMeshes = false;
+		objImportSettings.generateTangents = false;
+		objImportSettings.generateLODs = false;
+		ForEachObjectFile([&](const std::filesystem::path& path)
+			{
+				Compare(path.filename().string(), path.string(), true);
+			});
+
+		const std::filesystem::path gridPath = std::filesystem::temp_directory_path() / "streaming_benchmark.obj";
+		{
+			std::ofstream gridFile(gridPath, std::ios::binary | std::ios::trunc);
+			const std::string text = MakeGridOBJ(1000);
+			gridFile.write(text.data(), static_cast<std::streamsize>(text.size()));
+		}
+
+		Compare("generated 1000x1000 grid", gridPath.string(), true);
+
+		// With every pass on, as an import of a large scan would run
+		objImportSettings.cleanMeshes = previousSettings.cleanMeshes;
+		objImportSettings.optimizeMeshes = previousSettings.optimizeMeshes;
+		objImportSettings.generateTangents = previousSettings.generateTangents;
+		objImportSettings.generateLODs = previousSettings.generateLODs;
+		Compare("grid, all import passes", gridPath.string(), false);
+
+		std::error_code error;
+		std::filesystem::remove(gridPath, error);
+		objImportSettings = previousSettings;
+	}
+
+	// Imported indices against the parser's, whichever width the import stores
+	bool IndicesMatch(const MeshImport& import, const std::vector<unsigned int>& indices)
+	{
+		if (import.nrOfIndices != indices.size())
+			return false;
+
+		for (std::size_t i = 0; i < indices.size(); ++i)
+		{
+			const unsigned int index = import.indexFormat == DXGI_FORMAT_R16_UINT ?
+				static_cast<const uint16_t*>(import.indices)[i] : static_cast<const uint32_t*>(import.indices)[i];
+			if (index != indices[i])
+				return false;
+		}
+		return true;
+	}
+
+	// Cold text import against loading the .bmesh written from it (file in the page cache)
+	void BenchmarkBakedLoad()
+	{
+		Report("Mesh import (OBJ parse vs baked .bmesh load)");
+
+		auto CompareLoad = [](const std::string& label, std::string_view objContents, const std::string& bakedPath)
+			{
+				auto start = std::chrono::high_resolution_clock::now();
+				ParseData data;
+				ParseOBJContents(objContents, data);
+				const double parseSeconds = SecondsSince(start);
+
+				WriteBakedMesh(bakedPath, data, HashMeshSource(objContents, data.materialLibraries));
+
+				start = std::chrono::high_resolution_clock::now();
+				BakedMesh baked;
+				MeshImport import;
+				bool loaded = baked.Load(bakedPath, objContents, import);
+				const double loadSeconds = SecondsSince(start);
+
+				bool matches = loaded && import.nrOfVertices == data.vertices.size() &&
+					std::memcmp(import.vertices, data.vertices.data(), data.vertices.size() * sizeof(Vertex)) == 0 &&
+					(import.packedVertices != nullptr) == !data.packedVertices.empty() &&
+					(data.packedVertices.empty() || std::memcmp(import.packedVertices, data.packedVertices.data(), data.packedVertices.size()) == 0) &&
+					IndicesMatch(import, data.indexData);
+
+				char line[256];
+				std::snprintf(line, sizeof(line), "  %-28s parse %8.2f ms, baked load %8.2f ms (%.1fx)%s",
+					label.c_str(), parseSeconds * 1000.0, loadSeconds * 1000.0, parseSeconds / loadSeconds,
+					matches ? "" : "  MISMATCH");
+				Report(line);
+			};
+
+		ForEachObjectFile([&](const std::filesystem::path& path)
+			{
+				MemoryMappedFile objFile(path.string());
+				CompareLoad(path.filename().string(), objFile.GetView(), GetBakedMeshPath(path.string()));
+			});
+
+		const std::string text = MakeGridOBJ(1000);
+		CompareLoad("generated 1000x1000 grid", text, "benchmark_grid.bmesh");
+		std::remove("benchmark_grid.bmesh");
+	}
+
+	// Content addressing of mesh geometry: how many of the sample meshes share buffers, what that
+	// saves, and what hashing costs the loader thread
+	void BenchmarkGeometryDedup()
+	{
+		Report("Geometry deduplication (content hash of vertex and index payloads)");
+
+		auto GeometryBytes = [](const MeshImport& import)
+			{
+				return import.nrOfVertices * sizeof(Vertex) + (import.tangents ? import.nrOfVertices * sizeof(XMFLOAT4) : 0) +
+					(import.packedVertices ? import.nrOfVertices * import.packedFormat.GetStride() : 0) +
+					import.nrOfIndices * (import.indexFormat == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(uint32_t));
+			};
+
+		std::unordered_map<uint64_t, std::size_t> meshesByHash;
+		std::size_t nrOfMeshes = 0;
+		std::size_t bytesDeduplicated = 0;
+		ForEachObjectFile([&](const std::filesystem::path& path)
+			{
+				MemoryMappedFile objFile(path.string());
+				ParseData data;
+				ParseOBJContents(objFile.GetView(), data);
+				MeshImport import;
+				BuildMeshImport(data, import);
+
+				nrOfMeshes++;
+				if (meshesByHash[HashMeshGeometry(import)]++ > 0)
+				{
+					bytesDeduplicated += GeometryBytes(import);
+				}
+			});
+
+		char line[256];
+		std::snprintf(line, sizeof(line), "  sample meshes: %zu files, %zu distinct geometries, %.1f KB deduplicated",
+			nrOfMeshes, meshesByHash.size(), bytesDeduplicated / 1024.0);
+		Report(line);
+
+		// A renamed copy differs only in names, a nudged one in a single coordinate
+		const std::string text = MakeGridOBJ(1000);
+		std::string renamed = "o renamed_copy\n" + text;
+		std::string nudged = text;
+		nudged[nudged.find("v ") + 2] = nudged[nudged.find("v ") + 2] == '1' ? '2' : '1';
+
+		uint64_t hashes[3] = {};
+		MeshImport gridImport;
+		ParseData gridData;
+		const std::string* variants[3] = { &text, &renamed, &nudged };
+		for (std::size_t i = 0; i < 3; ++i)
+		{
+			ParseData data;
+			ParseOBJContents(*variants[i], data);
+			MeshImport import;
+			BuildMeshImport(data, import);
+			hashes[i] = HashMeshGeometry(import);
+
+			if (i == 0)
+			{
+				gridData = std::move(data);
+				BuildMeshImport(gridData, gridImport);
+			}
+		}
+
+		const int repeats = 10;
+		auto start = std::chrono::high_resolution_clock::now();
+		uint64_t sink = 0;
+		for (int i = 0; i < repeats; ++i)
+		{
+			sink += HashMeshGeometry(gridImport);
+		}
+		Report(FormatRate("hash 1000x1000 grid", static_cast<double>(GeometryBytes(gridImport)) * repeats, SecondsSince(start), "B"));
+
+		const bool matches = sink != 0 && hashes[0] == hashes[1] && hashes[0] != hashes[2];
+		Report(matches ? "  renamed copy shares its geometry, a changed one does not" : "  MISMATCH in geometry hashes");
+	}
+
+	// glTF binary for the same N x N grid, vertices interleaved exactly like Vertex or as one
+	// tightly packed array per attribute, the two layouts exporters write
+	std::string MakeGridGLB(int quadsPerSide, bool interleaved)
+	{
+		const int rowLength = quadsPerSide + 1;
+		const std::size_t nrOfVertices = static_cast<std::size_t>(rowLength) * rowLength;
+
+		std::vector<Vertex> vertices;
+		vertices.reserve(nrOfVertices);
+		for (int z = 0; z < rowLength; ++z)
+		{
+			for (int x = 0; x < rowLength; ++x)
+			{
+				const float u = static_cast<float>(x) / quadsPerSide;
+				const float v = static_cast<float>(z) / quadsPerSide;
+				vertices.push_back({ XMFLOAT3(u * 100.0f, 0.0f, v * 100.0f), XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT2(u, v) });
+			}
+		}
+
+		std::vector<uint32_t> indices;
+		indices.reserve(static_cast<std::size_t>(quadsPerSide) * quadsPerSide * 6);
+		for (int z = 0; z < quadsPerSide; ++z)
+		{
+			for (int x = 0; x < quadsPerSide; ++x)
+			{
+				const uint32_t a = z * rowLength + x;
+				const uint32_t b = a + 1;
+				const uint32_t c = a + rowLength + 1;
+				const uint32_t d = a + rowLength;
+				for (uint32_t corner : { a, b, c, a, c, d })
+				{
+					indices.push_back(corner);
+				}
+			}
+		}
+
+		std::string bin;
+		std::string bufferViews;
+		const std::size_t vertexBytes = nrOfVertices * sizeof(Vertex);
+		if (interleaved)
+		{
+			bin.append(reinterpret_cast<const char*>(vertices.data()), vertexBytes);
+			bufferViews = "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":" + std::to_string(vertexBytes) + ",\"byteStride\":32},";
+		}
+		else
+		{
+			std::size_t offset = 0;
+			for (std::size_t attributeBytes : { sizeof(XMFLOAT3), sizeof(XMFLOAT3), sizeof(XMFLOAT2) })
+			{
+				for (const Vertex& vertex : vertices)
+				{
+					bin.append(reinterpret_cast<const char*>(&vertex) + offset, attributeBytes);
+				}
+				bufferViews += "{\"buffer\":0,\"byteOffset\":" + std::to_string(offset * nrOfVertices) +
+					",\"byteLength\":" + std::to_string(attributeBytes * nrOfVertices) + "},";
+				offset += attributeBytes;
+			}
+		}
+		const std::size_t indexOffset = bin.size();
+		bin.append(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint32_t));
+		bufferViews += "{\"buffer\":0,\"byteOffset\":" + std::to_string(indexOffset) +
+			",\"byteLength\":" + std::to_string(indices.size() * sizeof(uint32_t)) + "}";
+
+		// Interleaved attributes share view 0 at their offsets in Vertex, separate ones get a view each
+		const std::string count = std::to_string(nrOfVertices);
+		auto Attribute = [&](int view, std::size_t offset, const char* type, const std::string& bounds)
+			{
+				return "{\"bufferView\":" + std::to_string(interleaved ? 0 : view) + ",\"byteOffset\":" +
+					std::to_string(interleaved ? offset : 0) + ",\"componentType\":5126,\"count\":" + count +
+					",\"type\":\"" + type + "\"" + bounds + "}";
+			};
+
+		std::string json = "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],"
+			"\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1,\"TEXCOORD_0\":2},\"indices\":3,\"material\":0}]}],"
+			"\"materials\":[{\"name\":\"grid\",\"pbrMetallicRoughness\":{\"baseColorFactor\":[1,0.5,0.25,1],\"metallicFactor\":0,\"roughnessFactor\":0.5}}],"
+			"\"accessors\":[" +
+			Attribute(0, offsetof(Vertex, Position), "VEC3", ",\"min\":[0,0,0],\"max\":[100,0,100]") + "," +
+			Attribute(1, offsetof(Vertex, Normal), "VEC3", "") + "," +
+			Attribute(2, offsetof(Vertex, UV), "VEC2", "") + "," +
+			"{\"bufferView\":" + std::to_string(interleaved ? 1 : 3) + ",\"componentType\":5125,\"count\":" +
+			std::to_string(indices.size()) + ",\"type\":\"SCALAR\"}],"
+			"\"bufferViews\":[" + bufferViews + "],\"buffers\":[{\"byteLength\":" + std::to_string(bin.size()) + "}]}";
+
+		json.append((4 - json.size() % 4) % 4, ' ');
+		bin.append((4 - bin.size() % 4) % 4, '\0');
+
+		auto AppendU32 = [](std::string& out, uint32_t value)
+			{
+				out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+			};
+
+		std::string glb;
+		AppendU32(glb, 0x46546C67);
+		AppendU32(glb, 2);
+		AppendU32(glb, static_cast<uint32_t>(12 + 8 + json.size() + 8 + bin.size()));
+		AppendU32(glb, static_cast<uint32_t>(json.size()));
+		AppendU32(glb, 0x4E4F534A);
+		glb += json;
+		AppendU32(glb, static_cast<uint32_t>(bin.size()));
+		AppendU32(glb, 0x004E4942);
+		glb += bin;
+		return glb;
+	}
+
+	// Zero-copy .glb import against converting the same file and against parsing the grid as OBJ.
+	// With the OBJ passes off, every path must give the same vertices and indices.
+	void BenchmarkGLBImport()
+	{
+		Report("glTF binary import (zero-copy vs converted vs OBJ text)");
+
+		const OBJImportSettings previousSettings = objImportSettings;
+		const GLBImportSettings previousGLBSettings = glbImportSettings;
+		objImportSettings.optimizeMeshes = false;
+		objImportSettings.generateTangents = false;
+		objImportSettings.generateLODs = false;
+
+		const int quadsPerSide = 1000;
+		const std::string interleaved = MakeGridGLB(quadsPerSide, true);
+		const std::string separate = MakeGridGLB(quadsPerSide, false);
+
+		auto Import = [](const char* label, std::string_view contents, bool zeroCopy, ParseData& data, MeshImport& import)
+			{
+				glbImportSettings.zeroCopy = zeroCopy;
+				GLBImportStatistics statistics;
+				auto start = std::chrono::high_resolution_clock::now();
+				ParseGLBContents(contents, "", data, import, &statistics);
+				const double seconds = SecondsSince(start);
+
+				char line[256];
+				std::snprintf(line, sizeof(line), "  %-28s %8.2f ms (vertices %s, indices %s)", label, seconds * 1000.0,
+					statistics.zeroCopyVertices ? "in place" : "converted", statistics.zeroCopyIndices ? "in place" : "converted");
+				Report(line);
+				return statistics;
+			};
+
+		ParseData zeroCopyData;
+		MeshImport zeroCopyImport;
+		const GLBImportStatistics zeroCopyStats = Import("interleaved, zero-copy", interleaved, true, zeroCopyData, zeroCopyImport);
+
+		ParseData separateData;
+		MeshImport separateImport;
+		const GLBImportStatistics separateStats = Import("separate, zero-copy", separate, true, separateData, separateImport);
+
+		ParseData convertedData;
+		MeshImport convertedImport;
+		Import("interleaved, converted", interleaved, false, convertedData, convertedImport);
+
+		{
+			const std::string text = MakeGridOBJ(quadsPerSide);
+			auto start = std::chrono::high_resolution_clock::now();
+			ParseData data;
+			ParseOBJContents(text, data);
+			Report(FormatRate("OBJ text of the same grid", static_cast<double>(text.size()), SecondsSince(start), "B"));
+		}
+
+		objImportSettings = previousSettings;
+		glbImportSettings = previousGLBSettings;
+
+		const bool inPlace = zeroCopyStats.zeroCopyVertices && zeroCopyStats.zeroCopyIndices &&
+			reinterpret_cast<const char*>(zeroCopyImport.vertices) >= interleaved.data() &&
+			reinterpret_cast<const char*>(zeroCopyImport.vertices) < interleaved.data() + interleaved.size() &&
+			!separateStats.zeroCopyVertices;
+
+		bool matches = true;
+		for (const MeshImport* import : { &separateImport, &convertedImport })
+		{
+			matches = matches && import->nrOfVertices == zeroCopyImport.nrOfVertices &&
+				std::memcmp(import->vertices, zeroCopyImport.vertices, zeroCopyImport.nrOfVertices * sizeof(Vertex)) == 0 &&
+				IndicesMatch(*import, convertedData.indexData) && import->subMeshes.size() == zeroCopyImport.subMeshes.size();
+		}
+		matches = matches && IndicesMatch(zeroCopyImport, convertedData.indexData);
+
+		Report(!inPlace ? "  MISMATCH: zero-copy layout not detected" :
+			matches ? "  zero-copy, separate and converted imports match" : "  MISMATCH between zero-copy and converted imports");
+	}
+
+	// MTL files through the library cache, cold then warm, and how many of their materials the
+	// table folds together. Local instances, so the counts of the running demo are untouched.
+	void BenchmarkMaterialTable()
+	{
+		Report("Material libraries (MTL cache and deduplicated material table)");
+
+		std::vector<std::string> mtlPaths;
+		for (const auto& entry : std::filesystem::directory_iterator(defaultDirectory))
+		{
+			if (entry.path().extension() == ".mtl")
+			{
+				mtlPaths.push_back(entry.path().string());
+			}
+		}
+
+		MtlLibraryCache cache;
+		MaterialTable table;
+		std::size_t nrOfRegistrations = 0;
+		for (const char* label : { "cold cache", "warm cache" })
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			for (const std::string& path : mtlPaths)
+			{
+				const std::shared_ptr<const std::vector<MaterialInfo>> library = cache.Load(path);
+				if (!library)
+				{
+					Report("  skipped " + path + ": cannot be opened");
+					continue;
+				}
+
+				for (const MaterialInfo& material : *library)
+				{
+					table.Register(material);
+					nrOfRegistrations++;
+				}
+			}
+
+			char line[256];
+			std::snprintf(line, sizeof(line), "  %-28s %zu files in %8.3f ms (%zu parsed, %zu reused)",
+				label, mtlPaths.size(), SecondsSince(start) * 1000.0, cache.GetNrOfParses(), cache.GetNrOfHits());
+			Report(line);
+		}
+
+		char line[256];
+		std::snprintf(line, sizeof(line), "  %zu registrations, %zu unique materials, %zu shared",
+			nrOfRegistrations, table.GetSize(), table.GetNrOfSharedRegistrations());
+		Report(line);
+
+		// The name is not part of a material's identity, its constants and textures are
+		MaterialInfo material;
+		material.mapKd = "Brick.png";
+		const MaterialId id = table.Register(material);
+		MaterialInfo renamed = material;
+		renamed.name = "renamed copy";
+		MaterialInfo changed = material;
+		changed.specularPower += 1.0f;
+
+		const bool matches = cache.GetNrOfParses() == mtlPaths.size() &&
+			table.Register(renamed) == id && table.Register(changed) != id;
+		Report(matches ? "  identical materials share an ID, different ones do not" : "  MISMATCH in material IDs");
+	}
+
+	// Index storage per triangle as 32-bit, 16-bit and encoded, and the decode rate at load
+	void BenchmarkIndexCompression()
+	{
+		Report("Index compression (bytes per triangle, decode rate)");
+
+		auto Compress = [](const std::string& label, std::string_view objContents)
+			{
+				ParseData data;
+				ParseOBJContents(objContents, data);
+				if (data.indexData.empty())
+					return;
+
+				std::vector<unsigned char> encoded;
+				auto start = std::chrono::high_resolution_clock::now();
+				IndexCompression::Encode(data.indexData.data(), data.indexData.size(), encoded);
+				const double encodeSeconds = SecondsSince(start);
+
+				const DXGI_FORMAT format = IndexCompression::ChooseFormat(data.vertices.size());
+				std::vector<unsigned char> decoded(data.indexData.size() * IndexCompression::GetIndexSize(format));
+
+				// Best of a few runs, the first one pays for faulting in the output
+				double decodeSeconds = 0.0;
+				bool decodedOK = true;
+				for (int run = 0; run < 5; ++run)
+				{
+					start = std::chrono::high_resolution_clock::now();
+					decodedOK = IndexCompression::Decode(encoded.data(), encoded.size(), data.indexData.size(),
+						data.vertices.size(), format, decoded.data()) && decodedOK;
+					const double seconds = SecondsSince(start);
+					decodeSeconds = run == 0 ? seconds : (std::min)(decodeSeconds, seconds);
+				}
+
+				MeshImport import;
+				import.indices = decoded.data();
+				import.nrOfIndices = data.indexData.size();
+				import.indexFormat = format;
+				const bool matches = decodedOK && IndicesMatch(import, data.indexData);
+
+				// Raw storage is 12 bytes per triangle at 32 bits, 6 at 16
+				const double triangles = static_cast<double>(data.indexData.size() / 3);
+				const double rawBytes = 3.0 * IndexCompression::GetIndexSize(format);
+				char line[256];
+				std::snprintf(line, sizeof(line), "  %-28s %s %.0f B/tri, encoded %.2f B/tri (%.0f%%), encode %.2f ms, decode %.0f M indices/s%s",
+					label.c_str(), format == DXGI_FORMAT_R16_UINT ? "R16" : "R32", rawBytes, encoded.size() / triangles,
+					100.0 * encoded.size() / (triangles * rawBytes), encodeSeconds * 1000.0, data.indexData.size() / decodeSeconds / 1.0e6,
+					matches ? "" : "  MISMATCH");
+				Report(line);
+			};
+
+		ForEachSampleOBJ(Compress);
+	}
+
+	// An N x N grid written the way careless exporters do: every quad with its own corners,
+	// jittered below the weld epsilon, a UV seam down the middle column, one collinear and one
+	// repeated triangle per row, and a usemtl switch between two materials on every row. The grid
+	// is split into two parts at its middle row.
+	void MakeMessyGrid(int quadsPerSide, float jitter, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+		std::vector<SubMeshInfo>& subMeshes, std::vector<MeshPart>& parts)
+	{
+		std::mt19937 random(99);
+		std::uniform_real_distribution<float> offset(-jitter, jitter);
+		const int seam = quadsPerSide / 2;
+
+		for (int z = 0; z < quadsPerSide; ++z)
+		{
+			if (z == 0 || z == quadsPerSide / 2)
+			{
+				MeshParts::Begin(z == 0 ? "north" : "south", subMeshes.size(), parts);
+			}
+
+			SubMeshInfo subMesh;
+			subMesh.startIndexValue = indices.size();
+			subMesh.currentSubMeshMaterial = z % 2;
+
+			for (int x = 0; x < quadsPerSide; ++x)
+			{
+				const unsigned int base = static_cast<unsigned int>(vertices.size());
+				const int cornerX[4] = { x, x + 1, x + 1, x };
+				const int cornerZ[4] = { z, z, z + 1, z + 1 };
+				for (int c = 0; c < 4; ++c)
+				{
+					Vertex vertex;
+					vertex.Position = XMFLOAT3(cornerX[c] + offset(random), 0.0f, cornerZ[c] + offset(random));
+					vertex.Normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+					// The quads left of the seam tile their texture from the other end
+					const float u = x < seam ? static_cast<float>(cornerX[c]) : cornerX[c] + 0.5f;
+					vertex.UV = XMFLOAT2(u / quadsPerSide, static_cast<float>(cornerZ[c]) / quadsPerSide);
+					vertices.push_back(vertex);
+				}
+
+				const unsigned int quad[6] = { base, base + 2, base + 1, base, base + 3, base + 2 };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+
+			// A fan triangle over three collinear corners off the grid, left unreferenced once it
+			// is dropped, and the row's first triangle again
+			const unsigned int base = static_cast<unsigned int>(vertices.size());
+			for (int c = 1; c <= 3; ++c)
+			{
+				Vertex vertex;
+				vertex.Position = XMFLOAT3(-static_cast<float>(c), 0.0f, static_cast<float>(z));
+				vertex.Normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+				vertex.UV = XMFLOAT2(-static_cast<float>(c), 0.0f);
+				vertices.push_back(vertex);
+				indices.push_back(base + c - 1);
+			}
+
+			const unsigned int* first = &indices[subMesh.startIndexValue];
+			const unsigned int repeated[3] = { first[1], first[2], first[0] };
+			indices.insert(indices.end(), repeated, repeated + 3);
+
+			subMesh.nrOfIndicesInSubMesh = indices.size() - subMesh.startIndexValue;
+			subMeshes.push_back(subMesh);
+		}
+	}
+
+	// Cleanup of a grid with known defects: every count removed must match what was put in
+	void BenchmarkMeshCleanup()
+	{
+		Report("Mesh cleanup (welding, degenerate and duplicate triangles, submesh merging)");
+
+		constexpr int QUADS_PER_SIDE = 512;
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		std::vector<SubMeshInfo> subMeshes;
+		std::vector<MeshPart> parts;
+		MakeMessyGrid(QUADS_PER_SIDE, 1.0e-5f, vertices, indices, subMeshes, parts);
+
+		const std::size_t verticesBefore = vertices.size();
+		const std::size_t subMeshesBefore = subMeshes.size();
+		MeshCleanupStatistics statistics;
+		auto start = std::chrono::high_resolution_clock::now();
+		MeshCleanup::Clean(vertices, indices, subMeshes, parts, 1.0e-4f, &statistics);
+		const double seconds = SecondsSince(start);
+
+		// Each grid corner once, plus a second copy of the seam column
+		const std::size_t expectedVertices = static_cast<std::size_t>(QUADS_PER_SIDE + 1) * (QUADS_PER_SIDE + 2);
+		const bool partsMatch = parts.size() == 2 && parts[0].firstSubMesh == 0 && parts[1].firstSubMesh == 2;
+		const bool matches = vertices.size() == expectedVertices && subMeshes.size() == 4 && partsMatch &&
+			statistics.degenerateTriangles == QUADS_PER_SIDE && statistics.duplicateTriangles == QUADS_PER_SIDE &&
+			indices.size() == static_cast<std::size_t>(QUADS_PER_SIDE) * QUADS_PER_SIDE * 6;
+
+		Report(FormatRate("Clean", static_cast<double>(verticesBefore), seconds, "vertices"));
+
+		char line[256];
+		std::snprintf(line, sizeof(line), "  vertices %zu -> %zu, %zu degenerate and %zu duplicate triangles, draws %zu -> %zu%s",
+			verticesBefore, vertices.size(), statistics.degenerateTriangles, statistics.duplicateTriangles,
+			subMeshesBefore, subMeshes.size(), matches ? "" : "  MISMATCH");
+		Report(line);
+	}
+
+	// Post-transform cache efficiency of the parsed index order against the optimized one
+	void BenchmarkMeshOptimization()
+	{
+		Report("Mesh optimization (ACMR/ATVR, 16-entry FIFO)");
+
+		const OBJImportSettings previousSettings = objImportSettings;
+		objImportSettings.optimizeMeshes = false;
+		objImportSettings.generateLODs = false;
+		objImportSettings.generateTangents = false;
+
+		auto Optimize = [](const std::string& label, std::string_view objContents)
+			{
+				ParseData data;
+				ParseOBJContents(objContents, data);
+
+				VertexCacheStatistics before;
+				VertexCacheStatistics after;
+				auto start = std::chrono::high_resolution_clock::now();
+				MeshOptimizer::Optimize(data.vertices, data.indexData, data.finishedSubMeshes, &before, &after);
+				const double seconds = SecondsSince(start);
+
+				char line[256];
+				std::snprintf(line, sizeof(line), "  %-28s ACMR %.3f -> %.3f, ATVR %.3f -> %.3f (%.2f ms, %zu triangles)",
+					label.c_str(), before.acmr, after.acmr, before.atvr, after.atvr, seconds * 1000.0, data.indexData.size() / 3);
+				Report(line);
+			};
+
+		ForEachSampleOBJ(Optimize);
+
+		objImportSettings = previousSettings;
+	}
+
+	// Triangles submitted and CPU time per view with whole-object culling against meshlet
+	// culling, over random views around each mesh. Every triangle that faces a view and is not
+	// fully outside it must survive meshlet culling, or the mesh is reported as MISSED.
+	void BenchmarkMeshletCulling()
+	{
+		Report("Meshlet culling (triangles submitted and CPU time per view, whole object vs meshlets)");
+
+		constexpr int NR_OF_VIEWS = 256;
+		const XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f);
+
+		// Only the full-detail indices, which are what meshlets cover
+		const OBJImportSettings previousSettings = objImportSettings;
+		objImportSettings.generateLODs = false;
+
+		auto Cull = [&](const std::string& label, std::string_view objContents)
+			{
+				ParseData data;
+				ParseOBJContents(objContents, data);
+				if (data.indexData.empty())
+					return;
+
+				BoundingBox localBox;
+				BoundingBox::CreateFromPoints(localBox, data.vertices.size(), &data.vertices[0].Position, sizeof(Vertex));
+				const float radius = (std::max)(XMVectorGetX(XMVector3Length(XMLoadFloat3(&localBox.Extents))), 0.01f);
+				const XMVECTOR center = XMLoadFloat3(&localBox.Center);
+
+				// Orbiting views, some looking past the mesh so it is only partly in the frustum
+				std::mt19937 random(1234);
+				std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+				std::vector<BoundingFrustum> frustums;
+				std::vector<XMFLOAT3> eyes;
+				for (int v = 0; v < NR_OF_VIEWS; ++v)
+				{
+					XMVECTOR direction = XMVector3Normalize(XMVectorSet(unit(random), unit(random), unit(random), 0.0f));
+					XMVECTOR eye = XMVectorAdd(center, XMVectorScale(direction, radius * (1.5f + unit(random))));
+					XMVECTOR target = XMVectorAdd(center, XMVectorScale(XMVectorSet(unit(random), unit(random), unit(random), 0.0f), radius));
+					XMMATRIX invView = XMMatrixInverse(nullptr, XMMatrixLookAtLH(eye, target, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
+
+					BoundingFrustum frustum(projection);
+					frustum.Transform(frustum, invView);
+					frustums.push_back(frustum);
+
+					XMFLOAT3 eyePosition;
+					XMStoreFloat3(&eyePosition, eye);
+					eyes.push_back(eyePosition);
+				}
+
+				const XMMATRIX world = XMMatrixIdentity();
+				const std::size_t nrOfTriangles = data.indexData.size() / 3;
+				std::size_t objectTriangles = 0;
+				std::size_t meshletTriangles = 0;
+				std::size_t missed = 0;
+				MeshletCullStatistics totals;
+				std::vector<MeshDrawRange> ranges;
+				std::vector<bool> drawn(nrOfTriangles);
+
+				auto start = std::chrono::high_resolution_clock::now();
+				for (const BoundingFrustum& frustum : frustums)
+				{
+					BoundingBox worldBox;
+					localBox.Transform(worldBox, world);
+					objectTriangles += frustum.Intersects(worldBox) ? nrOfTriangles : 0;
+				}
+				const double objectSeconds = SecondsSince(start);
+
+				double meshletSeconds = 0.0;
+				for (int v = 0; v < NR_OF_VIEWS; ++v)
+				{
+					start = std::chrono::high_resolution_clock::now();
+					BoundingBox worldBox;
+					localBox.Transform(worldBox, world);
+					ranges.clear();
+					MeshletCullStatistics statistics;
+					if (frustums[v].Intersects(worldBox))
+					{
+						Meshlets::Cull(data.meshlets.data(), data.meshlets.size(), world, frustums[v], eyes[v], ranges, &statistics);
+					}
+					meshletSeconds += SecondsSince(start);
+
+					totals.frustumCulled += statistics.frustumCulled;
+					totals.backfaceCulled += statistics.backfaceCulled;
+					totals.visible += statistics.visible;
+
+					std::fill(drawn.begin(), drawn.end(), false);
+					for (const MeshDrawRange& range : ranges)
+					{
+						meshletTriangles += range.nrOfIndices / 3;
+						std::fill(drawn.begin() + range.startIndex / 3, drawn.begin() + (range.startIndex + range.nrOfIndices) / 3, true);
+					}
+
+					// Conservative check against exact per-triangle facing and plane tests
+					XMVECTOR planes[6];
+					frustums[v].GetPlanes(&planes[0], &planes[1], &planes[2], &planes[3], &planes[4], &planes[5]);
+					const XMVECTOR eye = XMLoadFloat3(&eyes[v]);
+					for (std::size_t t = 0; t < nrOfTriangles; ++t)
+					{
+						if (drawn[t])
+							continue;
+
+						XMVECTOR p[3];
+						for (int corner = 0; corner < 3; ++corner)
+						{
+							p[corner] = XMLoadFloat3(&data.vertices[data.indexData[t * 3 + corner]].Position);
+						}
+
+						// Slivers below float precision have no reliable facing, Meshlets::Build ignores them too
+						XMVECTOR normal = XMVector3Cross(XMVectorSubtract(p[1], p[0]), XMVectorSubtract(p[2], p[0]));
+						float longestEdgeSq = (std::max)({ XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(p[1], p[0]))),
+							XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(p[2], p[0]))), XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(p[2], p[1]))) });
+						if (XMVectorGetX(XMVector3Length(normal)) <= 1.0e-5f * longestEdgeSq)
+							continue;
+
+						normal = XMVector3Normalize(normal);
+						XMVECTOR toEye = XMVectorSubtract(eye, p[0]);
+						if (XMVectorGetX(XMVector3Dot(normal, toEye)) <= 1.0e-4f * XMVectorGetX(XMVector3Length(toEye)))
+							continue;
+
+						bool outside = false;
+						for (const XMVECTOR& plane : planes)
+						{
+							outside = outside || (XMVectorGetX(XMPlaneDotCoord(plane, p[0])) > 0.0f &&
+								XMVectorGetX(XMPlaneDotCoord(plane, p[1])) > 0.0f &&
+								XMVectorGetX(XMPlaneDotCoord(plane, p[2])) > 0.0f);
+						}
+						missed += outside ? 0 : 1;
+					}
+				}
+
+				const double meshletsPerView = static_cast<double>(data.meshlets.size());
+				const std::string missedText = missed > 0 ? "  MISSED " + std::to_string(missed) + " triangles" : "";
+				char line[320];
+				std::snprintf(line, sizeof(line), "  %-28s %zu meshlets; triangles/view %.0f -> %.0f (%.0f%%), meshlets frustum %.0f%% backface %.0f%%; CPU/view %.2f us -> %.2f us%s",
+					label.c_str(), data.meshlets.size(), static_cast<double>(objectTriangles) / NR_OF_VIEWS,
+					static_cast<double>(meshletTriangles) / NR_OF_VIEWS,
+					objectTriangles > 0 ? 100.0 * meshletTriangles / objectTriangles : 0.0,
+					100.0 * totals.frustumCulled / (meshletsPerView * NR_OF_VIEWS),
+					100.0 * totals.backfaceCulled / (meshletsPerView * NR_OF_VIEWS),
+					objectSeconds * 1.0e6 / NR_OF_VIEWS, meshletSeconds * 1.0e6 / NR_OF_VIEWS,
+					missedText.c_str());
+				Report(line);
+			};
+
+		ForEachSampleOBJ(Cull);
+
+		objImportSettings = previousSettings;
+	}
+
+	// OBJ text for an N x N block of buildings, each an "o" record with a closed box of quads
+	// under a shared material, the layout of an architectural export
+	std::string MakePartsOBJ(int partsPerSide, int quadsPerFace)
+	{
+		std::string text = "usemtl concrete\n";
+		char line[128];
+		int nrOfPositions = 0;
+		for (int pz = 0; pz < partsPerSide; ++pz)
+		{
+			for (int px = 0; px < partsPerSide; ++px)
+			{
+				std::snprintf(line, sizeof(line), "o building_%d_%d\n", px, pz);
+				text += line;
+
+				// Six faces of a unit-spaced box, each a grid of quads
+				const float originX = px * 20.0f;
+				const float originZ = pz * 20.0f;
+				const float size = 10.0f;
+				for (int face = 0; face < 6; ++face)
+				{
+					const int axis = face / 2;
+					const float side = (face % 2) ? size : 0.0f;
+					const int rowLength = quadsPerFace + 1;
+					const int base = nrOfPositions + 1;
+					for (int j = 0; j < rowLength; ++j)
+					{
+						for (int i = 0; i < rowLength; ++i)
+						{
+							const float a = size * i / quadsPerFace;
+							const float b = size * j / quadsPerFace;
+							const float coordinates[3] = { axis == 0 ? side : a, axis == 1 ? side : (axis == 0 ? a : b), axis == 2 ? side : b };
+							std::snprintf(line, sizeof(line), "v %.4f %.4f %.4f\n",
+								originX + coordinates[0], coordinates[1], originZ + coordinates[2]);
+							text += line;
+							nrOfPositions++;
+						}
+					}
+
+					for (int j = 0; j < quadsPerFace; ++j)
+					{
+						for (int i = 0; i < quadsPerFace; ++i)
+						{
+							const int c = base + j * rowLength + i;
+							std::snprintf(line, sizeof(line), "f %d %d %d %d\n", c, c + 1, c + rowLength + 1, c + rowLength);
+							text += line;
+						}
+					}
+				}
+			}
+		}
+		return text;
+	}
+
+	// Triangles submitted per view with the object test alone and with each part tested too,
+	// for views over the corner of a large multi-object mesh. Serial and parallel parses must
+	// find the same parts, and every part's bounds must hold its triangles.
+	void BenchmarkMeshParts()
+	{
+		Report("Mesh parts (OBJ objects culled on their own)");
+
+		constexpr int PARTS_PER_SIDE = 16;
+		constexpr int NR_OF_VIEWS = 256;
+		const std::string text = MakePartsOBJ(PARTS_PER_SIDE, 8);
+		const OBJImportSettings previousSettings = objImportSettings;
+		objImportSettings.generateLODs = false;
+
+		ParseData serial;
+		objImportSettings.parallelParseMinBytes = SIZE_MAX;
+		ParseOBJContents(text, serial);
+
+		ParseData parallel;
+		objImportSettings.parallelParseMinBytes = 0;
+		ParseOBJContents(text, parallel);
+
+		objImportSettings = previousSettings;
+
+		bool partsMatch = serial.parts.size() == parallel.parts.size();
+		for (std::size_t p = 0; partsMatch && p < serial.parts.size(); ++p)
+		{
+			partsMatch = serial.parts[p].name == parallel.parts[p].name &&
+				serial.parts[p].firstSubMesh == parallel.parts[p].firstSubMesh &&
+				serial.parts[p].nrOfSubMeshes == parallel.parts[p].nrOfSubMeshes;
+		}
+
+		std::size_t outsideBounds = 0;
+		for (const MeshPart& part : serial.parts)
+		{
+			BoundingBox box = part.boundingBox;
+			box.Extents = XMFLOAT3(box.Extents.x + 1.0e-3f, box.Extents.y + 1.0e-3f, box.Extents.z + 1.0e-3f);
+			for (uint32_t s = part.firstSubMesh; s < part.firstSubMesh + part.nrOfSubMeshes; ++s)
+			{
+				const SubMeshInfo& sub = serial.finishedSubMeshes[s];
+				for (std::size_t i = sub.startIndexValue; i < sub.startIndexValue + sub.nrOfIndicesInSubMesh; ++i)
+				{
+					outsideBounds += box.Contains(XMLoadFloat3(&serial.vertices[serial.indexData[i]].Position)) == DISJOINT ? 1 : 0;
+				}
+			}
+		}
+
+		char line[320];
+		std::snprintf(line, sizeof(line), "  %zu parts in %zu submeshes%s%s", serial.parts.size(), serial.finishedSubMeshes.size(),
+			serial.parts.size() == PARTS_PER_SIDE * PARTS_PER_SIDE && partsMatch ? "" : "  MISMATCH between serial and parallel parts",
+			outsideBounds == 0 ? "" : "  MISMATCH vertices outside their part bounds");
+		Report(line);
+
+		// Views from inside the block looking out over a corner, so most parts are out of view
+		BoundingBox localBox;
+		BoundingBox::CreateFromPoints(localBox, serial.vertices.size(), &serial.vertices[0].Position, sizeof(Vertex));
+		const XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f);
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		const std::size_t nrOfTriangles = serial.indexData.size() / 3;
+		std::size_t objectTriangles = 0;
+		std::size_t partTriangles = 0;
+		double cullSeconds = 0.0;
+		std::vector<uint8_t> visibleParts;
+		for (int v = 0; v < NR_OF_VIEWS; ++v)
+		{
+			const XMVECTOR eye = XMVectorSet(unit(random) * 60.0f, 5.0f + unit(random) * 20.0f, unit(random) * 60.0f, 0.0f);
+			const XMVECTOR target = XMVectorSubtract(eye, XMVectorSet(0.5f + unit(random), 0.2f, 0.5f + unit(random), 0.0f));
+			BoundingFrustum frustum(projection);
+			frustum.Transform(frustum, XMMatrixInverse(nullptr, XMMatrixLookAtLH(eye, target, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f))));
+
+			if (!frustum.Intersects(localBox))
+				continue;
+			objectTriangles += nrOfTriangles;
+
+			auto start = std::chrono::high_resolution_clock::now();
+			MeshParts::Cull(serial.parts, XMMatrixIdentity(), frustum, visibleParts);
+			cullSeconds += SecondsSince(start);
+
+			for (std::size_t p = 0; p < serial.parts.size(); ++p)
+			{
+				const MeshPart& part = serial.parts[p];
+				for (uint32_t s = part.firstSubMesh; visibleParts[p] && s < part.firstSubMesh + part.nrOfSubMeshes; ++s)
+				{
+					partTriangles += serial.finishedSubMeshes[s].nrOfIndicesInSubMesh / 3;
+				}
+			}
+		}
+
+		std::snprintf(line, sizeof(line), "  triangles/view %.0f -> %.0f (%.0f%%), CPU/view %.2f us",
+			static_cast<double>(objectTriangles) / NR_OF_VIEWS, static_cast<double>(partTriangles) / NR_OF_VIEWS,
+			objectTriangles > 0 ? 100.0 * partTriangles / objectTriangles : 0.0, cullSeconds * 1.0e6 / NR_OF_VIEWS);
+		Report(line);
+	}
+
+	// Scattered props over a 1 km square, sized like the demo's objects
+	const BoundingBox SCENE_BOUNDS(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(500.0f, 50.0f, 500.0f));
+
+	std::vector<BoundingBox> MakeSceneBoxes(std::size_t count, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> position(-495.0f, 495.0f);
+		std::uniform_real_distribution<float> height(0.0f, 20.0f);
+		std::uniform_real_distribution<float> size(0.5f, 4.0f);
+
+		std::vector<BoundingBox> boxes(count);
+		for (BoundingBox& box : boxes)
+		{
+			box.Center = XMFLOAT3(position(random), height(random), position(random));
+			box.Extents = XMFLOAT3(size(random), size(random), size(random));
+		}
+		return boxes;
+	}
+
+	// Views from walking height in random directions, reaching 300 m
+	std::vector<BoundingFrustum> MakeSceneFrustums(std::size_t count, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> position(-450.0f, 450.0f);
+		std::uniform_real_distribution<float> angle(0.0f, XM_2PI);
+		const XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 300.0f);
+
+		std::vector<BoundingFrustum> frustums(count);
+		for (BoundingFrustum& frustum : frustums)
+		{
+			const XMVECTOR eye = XMVectorSet(position(random), 2.0f, position(random), 1.0f);
+			const float yaw = angle(random);
+			const XMVECTOR direction = XMVectorSet(std::sin(yaw), -0.1f, std::cos(yaw), 0.0f);
+			BoundingFrustum local(projection);
+			local.Transform(frustum, XMMatrixInverse(nullptr, XMMatrixLookToLH(eye, direction, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f))));
+		}
+		return frustums;
+	}
+
+	// The per-frame rebuild Main does (Clear, an Insert per object, Query) with the sort on one
+	// thread and on all of them, and the query against testing every box
+	void BenchmarkQuadTree()
+	{
+		Report("QuadTree (per-frame rebuild and frustum query, depth 5, 8 per node)");
+
+		constexpr int NR_OF_FRAMES = 32;
+		std::mt19937 random(4321);
+		const std::vector<BoundingFrustum> frustums = MakeSceneFrustums(NR_OF_FRAMES, random);
+
+		for (std::size_t count : { std::size_t{ 1000 }, std::size_t{ 10000 }, std::size_t{ 100000 } })
+		{
+			const std::vector<BoundingBox> boxes = MakeSceneBoxes(count, random);
+			QuadTree<uint32_t, 5, 8> tree(SCENE_BOUNDS);
+			tree.Reserve(count);
+
+			double buildSeconds[2] = {};
+			double querySeconds = 0.0;
+			double bruteForceSeconds = 0.0;
+			std::size_t visible = 0;
+			bool matches = true;
+			std::vector<uint32_t> result;
+			std::vector<uint32_t> expected;
+
+			for (int frame = 0; frame < NR_OF_FRAMES; ++frame)
+			{
+				for (int threads = 0; threads < 2; ++threads)
+				{
+					auto start = std::chrono::high_resolution_clock::now();
+					tree.Clear();
+					for (uint32_t i = 0; i < count; ++i)
+					{
+						tree.Insert(i, boxes[i]);
+					}
+					tree.Build(threads == 0 ? 1 : 0);
+					buildSeconds[threads] += SecondsSince(start);
+				}
+
+				auto start = std::chrono::high_resolution_clock::now();
+				tree.Query(frustums[frame], result);
+				querySeconds += SecondsSince(start);
+
+				start = std::chrono::high_resolution_clock::now();
+				expected.clear();
+				for (uint32_t i = 0; i < count; ++i)
+				{
+					if (frustums[frame].Intersects(boxes[i]))
+					{
+						expected.push_back(i);
+					}
+				}
+				bruteForceSeconds += SecondsSince(start);
+
+				visible += result.size();
+				std::sort(result.begin(), result.end());
+				matches = matches && result == expected;
+			}
+
+			char line[256];
+			std::snprintf(line, sizeof(line), "  %6zu elements: build %.3f ms (1 thread) %.3f ms (all), query %.1f us, every box %.1f us, %.0f visible%s",
+				count, buildSeconds[0] * 1000.0 / NR_OF_FRAMES, buildSeconds[1] * 1000.0 / NR_OF_FRAMES,
+				querySeconds * 1.0e6 / NR_OF_FRAMES, bruteForceSeconds * 1.0e6 / NR_OF_FRAMES,
+				static_cast<double>(visible) / NR_OF_FRAMES, matches ? "" : "  MISMATCH");
+			Report(line);
+		}
+	}
+
+	// Views from 400 m up looking straight down, which hold whole nodes from ground to sky
+	std::vector<BoundingFrustum> MakeOverheadFrustums(std::size_t count, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> position(-350.0f, 350.0f);
+		const XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 600.0f);
+
+		std::vector<BoundingFrustum> frustums(count);
+		for (BoundingFrustum& frustum : frustums)
+		{
+			const XMVECTOR eye = XMVectorSet(position(random), 400.0f, position(random), 1.0f);
+			BoundingFrustum local(projection);
+			local.Transform(frustum, XMMatrixInverse(nullptr,
+				XMMatrixLookToLH(eye, XMVectorSet(0.0f, -1.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f))));
+		}
+		return frustums;
+	}
+
+	// Query alone on a built tree, for views that cut through many nodes and for views that hold
+	// many nodes whole, whose elements are reported without being tested
+	void BenchmarkQuadTreeQuery()
+	{
+		Report("QuadTree query (built once, depth 5, 8 per node)");
+
+		constexpr int NR_OF_VIEWS = 64;
+		std::mt19937 random(2468);
+		const std::vector<BoundingFrustum> viewSets[2] = { MakeSceneFrustums(NR_OF_VIEWS, random), MakeOverheadFrustums(NR_OF_VIEWS, random) };
+		const char* viewNames[2] = { "walking", "overhead" };
+
+		for (std::size_t count : { std::size_t{ 1000 }, std::size_t{ 10000 }, std::size_t{ 100000 } })
+		{
+			const std::vector<BoundingBox> boxes = MakeSceneBoxes(count, random);
+			QuadTree<uint32_t, 5, 8> tree(SCENE_BOUNDS);
+			tree.Reserve(count);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				tree.Insert(i, boxes[i]);
+			}
+			tree.Build();
+
+			for (int set = 0; set < 2; ++set)
+			{
+				double querySeconds = 0.0;
+				double bruteForceSeconds = 0.0;
+				std::size_t visible = 0;
+				bool matches = true;
+				std::vector<uint32_t> result;
+				std::vector<uint32_t> expected;
+
+				for (const BoundingFrustum& frustum : viewSets[set])
+				{
+					auto start = std::chrono::high_resolution_clock::now();
+					tree.Query(frustum, result);
+					querySeconds += SecondsSince(start);
+
+					start = std::chrono::high_resolution_clock::now();
+					expected.clear();
+					for (uint32_t i = 0; i < count; ++i)
+					{
+						if (frustum.Intersects(boxes[i]))
+						{
+							expected.push_back(i);
+						}
+					}
+					bruteForceSeconds += SecondsSince(start);
+
+					visible += result.size();
+					std::sort(result.begin(), result.end());
+					matches = matches && result == expected;
+				}
+
+				char line[256];
+				std::snprintf(line, sizeof(line), "  %6zu elements, %-8s views: query %.1f us, every box %.1f us, %.0f visible%s",
+					count, viewNames[set], querySeconds * 1.0e6 / NR_OF_VIEWS, bruteForceSeconds * 1.0e6 / NR_OF_VIEWS,
+					static_cast<double>(visible) / NR_OF_VIEWS, matches ? "" : "  MISMATCH");
+				Report(line);
+			}
+		}
+	}
+
+	// 100k static props with a few moving each frame: the QuadTree rebuilt from scratch, as Main did,
+	// against the LooseQuadTree updating only the moved elements, and both queries against testing
+	// every box
+	void BenchmarkLooseQuadTree()
+	{
+		Report("LooseQuadTree (100000 props, moving elements updated per frame, depth 5)");
+
+		constexpr int NR_OF_FRAMES = 32;
+		constexpr std::size_t NR_OF_ELEMENTS = 100000;
+		std::mt19937 random(8765);
+		const std::vector<BoundingFrustum> frustums = MakeSceneFrustums(NR_OF_FRAMES, random);
+		std::uniform_real_distribution<float> step(-2.0f, 2.0f);
+
+		for (std::size_t nrOfMoving : { std::size_t{ 3 }, std::size_t{ 300 }, std::size_t{ 3000 } })
+		{
+			std::vector<BoundingBox> boxes = MakeSceneBoxes(NR_OF_ELEMENTS, random);
+			QuadTree<uint32_t, 5, 8> rebuiltTree(SCENE_BOUNDS);
+			rebuiltTree.Reserve(NR_OF_ELEMENTS);
+			LooseQuadTree<uint32_t, 5> looseTree(SCENE_BOUNDS);
+			looseTree.Reserve(NR_OF_ELEMENTS);
+
+			std::vector<LooseQuadTreeHandle> handles;
+			handles.reserve(NR_OF_ELEMENTS);
+			for (uint32_t i = 0; i < NR_OF_ELEMENTS; ++i)
+			{
+				handles.push_back(looseTree.Insert(i, boxes[i]));
+			}
+
+			double rebuildSeconds = 0.0;
+			double updateSeconds = 0.0;
+			double querySeconds[2] = {};
+			bool matches = true;
+			std::vector<uint32_t> result;
+			std::vector<uint32_t> expected;
+
+			for (int frame = 0; frame < NR_OF_FRAMES; ++frame)
+			{
+				// The first elements wander a few metres a frame, sometimes out of the world
+				for (std::size_t i = 0; i < nrOfMoving; ++i)
+				{
+					boxes[i].Center.x += step(random);
+					boxes[i].Center.z += step(random);
+				}
+
+				auto start = std::chrono::high_resolution_clock::now();
+				rebuiltTree.Clear();
+				for (uint32_t i = 0; i < NR_OF_ELEMENTS; ++i)
+				{
+					rebuiltTree.Insert(i, boxes[i]);
+				}
+				rebuiltTree.Build();
+				rebuildSeconds += SecondsSince(start);
+
+				start = std::chrono::high_resolution_clock::now();
+				for (std::size_t i = 0; i < nrOfMoving; ++i)
+				{
+					looseTree.Update(handles[i], boxes[i]);
+				}
+				updateSeconds += SecondsSince(start);
+
+				expected.clear();
+				for (uint32_t i = 0; i < NR_OF_ELEMENTS; ++i)
+				{
+					if (frustums[frame].Intersects(boxes[i]))
+					{
+						expected.push_back(i);
+					}
+				}
+
+				start = std::chrono::high_resolution_clock::now();
+				rebuiltTree.Query(frustums[frame], result);
+				querySeconds[0] += SecondsSince(start);
+				std::sort(result.begin(), result.end());
+				matches = matches && result == expected;
+
+				start = std::chrono::high_resolution_clock::now();
+				looseTree.Query(frustums[frame], result);
+				querySeconds[1] += SecondsSince(start);
+				std::sort(result.begin(), result.end());
+				matches = matches && result == expected;
+			}
+
+			char line[256];
+			std::snprintf(line, sizeof(line), "  %4zu moving: rebuild %.3f ms, update %.1f us; query %.1f us (QuadTree) %.1f us (loose)%s",
+				nrOfMoving, rebuildSeconds * 1000.0 / NR_OF_FRAMES, updateSeconds * 1.0e6 / NR_OF_FRAMES,
+				querySeconds[0] * 1.0e6 / NR_OF_FRAMES, querySeconds[1] * 1.0e6 / NR_OF_FRAMES, matches ? "" : "  MISMATCH");
+			Report(line);
+		}
+	}
+
+	// Each kernel against BoundingFrustum::Intersects on the same boxes: all kernels must keep the
+	// same boxes, those must include every box Intersects accepts, and CullExact must give exactly
+	// what Intersects does
+	void BenchmarkFrustumCulling()
+	{
+		constexpr std::size_t NR_OF_BOXES = 100000;
+		constexpr int NR_OF_VIEWS = 64;
+		Report("Frustum culling (100000 boxes, SoA kernels against BoundingFrustum::Intersects)");
+
+		std::mt19937 random(1357);
+		const std::vector<BoundingBox> boxes = MakeSceneBoxes(NR_OF_BOXES, random);
+		const std::vector<BoundingFrustum> frustums = MakeSceneFrustums(NR_OF_VIEWS, random);
+		BoundingBoxArray boxArray;
+		boxArray.Reserve(NR_OF_BOXES);
+		for (const BoundingBox& box : boxes)
+		{
+			boxArray.Add(box);
+		}
+
+		std::vector<CullingPlanes> planes;
+		for (const BoundingFrustum& frustum : frustums)
+		{
+			planes.push_back(FrustumCulling::GetPlanes(frustum));
+		}
+
+		const double nrOfTests = static_cast<double>(NR_OF_BOXES) * NR_OF_VIEWS;
+		std::vector<std::vector<uint32_t>> expected(NR_OF_VIEWS);
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int v = 0; v < NR_OF_VIEWS; ++v)
+		{
+			for (uint32_t i = 0; i < NR_OF_BOXES; ++i)
+			{
+				if (frustums[v].Intersects(boxes[i]))
+				{
+					expected[v].push_back(i);
+				}
+			}
+		}
+		Report(FormatRate("BoundingFrustum::Intersects", nrOfTests, SecondsSince(start), "boxes"));
+
+		const std::pair<CullingKernel, const char*> kernels[] = {
+			{ CullingKernel::Scalar, "scalar" }, { CullingKernel::SSE, "SSE" }, { CullingKernel::AVX2, "AVX2" } };
+		std::vector<std::vector<uint32_t>> scalarResults(NR_OF_VIEWS);
+		std::vector<uint32_t> visible;
+		std::size_t nrOfPlanesVisible = 0;
+		std::size_t nrOfVisible = 0;
+		bool matches = true;
+
+		for (const auto& [kernel, name] : kernels)
+		{
+			if (!FrustumCulling::IsSupported(kernel))
+			{
+				Report(std::string("  ") + name + " not supported on this CPU");
+				continue;
+			}
+
+			double seconds = 0.0;
+			for (int v = 0; v < NR_OF_VIEWS; ++v)
+			{
+				visible.clear();
+				start = std::chrono::high_resolution_clock::now();
+				FrustumCulling::Cull(planes[v], boxArray, 0, NR_OF_BOXES, visible, kernel);
+				seconds += SecondsSince(start);
+
+				if (kernel == CullingKernel::Scalar)
+				{
+					scalarResults[v] = visible;
+					nrOfPlanesVisible += visible.size();
+					matches = matches && std::includes(visible.begin(), visible.end(), expected[v].begin(), expected[v].end());
+				}
+				matches = matches && visible == scalarResults[v];
+			}
+			Report(FormatRate(name, nrOfTests, seconds, "boxes"));
+
+			seconds = 0.0;
+			for (int v = 0; v < NR_OF_VIEWS; ++v)
+			{
+				visible.clear();
+				start = std::chrono::high_resolution_clock::now();
+				FrustumCulling::CullExact(frustums[v], planes[v], boxArray, 0, NR_OF_BOXES, visible, kernel);
+				seconds += SecondsSince(start);
+
+				std::sort(visible.begin(), visible.end());
+				matches = matches && visible == expected[v];
+				nrOfVisible += kernel == CullingKernel::Scalar ? visible.size() : 0;
+			}
+			Report(FormatRate((std::string(name) + " exact").c_str(), nrOfTests, seconds, "boxes"));
+		}
+
+		char line[256];
+		std::snprintf(line, sizeof(line), "  visible/view %.1f, %.1f more kept by the planes alone%s",
+			static_cast<double>(nrOfVisible) / NR_OF_VIEWS, static_cast<double>(nrOfPlanesVisible - nrOfVisible) / NR_OF_VIEWS,
+			matches ? "" : "  MISMATCH");
+		Report(line);
+	}
+
+	// Triangles and error of every generated level, and the distance at which it would be drawn
+	// on a 1080p screen with a 45 degree field of view, in multiples of the mesh's bounding radius
+	void BenchmarkMeshLODs()
+	{
+		Report("Mesh LODs (triangles, error and switch distance per level)");
+
+		const OBJImportSettings previousSettings = objImportSettings;
+		objImportSettings.generateLODs = false;
+		const float projectionScale = 1080.0f / (2.0f * std::tan(XM_PIDIV4 * 0.5f));
+
+		auto Simplify = [&](const std::string& label, std::string_view objContents)
+			{
+				ParseData data;
+				ParseOBJContents(objContents, data);
+				if (data.indexData.empty())
+					return;
+
+				BoundingSphere bounds;
+				BoundingSphere::CreateFromPoints(bounds, data.vertices.size(), &data.vertices[0].Position, sizeof(Vertex));
+				const float radius = (std::max)(bounds.Radius, 1.0e-6f);
+
+				const std::size_t fullTriangles = data.indexData.size() / 3;
+				auto start = std::chrono::high_resolution_clock::now();
+				MeshSimplifier::GenerateLODs(data.vertices, data.indexData, data.finishedSubMeshes, data.lods);
+				const double seconds = SecondsSince(start);
+
+				char line[512];
+				int length = std::snprintf(line, sizeof(line), "  %-28s %zu triangles, %.1f ms:", label.c_str(), fullTriangles, seconds * 1000.0);
+				for (const MeshLOD& lod : data.lods)
+				{
+					std::size_t triangles = 0;
+					for (const MeshDrawRange& range : lod.ranges)
+					{
+						triangles += range.nrOfIndices / 3;
+					}
+
+					// One pixel of error at this distance
+					const float switchDistance = lod.error * projectionScale;
+					length += std::snprintf(line + length, sizeof(line) - length, " %zu (%.0f%%) err %.4f%% at %.1fr;",
+						triangles, 100.0 * triangles / fullTriangles, 100.0 * lod.error / radius, switchDistance / radius);
+					if (length >= static_cast<int>(sizeof(line)))
+						break;
+				}
+				Report(line);
+			};
+
+		ForEachSampleOBJ(Simplify);
+
+		objImportSettings = previousSettings;
+	}
+
+	// Tangent generation on one thread against every hardware thread, which must agree bit for
+	// bit. Every frame must be unit length, orthogonal to its normal and carry a sign of +-1. On
+	// the normal mapped cubes, whose faces are flat, the tangent and bitangent of every corner
+	// must also follow the face's dP/du and dP/dv exactly.
+	void BenchmarkTangents()
+	{
+		Report("Tangent generation (1 thread vs all threads, frame checks)");
+
+		const OBJImportSettings previousSettings = objImportSettings;
+		objImportSettings.generateTangents = false;
+		objImportSettings.generateLODs = false;
+		const unsigned int hardwareThreads = (std::max)(1u, std::thread::hardware_concurrency());
+
+		auto Generate = [&](const std::string& label, std::string_view objContents, bool checkFaceFrames)
+			{
+				ParseData data;
+				ParseOBJContents(objContents, data);
+				if (data.indexData.empty())
+					return;
+
+				const std::size_t sourceVertices = data.vertices.size();
+				std::vector<Vertex> serialVertices = data.vertices;
+				std::vector<unsigned int> serialIndices = data.indexData;
+				std::vector<XMFLOAT4> serialTangents;
+				auto start = std::chrono::high_resolution_clock::now();
+				TangentGenerator::Generate(serialVertices, serialIndices, serialTangents, 1);
+				const double serialSeconds = SecondsSince(start);
+
+				std::vector<XMFLOAT4> tangents;
+				start = std::chrono::high_resolution_clock::now();
+				TangentGenerator::Generate(data.vertices, data.indexData, tangents, hardwareThreads);
+				const double parallelSeconds = SecondsSince(start);
+
+				const bool deterministic = serialIndices == data.indexData && serialTangents.size() == tangents.size() &&
+					std::memcmp(serialVertices.data(), data.vertices.data(), serialVertices.size() * sizeof(Vertex)) == 0 &&
+					std::memcmp(serialTangents.data(), tangents.data(), tangents.size() * sizeof(XMFLOAT4)) == 0;
+
+				std::size_t badFrames = 0;
+				for (std::size_t v = 0; v < tangents.size(); ++v)
+				{
+					const XMVECTOR normal = XMVector3Normalize(XMLoadFloat3(&data.vertices[v].Normal));
+					const XMVECTOR tangent = XMLoadFloat4(&tangents[v]);
+					if (std::fabs(XMVectorGetX(XMVector3Length(tangent)) - 1.0f) > 1.0e-4f ||
+						std::fabs(XMVectorGetX(XMVector3Dot(normal, tangent))) > 1.0e-3f ||
+						std::fabs(tangents[v].w) != 1.0f)
+					{
+						++badFrames;
+					}
+				}
+
+				std::size_t badCorners = 0;
+				for (std::size_t t = 0; checkFaceFrames && t < data.indexData.size() / 3; ++t)
+				{
+					const Vertex& v0 = data.vertices[data.indexData[t * 3]];
+					const Vertex& v1 = data.vertices[data.indexData[t * 3 + 1]];
+					const Vertex& v2 = data.vertices[data.indexData[t * 3 + 2]];
+					const XMVECTOR d1 = XMVectorSubtract(XMLoadFloat3(&v1.Position), XMLoadFloat3(&v0.Position));
+					const XMVECTOR d2 = XMVectorSubtract(XMLoadFloat3(&v2.Position), XMLoadFloat3(&v0.Position));
+					const float t21x = v1.UV.x - v0.UV.x, t21y = v1.UV.y - v0.UV.y;
+					const float t31x = v2.UV.x - v0.UV.x, t31y = v2.UV.y - v0.UV.y;
+					const float signedArea = t21x * t31y - t21y * t31x;
+					if (signedArea == 0.0f)
+						continue;
+
+					const XMVECTOR dPdu = XMVector3Normalize(XMVectorScale(XMVectorSubtract(XMVectorScale(d1, t31y), XMVectorScale(d2, t21y)), 1.0f / signedArea));
+					const XMVECTOR dPdv = XMVector3Normalize(XMVectorScale(XMVectorSubtract(XMVectorScale(d2, t21x), XMVectorScale(d1, t31x)), 1.0f / signedArea));
+					for (std::size_t corner = 0; corner < 3; ++corner)
+					{
+						const unsigned int v = data.indexData[t * 3 + corner];
+						const XMVECTOR normal = XMVector3Normalize(XMLoadFloat3(&data.vertices[v].Normal));
+						const XMVECTOR tangent = XMLoadFloat4(&tangents[v]);
+						const XMVECTOR bitangent = XMVectorScale(XMVector3Cross(normal, tangent), tangents[v].w);
+						if (XMVectorGetX(XMVector3Dot(tangent, dPdu)) < 0.999f || XMVectorGetX(XMVector3Dot(bitangent, dPdv)) < 0.999f)
+							++badCorners;
+					}
+				}
+
+				char line[256];
+				std::snprintf(line, sizeof(line), "  %-28s %zu triangles, %zu -> %zu vertices, 1 thread %.2f ms, %u threads %.2f ms%s%s%s",
+					label.c_str(), data.indexData.size() / 3, sourceVertices, data.vertices.size(), serialSeconds * 1000.0,
+					hardwareThreads, parallelSeconds * 1000.0, deterministic ? "" : " NONDETERMINISTIC",
+					badFrames == 0 ? "" : " BAD FRAMES", badCorners == 0 ? "" : " MISMATCH");
+				Report(line);
+			};
+
+		ForEachSampleOBJ([&](const std::string& label, std::string_view objContents)
+			{
+				Generate(label, objContents,
+					label == "NormalCube.obj" || label == "SimpleCubeParallax.obj" || label == SAMPLE_GRID_LABEL);
+			});
+
+		objImportSettings = previousSettings;
+	}
+
+	// Round trip of every mesh in objects/ and the sample grid through both packed layouts,
+	// checked against the documented error bounds
+	void BenchmarkVertexPacking()
+	{
+		Report("Vertex packing (max reconstruction error vs bound)");
+
+		ForEachSampleOBJ([](const std::string& label, std::string_view objContents)
+			{
+				ParseData data;
+				ParseOBJContents(objContents, data);
+
+				for (bool quantizePositions : { false, true })
+				{
+					VertexPackingOptions options;
+					options.quantizePositions = quantizePositions;
+					const PackedVertexFormat format = VertexPacking::ChooseFormat(data.vertices.data(), data.vertices.size(), options);
+					const VertexPackingErrorBounds bounds = VertexPacking::GetErrorBounds(format);
+
+					std::vector<unsigned char> packed;
+					auto start = std::chrono::high_resolution_clock::now();
+					VertexPacking::Pack(data.vertices.data(), data.vertices.size(), format, packed);
+					const double seconds = SecondsSince(start);
+
+					double positionError = 0.0;
+					double normalError = 0.0;
+					double texCoordError = 0.0;
+					for (size_t i = 0; i < data.vertices.size(); ++i)
+					{
+						const Vertex& original = data.vertices[i];
+						const Vertex decoded = VertexPacking::Unpack(packed.data() + i * format.GetStride(), format);
+
+						positionError = (std::max)({ positionError,
+							std::fabs(static_cast<double>(decoded.Position.x) - original.Position.x),
+							std::fabs(static_cast<double>(decoded.Position.y) - original.Position.y),
+							std::fabs(static_cast<double>(decoded.Position.z) - original.Position.z) });
+						texCoordError = (std::max)({ texCoordError,
+							std::fabs(static_cast<double>(decoded.UV.x) - original.UV.x),
+							std::fabs(static_cast<double>(decoded.UV.y) - original.UV.y) });
+
+						// Angle through atan2 of cross and dot, acos loses the small angles to rounding
+						const double nx = original.Normal.x, ny = original.Normal.y, nz = original.Normal.z;
+						if (nx * nx + ny * ny + nz * nz > 0.0)
+						{
+							const double cx = ny * decoded.Normal.z - nz * decoded.Normal.y;
+							const double cy = nz * decoded.Normal.x - nx * decoded.Normal.z;
+							const double cz = nx * decoded.Normal.y - ny * decoded.Normal.x;
+							const double dot = nx * decoded.Normal.x + ny * decoded.Normal.y + nz * decoded.Normal.z;
+							normalError = (std::max)(normalError, std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), dot) * 180.0 / 3.14159265358979);
+						}
+					}
+
+					const bool withinBounds = positionError <= bounds.position && normalError <= bounds.normalDegrees &&
+						texCoordError <= bounds.texCoord;
+
+					char line[320];
+					std::snprintf(line, sizeof(line), "  %-22s %2zu B/vertex: position %.2e (%.2e), normal %.4f deg (%.4f), uv %.2e (%.2e) %s, %.2f ms%s",
+						label.c_str(), format.GetStride(),
+						positionError, bounds.position, normalError, bounds.normalDegrees, texCoordError, bounds.texCoord,
+						format.unormTexCoords ? "unorm" : "half", seconds * 1000.0, withinBounds ? "" : "  EXCEEDS BOUND");
+					Report(line);
+				}
+			});
+	}
+
+	// CPU side of the startup mesh loads: one after another versus RequestMesh on the loader pool
+	void BenchmarkAsyncImport()
+	{
+		Report("Startup mesh import (sequential vs loader pool)");
+
+		std::vector<std::string> meshFiles;
+		for (const auto& entry : std::filesystem::directory_iterator(defaultDirectory))
+		{
+			if (entry.path().extension() == ".obj")
+				meshFiles.push_back(entry.path().filename().string());
+		}
+
+		// Start both runs without decoded images shared through the texture cache
+		textureCache.Clear();
+
+		size_t sequentialImages = 0;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (const std::string& file : meshFiles)
+		{
+			try
+			{
+				sequentialImages += ImportMesh(file)->images.size();
+			}
+			catch (const std::exception&)
+			{
+			}
+		}
+		const double sequentialSeconds = SecondsSince(start);
+
+		textureCache.Clear();
+
+		size_t pooledImages = 0;
+		start = std::chrono::high_resolution_clock::now();
+		std::vector<MeshRequest> requests;
+		for (const std::string& file : meshFiles)
+		{
+			requests.push_back(RequestMesh(file));
+		}
+		for (MeshRequest& request : requests)
+		{
+			try
+			{
+				pooledImages += request.pending.get()->images.size();
+			}
+			catch (const std::exception&)
+			{
+			}
+		}
+		const double pooledSeconds = SecondsSince(start);
+		textureCache.Clear();
+
+		char line[256];
+		std::snprintf(line, sizeof(line), "  %zu meshes, %zu textures: sequential %.2f ms, pool %.2f ms (%.1fx)%s",
+			meshFiles.size(), sequentialImages, sequentialSeconds * 1000.0, pooledSeconds * 1000.0,
+			sequentialSeconds / pooledSeconds, sequentialImages == pooledImages ? "" : "  MISMATCH");
+		Report(line);
+	}
+
+	// Synthetic 2K content: a one-texel black/white checker and a bumpy normal map
+	ImageData MakeTestImage(int size, MipContent content)
+	{
+		ImageData image;
+		image.width = size;
+		image.height = size;
+		image.pixels.resize(static_cast<size_t>(size) * size * 4);
+
+		for (int y = 0; y < size; ++y)
+		{
+			for (int x = 0; x < size; ++x)
+			{
+				unsigned char* texel = image.pixels.data() + (static_cast<size_t>(y) * size + x) * 4;
+				if (content == MipContent::Normal)
+				{
+					float nx = 0.6f * std::sin(x * 0.05f);
+					float ny = 0.6f * std::cos(y * 0.07f);
+					float nz = std::sqrt((std::max)(0.0f, 1.0f - nx * nx - ny * ny));
+					texel[0] = static_cast<unsigned char>((nx * 0.5f + 0.5f) * 255.0f + 0.5f);
+					texel[1] = static_cast<unsigned char>((ny * 0.5f + 0.5f) * 255.0f + 0.5f);
+					texel[2] = static_cast<unsigned char>((nz * 0.5f + 0.5f) * 255.0f + 0.5f);
+				}
+				else
+				{
+					unsigned char value = ((x + y) & 1) ? 255 : 0;
+					texel[0] = texel[1] = texel[2] = value;
+				}
+				texel[3] = 255;
+			}
+		}
+		return image;
+	}
+
+	// Largest deviation from unit length over all generated levels of a normal map
+	float MaxNormalLengthError(const ImageData& image)
+	{
+		float maxError = 0.0f;
+		for (int level = 1; level < image.mipLevels; ++level)
+		{
+			const unsigned char* texels = image.pixels.data() + image.GetLevelOffset(level);
+			const size_t nrOfTexels = static_cast<size_t>(image.GetLevelWidth(level)) * image.GetLevelHeight(level);
+			for (size_t i = 0; i < nrOfTexels; ++i)
+			{
+				float nx = texels[i * 4 + 0] / 127.5f - 1.0f;
+				float ny = texels[i * 4 + 1] / 127.5f - 1.0f;
+				float nz = texels[i * 4 + 2] / 127.5f - 1.0f;
+				maxError = (std::max)(maxError, std::fabs(std::sqrt(nx * nx + ny * ny + nz * nz) - 1.0f));
+			}
+		}
+		return maxError;
+	}
+
+	void BenchmarkMipGeneration()
+	{
+		Report("Mip chain generation (2048x2048 RGBA8)");
+
+		const int size = 2048;
+		const struct { const char* name; MipContent content; } contents[] = {
+			{ "color", MipContent::Color }, { "normal", MipContent::Normal }, { "data", MipContent::Data } };
+		const struct { const char* name; MipFilter filter; } filters[] = {
+			{ "box", MipFilter::Box }, { "lanczos", MipFilter::Lanczos } };
+
+		for (const auto& content : contents)
+		{
+			const ImageData source = MakeTestImage(size, content.content);
+			for (const auto& filter : filters)
+			{
+				ImageData image = source;
+				auto start = std::chrono::high_resolution_clock::now();
+				MipGenerator::GenerateMips(image, content.content, filter.filter);
+				const double seconds = SecondsSince(start);
+
+				char label[64];
+				std::snprintf(label, sizeof(label), "%s, %s (%d levels)", content.name, filter.name, image.mipLevels);
+				Report(FormatRate(label, static_cast<double>(size) * size, seconds, "texels"));
+
+				if (content.content == MipContent::Color)
+				{
+					// A black/white checker is 50% linear light, which is 188 in sRGB (a gamma-naive average gives 128)
+					int level1 = image.pixels[image.GetLevelOffset(1)];
+					char line[128];
+					std::snprintf(line, sizeof(line), "    checker level 1 = %d (188 is 50%% linear light, 128 would be gamma-naive)", level1);
+					Report(line);
+				}
+				else if (content.content == MipContent::Normal)
+				{
+					char line[128];
+					std::snprintf(line, sizeof(line), "    max |length - 1| over levels = %.4f", MaxNormalLengthError(image));
+					Report(line);
+				}
+			}
+		}
+	}
+
+	// PSNR in dB over the first nrOfChannels channels of two RGBA8 levels
+	double ComputePSNR(const std::vector<unsigned char>& reference, const unsigned char* decoded, int nrOfChannels)
+	{
+		double squaredError = 0.0;
+		size_t nrOfSamples = 0;
+		for (size_t i = 0; i < reference.size(); i += 4)
+		{
+			for (int c = 0; c < nrOfChannels; ++c)
+			{
+				double difference = static_cast<double>(reference[i + c]) - decoded[i + c];
+				squaredError += difference * difference;
+				++nrOfSamples;
+			}
+		}
+
+		if (squaredError == 0.0)
+			return 99.0;
+
+		return 10.0 * std::log10(255.0 * 255.0 / (squaredError / nrOfSamples));
+	}
+
+	// The brick textures when they are present, synthetic 2K content otherwise
+	ImageData LoadCompressionSource(const std::string& fileName, MipContent content)
+	{
+		ImageData image;
+		if (TextureLoader::DecodeImage(defaultDirectory + "../textures/" + fileName, image) &&
+			image.width % 4 == 0 && image.height % 4 == 0)
+		{
+			return image;
+		}
+
+		image = MakeTestImage(2048, content);
+		if (content == MipContent::Color)
+		{
+			// Smooth gradients with a little noise, closer to a photo than the checker
+			uint32_t noise = 12345;
+			for (int y = 0; y < image.height; ++y)
+			{
+				for (int x = 0; x < image.width; ++x)
+				{
+					noise = noise * 1664525u + 1013904223u;
+					unsigned char* texel = image.pixels.data() + (static_cast<size_t>(y) * image.width + x) * 4;
+					texel[0] = static_cast<unsigned char>((x * 255) / image.width);
+					texel[1] = static_cast<unsigned char>((y * 255) / image.height);
+					texel[2] = static_cast<unsigned char>(128 + ((noise >> 24) & 15));
+				}
+			}
+		}
+		return image;
+	}
+
+	void BenchmarkBlockCompression()
+	{
+		Report("Block compression (base level, RGBA8 input)");
+
+		ImageData color = LoadCompressionSource("Brick_Wall_Worn_sexkaitb_2K_BaseColor.jpg", MipContent::Color);
+		ImageData normal = LoadCompressionSource("Brick_Wall_Worn_sexkaitb_2K_Normal.jpg", MipContent::Normal);
+
+		// BC3 gets the color map with a diagonal alpha ramp
+		ImageData alpha = color;
+		for (int y = 0; y < alpha.height; ++y)
+		{
+			for (int x = 0; x < alpha.width; ++x)
+			{
+				alpha.pixels[(static_cast<size_t>(y) * alpha.width + x) * 4 + 3] =
+					static_cast<unsigned char>(((x + y) * 255) / (alpha.width + alpha.height));
+			}
+		}
+
+		const struct { const char* name; const ImageData* source; DXGI_FORMAT format; int nrOfChannels; } formats[] = {
+			{ "BC1 color (RGB)", &color, DXGI_FORMAT_BC1_UNORM, 3 },
+			{ "BC3 color+alpha (RGBA)", &alpha, DXGI_FORMAT_BC3_UNORM, 4 },
+			{ "BC5 normal (RG)", &normal, DXGI_FORMAT_BC5_UNORM, 2 } };
+
+		for (const auto& format : formats)
+		{
+			ImageData image = *format.source;
+			const double inputBytes = static_cast<double>(image.pixels.size());
+
+			auto start = std::chrono::high_resolution_clock::now();
+			bool compressed = BlockCompression::CompressImage(image, format.format);
+			const double seconds = SecondsSince(start);
+
+			if (!compressed)
+			{
+				Report(std::string("  ") + format.name + ": compression failed");
+				continue;
+			}
+
+			const std::vector<unsigned char> decoded = BlockCompression::DecompressLevel(image, 0);
+			const double psnr = ComputePSNR(format.source->pixels, decoded.data(), format.nrOfChannels);
+
+			char line[256];
+			std::snprintf(line, sizeof(line), "  %-28s %8.1f MB/s, PSNR %5.2f dB, %.1f MB -> %.1f MB (%.0fx)",
+				format.name, inputBytes / seconds / (1024.0 * 1024.0), psnr,
+				inputBytes / (1024.0 * 1024.0), image.pixels.size() / (1024.0 * 1024.0), inputBytes / image.pixels.size());
+			Report(line);
+		}
+
+		// Startup cost of one texture: decode, mips and encode versus loading the baked copy
+		const std::string imagePath = defaultDirectory + "../textures/Brick_Wall_Worn_sexkaitb_2K_BaseColor.jpg";
+		if (std::filesystem::exists(imagePath))
+		{
+			const std::string bakedPath = GetBakedTexturePath(imagePath, MipContent::Color);
+			std::remove(bakedPath.c_str());
+
+			ImageData image;
+			auto start = std::chrono::high_resolution_clock::now();
+			ImportTexture(imagePath, MipContent::Color, MipFilter::Lanczos, image);
+			const double importSeconds = SecondsSince(start);
+
+			start = std::chrono::high_resolution_clock::now();
+			ImageData baked;
+			bool loaded = ImportTexture(imagePath, MipContent::Color, MipFilter::Lanczos, baked);
+			const double loadSeconds = SecondsSince(start);
+
+			char line[256];
+			std::snprintf(line, sizeof(line), "  2K color map: decode+mips+encode %.1f ms, baked load %.2f ms (%.0fx), %.1f MB on the GPU%s",
+				importSeconds * 1000.0, loadSeconds * 1000.0, importSeconds / loadSeconds, baked.pixels.size() / (1024.0 * 1024.0),
+				loaded && baked.pixels == image.pixels ? "" : "  MISMATCH");
+			Report(line);
+		}
+	}
+}
+
+void RunBenchmarks()
+{
+	resultFile.open("benchmark_results.txt");
+
+	Report("===========================================");
+	Report("BENCHMARKS");
+	Report("===========================================");
+
+	BenchmarkVertexDedup();
+	BenchmarkParallelParse();
+	BenchmarkStreamingImport();
+	BenchmarkBakedLoad();
+	BenchmarkGLBImport();
+	BenchmarkGeometryDedup();
+	BenchmarkMaterialTable();
+	BenchmarkIndexCompression();
+	BenchmarkMeshCleanup();
+	BenchmarkMeshOptimization();
+	BenchmarkMeshletCulling();
+	BenchmarkMeshParts();
+	BenchmarkQuadTree();
+	BenchmarkQuadTreeQuery();
+	BenchmarkLooseQuadTree();
+	BenchmarkFrustumCulling();
+	BenchmarkMeshLODs();
+	BenchmarkTangents();
+	BenchmarkVertexPacking();
+	BenchmarkAsyncImport();
+	BenchmarkMipGeneration();
+	BenchmarkBlockCompression();
+
+	Report("===========================================");
+	resultFile.close();
+}
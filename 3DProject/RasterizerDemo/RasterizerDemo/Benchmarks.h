@@ -0,0 +1,5 @@
+#pragma once
+
+// CPU-side benchmarks for the asset pipeline, run with "RasterizerDemo.exe -benchmark".
+// Results go to the debugger output and to benchmark_results.txt in the working directory.
+void RunBenchmarks();
@@ -0,0 +1,490 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+	struct Color565
+	{
+		uint16_t packed;
+		float rgb[3];
+	};
+
+	Color565 QuantizeTo565(const float rgb[3])
+	{
+		int r = std::clamp(static_cast<int>(rgb[0] * (31.0f / 255.0f) + 0.5f), 0, 31);
+		int g = std::clamp(static_cast<int>(rgb[1] * (63.0f / 255.0f) + 0.5f), 0, 63);
+		int b = std::clamp(static_cast<int>(rgb[2] * (31.0f / 255.0f) + 0.5f), 0, 31);
+
+		Color565 color;
+		color.packed = static_cast<uint16_t>((r << 11) | (g << 5) | b);
+		color.rgb[0] = static_cast<float>((r << 3) | (r >> 2));
+		color.rgb[1] = static_cast<float>((g << 2) | (g >> 4));
+		color.rgb[2] = static_cast<float>((b << 3) | (b >> 2));
+		return color;
+	}
+
+	void Expand565(uint16_t packed, unsigned char* rgb)
+	{
+		int r = (packed >> 11) & 31;
+		int g = (packed >> 5) & 63;
+		int b = packed & 31;
+		rgb[0] = static_cast<unsigned char>((r << 3) | (r >> 2));
+		rgb[1] = static_cast<unsigned char>((g << 2) | (g >> 4));
+		rgb[2] = static_cast<unsigned char>((b << 3) | (b >> 2));
+	}
+
+	float DistanceSquared(const float* a, const float* b)
+	{
+		float dr = a[0] - b[0];
+		float dg = a[1] - b[1];
+		float db = a[2] - b[2];
+		return dr * dr + dg * dg + db * db;
+	}
+
+	// Pick the nearest of the four palette entries per texel, returns the total squared error
+	float SelectColorIndices(const float texels[16][3], const float palette[4][3], uint32_t& indices)
+	{
+		float totalError = 0.0f;
+		indices = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			int best = 0;
+			float bestError = DistanceSquared(texels[i], palette[0]);
+			for (int p = 1; p < 4; ++p)
+			{
+				float error = DistanceSquared(texels[i], palette[p]);
+				if (error < bestError)
+				{
+					bestError = error;
+					best = p;
+				}
+			}
+			indices |= static_cast<uint32_t>(best) << (i * 2);
+			totalError += bestError;
+		}
+		return totalError;
+	}
+
+	void BuildPalette(const Color565& c0, const Color565& c1, float palette[4][3])
+	{
+		for (int c = 0; c < 3; ++c)
+		{
+			palette[0][c] = c0.rgb[c];
+			palette[1][c] = c1.rgb[c];
+			palette[2][c] = (2.0f * c0.rgb[c] + c1.rgb[c]) / 3.0f;
+			palette[3][c] = (c0.rgb[c] + 2.0f * c1.rgb[c]) / 3.0f;
+		}
+	}
+
+	// Encode endpoints and indices, keeping the four-color ordering (color0 > color1)
+	float EncodeEndpoints(const float texels[16][3], const float endA[3], const float endB[3], uint16_t& color0, uint16_t& color1, uint32_t& indices)
+	{
+		Color565 c0 = QuantizeTo565(endA);
+		Color565 c1 = QuantizeTo565(endB);
+		if (c0.packed < c1.packed)
+		{
+			std::swap(c0, c1);
+		}
+
+		color0 = c0.packed;
+		color1 = c1.packed;
+		if (c0.packed == c1.packed)
+		{
+			// Single color, index 0 everywhere
+			indices = 0;
+			float error = 0.0f;
+			for (int i = 0; i < 16; ++i)
+			{
+				error += DistanceSquared(texels[i], c0.rgb);
+			}
+			return error;
+		}
+
+		float palette[4][3];
+		BuildPalette(c0, c1, palette);
+		return SelectColorIndices(texels, palette, indices);
+	}
+
+	// Color part of BC1/BC3: endpoints along the principal axis of the block's colors, inset
+	// slightly, then one least-squares refit of the endpoints to the chosen indices
+	void EncodeColorBlock(const unsigned char* rgba, unsigned char* output)
+	{
+		float texels[16][3];
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; ++i)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				texels[i][c] = rgba[i * 4 + c];
+				mean[c] += texels[i][c] / 16.0f;
+			}
+		}
+
+		float covariance[6] = {};
+		for (int i = 0; i < 16; ++i)
+		{
+			float r = texels[i][0] - mean[0];
+			float g = texels[i][1] - mean[1];
+			float b = texels[i][2] - mean[2];
+			covariance[0] += r * r;
+			covariance[1] += r * g;
+			covariance[2] += r * b;
+			covariance[3] += g * g;
+			covariance[4] += g * b;
+			covariance[5] += b * b;
+		}
+
+		// Power iteration for the dominant eigenvector
+		float axis[3] = { 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 8; ++iteration)
+		{
+			float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+			float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+			float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+			float length = std::sqrt(x * x + y * y + z * z);
+			if (length < 1e-6f)
+				break;
+
+			axis[0] = x / length;
+			axis[1] = y / length;
+			axis[2] = z / length;
+		}
+
+		float minProjection = 0.0f;
+		float maxProjection = 0.0f;
+		for (int i = 0; i < 16; ++i)
+		{
+			float projection = (texels[i][0] - mean[0]) * axis[0] + (texels[i][1] - mean[1]) * axis[1] + (texels[i][2] - mean[2]) * axis[2];
+			minProjection = (std::min)(minProjection, projection);
+			maxProjection = (std::max)(maxProjection, projection);
+		}
+
+		// Inset by 1/16 of the range, the extremes are rarely hit exactly after quantization
+		float inset = (maxProjection - minProjection) / 16.0f;
+		float endA[3];
+		float endB[3];
+		for (int c = 0; c < 3; ++c)
+		{
+			endA[c] = std::clamp(mean[c] + axis[c] * (maxProjection - inset), 0.0f, 255.0f);
+			endB[c] = std::clamp(mean[c] + axis[c] * (minProjection + inset), 0.0f, 255.0f);
+		}
+
+		uint16_t color0 = 0;
+		uint16_t color1 = 0;
+		uint32_t indices = 0;
+		float error = EncodeEndpoints(texels, endA, endB, color0, color1, indices);
+
+		// Least-squares fit of both endpoints to the selected palette weights
+		if (color0 != color1)
+		{
+			static const float WEIGHTS[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+			float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+			float ax[3] = {}, bx[3] = {};
+			for (int i = 0; i < 16; ++i)
+			{
+				float a = WEIGHTS[(indices >> (i * 2)) & 3];
+				float b = 1.0f - a;
+				aa += a * a;
+				bb += b * b;
+				ab += a * b;
+				for (int c = 0; c < 3; ++c)
+				{
+					ax[c] += a * texels[i][c];
+					bx[c] += b * texels[i][c];
+				}
+			}
+
+			float determinant = aa * bb - ab * ab;
+			if (std::fabs(determinant) > 1e-6f)
+			{
+				float refinedA[3];
+				float refinedB[3];
+				for (int c = 0; c < 3; ++c)
+				{
+					refinedA[c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+					refinedB[c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+				}
+
+				uint16_t refined0 = 0;
+				uint16_t refined1 = 0;
+				uint32_t refinedIndices = 0;
+				float refinedError = EncodeEndpoints(texels, refinedA, refinedB, refined0, refined1, refinedIndices);
+				if (refinedError < error)
+				{
+					color0 = refined0;
+					color1 = refined1;
+					indices = refinedIndices;
+				}
+			}
+		}
+
+		std::memcpy(output + 0, &color0, 2);
+		std::memcpy(output + 2, &color1, 2);
+		std::memcpy(output + 4, &indices, 4);
+	}
+
+	// BC4 block for one channel: max and min as endpoints, six interpolated values between them
+	void EncodeSingleChannelBlock(const unsigned char* rgba, int channel, unsigned char* output)
+	{
+		int minValue = 255;
+		int maxValue = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			minValue = (std::min)(minValue, static_cast<int>(rgba[i * 4 + channel]));
+			maxValue = (std::max)(maxValue, static_cast<int>(rgba[i * 4 + channel]));
+		}
+
+		output[0] = static_cast<unsigned char>(maxValue);
+		output[1] = static_cast<unsigned char>(minValue);
+
+		uint64_t indices = 0;
+		if (maxValue > minValue)
+		{
+			const int range = maxValue - minValue;
+			for (int i = 0; i < 16; ++i)
+			{
+				// Step 0 is the max endpoint, step 7 the min; palette index 0/1 are the endpoints
+				int step = ((maxValue - rgba[i * 4 + channel]) * 7 + range / 2) / range;
+				int index = step == 0 ? 0 : step == 7 ? 1 : step + 1;
+				indices |= static_cast<uint64_t>(index) << (i * 3);
+			}
+		}
+
+		for (int b = 0; b < 6; ++b)
+		{
+			output[2 + b] = static_cast<unsigned char>(indices >> (b * 8));
+		}
+	}
+
+	void DecodeColorBlock(const unsigned char* block, unsigned char* rgba, bool allowTransparent)
+	{
+		uint16_t color0;
+		uint16_t color1;
+		uint32_t indices;
+		std::memcpy(&color0, block + 0, 2);
+		std::memcpy(&color1, block + 2, 2);
+		std::memcpy(&indices, block + 4, 4);
+
+		unsigned char palette[4][4];
+		Expand565(color0, palette[0]);
+		Expand565(color1, palette[1]);
+		palette[0][3] = palette[1][3] = 255;
+
+		if (color0 > color1 || !allowTransparent)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				palette[2][c] = static_cast<unsigned char>((2 * palette[0][c] + palette[1][c]) / 3);
+				palette[3][c] = static_cast<unsigned char>((palette[0][c] + 2 * palette[1][c]) / 3);
+			}
+			palette[2][3] = palette[3][3] = 255;
+		}
+		else
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				palette[2][c] = static_cast<unsigned char>((palette[0][c] + palette[1][c]) / 2);
+				palette[3][c] = 0;
+			}
+			palette[2][3] = 255;
+			palette[3][3] = 0;
+		}
+
+		for (int i = 0; i < 16; ++i)
+		{
+			std::memcpy(rgba + i * 4, palette[(indices >> (i * 2)) & 3], 4);
+		}
+	}
+
+	void DecodeSingleChannelBlock(const unsigned char* block, unsigned char* rgba, int channel)
+	{
+		int palette[8];
+		palette[0] = block[0];
+		palette[1] = block[1];
+		if (palette[0] > palette[1])
+		{
+			for (int i = 1; i < 7; ++i)
+			{
+				palette[i + 1] = ((7 - i) * palette[0] + i * palette[1]) / 7;
+			}
+		}
+		else
+		{
+			for (int i = 1; i < 5; ++i)
+			{
+				palette[i + 1] = ((5 - i) * palette[0] + i * palette[1]) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		uint64_t indices = 0;
+		for (int b = 0; b < 6; ++b)
+		{
+			indices |= static_cast<uint64_t>(block[2 + b]) << (b * 8);
+		}
+
+		for (int i = 0; i < 16; ++i)
+		{
+			rgba[i * 4 + channel] = static_cast<unsigned char>(palette[(indices >> (i * 3)) & 7]);
+		}
+	}
+
+	// Copy a 4x4 block out of an RGBA8 level, repeating the last row/column past the edge
+	void GatherBlock(const unsigned char* texels, int width, int height, int blockX, int blockY, unsigned char* block)
+	{
+		for (int y = 0; y < 4; ++y)
+		{
+			int sy = (std::min)(blockY * 4 + y, height - 1);
+			for (int x = 0; x < 4; ++x)
+			{
+				int sx = (std::min)(blockX * 4 + x, width - 1);
+				std::memcpy(block + (y * 4 + x) * 4, texels + (static_cast<size_t>(sy) * width + sx) * 4, 4);
+			}
+		}
+	}
+}
+
+void BlockCompression::EncodeBC1Block(const unsigned char* rgba, unsigned char* output)
+{
+	EncodeColorBlock(rgba, output);
+}
+
+void BlockCompression::EncodeBC3Block(const unsigned char* rgba, unsigned char* output)
+{
+	EncodeSingleChannelBlock(rgba, 3, output);
+	EncodeColorBlock(rgba, output + 8);
+}
+
+void BlockCompression::EncodeBC5Block(const unsigned char* rgba, unsigned char* output)
+{
+	EncodeSingleChannelBlock(rgba, 0, output);
+	EncodeSingleChannelBlock(rgba, 1, output + 8);
+}
+
+void BlockCompression::DecodeBlock(DXGI_FORMAT format, const unsigned char* block, unsigned char* rgba)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_BC1_UNORM:
+		DecodeColorBlock(block, rgba, true);
+		break;
+	case DXGI_FORMAT_BC3_UNORM:
+		DecodeColorBlock(block + 8, rgba, false);
+		DecodeSingleChannelBlock(block, rgba, 3);
+		break;
+	case DXGI_FORMAT_BC5_UNORM:
+		for (int i = 0; i < 16; ++i)
+		{
+			rgba[i * 4 + 2] = 0;
+			rgba[i * 4 + 3] = 255;
+		}
+		DecodeSingleChannelBlock(block, rgba, 0);
+		DecodeSingleChannelBlock(block + 8, rgba, 1);
+		break;
+	default:
+		break;
+	}
+}
+
+DXGI_FORMAT BlockCompression::ChooseFormat(const ImageData& image, MipContent content)
+{
+	bool isOpaque = true;
+	const size_t baseSize = static_cast<size_t>(image.width) * image.height * 4;
+	for (size_t i = 3; i < baseSize && isOpaque; i += 4)
+	{
+		isOpaque = image.pixels[i] == 255;
+	}
+
+	// A normal map with a height channel in alpha would lose it in BC5
+	if (!isOpaque)
+		return DXGI_FORMAT_BC3_UNORM;
+
+	return content == MipContent::Normal ? DXGI_FORMAT_BC5_UNORM : DXGI_FORMAT_BC1_UNORM;
+}
+
+bool BlockCompression::CompressImage(ImageData& image, DXGI_FORMAT format)
+{
+	if (!image.IsValid() || image.format != DXGI_FORMAT_R8G8B8A8_UNORM ||
+		image.width % 4 != 0 || image.height % 4 != 0)
+	{
+		return false;
+	}
+
+	ImageData compressed;
+	compressed.width = image.width;
+	compressed.height = image.height;
+	compressed.mipLevels = image.mipLevels;
+	compressed.format = format;
+	compressed.pixels.resize(compressed.GetLevelOffset(compressed.mipLevels));
+
+	unsigned char block[64];
+
+	for (int level = 0; level < image.mipLevels; ++level)
+	{
+		const int width = image.GetLevelWidth(level);
+		const int height = image.GetLevelHeight(level);
+		const unsigned char* source = image.pixels.data() + image.GetLevelOffset(level);
+		unsigned char* target = compressed.pixels.data() + compressed.GetLevelOffset(level);
+
+		const size_t pitch = compressed.GetLevelPitch(level);
+		const size_t blockSize = pitch / ((width + 3) / 4);
+		const int blocksX = (width + 3) / 4;
+		const int blocksY = (height + 3) / 4;
+		for (int by = 0; by < blocksY; ++by)
+		{
+			for (int bx = 0; bx < blocksX; ++bx)
+			{
+				GatherBlock(source, width, height, bx, by, block);
+				unsigned char* output = target + by * pitch + bx * blockSize;
+
+				switch (format)
+				{
+				case DXGI_FORMAT_BC1_UNORM: EncodeBC1Block(block, output); break;
+				case DXGI_FORMAT_BC3_UNORM: EncodeBC3Block(block, output); break;
+				case DXGI_FORMAT_BC5_UNORM: EncodeBC5Block(block, output); break;
+				default: return false;
+				}
+			}
+		}
+	}
+
+	image = std::move(compressed);
+	return true;
+}
+
+std::vector<unsigned char> BlockCompression::DecompressLevel(const ImageData& image, int level)
+{
+	const int width = image.GetLevelWidth(level);
+	const int height = image.GetLevelHeight(level);
+	const int blocksX = (width + 3) / 4;
+	const int blocksY = (height + 3) / 4;
+	const size_t pitch = image.GetLevelPitch(level);
+	const size_t blockSize = pitch / blocksX;
+	const unsigned char* source = image.pixels.data() + image.GetLevelOffset(level);
+
+	std::vector<unsigned char> texels(static_cast<size_t>(width) * height * 4);
+	unsigned char block[64];
+
+	for (int by = 0; by < blocksY; ++by)
+	{
+		for (int bx = 0; bx < blocksX; ++bx)
+		{
+			DecodeBlock(image.format, source + by * pitch + bx * blockSize, block);
+
+			for (int y = 0; y < 4 && by * 4 + y < height; ++y)
+			{
+				for (int x = 0; x < 4 && bx * 4 + x < width; ++x)
+				{
+					std::memcpy(texels.data() + ((static_cast<size_t>(by) * 4 + y) * width + bx * 4 + x) * 4, block + (y * 4 + x) * 4, 4);
+				}
+			}
+		}
+	}
+
+	return texels;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "MipGenerator.h"
+#include "TextureLoader.h"
+
+// Bump when the encoder output changes so baked textures are rebuilt
+constexpr unsigned int BLOCK_COMPRESSION_VERSION = 1;
+
+// CPU encoder and decoder for the BC formats the texture pipeline uses:
+// BC1 for opaque color, BC3 for color with alpha and BC5 for tangent-space normal maps (RG only,
+// the shader rebuilds z). Each 4x4 block is encoded independently; edge blocks repeat the last texel.
+class BlockCompression
+{
+public:
+	// Encode a single block of 16 RGBA8 texels (64 bytes, row-major)
+	static void EncodeBC1Block(const unsigned char* rgba, unsigned char* output);
+	static void EncodeBC3Block(const unsigned char* rgba, unsigned char* output);
+	static void EncodeBC5Block(const unsigned char* rgba, unsigned char* output);
+
+	// Decode a block back to 16 RGBA8 texels, channels the format does not store come back as
+	// 0 (color) or 255 (alpha)
+	static void DecodeBlock(DXGI_FORMAT format, const unsigned char* block, unsigned char* rgba);
+
+	// BC1 when every texel is opaque, BC3 otherwise, BC5 for normal maps
+	static DXGI_FORMAT ChooseFormat(const ImageData& image, MipContent content);
+
+	// Converts every mip level of an RGBA8 image in place. Returns false, leaving the image
+	// unchanged, if it is not RGBA8 or its base size is not a multiple of 4 (a D3D11 requirement).
+	static bool CompressImage(ImageData& image, DXGI_FORMAT format);
+
+	// Expands one level of a block-compressed image back to RGBA8
+	static std::vector<unsigned char> DecompressLevel(const ImageData& image, int level);
+};
@@ -0,0 +1,37 @@
+#include "ContentHash.h"
+
+#include <cstring>
+
+// 64-bit multiply-xorshift hash, eight bytes per step
+uint64_t HashBytes(std::string_view bytes, uint64_t seed)
+{
+	constexpr uint64_t MULTIPLIER = 0x9E3779B97F4A7C15ull;
+
+	uint64_t hash = seed ^ (bytes.size() * MULTIPLIER);
+	const char* data = bytes.data();
+	size_t remaining = bytes.size();
+
+	while (remaining >= 8)
+	{
+		uint64_t word;
+		std::memcpy(&word, data, sizeof(word));
+		word *= MULTIPLIER;
+		word ^= word >> 29;
+		hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+		hash ^= hash >> 32;
+		data += 8;
+		remaining -= 8;
+	}
+
+	uint64_t tail = 0;
+	if (remaining > 0)
+	{
+		std::memcpy(&tail, data, remaining);
+	}
+	hash = (hash ^ (tail * MULTIPLIER)) * 0xFF51AFD7ED558CCDull;
+
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ull;
+	hash ^= hash >> 33;
+	return hash;
+}
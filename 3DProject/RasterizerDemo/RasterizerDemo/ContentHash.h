@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// Fast 64-bit hash for cache keys (not cryptographic); chain calls by passing the previous result as seed
+uint64_t HashBytes(std::string_view bytes, uint64_t seed = 0);
@@ -60,8 +60,9 @@ void EnvironmentMapRenderer::RenderEnvironmentMap(
     ID3D11VertexShader* vertexShader,
     ID3D11PixelShader* cubeMapPixelShader,
     ID3D11InputLayout* inputLayout,
+    PackedVertexPipelineD3D11& packedVertexPipeline,
     ConstantBufferD3D11& constantBuffer,
-    ConstantBufferD3D11& materialBuffer,
+    MaterialBufferD3D11& materialBuffer,
     SamplerD3D11& sampler,
     ID3D11ShaderResourceView* fallbackTexture)
 {
@@ -116,7 +117,20 @@ void EnvironmentMapRenderer::RenderEnvironmentMap(
             if (objIdx == reflectiveObjectIndex)
                 continue;
 
-            gameObjects[objIdx].Draw(context, constantBuffer, materialBuffer, cubeViewProj, fallbackTexture);
+            // Meshes with packed vertices go through PackedVertexVS, reading fewer bytes per vertex
+            const MeshD3D11* mesh = gameObjects[objIdx].GetMesh();
+            const bool usePackedVertices = packedVertexPipeline.IsInitialized() && mesh && mesh->HasPackedVertices();
+            if (usePackedVertices)
+            {
+                packedVertexPipeline.Apply(context, mesh->GetPackedVertexFormat());
+            }
+            else
+            {
+                context->IASetInputLayout(inputLayout);
+                context->VSSetShader(vertexShader, nullptr, 0);
+            }
+
+            gameObjects[objIdx].Draw(context, constantBuffer, materialBuffer, cubeViewProj, fallbackTexture, nullptr, usePackedVertices);
 
             ID3D11ShaderResourceView* nullSRV = nullptr;
             context->PSSetShaderResources(0, 1, &nullSRV);
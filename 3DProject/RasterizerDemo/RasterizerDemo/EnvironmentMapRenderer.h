@@ -6,8 +6,10 @@
 #include "TextureCubeD3D11.h"
 #include "CameraD3D11.h"
 #include "ConstantBufferD3D11.h"
+#include "MaterialBufferD3D11.h"
 #include "GameObject.h"
 #include "SamplerD3D11.h"
+#include "PackedVertexPipelineD3D11.h"
 
 class EnvironmentMapRenderer
 {
@@ -28,8 +30,9 @@ public:
 		ID3D11VertexShader* vertexShader,
 		ID3D11PixelShader* cubeMapPixelShader,
 		ID3D11InputLayout* inputLayout,
+		PackedVertexPipelineD3D11& packedVertexPipeline,
 		ConstantBufferD3D11& constantBuffer,
-		ConstantBufferD3D11& materialBuffer,
+		MaterialBufferD3D11& materialBuffer,
 		SamplerD3D11& sampler,
 		ID3D11ShaderResourceView* fallbackTexture
 	);
@@ -0,0 +1,394 @@
+#include "FrustumCulling.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <intrin.h>
+#include <immintrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+	// Room after the boxes' slots in the output, for 8-wide stores past the last kept index
+	constexpr std::size_t OUTPUT_PADDING = 8;
+
+	bool DetectAVX2()
+	{
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+
+		// AVX, and OSXSAVE so xgetbv can tell whether the OS saves the YMM registers
+		__cpuid(info, 1);
+		if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+			return false;
+		if ((_xgetbv(0) & 0x6) != 0x6)
+			return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+	}
+
+	CullingKernel Resolve(CullingKernel kernel)
+	{
+		if (kernel == CullingKernel::Fastest || (kernel == CullingKernel::AVX2 && !FrustumCulling::IsSupported(kernel)))
+		{
+			return FrustumCulling::IsSupported(CullingKernel::AVX2) ? CullingKernel::AVX2 : CullingKernel::SSE;
+		}
+		return kernel;
+	}
+
+	// Indices of the set lanes of an 8-bit mask, packed to the front, one byte each
+	const std::array<uint64_t, 256>& CompactionTable()
+	{
+		static const std::array<uint64_t, 256> table = []()
+			{
+				std::array<uint64_t, 256> values = {};
+				for (uint32_t mask = 0; mask < 256; ++mask)
+				{
+					int packed = 0;
+					for (uint32_t lane = 0; lane < 8; ++lane)
+					{
+						if (mask & (1u << lane))
+						{
+							values[mask] |= static_cast<uint64_t>(lane) << (8 * packed++);
+						}
+					}
+				}
+				return values;
+			}();
+		return table;
+	}
+
+	// Every kernel writes each box it keeps to front. With Split it keeps the boxes inside every
+	// plane there and writes the crossing ones downwards from back; without, it keeps every box
+	// not outside a plane. Writes at front may go past the last kept index, which the output's
+	// padding and the gap before back leave room for.
+	template<bool Split>
+	void CullScalar(const CullingPlanes& planes, const BoundingBoxArray& boxes, std::size_t begin, std::size_t end,
+		uint32_t*& front, uint32_t*& back)
+	{
+		float absX[6], absY[6], absZ[6];
+		for (int p = 0; p < 6; ++p)
+		{
+			absX[p] = std::fabs(planes.normalX[p]);
+			absY[p] = std::fabs(planes.normalY[p]);
+			absZ[p] = std::fabs(planes.normalZ[p]);
+		}
+
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			const float cx = boxes.centerX[i], cy = boxes.centerY[i], cz = boxes.centerZ[i];
+			const float ex = boxes.extentX[i], ey = boxes.extentY[i], ez = boxes.extentZ[i];
+
+			bool outside = false;
+			bool inside = true;
+			for (int p = 0; p < 6; ++p)
+			{
+				const float distance = planes.normalX[p] * cx + planes.normalY[p] * cy + planes.normalZ[p] * cz + planes.distance[p];
+				const float radius = absX[p] * ex + absY[p] * ey + absZ[p] * ez;
+				outside = outside || distance > radius;
+				inside = inside && distance < -radius;
+			}
+
+			*front = static_cast<uint32_t>(i);
+			if constexpr (Split)
+			{
+				front += inside;
+				if (!inside && !outside)
+				{
+					*--back = static_cast<uint32_t>(i);
+				}
+			}
+			else
+			{
+				front += !outside;
+			}
+		}
+	}
+
+	template<bool Split>
+	void CullSSE(const CullingPlanes& planes, const BoundingBoxArray& boxes, std::size_t begin, std::size_t end,
+		uint32_t*& front, uint32_t*& back)
+	{
+		__m128 normalX[6], normalY[6], normalZ[6], distance[6], absX[6], absY[6], absZ[6];
+		for (int p = 0; p < 6; ++p)
+		{
+			normalX[p] = _mm_set1_ps(planes.normalX[p]);
+			normalY[p] = _mm_set1_ps(planes.normalY[p]);
+			normalZ[p] = _mm_set1_ps(planes.normalZ[p]);
+			distance[p] = _mm_set1_ps(planes.distance[p]);
+			absX[p] = _mm_set1_ps(std::fabs(planes.normalX[p]));
+			absY[p] = _mm_set1_ps(std::fabs(planes.normalY[p]));
+			absZ[p] = _mm_set1_ps(std::fabs(planes.normalZ[p]));
+		}
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 allSet = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+		std::size_t i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			const __m128 cx = _mm_loadu_ps(boxes.centerX.data() + i);
+			const __m128 cy = _mm_loadu_ps(boxes.centerY.data() + i);
+			const __m128 cz = _mm_loadu_ps(boxes.centerZ.data() + i);
+			const __m128 ex = _mm_loadu_ps(boxes.extentX.data() + i);
+			const __m128 ey = _mm_loadu_ps(boxes.extentY.data() + i);
+			const __m128 ez = _mm_loadu_ps(boxes.extentZ.data() + i);
+
+			__m128 outside = zero;
+			__m128 inside = allSet;
+			for (int p = 0; p < 6; ++p)
+			{
+				const __m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX[p], cx), _mm_mul_ps(normalY[p], cy)),
+					_mm_mul_ps(normalZ[p], cz)), distance[p]);
+				const __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)), _mm_mul_ps(absZ[p], ez));
+				outside = _mm_or_ps(outside, _mm_cmpgt_ps(dist, radius));
+				inside = _mm_and_ps(inside, _mm_cmplt_ps(dist, _mm_sub_ps(zero, radius)));
+			}
+
+			const uint32_t outsideMask = static_cast<uint32_t>(_mm_movemask_ps(outside));
+			const uint32_t insideMask = static_cast<uint32_t>(_mm_movemask_ps(inside));
+			const uint32_t keep = Split ? insideMask : ~outsideMask & 0xf;
+			for (uint32_t lane = 0; lane < 4; ++lane)
+			{
+				*front = static_cast<uint32_t>(i + lane);
+				front += (keep >> lane) & 1;
+			}
+
+			if constexpr (Split)
+			{
+				for (uint32_t crossing = ~(insideMask | outsideMask) & 0xf; crossing != 0; crossing &= crossing - 1)
+				{
+					*--back = static_cast<uint32_t>(i + std::countr_zero(crossing));
+				}
+			}
+		}
+
+		CullScalar<Split>(planes, boxes, i, end, front, back);
+	}
+
+	// Only called where DetectAVX2 found support; the compiler may use AVX2 here without /arch
+	template<bool Split>
+	void CullAVX2(const CullingPlanes& planes, const BoundingBoxArray& boxes, std::size_t begin, std::size_t end,
+		uint32_t*& front, uint32_t*& back)
+	{
+		__m256 normalX[6], normalY[6], normalZ[6], distance[6], absX[6], absY[6], absZ[6];
+		for (int p = 0; p < 6; ++p)
+		{
+			normalX[p] = _mm256_set1_ps(planes.normalX[p]);
+			normalY[p] = _mm256_set1_ps(planes.normalY[p]);
+			normalZ[p] = _mm256_set1_ps(planes.normalZ[p]);
+			distance[p] = _mm256_set1_ps(planes.distance[p]);
+			absX[p] = _mm256_set1_ps(std::fabs(planes.normalX[p]));
+			absY[p] = _mm256_set1_ps(std::fabs(planes.normalY[p]));
+			absZ[p] = _mm256_set1_ps(std::fabs(planes.normalZ[p]));
+		}
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 allSet = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		const __m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		const std::array<uint64_t, 256>& compaction = CompactionTable();
+
+		std::size_t i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			const __m256 cx = _mm256_loadu_ps(boxes.centerX.data() + i);
+			const __m256 cy = _mm256_loadu_ps(boxes.centerY.data() + i);
+			const __m256 cz = _mm256_loadu_ps(boxes.centerZ.data() + i);
+			const __m256 ex = _mm256_loadu_ps(boxes.extentX.data() + i);
+			const __m256 ey = _mm256_loadu_ps(boxes.extentY.data() + i);
+			const __m256 ez = _mm256_loadu_ps(boxes.extentZ.data() + i);
+
+			__m256 outside = zero;
+			__m256 inside = allSet;
+			for (int p = 0; p < 6; ++p)
+			{
+				const __m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(normalX[p], cx), _mm256_mul_ps(normalY[p], cy)),
+					_mm256_mul_ps(normalZ[p], cz)), distance[p]);
+				const __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absX[p], ex), _mm256_mul_ps(absY[p], ey)), _mm256_mul_ps(absZ[p], ez));
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(dist, radius, _CMP_GT_OQ));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, _mm256_sub_ps(zero, radius), _CMP_LT_OQ));
+			}
+
+			const uint32_t outsideMask = static_cast<uint32_t>(_mm256_movemask_ps(outside));
+			const uint32_t insideMask = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+			const uint32_t keep = Split ? insideMask : ~outsideMask & 0xff;
+
+			// The kept lanes' indices moved to the front of the register, stored all eight
+			const __m256i lanes = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(static_cast<long long>(compaction[keep])));
+			const __m256i indices = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(i)), laneOffsets);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(front), _mm256_permutevar8x32_epi32(indices, lanes));
+			front += std::popcount(keep);
+
+			if constexpr (Split)
+			{
+				for (uint32_t crossing = ~(insideMask | outsideMask) & 0xff; crossing != 0; crossing &= crossing - 1)
+				{
+					*--back = static_cast<uint32_t>(i + std::countr_zero(crossing));
+				}
+			}
+		}
+
+		CullScalar<Split>(planes, boxes, i, end, front, back);
+	}
+
+	template<bool Split>
+	void Run(CullingKernel kernel, const CullingPlanes& planes, const BoundingBoxArray& boxes, std::size_t begin, std::size_t end,
+		uint32_t*& front, uint32_t*& back)
+	{
+		switch (Resolve(kernel))
+		{
+		case CullingKernel::AVX2:
+			CullAVX2<Split>(planes, boxes, begin, end, front, back);
+			break;
+		case CullingKernel::SSE:
+			CullSSE<Split>(planes, boxes, begin, end, front, back);
+			break;
+		default:
+			CullScalar<Split>(planes, boxes, begin, end, front, back);
+			break;
+		}
+	}
+}
+
+void BoundingBoxArray::Clear()
+{
+	centerX.clear();
+	centerY.clear();
+	centerZ.clear();
+	extentX.clear();
+	extentY.clear();
+	extentZ.clear();
+}
+
+void BoundingBoxArray::Reserve(std::size_t nrOfBoxes)
+{
+	centerX.reserve(nrOfBoxes);
+	centerY.reserve(nrOfBoxes);
+	centerZ.reserve(nrOfBoxes);
+	extentX.reserve(nrOfBoxes);
+	extentY.reserve(nrOfBoxes);
+	extentZ.reserve(nrOfBoxes);
+}
+
+void BoundingBoxArray::Add(const BoundingBox& box)
+{
+	centerX.push_back(box.Center.x);
+	centerY.push_back(box.Center.y);
+	centerZ.push_back(box.Center.z);
+	extentX.push_back(box.Extents.x);
+	extentY.push_back(box.Extents.y);
+	extentZ.push_back(box.Extents.z);
+}
+
+void BoundingBoxArray::Set(std::size_t index, const BoundingBox& box)
+{
+	centerX[index] = box.Center.x;
+	centerY[index] = box.Center.y;
+	centerZ[index] = box.Center.z;
+	extentX[index] = box.Extents.x;
+	extentY[index] = box.Extents.y;
+	extentZ[index] = box.Extents.z;
+}
+
+BoundingBox BoundingBoxArray::Get(std::size_t index) const
+{
+	return BoundingBox(XMFLOAT3(centerX[index], centerY[index], centerZ[index]),
+		XMFLOAT3(extentX[index], extentY[index], extentZ[index]));
+}
+
+CullingPlanes FrustumCulling::GetPlanes(const BoundingFrustum& frustum)
+{
+	XMVECTOR planes[6];
+	frustum.GetPlanes(&planes[0], &planes[1], &planes[2], &planes[3], &planes[4], &planes[5]);
+
+	CullingPlanes result;
+	for (int p = 0; p < 6; ++p)
+	{
+		XMFLOAT4 plane;
+		XMStoreFloat4(&plane, planes[p]);
+		result.normalX[p] = plane.x;
+		result.normalY[p] = plane.y;
+		result.normalZ[p] = plane.z;
+		result.distance[p] = plane.w;
+	}
+	return result;
+}
+
+// A point is in view when its clip position has 0 <= z <= w and -w <= x, y <= w; each bound is
+// a plane made of columns of the matrix, negated where needed so its normal points out
+CullingPlanes FrustumCulling::GetPlanes(const XMMATRIX& viewProjection)
+{
+	const XMMATRIX columns = XMMatrixTranspose(viewProjection);
+	const XMVECTOR planes[6] = {
+		XMVectorNegate(columns.r[2]),
+		XMVectorSubtract(columns.r[2], columns.r[3]),
+		XMVectorSubtract(columns.r[0], columns.r[3]),
+		XMVectorNegate(XMVectorAdd(columns.r[0], columns.r[3])),
+		XMVectorSubtract(columns.r[1], columns.r[3]),
+		XMVectorNegate(XMVectorAdd(columns.r[1], columns.r[3]))
+	};
+
+	CullingPlanes result;
+	for (int p = 0; p < 6; ++p)
+	{
+		XMFLOAT4 plane;
+		XMStoreFloat4(&plane, XMPlaneNormalize(planes[p]));
+		result.normalX[p] = plane.x;
+		result.normalY[p] = plane.y;
+		result.normalZ[p] = plane.z;
+		result.distance[p] = plane.w;
+	}
+	return result;
+}
+
+bool FrustumCulling::IsSupported(CullingKernel kernel)
+{
+	static const bool hasAVX2 = DetectAVX2();
+	return kernel != CullingKernel::AVX2 || hasAVX2;
+}
+
+std::size_t FrustumCulling::Cull(const CullingPlanes& planes, const BoundingBoxArray& boxes, std::size_t begin, std::size_t end,
+	std::vector<uint32_t>& visible, CullingKernel kernel)
+{
+	const std::size_t start = visible.size();
+	visible.resize(start + (end - begin) + OUTPUT_PADDING);
+
+	uint32_t* front = visible.data() + start;
+	uint32_t* back = visible.data() + visible.size();
+	Run<false>(kernel, planes, boxes, begin, end, front, back);
+
+	const std::size_t nrOfVisible = front - (visible.data() + start);
+	visible.resize(start + nrOfVisible);
+	return nrOfVisible;
+}
+
+std::size_t FrustumCulling::CullExact(const BoundingFrustum& frustum, const CullingPlanes& planes,
+	const BoundingBoxArray& boxes, std::size_t begin, std::size_t end, std::vector<uint32_t>& visible, CullingKernel kernel)
+{
+	const std::size_t start = visible.size();
+	visible.resize(start + (end - begin) + OUTPUT_PADDING);
+
+	uint32_t* front = visible.data() + start;
+	uint32_t* const last = visible.data() + visible.size();
+	uint32_t* back = last;
+	Run<true>(kernel, planes, boxes, begin, end, front, back);
+
+	// The crossing boxes were written downwards; reversed, they are back in order and front stays
+	// below every one still to be read
+	std::reverse(back, last);
+	for (uint32_t* crossing = back; crossing < last; ++crossing)
+	{
+		const uint32_t index = *crossing;
+		if (frustum.Intersects(boxes.Get(index)))
+		{
+			*front++ = index;
+		}
+	}
+
+	const std::size_t nrOfVisible = front - (visible.data() + start);
+	visible.resize(start + nrOfVisible);
+	return nrOfVisible;
+}
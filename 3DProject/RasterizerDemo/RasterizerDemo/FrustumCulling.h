@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+// Axis-aligned boxes stored one component per array, so one SIMD load reads the same component
+// of consecutive boxes
+struct BoundingBoxArray
+{
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> extentX;
+	std::vector<float> extentY;
+	std::vector<float> extentZ;
+
+	std::size_t Size() const { return centerX.size(); }
+	void Clear();
+	void Reserve(std::size_t nrOfBoxes);
+	void Add(const DirectX::BoundingBox& box);
+	void Set(std::size_t index, const DirectX::BoundingBox& box);
+	DirectX::BoundingBox Get(std::size_t index) const;
+};
+
+// The six planes of a frustum (near, far, right, left, top, bottom), normals pointing out and
+// of unit length, stored one component per array like the boxes
+struct CullingPlanes
+{
+	float normalX[6];
+	float normalY[6];
+	float normalZ[6];
+	float distance[6];
+};
+
+enum class CullingKernel
+{
+	Scalar,
+	// 4 boxes per iteration; every x86 target the project builds for has it
+	SSE,
+	// 8 boxes per iteration, where the CPU and OS support it
+	AVX2,
+	// The widest of the above the CPU supports
+	Fastest
+};
+
+// Frustum culling of many boxes at once. A box is outside when it lies entirely in front of one
+// plane and inside when it lies behind all six, which is the first test of
+// BoundingFrustum::Intersects; boxes doing neither cross a plane and usually, but not always,
+// intersect the frustum. The kernels compute this with the same operations in the same order,
+// so every kernel gives the same result.
+class FrustumCulling
+{
+public:
+	// From a frustum as DirectXCollision stores it, in the space the frustum is in
+	static CullingPlanes GetPlanes(const DirectX::BoundingFrustum& frustum);
+	// From a view-projection matrix, perspective or orthographic, in world space
+	static CullingPlanes GetPlanes(const DirectX::XMMATRIX& viewProjection);
+
+	static bool IsSupported(CullingKernel kernel);
+
+	// Appends to visible, in order, the indices in [begin, end) of the boxes not outside a plane:
+	// every box the frustum intersects and some near its corners that it does not. Returns the
+	// number appended.
+	static std::size_t Cull(const CullingPlanes& planes, const BoundingBoxArray& boxes, std::size_t begin, std::size_t end,
+		std::vector<uint32_t>& visible, CullingKernel kernel = CullingKernel::Fastest);
+
+	// Cull with the result of BoundingFrustum::Intersects: boxes crossing a plane are passed to
+	// frustum.Intersects, which planes must have been made from. The inside boxes are appended
+	// first, in order, then the crossing ones that intersect.
+	static std::size_t CullExact(const DirectX::BoundingFrustum& frustum, const CullingPlanes& planes,
+		const BoundingBoxArray& boxes, std::size_t begin, std::size_t end, std::vector<uint32_t>& visible,
+		CullingKernel kernel = CullingKernel::Fastest);
+};
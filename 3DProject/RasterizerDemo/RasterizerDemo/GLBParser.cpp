@@ -0,0 +1,978 @@
+#include "GLBParser.h"
+#include "OBJParser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+using namespace DirectX;
+
+GLBImportSettings glbImportSettings;
+
+namespace
+{
+	constexpr uint32_t GLB_MAGIC = 0x46546C67;      // "glTF"
+	constexpr uint32_t GLB_VERSION = 2;
+	constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+	constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;  // "BIN\0"
+	constexpr std::size_t GLB_HEADER_BYTES = 12;
+	constexpr std::size_t GLB_CHUNK_HEADER_BYTES = 8;
+
+	constexpr int COMPONENT_BYTE = 5120;
+	constexpr int COMPONENT_UNSIGNED_BYTE = 5121;
+	constexpr int COMPONENT_SHORT = 5122;
+	constexpr int COMPONENT_UNSIGNED_SHORT = 5123;
+	constexpr int COMPONENT_UNSIGNED_INT = 5125;
+	constexpr int COMPONENT_FLOAT = 5126;
+
+	constexpr int MODE_TRIANGLES = 4;
+
+	// Deeper documents than any exporter writes are rejected rather than recursed into
+	constexpr int MAX_JSON_DEPTH = 64;
+
+	// Just enough of a JSON document model for the glTF header chunk
+	struct JsonValue
+	{
+		enum class Type { Null, Bool, Number, String, Array, Object };
+
+		Type type = Type::Null;
+		bool boolean = false;
+		double number = 0.0;
+		std::string string;
+		// Array elements, or object member values in the order of keys
+		std::vector<JsonValue> elements;
+		std::vector<std::string> keys;
+
+		const JsonValue& operator[](std::string_view key) const
+		{
+			static const JsonValue null;
+			for (std::size_t i = 0; i < keys.size(); ++i)
+			{
+				if (keys[i] == key)
+					return elements[i];
+			}
+			return null;
+		}
+
+		const JsonValue& operator[](std::size_t index) const
+		{
+			static const JsonValue null;
+			return type == Type::Array && index < elements.size() ? elements[index] : null;
+		}
+
+		bool IsNull() const { return type == Type::Null; }
+		std::size_t Size() const { return type == Type::Array ? elements.size() : 0; }
+		double GetNumber(double fallback) const { return type == Type::Number ? number : fallback; }
+		const std::string& GetString() const { return string; }
+
+		// An index into another top-level array, SIZE_MAX when absent
+		std::size_t GetIndex() const
+		{
+			return type == Type::Number && number >= 0.0 ? static_cast<std::size_t>(number) : SIZE_MAX;
+		}
+	};
+
+	class JsonReader
+	{
+	private:
+		std::string_view text;
+		std::size_t pos = 0;
+
+		[[noreturn]] void Fail(const char* what) const
+		{
+			throw std::runtime_error(std::string("Malformed glTF JSON: ") + what + " at byte " + std::to_string(pos));
+		}
+
+		void SkipSpace()
+		{
+			while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r'))
+			{
+				pos++;
+			}
+		}
+
+		bool Consume(std::string_view token)
+		{
+			if (text.substr(pos, token.size()) != token)
+				return false;
+			pos += token.size();
+			return true;
+		}
+
+		void AppendUtf8(uint32_t codePoint, std::string& out)
+		{
+			if (codePoint < 0x80)
+			{
+				out += static_cast<char>(codePoint);
+			}
+			else if (codePoint < 0x800)
+			{
+				out += static_cast<char>(0xC0 | (codePoint >> 6));
+				out += static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+			else if (codePoint < 0x10000)
+			{
+				out += static_cast<char>(0xE0 | (codePoint >> 12));
+				out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+				out += static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+			else
+			{
+				out += static_cast<char>(0xF0 | (codePoint >> 18));
+				out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+				out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+				out += static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+		}
+
+		uint32_t ReadHex4()
+		{
+			if (pos + 4 > text.size())
+				Fail("truncated escape");
+
+			uint32_t value = 0;
+			auto [end, error] = std::from_chars(text.data() + pos, text.data() + pos + 4, value, 16);
+			if (error != std::errc() || end != text.data() + pos + 4)
+				Fail("bad unicode escape");
+			pos += 4;
+			return value;
+		}
+
+		std::string ReadString()
+		{
+			// Opening quote already checked by the caller
+			pos++;
+			std::string out;
+			while (true)
+			{
+				if (pos >= text.size())
+					Fail("unterminated string");
+
+				const char c = text[pos++];
+				if (c == '"')
+					return out;
+				if (c != '\\')
+				{
+					out += c;
+					continue;
+				}
+
+				if (pos >= text.size())
+					Fail("unterminated string");
+
+				const char escaped = text[pos++];
+				switch (escaped)
+				{
+				case '"': out += '"'; break;
+				case '\\': out += '\\'; break;
+				case '/': out += '/'; break;
+				case 'b': out += '\b'; break;
+				case 'f': out += '\f'; break;
+				case 'n': out += '\n'; break;
+				case 'r': out += '\r'; break;
+				case 't': out += '\t'; break;
+				case 'u':
+				{
+					uint32_t codePoint = ReadHex4();
+					if (codePoint >= 0xD800 && codePoint < 0xDC00 && Consume("\\u"))
+					{
+						const uint32_t low = ReadHex4();
+						if (low < 0xDC00 || low > 0xDFFF)
+							Fail("bad surrogate pair");
+						codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+					}
+					AppendUtf8(codePoint, out);
+					break;
+				}
+				default:
+					Fail("bad escape");
+				}
+			}
+		}
+
+		void ReadValue(JsonValue& value, int depth)
+		{
+			if (depth > MAX_JSON_DEPTH)
+				Fail("nesting too deep");
+
+			SkipSpace();
+			if (pos >= text.size())
+				Fail("unexpected end");
+
+			const char c = text[pos];
+			if (c == '{')
+			{
+				value.type = JsonValue::Type::Object;
+				pos++;
+				SkipSpace();
+				if (Consume("}"))
+					return;
+
+				do
+				{
+					SkipSpace();
+					if (pos >= text.size() || text[pos] != '"')
+						Fail("expected member name");
+					value.keys.push_back(ReadString());
+
+					SkipSpace();
+					if (!Consume(":"))
+						Fail("expected ':'");
+
+					value.elements.emplace_back();
+					ReadValue(value.elements.back(), depth + 1);
+					SkipSpace();
+				} while (Consume(","));
+
+				if (!Consume("}"))
+					Fail("expected '}'");
+			}
+			else if (c == '[')
+			{
+				value.type = JsonValue::Type::Array;
+				pos++;
+				SkipSpace();
+				if (Consume("]"))
+					return;
+
+				do
+				{
+					value.elements.emplace_back();
+					ReadValue(value.elements.back(), depth + 1);
+					SkipSpace();
+				} while (Consume(","));
+
+				if (!Consume("]"))
+					Fail("expected ']'");
+			}
+			else if (c == '"')
+			{
+				value.type = JsonValue::Type::String;
+				value.string = ReadString();
+			}
+			else if (Consume("true"))
+			{
+				value.type = JsonValue::Type::Bool;
+				value.boolean = true;
+			}
+			else if (Consume("false"))
+			{
+				value.type = JsonValue::Type::Bool;
+			}
+			else if (Consume("null"))
+			{
+				value.type = JsonValue::Type::Null;
+			}
+			else
+			{
+				value.type = JsonValue::Type::Number;
+				auto [end, error] = std::from_chars(text.data() + pos, text.data() + text.size(), value.number);
+				if (error != std::errc())
+					Fail("expected a value");
+				pos = static_cast<std::size_t>(end - text.data());
+			}
+		}
+
+	public:
+		explicit JsonReader(std::string_view newText) : text(newText) {}
+
+		JsonValue Read()
+		{
+			JsonValue root;
+			ReadValue(root, 0);
+			SkipSpace();
+
+			// The JSON chunk is padded with spaces, anything else after the document is an error
+			if (pos != text.size())
+				Fail("trailing data");
+			return root;
+		}
+	};
+
+	uint32_t ReadU32(const char* bytes)
+	{
+		uint32_t value;
+		std::memcpy(&value, bytes, sizeof(value));
+		return value;
+	}
+
+	std::size_t GetComponentBytes(int componentType)
+	{
+		switch (componentType)
+		{
+		case COMPONENT_BYTE:
+		case COMPONENT_UNSIGNED_BYTE: return 1;
+		case COMPONENT_SHORT:
+		case COMPONENT_UNSIGNED_SHORT: return 2;
+		case COMPONENT_UNSIGNED_INT:
+		case COMPONENT_FLOAT: return 4;
+		default: return 0;
+		}
+	}
+
+	std::size_t GetNrOfComponents(const std::string& type)
+	{
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4") return 4;
+		return 0;
+	}
+
+	// An accessor resolved to bytes in the BIN chunk
+	struct AccessorView
+	{
+		const unsigned char* data = nullptr;
+		std::size_t count = 0;
+		// Bytes from one element to the next
+		std::size_t stride = 0;
+		int componentType = 0;
+		std::size_t nrOfComponents = 0;
+		bool normalized = false;
+		const JsonValue* json = nullptr;
+
+		float ReadComponent(std::size_t element, std::size_t component) const
+		{
+			const unsigned char* bytes = data + element * stride + component * GetComponentBytes(componentType);
+			switch (componentType)
+			{
+			case COMPONENT_FLOAT:
+			{
+				float value;
+				std::memcpy(&value, bytes, sizeof(value));
+				return value;
+			}
+			case COMPONENT_UNSIGNED_BYTE:
+				return normalized ? bytes[0] / 255.0f : bytes[0];
+			case COMPONENT_BYTE:
+			{
+				const float value = static_cast<float>(static_cast<int8_t>(bytes[0]));
+				return normalized ? (std::max)(value / 127.0f, -1.0f) : value;
+			}
+			case COMPONENT_UNSIGNED_SHORT:
+			{
+				uint16_t value;
+				std::memcpy(&value, bytes, sizeof(value));
+				return normalized ? value / 65535.0f : value;
+			}
+			case COMPONENT_SHORT:
+			{
+				int16_t value;
+				std::memcpy(&value, bytes, sizeof(value));
+				return normalized ? (std::max)(value / 32767.0f, -1.0f) : value;
+			}
+			default:
+			{
+				uint32_t value;
+				std::memcpy(&value, bytes, sizeof(value));
+				return static_cast<float>(value);
+			}
+			}
+		}
+
+		uint32_t ReadIndex(std::size_t element) const
+		{
+			const unsigned char* bytes = data + element * stride;
+			switch (componentType)
+			{
+			case COMPONENT_UNSIGNED_BYTE:
+				return bytes[0];
+			case COMPONENT_UNSIGNED_SHORT:
+			{
+				uint16_t value;
+				std::memcpy(&value, bytes, sizeof(value));
+				return value;
+			}
+			default:
+			{
+				uint32_t value;
+				std::memcpy(&value, bytes, sizeof(value));
+				return value;
+			}
+			}
+		}
+
+		bool IsTight() const { return stride == nrOfComponents * GetComponentBytes(componentType); }
+	};
+
+	class GLBDocument
+	{
+	private:
+		JsonValue root;
+		std::string_view bin;
+
+	public:
+		GLBDocument(std::string_view contents)
+		{
+			if (contents.size() < GLB_HEADER_BYTES + GLB_CHUNK_HEADER_BYTES || ReadU32(contents.data()) != GLB_MAGIC)
+				throw std::runtime_error("Not a glTF binary file");
+			if (ReadU32(contents.data() + 4) != GLB_VERSION)
+				throw std::runtime_error("Unsupported glTF binary version " + std::to_string(ReadU32(contents.data() + 4)));
+
+			const std::size_t length = (std::min)(static_cast<std::size_t>(ReadU32(contents.data() + 8)), contents.size());
+
+			std::string_view json;
+			std::size_t chunkPos = GLB_HEADER_BYTES;
+			while (chunkPos + GLB_CHUNK_HEADER_BYTES <= length)
+			{
+				const std::size_t chunkLength = ReadU32(contents.data() + chunkPos);
+				const uint32_t chunkType = ReadU32(contents.data() + chunkPos + 4);
+				chunkPos += GLB_CHUNK_HEADER_BYTES;
+				if (chunkLength > length - chunkPos)
+					throw std::runtime_error("Truncated glTF binary chunk");
+
+				// The first JSON and first BIN chunk are the only ones defined; others are skipped
+				if (chunkType == GLB_CHUNK_JSON && json.empty())
+					json = contents.substr(chunkPos, chunkLength);
+				else if (chunkType == GLB_CHUNK_BIN && bin.empty())
+					bin = contents.substr(chunkPos, chunkLength);
+
+				chunkPos += chunkLength;
+			}
+
+			if (json.empty())
+				throw std::runtime_error("glTF binary has no JSON chunk");
+
+			root = JsonReader(json).Read();
+		}
+
+		const JsonValue& operator[](std::string_view key) const { return root[key]; }
+
+		AccessorView GetAccessor(std::size_t index) const
+		{
+			const JsonValue& accessor = root["accessors"][index];
+			if (accessor.IsNull())
+				throw std::runtime_error("glTF accessor " + std::to_string(index) + " does not exist");
+			if (!accessor["sparse"].IsNull())
+				throw std::runtime_error("glTF sparse accessors are not supported");
+
+			AccessorView view;
+			view.json = &accessor;
+			view.count = static_cast<std::size_t>(accessor["count"].GetNumber(0.0));
+			view.componentType = static_cast<int>(accessor["componentType"].GetNumber(0.0));
+			view.nrOfComponents = GetNrOfComponents(accessor["type"].GetString());
+			view.normalized = accessor["normalized"].boolean;
+
+			const std::size_t elementBytes = view.nrOfComponents * GetComponentBytes(view.componentType);
+			if (elementBytes == 0)
+				throw std::runtime_error("glTF accessor " + std::to_string(index) + " has an unknown type");
+
+			const JsonValue& bufferView = root["bufferViews"][accessor["bufferView"].GetIndex()];
+			if (bufferView.IsNull())
+				throw std::runtime_error("glTF accessor " + std::to_string(index) + " has no buffer view");
+
+			// Only the embedded buffer; external .bin files are not what a .glb pipeline produces
+			const JsonValue& buffer = root["buffers"][bufferView["buffer"].GetIndex()];
+			if (buffer.IsNull() || !buffer["uri"].IsNull() || bufferView["buffer"].GetIndex() != 0)
+				throw std::runtime_error("glTF external buffers are not supported");
+
+			const std::size_t viewOffset = static_cast<std::size_t>(bufferView["byteOffset"].GetNumber(0.0));
+			const std::size_t viewLength = static_cast<std::size_t>(bufferView["byteLength"].GetNumber(0.0));
+			const std::size_t accessorOffset = static_cast<std::size_t>(accessor["byteOffset"].GetNumber(0.0));
+			view.stride = static_cast<std::size_t>(bufferView["byteStride"].GetNumber(static_cast<double>(elementBytes)));
+			if (view.stride < elementBytes)
+				throw std::runtime_error("glTF accessor " + std::to_string(index) + " has a stride smaller than its elements");
+
+			const std::size_t lastByte = view.count == 0 ? 0 : accessorOffset + view.stride * (view.count - 1) + elementBytes;
+			if (viewOffset > bin.size() || viewLength > bin.size() - viewOffset || lastByte > viewLength)
+				throw std::runtime_error("glTF accessor " + std::to_string(index) + " is outside its buffer");
+
+			view.data = reinterpret_cast<const unsigned char*>(bin.data()) + viewOffset + accessorOffset;
+			return view;
+		}
+
+		// URI of a texture's image relative to the file, empty for images stored in the BIN chunk
+		std::string GetTextureURI(const JsonValue& textureInfo) const
+		{
+			const JsonValue& texture = root["textures"][textureInfo["index"].GetIndex()];
+			const JsonValue& image = root["images"][texture["source"].GetIndex()];
+			const std::string& uri = image["uri"].GetString();
+			if (uri.empty() || uri.starts_with("data:"))
+				return {};
+
+			// URIs are percent-encoded; spaces in file names are the common case
+			std::string decoded;
+			for (std::size_t i = 0; i < uri.size(); ++i)
+			{
+				unsigned int value = 0;
+				if (uri[i] == '%' && i + 2 < uri.size() &&
+					std::from_chars(uri.data() + i + 1, uri.data() + i + 3, value, 16).ptr == uri.data() + i + 3)
+				{
+					decoded += static_cast<char>(value);
+					i += 2;
+				}
+				else
+				{
+					decoded += uri[i];
+				}
+			}
+			return decoded;
+		}
+
+		bool HasImage(const JsonValue& textureInfo) const
+		{
+			return !root["textures"][textureInfo["index"].GetIndex()]["source"].IsNull();
+		}
+	};
+
+	// A mesh placed by the scene, with its world transform
+	struct MeshInstance
+	{
+		std::size_t mesh;
+		XMFLOAT4X4 world;
+	};
+
+	XMMATRIX GetLocalTransform(const JsonValue& node)
+	{
+		const JsonValue& matrix = node["matrix"];
+		if (matrix.Size() == 16)
+		{
+			// Column-major with column vectors, which is the same memory as DirectXMath's row vectors
+			XMFLOAT4X4 m;
+			for (std::size_t i = 0; i < 16; ++i)
+			{
+				m.m[i / 4][i % 4] = static_cast<float>(matrix[i].GetNumber(0.0));
+			}
+			return XMLoadFloat4x4(&m);
+		}
+
+		const JsonValue& t = node["translation"];
+		const JsonValue& r = node["rotation"];
+		const JsonValue& s = node["scale"];
+		const XMMATRIX scale = XMMatrixScaling(static_cast<float>(s[0].GetNumber(1.0)),
+			static_cast<float>(s[1].GetNumber(1.0)), static_cast<float>(s[2].GetNumber(1.0)));
+		const XMMATRIX rotation = XMMatrixRotationQuaternion(XMVectorSet(static_cast<float>(r[0].GetNumber(0.0)),
+			static_cast<float>(r[1].GetNumber(0.0)), static_cast<float>(r[2].GetNumber(0.0)), static_cast<float>(r[3].GetNumber(1.0))));
+		const XMMATRIX translation = XMMatrixTranslation(static_cast<float>(t[0].GetNumber(0.0)),
+			static_cast<float>(t[1].GetNumber(0.0)), static_cast<float>(t[2].GetNumber(0.0)));
+		return scale * rotation * translation;
+	}
+
+	void CollectInstances(const GLBDocument& document, std::size_t nodeIndex, const XMMATRIX& parentWorld,
+		std::size_t depth, std::vector<MeshInstance>& instances)
+	{
+		const JsonValue& nodes = document["nodes"];
+		const JsonValue& node = nodes[nodeIndex];
+
+		// A node can only appear once in a hierarchy, so a deeper chain is a cycle
+		if (node.IsNull() || depth > nodes.Size())
+			throw std::runtime_error("glTF node hierarchy is malformed");
+
+		const XMMATRIX world = GetLocalTransform(node) * parentWorld;
+		if (!node["mesh"].IsNull())
+		{
+			MeshInstance instance;
+			instance.mesh = node["mesh"].GetIndex();
+			XMStoreFloat4x4(&instance.world, world);
+			instances.push_back(instance);
+		}
+
+		const JsonValue& children = node["children"];
+		for (std::size_t i = 0; i < children.Size(); ++i)
+		{
+			CollectInstances(document, children[i].GetIndex(), world, depth + 1, instances);
+		}
+	}
+
+	std::vector<MeshInstance> GetMeshInstances(const GLBDocument& document)
+	{
+		std::vector<MeshInstance> instances;
+
+		const JsonValue& scenes = document["scenes"];
+		const std::size_t sceneIndex = document["scene"].IsNull() ? 0 : document["scene"].GetIndex();
+		if (sceneIndex < scenes.Size())
+		{
+			const JsonValue& roots = scenes[sceneIndex]["nodes"];
+			for (std::size_t i = 0; i < roots.Size(); ++i)
+			{
+				CollectInstances(document, roots[i].GetIndex(), XMMatrixIdentity(), 0, instances);
+			}
+		}
+		else
+		{
+			// Without a scene every mesh is used once, untransformed
+			XMFLOAT4X4 identity;
+			XMStoreFloat4x4(&identity, XMMatrixIdentity());
+			for (std::size_t i = 0; i < document["meshes"].Size(); ++i)
+			{
+				instances.push_back({ i, identity });
+			}
+		}
+
+		return instances;
+	}
+
+	// glTF materials are metallic-roughness; the renderer is Phong. Metals keep their base
+	// colour in the specular term, and roughness maps to the Blinn-Phong exponent with the
+	// same highlight width.
+	MaterialInfo ConvertMaterial(const GLBDocument& document, const JsonValue& material, const std::string& textureDirectory,
+		std::size_t& nrOfSkippedImages)
+	{
+		MaterialInfo info;
+		info.name = material["name"].GetString();
+
+		const JsonValue& pbr = material["pbrMetallicRoughness"];
+		const JsonValue& baseColorFactor = pbr["baseColorFactor"];
+		const XMFLOAT3 baseColor(static_cast<float>(baseColorFactor[0].GetNumber(1.0)),
+			static_cast<float>(baseColorFactor[1].GetNumber(1.0)), static_cast<float>(baseColorFactor[2].GetNumber(1.0)));
+		const float metallic = std::clamp(static_cast<float>(pbr["metallicFactor"].GetNumber(1.0)), 0.0f, 1.0f);
+		const float roughness = std::clamp(static_cast<float>(pbr["roughnessFactor"].GetNumber(1.0)), 0.05f, 1.0f);
+
+		info.ambient = XMFLOAT3(baseColor.x * 0.2f, baseColor.y * 0.2f, baseColor.z * 0.2f);
+		info.diffuse = XMFLOAT3(baseColor.x * (1.0f - metallic), baseColor.y * (1.0f - metallic), baseColor.z * (1.0f - metallic));
+		info.specular = XMFLOAT3(0.04f + (baseColor.x - 0.04f) * metallic, 0.04f + (baseColor.y - 0.04f) * metallic,
+			0.04f + (baseColor.z - 0.04f) * metallic);
+
+		const float alpha = roughness * roughness;
+		info.specularPower = std::clamp(2.0f / (alpha * alpha) - 2.0f, 1.0f, 2048.0f);
+
+		auto GetTexturePath = [&](const JsonValue& textureInfo) -> std::string
+			{
+				if (textureInfo.IsNull() || !document.HasImage(textureInfo))
+					return {};
+
+				const std::string uri = document.GetTextureURI(textureInfo);
+				if (uri.empty())
+				{
+					nrOfSkippedImages++;
+					return {};
+				}
+				return textureDirectory + uri;
+			};
+
+		info.mapKd = GetTexturePath(pbr["baseColorTexture"]);
+		info.mapBump = GetTexturePath(material["normalTexture"]);
+		return info;
+	}
+
+	struct Primitive
+	{
+		const JsonValue* json;
+		std::size_t instance;
+		std::size_t materialIndex;
+	};
+
+	std::size_t GetAttribute(const Primitive& primitive, std::string_view name)
+	{
+		return (*primitive.json)["attributes"][name].GetIndex();
+	}
+
+	// glTF requires accessors aligned to their component size, but the file is only pointed at
+	// as typed data when it actually is
+	bool IsAligned(const unsigned char* data, std::size_t alignment)
+	{
+		return reinterpret_cast<std::uintptr_t>(data) % alignment == 0;
+	}
+
+	// Points import at the file when every primitive shares one interleaved vertex array laid out
+	// like Vertex, and at the file or data for the indices. Returns false, having changed
+	// nothing, when the vertices have to be converted.
+	bool TryZeroCopy(const GLBDocument& document, const std::vector<MeshInstance>& instances,
+		const std::vector<Primitive>& primitives, const std::vector<MaterialInfo>& materials,
+		ParseData& data, MeshImport& import, GLBImportStatistics& stats)
+	{
+		for (const MeshInstance& instance : instances)
+		{
+			if (!XMMatrixIsIdentity(XMLoadFloat4x4(&instance.world)))
+				return false;
+		}
+
+		const std::size_t positionAccessor = GetAttribute(primitives[0], "POSITION");
+		const std::size_t normalAccessor = GetAttribute(primitives[0], "NORMAL");
+		const std::size_t texCoordAccessor = GetAttribute(primitives[0], "TEXCOORD_0");
+		const std::size_t tangentAccessor = GetAttribute(primitives[0], "TANGENT");
+		for (const Primitive& primitive : primitives)
+		{
+			if (GetAttribute(primitive, "POSITION") != positionAccessor || GetAttribute(primitive, "NORMAL") != normalAccessor ||
+				GetAttribute(primitive, "TEXCOORD_0") != texCoordAccessor || GetAttribute(primitive, "TANGENT") != tangentAccessor)
+				return false;
+		}
+
+		if (normalAccessor == SIZE_MAX || texCoordAccessor == SIZE_MAX)
+			return false;
+
+		const AccessorView positions = document.GetAccessor(positionAccessor);
+		const AccessorView normals = document.GetAccessor(normalAccessor);
+		const AccessorView texCoords = document.GetAccessor(texCoordAccessor);
+		if (positions.nrOfComponents != 3 || normals.nrOfComponents != 3 || texCoords.nrOfComponents != 2)
+			return false;
+		for (const AccessorView* view : { &positions, &normals, &texCoords })
+		{
+			if (view->componentType != COMPONENT_FLOAT || view->stride != sizeof(Vertex) || view->count != positions.count)
+				return false;
+		}
+		if (normals.data != positions.data + offsetof(Vertex, Normal) || texCoords.data != positions.data + offsetof(Vertex, UV) ||
+			!IsAligned(positions.data, alignof(Vertex)))
+			return false;
+
+		// Tangents in place, or none at all when nothing is normal mapped
+		const DirectX::XMFLOAT4* tangents = nullptr;
+		if (tangentAccessor != SIZE_MAX)
+		{
+			const AccessorView view = document.GetAccessor(tangentAccessor);
+			if (view.componentType != COMPONENT_FLOAT || view.nrOfComponents != 4 || !view.IsTight() || view.count != positions.count ||
+				!IsAligned(view.data, alignof(DirectX::XMFLOAT4)))
+				return false;
+			tangents = reinterpret_cast<const DirectX::XMFLOAT4*>(view.data);
+		}
+		else if (objImportSettings.generateTangents)
+		{
+			for (const MaterialInfo& material : materials)
+			{
+				if (!material.mapBump.empty())
+					return false;
+			}
+		}
+
+		// One run of 16 or 32-bit indices, each primitive's straight after the previous one's
+		std::vector<AccessorView> indexViews;
+		bool indicesInPlace = true;
+		for (const Primitive& primitive : primitives)
+		{
+			const std::size_t indexAccessor = (*primitive.json)["indices"].GetIndex();
+			if (indexAccessor == SIZE_MAX)
+			{
+				indicesInPlace = false;
+				indexViews.push_back({});
+				continue;
+			}
+
+			const AccessorView view = document.GetAccessor(indexAccessor);
+			if (view.nrOfComponents != 1 || (view.componentType != COMPONENT_UNSIGNED_BYTE &&
+				view.componentType != COMPONENT_UNSIGNED_SHORT && view.componentType != COMPONENT_UNSIGNED_INT))
+				throw std::runtime_error("glTF index accessor " + std::to_string(indexAccessor) + " has an invalid type");
+
+			for (std::size_t i = 0; i < view.count; ++i)
+			{
+				if (view.ReadIndex(i) >= positions.count)
+					throw std::runtime_error("glTF index accessor " + std::to_string(indexAccessor) + " is out of range");
+			}
+
+			if (view.componentType == COMPONENT_UNSIGNED_BYTE || !view.IsTight() || !IsAligned(view.data, GetComponentBytes(view.componentType)) ||
+				(!indexViews.empty() && (indexViews[0].componentType != view.componentType ||
+				indexViews.back().data + indexViews.back().count * indexViews.back().stride != view.data)))
+			{
+				indicesInPlace = false;
+			}
+			indexViews.push_back(view);
+		}
+
+		import.vertices = reinterpret_cast<const Vertex*>(positions.data);
+		import.nrOfVertices = positions.count;
+		import.tangents = tangents;
+		stats.zeroCopyVertices = true;
+
+		std::size_t nrOfIndices = 0;
+		import.subMeshes.clear();
+		for (std::size_t i = 0; i < primitives.size(); ++i)
+		{
+			const std::size_t count = indexViews[i].data ? indexViews[i].count : positions.count;
+			SubMeshInfo subMesh;
+			subMesh.startIndexValue = nrOfIndices;
+			subMesh.nrOfIndicesInSubMesh = count;
+			subMesh.currentSubMeshMaterial = primitives[i].materialIndex;
+			import.subMeshes.push_back(subMesh);
+			nrOfIndices += count;
+		}
+		import.nrOfIndices = nrOfIndices;
+
+		if (indicesInPlace)
+		{
+			import.indices = indexViews[0].data;
+			import.indexFormat = indexViews[0].componentType == COMPONENT_UNSIGNED_SHORT ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+			stats.zeroCopyIndices = true;
+		}
+		else
+		{
+			data.indexData.clear();
+			data.indexData.reserve(nrOfIndices);
+			for (const AccessorView& view : indexViews)
+			{
+				for (std::size_t i = 0; i < (view.data ? view.count : positions.count); ++i)
+				{
+					data.indexData.push_back(view.data ? view.ReadIndex(i) : static_cast<uint32_t>(i));
+				}
+			}
+			import.indices = data.indexData.data();
+			import.indexFormat = DXGI_FORMAT_R32_UINT;
+		}
+
+		// POSITION must carry its bounds, which saves CreateMeshFromImport walking the vertices
+		const JsonValue& minimum = (*positions.json)["min"];
+		const JsonValue& maximum = (*positions.json)["max"];
+		if (minimum.Size() == 3 && maximum.Size() == 3)
+		{
+			const XMFLOAT3 low(static_cast<float>(minimum[0].GetNumber(0.0)), static_cast<float>(minimum[1].GetNumber(0.0)),
+				static_cast<float>(minimum[2].GetNumber(0.0)));
+			const XMFLOAT3 high(static_cast<float>(maximum[0].GetNumber(0.0)), static_cast<float>(maximum[1].GetNumber(0.0)),
+				static_cast<float>(maximum[2].GetNumber(0.0)));
+			import.localBoundingBox.Center = XMFLOAT3((low.x + high.x) * 0.5f, (low.y + high.y) * 0.5f, (low.z + high.z) * 0.5f);
+			import.localBoundingBox.Extents = XMFLOAT3((high.x - low.x) * 0.5f, (high.y - low.y) * 0.5f, (high.z - low.z) * 0.5f);
+			import.hasLocalBoundingBox = true;
+		}
+
+		import.materials = materials;
+		import.meshlets = nullptr;
+		import.nrOfMeshlets = 0;
+		import.lods.clear();
+		return true;
+	}
+
+	// Copies every primitive into data in world space, as if it had been parsed from an OBJ.
+	// Tangents in the file are dropped: the OBJ passes reorder and split vertices afterwards, and
+	// TangentGenerator builds the same MikkTSpace frames glTF asks for.
+	void Convert(const GLBDocument& document, const std::vector<MeshInstance>& instances,
+		const std::vector<Primitive>& primitives, ParseData& data)
+	{
+		for (const Primitive& primitive : primitives)
+		{
+			const XMMATRIX world = XMLoadFloat4x4(&instances[primitive.instance].world);
+			const XMMATRIX normalMatrix = XMMatrixTranspose(XMMatrixInverse(nullptr, world));
+			const bool mirrored = XMVectorGetX(XMMatrixDeterminant(world)) < 0.0f;
+
+			const AccessorView positions = document.GetAccessor(GetAttribute(primitive, "POSITION"));
+			if (positions.componentType != COMPONENT_FLOAT || positions.nrOfComponents != 3)
+				throw std::runtime_error("glTF POSITION must be three floats");
+
+			auto GetOptional = [&](std::string_view name, std::size_t nrOfComponents) -> AccessorView
+				{
+					const std::size_t index = GetAttribute(primitive, name);
+					if (index == SIZE_MAX)
+						return {};
+
+					AccessorView view = document.GetAccessor(index);
+					if (view.count != positions.count || view.nrOfComponents != nrOfComponents)
+						throw std::runtime_error("glTF " + std::string(name) + " does not match POSITION");
+					return view;
+				};
+			const AccessorView normals = GetOptional("NORMAL", 3);
+			const AccessorView texCoords = GetOptional("TEXCOORD_0", 2);
+
+			const std::size_t baseVertex = data.vertices.size();
+			for (std::size_t i = 0; i < positions.count; ++i)
+			{
+				Vertex vertex = {};
+				XMStoreFloat3(&vertex.Position, XMVector3TransformCoord(XMVectorSet(positions.ReadComponent(i, 0),
+					positions.ReadComponent(i, 1), positions.ReadComponent(i, 2), 1.0f), world));
+
+				if (normals.data)
+				{
+					XMStoreFloat3(&vertex.Normal, XMVector3Normalize(XMVector3TransformNormal(XMVectorSet(normals.ReadComponent(i, 0),
+						normals.ReadComponent(i, 1), normals.ReadComponent(i, 2), 0.0f), normalMatrix)));
+				}
+
+				// glTF UVs already start at the top left, as D3D samples them
+				if (texCoords.data)
+				{
+					vertex.UV = XMFLOAT2(texCoords.ReadComponent(i, 0), texCoords.ReadComponent(i, 1));
+				}
+
+				data.vertices.push_back(vertex);
+			}
+
+			SubMeshInfo subMesh;
+			subMesh.startIndexValue = data.indexData.size();
+			subMesh.currentSubMeshMaterial = primitive.materialIndex;
+
+			const std::size_t indexAccessor = (*primitive.json)["indices"].GetIndex();
+			const AccessorView indices = indexAccessor != SIZE_MAX ? document.GetAccessor(indexAccessor) : AccessorView{};
+			const std::size_t nrOfIndices = (indices.data ? indices.count : positions.count) / 3 * 3;
+			for (std::size_t i = 0; i < nrOfIndices; i += 3)
+			{
+				uint32_t triangle[3];
+				for (std::size_t corner = 0; corner < 3; ++corner)
+				{
+					triangle[corner] = indices.data ? indices.ReadIndex(i + corner) : static_cast<uint32_t>(i + corner);
+					if (triangle[corner] >= positions.count)
+						throw std::runtime_error("glTF index accessor " + std::to_string(indexAccessor) + " is out of range");
+				}
+
+				// A mirroring transform turns the triangles inside out unless the winding flips with it
+				if (mirrored)
+				{
+					std::swap(triangle[1], triangle[2]);
+				}
+
+				for (uint32_t index : triangle)
+				{
+					data.indexData.push_back(static_cast<unsigned int>(baseVertex + index));
+				}
+			}
+
+			subMesh.nrOfIndicesInSubMesh = data.indexData.size() - subMesh.startIndexValue;
+			if (subMesh.nrOfIndicesInSubMesh > 0)
+			{
+				data.finishedSubMeshes.push_back(subMesh);
+			}
+		}
+	}
+}
+
+bool IsGLBPath(const std::string& path)
+{
+	std::string extension = std::filesystem::path(path).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(),
+		[](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return extension == ".glb";
+}
+
+void ParseGLBContents(std::string_view contents, const std::string& textureDirectory, ParseData& data,
+	MeshImport& import, GLBImportStatistics* statistics)
+{
+	const GLBDocument document(contents);
+	GLBImportStatistics stats;
+
+	// Index 0 is the default material for primitives without one, as in the OBJ parser
+	std::vector<MaterialInfo> materials(1);
+	const JsonValue& gltfMaterials = document["materials"];
+	for (std::size_t i = 0; i < gltfMaterials.Size(); ++i)
+	{
+		materials.push_back(ConvertMaterial(document, gltfMaterials[i], textureDirectory, stats.nrOfSkippedImages));
+	}
+
+	const std::vector<MeshInstance> instances = GetMeshInstances(document);
+	std::vector<Primitive> primitives;
+	for (std::size_t instance = 0; instance < instances.size(); ++instance)
+	{
+		const JsonValue& mesh = document["meshes"][instances[instance].mesh];
+		if (mesh.IsNull())
+			throw std::runtime_error("glTF mesh " + std::to_string(instances[instance].mesh) + " does not exist");
+
+		const JsonValue& meshPrimitives = mesh["primitives"];
+		for (std::size_t i = 0; i < meshPrimitives.Size(); ++i)
+		{
+			const JsonValue& primitive = meshPrimitives[i];
+			if (static_cast<int>(primitive["mode"].GetNumber(MODE_TRIANGLES)) != MODE_TRIANGLES)
+				throw std::runtime_error("glTF primitives other than triangle lists are not supported");
+			if (GetAttribute({ &primitive, instance, 0 }, "POSITION") == SIZE_MAX)
+				throw std::runtime_error("glTF primitive has no POSITION");
+
+			const std::size_t material = primitive["material"].GetIndex();
+			primitives.push_back({ &primitive, instance, material < gltfMaterials.Size() ? material + 1 : 0 });
+		}
+	}
+
+	if (primitives.empty())
+		throw std::runtime_error("glTF file has no meshes in its scene");
+	stats.nrOfPrimitives = primitives.size();
+
+	if (!glbImportSettings.zeroCopy || !TryZeroCopy(document, instances, primitives, materials, data, import, stats))
+	{
+		data.parsedMaterials = std::move(materials);
+		Convert(document, instances, primitives, data);
+		ProcessParseData(data);
+		BuildMeshImport(data, import);
+	}
+
+	if (statistics)
+	{
+		*statistics = stats;
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+struct ParseData;
+struct MeshImport;
+
+// Options applied to every glTF binary import
+struct GLBImportSettings
+{
+	// Point the import straight at the file's buffer views when their layout matches Vertex and
+	// a D3D index format. Such a mesh is used exactly as exported, so it gets no optimization,
+	// LODs, meshlets or packed vertices, and tangents only if the file has them. Off, or when
+	// the layout doesn't match, the mesh is converted and goes through the same passes as an OBJ.
+	bool zeroCopy = true;
+};
+
+struct GLBImportStatistics
+{
+	bool zeroCopyVertices = false;
+	bool zeroCopyIndices = false;
+	std::size_t nrOfPrimitives = 0;
+	// Images stored inside the file, which the texture cache cannot load by path
+	std::size_t nrOfSkippedImages = 0;
+};
+
+extern GLBImportSettings glbImportSettings;
+
+// Whether path names a glTF binary (.glb), imported by ParseGLBContents instead of the OBJ parser
+bool IsGLBPath(const std::string& path);
+
+// Reads a glTF 2.0 binary into import, pointing at contents where the layout allows and at
+// data where it had to be converted, so both must outlive the import. Every mesh the default
+// scene places is included, in node order and with its node transforms applied; each
+// primitive becomes a submesh. Image URIs are resolved against textureDirectory, relative to
+// defaultDirectory like MTL texture paths. Base colour, metallic and roughness are turned
+// into the closest Phong constants and the normal texture into map_Bump. Throws
+// std::runtime_error for malformed files and for what the renderer has no use for: external
+// buffers, sparse accessors and primitives other than triangle lists.
+void ParseGLBContents(std::string_view contents, const std::string& textureDirectory, ParseData& data,
+	MeshImport& import, GLBImportStatistics* statistics = nullptr);
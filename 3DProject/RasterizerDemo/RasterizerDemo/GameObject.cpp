@@ -1,19 +1,11 @@
 #include "GameObject.h"
 #include "CommonStructures.h"
 
+#include <cstdint>
+
 using namespace DirectX;
 
-struct MaterialPadding
-{
-	XMFLOAT3 ambient;
-	float    padding1;
-	XMFLOAT3 diffuse;
-	float    padding2;
-	XMFLOAT3 specular;
-	float    specularPower;
-};
-
-GameObject::GameObject(const MeshD3D11* mesh)
+GameObject::GameObject(MeshHandle mesh)
 	: m_mesh(mesh)
 {
 	XMStoreFloat4x4(&m_worldMatrix, XMMatrixIdentity());
@@ -31,12 +23,8 @@ DirectX::XMMATRIX GameObject::GetWorldMatrix() const
 
 DirectX::BoundingBox GameObject::GetWorldBoundingBox() const
 {
-	if (!m_mesh)
-	{
-		return DirectX::BoundingBox(DirectX::XMFLOAT3(0, 0, 0), DirectX::XMFLOAT3(0, 0, 0));
-	}
-
-	DirectX::BoundingBox localBox = m_mesh->GetLocalBoundingBox();
+	// Known while the mesh is evicted, so it is still culled and placed like a resident one
+	DirectX::BoundingBox localBox = meshResidency.GetLocalBoundingBox(m_mesh);
 
 	DirectX::BoundingBox worldBox;
 	localBox.Transform(worldBox, GetWorldMatrix());
@@ -46,11 +34,14 @@ DirectX::BoundingBox GameObject::GetWorldBoundingBox() const
 
 void GameObject::Draw(ID3D11DeviceContext* context,
 	ConstantBufferD3D11& matrixBuffer,
-	ConstantBufferD3D11& materialBuffer,
+	MaterialBufferD3D11& materialBuffer,
 	const DirectX::XMMATRIX& viewProjection,
-	ID3D11ShaderResourceView* fallbackTexture)
+	ID3D11ShaderResourceView* fallbackTexture,
+	const std::vector<MeshDrawRange>* visibleRanges,
+	bool usePackedVertices)
 {
-	if (!m_mesh) return;
+	const MeshD3D11* mesh = GetMesh();
+	if (!mesh) return;
 
 	MatrixPair matrixData;
 	XMMATRIX world = GetWorldMatrix();
@@ -59,26 +50,40 @@ void GameObject::Draw(ID3D11DeviceContext* context,
 
 	matrixBuffer.UpdateBuffer(context, &matrixData);
 
-	m_mesh->BindMeshBuffers(context);
+	if (usePackedVertices)
+		mesh->BindPackedMeshBuffers(context);
+	else
+		mesh->BindMeshBuffers(context);
 
-	for (size_t i = 0; i < m_mesh->GetNrOfSubMeshes(); ++i)
-	{
-		const auto& meshMat = m_mesh->GetMaterial(i);
-		MaterialPadding matData;
-		matData.ambient = meshMat.ambient;
-		matData.padding1 = 0.0f;
-		matData.diffuse = meshMat.diffuse;
-		matData.padding2 = 0.0f;
-		matData.specular = meshMat.specular;
-		matData.specularPower = meshMat.specularPower;
+	auto BindSubMeshMaterial = [&](size_t i)
+		{
+			materialBuffer.Upload(context, mesh->GetMaterialId(i));
 
-		materialBuffer.UpdateBuffer(context, &matData);
+			ID3D11ShaderResourceView* texture = mesh->GetDiffuseSRV(i);
+			if (!texture) texture = fallbackTexture;
 
-		ID3D11ShaderResourceView* texture = m_mesh->GetDiffuseSRV(i);
-		if (!texture) texture = fallbackTexture;
+			context->PSSetShaderResources(0, 1, &texture);
+		};
 
-		context->PSSetShaderResources(0, 1, &texture);
+	if (visibleRanges)
+	{
+		size_t boundSubMesh = SIZE_MAX;
+		for (const MeshDrawRange& range : *visibleRanges)
+		{
+			if (range.subMeshIndex != boundSubMesh)
+			{
+				boundSubMesh = range.subMeshIndex;
+				BindSubMeshMaterial(boundSubMesh);
+			}
+
+			mesh->PerformRangeDrawCall(context, range);
+		}
+		return;
+	}
 
-		m_mesh->PerformSubMeshDrawCall(context, i);
+	for (size_t i = 0; i < mesh->GetNrOfSubMeshes(); ++i)
+	{
+		BindSubMeshMaterial(i);
+		mesh->PerformSubMeshDrawCall(context, i);
 	}
 }
\ No newline at end of file
@@ -1,29 +1,39 @@
 #pragma once
+#include <vector>
 #include <d3d11.h>
 #include <DirectXMath.h>
 #include <DirectXCollision.h>
 #include "MeshD3D11.h"
 #include "ConstantBufferD3D11.h"
+#include "MaterialBufferD3D11.h"
+#include "MeshResidency.h"
 
 class GameObject
 {
 public:
-	GameObject(const MeshD3D11* mesh);
+	GameObject(MeshHandle mesh);
 
 	void SetWorldMatrix(const DirectX::XMMATRIX& world);
 	DirectX::XMMATRIX GetWorldMatrix() const;
 
-	const MeshD3D11* GetMesh() const { return m_mesh; }
+	// The mesh to draw this frame, nullptr while meshResidency reloads it
+	const MeshD3D11* GetMesh() const { return meshResidency.Acquire(m_mesh); }
+	MeshHandle GetMeshHandle() const { return m_mesh; }
 
 	DirectX::BoundingBox GetWorldBoundingBox() const;
 
+	// With visibleRanges only those parts of the mesh are drawn, in the order given. With
+	// usePackedVertices the mesh's packed vertices are bound instead of the full ones, for a
+	// PackedVertexPipelineD3D11 the caller has applied.
 	void Draw(ID3D11DeviceContext* context,
 		ConstantBufferD3D11& matrixBuffer,
-		ConstantBufferD3D11& materialBuffer,
+		MaterialBufferD3D11& materialBuffer,
 		const DirectX::XMMATRIX& viewProjection,
-		ID3D11ShaderResourceView* fallbackTexture);
+		ID3D11ShaderResourceView* fallbackTexture,
+		const std::vector<MeshDrawRange>* visibleRanges = nullptr,
+		bool usePackedVertices = false);
 
 private:
-	const MeshD3D11* m_mesh;
+	MeshHandle m_mesh;
 	DirectX::XMFLOAT4X4 m_worldMatrix;
 };
\ No newline at end of file
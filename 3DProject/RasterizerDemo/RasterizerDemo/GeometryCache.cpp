@@ -0,0 +1,118 @@
+#include "GeometryCache.h"
+#include "MeshD3D11.h"
+
+#include <Windows.h>
+#include <cstdio>
+
+std::shared_ptr<const MeshGeometryD3D11> GeometryCache::Acquire(ID3D11Device* device, const MeshData& meshInfo)
+{
+	bool collided = false;
+	if (meshInfo.geometryHash != 0)
+	{
+		auto cached = geometries.find(meshInfo.geometryHash);
+		if (cached != geometries.end())
+		{
+			if (std::shared_ptr<const MeshGeometryD3D11> shared = cached->second.lock())
+			{
+				if (shared->Matches(meshInfo))
+				{
+					return shared;
+				}
+
+				// Different geometry under the same hash: upload it apart and leave the entry to
+				// the meshes already sharing it
+				collided = true;
+				nrOfCollisions++;
+			}
+		}
+	}
+
+	auto geometry = std::make_shared<MeshGeometryD3D11>();
+	geometry->Initialize(device, meshInfo);
+
+	if (meshInfo.geometryHash != 0 && !collided)
+	{
+		// Replaces an expired entry left by evicted meshes
+		geometries[meshInfo.geometryHash] = geometry;
+	}
+	return geometry;
+}
+
+size_t GeometryCache::GetSize() const
+{
+	size_t size = 0;
+	for (const auto& pair : geometries)
+	{
+		if (!pair.second.expired())
+		{
+			size++;
+		}
+	}
+	return size;
+}
+
+size_t GeometryCache::GetNrOfShares() const
+{
+	size_t nrOfShares = 0;
+	for (const auto& pair : geometries)
+	{
+		const long nrOfMeshes = pair.second.use_count();
+		nrOfShares += nrOfMeshes > 1 ? static_cast<size_t>(nrOfMeshes - 1) : 0;
+	}
+	return nrOfShares;
+}
+
+size_t GeometryCache::GetBytesDeduplicated() const
+{
+	size_t bytesDeduplicated = 0;
+	for (const auto& pair : geometries)
+	{
+		if (std::shared_ptr<const MeshGeometryD3D11> geometry = pair.second.lock())
+		{
+			// Minus the reference just taken and the mesh the buffers count against
+			const long nrOfSharers = geometry.use_count() - 2;
+			bytesDeduplicated += nrOfSharers > 0 ? static_cast<size_t>(nrOfSharers) * geometry->GetSizeInBytes() : 0;
+		}
+	}
+	return bytesDeduplicated;
+}
+
+void GeometryCache::ReportStatistics() const
+{
+	size_t nrOfGeometries = 0;
+	size_t residentBytes = 0;
+	for (const auto& pair : geometries)
+	{
+		if (std::shared_ptr<const MeshGeometryD3D11> geometry = pair.second.lock())
+		{
+			nrOfGeometries++;
+			residentBytes += geometry->GetSizeInBytes();
+		}
+	}
+
+	char buffer[256];
+	std::snprintf(buffer, sizeof(buffer), "Geometry cache: %zu geometries (%.1f KB), %zu shares, %.1f KB deduplicated, %zu hash collisions\n",
+		nrOfGeometries, residentBytes / 1024.0, GetNrOfShares(), GetBytesDeduplicated() / 1024.0, nrOfCollisions);
+	OutputDebugStringA(buffer);
+}
+
+void GeometryCache::ReleaseUnreferenced()
+{
+	for (auto it = geometries.begin(); it != geometries.end();)
+	{
+		if (it->second.expired())
+		{
+			it = geometries.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void GeometryCache::Clear()
+{
+	geometries.clear();
+	nrOfCollisions = 0;
+}
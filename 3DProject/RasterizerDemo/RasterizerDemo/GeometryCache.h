@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+#include <d3d11.h>
+
+#include "MeshGeometryD3D11.h"
+
+struct MeshData;
+
+// Shares GPU vertex and index buffers between every mesh with the same geometry, whatever file
+// it came from; only the submesh ranges and material bindings stay per mesh. Geometry is
+// addressed by MeshData::geometryHash, a hash of the vertex, tangent and index payloads taken at
+// import. The buffers are held weakly and freed with the last mesh using them, so an evicted
+// mesh gives its GPU memory back. Device thread only, like the buffers it creates.
+class GeometryCache
+{
+private:
+	std::unordered_map<uint64_t, std::weak_ptr<const MeshGeometryD3D11>> geometries;
+
+	// Hashes that matched buffers of another shape, see MeshGeometryD3D11::Matches
+	size_t nrOfCollisions = 0;
+
+public:
+	GeometryCache() = default;
+	~GeometryCache() = default;
+	GeometryCache(const GeometryCache& other) = delete;
+	GeometryCache& operator=(const GeometryCache& other) = delete;
+	GeometryCache(GeometryCache&& other) = delete;
+	GeometryCache& operator=(GeometryCache&& other) = delete;
+
+	// The buffers of a live mesh with the same hash and shape, or new ones uploaded from
+	// meshInfo. A hash of 0 always uploads and is not shared.
+	std::shared_ptr<const MeshGeometryD3D11> Acquire(ID3D11Device* device, const MeshData& meshInfo);
+
+	// Geometries some mesh still uses
+	size_t GetSize() const;
+	// Meshes using buffers another mesh already holds, and the GPU memory that saves. Counted
+	// over the meshes alive now, so a mesh reloaded after eviction is not counted twice.
+	size_t GetNrOfShares() const;
+	size_t GetBytesDeduplicated() const;
+	void ReportStatistics() const;
+	// Drop the entries of geometry no mesh uses anymore; its buffers are already freed
+	void ReleaseUnreferenced();
+	// Meshes keep the buffers they hold alive after this
+	void Clear();
+};
@@ -1,8 +1,9 @@
 #include "IndexBufferD3D11.h"
 
-IndexBufferD3D11::IndexBufferD3D11(ID3D11Device* device, size_t nrOfIndicesInBuffer, uint32_t* indexData)
+IndexBufferD3D11::IndexBufferD3D11(ID3D11Device* device, size_t nrOfIndicesInBuffer, const void* indexData,
+	DXGI_FORMAT indexFormat)
 {
-	Initialize(device, nrOfIndicesInBuffer, indexData);
+	Initialize(device, nrOfIndicesInBuffer, indexData, indexFormat);
 }
 
 IndexBufferD3D11::~IndexBufferD3D11()
@@ -14,7 +15,8 @@ IndexBufferD3D11::~IndexBufferD3D11()
 	}
 }
 
-void IndexBufferD3D11::Initialize(ID3D11Device* device, size_t nrOfIndicesInBuffer, uint32_t* indexData)
+void IndexBufferD3D11::Initialize(ID3D11Device* device, size_t nrOfIndicesInBuffer, const void* indexData,
+	DXGI_FORMAT indexFormat)
 {
 	if (buffer)
 	{
@@ -23,8 +25,11 @@ void IndexBufferD3D11::Initialize(ID3D11Device* device, size_t nrOfIndicesInBuff
 	}
 
 	nrOfIndices = nrOfIndicesInBuffer;
+	format = indexFormat;
+	const size_t indexSize = format == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(uint32_t);
+
 	D3D11_BUFFER_DESC desc = {};
-	desc.ByteWidth = static_cast<UINT>(nrOfIndicesInBuffer * sizeof(uint32_t));
+	desc.ByteWidth = static_cast<UINT>(nrOfIndicesInBuffer * indexSize);
 	desc.Usage = D3D11_USAGE_DEFAULT;
 	desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	desc.CPUAccessFlags = 0;
@@ -42,6 +47,11 @@ size_t IndexBufferD3D11::GetNrOfIndices() const
 	return nrOfIndices;
 }
 
+DXGI_FORMAT IndexBufferD3D11::GetFormat() const
+{
+	return format;
+}
+
 ID3D11Buffer* IndexBufferD3D11::GetBuffer() const
 {
 	return buffer;
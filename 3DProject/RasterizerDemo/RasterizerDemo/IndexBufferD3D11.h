@@ -9,18 +9,23 @@ class IndexBufferD3D11
 private:
 	ID3D11Buffer* buffer = nullptr;
 	size_t nrOfIndices = 0;
+	DXGI_FORMAT format = DXGI_FORMAT_R32_UINT;
 
 public:
 	IndexBufferD3D11() = default;
-	IndexBufferD3D11(ID3D11Device* device, size_t nrOfIndicesInBuffer, uint32_t* indexData);
+	IndexBufferD3D11(ID3D11Device* device, size_t nrOfIndicesInBuffer, const void* indexData,
+		DXGI_FORMAT indexFormat = DXGI_FORMAT_R32_UINT);
 	~IndexBufferD3D11();
 	IndexBufferD3D11(const IndexBufferD3D11& other) = delete;
 	IndexBufferD3D11& operator=(const IndexBufferD3D11& other) = delete;
 	IndexBufferD3D11(IndexBufferD3D11&& other) = delete;
 	IndexBufferD3D11& operator=(IndexBufferD3D11&& other) = delete;
 
-	void Initialize(ID3D11Device* device, size_t nrOfIndicesInBuffer, uint32_t* indexData);
+	void Initialize(ID3D11Device* device, size_t nrOfIndicesInBuffer, const void* indexData,
+		DXGI_FORMAT indexFormat = DXGI_FORMAT_R32_UINT);
 
 	size_t GetNrOfIndices() const;
+	// DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT, as passed to IASetIndexBuffer
+	DXGI_FORMAT GetFormat() const;
 	ID3D11Buffer* GetBuffer() const;
 };
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "IndexCompression.h"
+
+namespace
+{
+	// Varints carry at most a zigzagged 33-bit difference plus one
+	constexpr int MAX_VARINT_BYTES = 5;
+
+	void WriteVarint(uint64_t value, std::vector<unsigned char>& output)
+	{
+		while (value >= 0x80)
+		{
+			output.push_back(static_cast<unsigned char>(value | 0x80));
+			value >>= 7;
+		}
+		output.push_back(static_cast<unsigned char>(value));
+	}
+
+	template<typename IndexType>
+	bool DecodeIndices(const unsigned char* input, const unsigned char* end, std::size_t nrOfIndices,
+		std::size_t nrOfVertices, IndexType* output)
+	{
+		int64_t next = 0;
+		int64_t last = 0;
+
+		for (std::size_t i = 0; i < nrOfIndices; ++i)
+		{
+			if (input == end)
+				return false;
+
+			// Single-byte codes are the common case, keep them off the loop below
+			uint64_t code = *input++;
+			if (code >= 0x80)
+			{
+				code &= 0x7F;
+				int shift = 7;
+				for (int byte = 1; ; ++byte)
+				{
+					if (input == end || byte == MAX_VARINT_BYTES)
+						return false;
+
+					const uint64_t value = *input++;
+					code |= (value & 0x7F) << shift;
+					shift += 7;
+					if (value < 0x80)
+						break;
+				}
+			}
+
+			int64_t index;
+			if (code == 0)
+			{
+				index = next;
+			}
+			else
+			{
+				const uint64_t zigzag = code - 1;
+				index = last + (static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1));
+			}
+
+			if (index < 0 || index >= static_cast<int64_t>(nrOfVertices))
+				return false;
+
+			output[i] = static_cast<IndexType>(index);
+			last = index;
+			next = index >= next ? index + 1 : next;
+		}
+
+		return input == end;
+	}
+}
+
+DXGI_FORMAT IndexCompression::ChooseFormat(std::size_t nrOfVertices)
+{
+	return nrOfVertices <= 0x10000 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+}
+
+std::size_t IndexCompression::GetIndexSize(DXGI_FORMAT format)
+{
+	return format == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+void IndexCompression::Narrow(const unsigned int* indices, std::size_t nrOfIndices, std::vector<uint16_t>& narrowed)
+{
+	narrowed.resize(nrOfIndices);
+	for (std::size_t i = 0; i < nrOfIndices; ++i)
+	{
+		narrowed[i] = static_cast<uint16_t>(indices[i]);
+	}
+}
+
+void IndexCompression::Encode(const unsigned int* indices, std::size_t nrOfIndices, std::vector<unsigned char>& encoded)
+{
+	encoded.clear();
+	encoded.reserve(nrOfIndices + nrOfIndices / 4);
+
+	int64_t next = 0;
+	int64_t last = 0;
+	for (std::size_t i = 0; i < nrOfIndices; ++i)
+	{
+		const int64_t index = indices[i];
+		if (index == next)
+		{
+			encoded.push_back(0);
+		}
+		else
+		{
+			const int64_t difference = index - last;
+			const uint64_t zigzag = (static_cast<uint64_t>(difference) << 1) ^ static_cast<uint64_t>(difference >> 63);
+			WriteVarint(zigzag + 1, encoded);
+		}
+
+		last = index;
+		next = index >= next ? index + 1 : next;
+	}
+}
+
+bool IndexCompression::Decode(const unsigned char* encoded, std::size_t encodedSize, std::size_t nrOfIndices,
+	std::size_t nrOfVertices, DXGI_FORMAT format, void* output)
+{
+	const unsigned char* end = encoded + encodedSize;
+	if (format == DXGI_FORMAT_R16_UINT)
+	{
+		if (nrOfVertices > 0x10000)
+			return false;
+
+		return DecodeIndices(encoded, end, nrOfIndices, nrOfVertices, static_cast<uint16_t*>(output));
+	}
+
+	return DecodeIndices(encoded, end, nrOfIndices, nrOfVertices, static_cast<uint32_t*>(output));
+}
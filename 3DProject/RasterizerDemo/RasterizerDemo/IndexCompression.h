@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <d3d11.h>
+
+// Index buffer width selection and the compact index encoding used by baked meshes.
+//
+// Encoded indices are one varint per index, in order. Code 0 means "the next vertex not
+// referenced yet", which after MeshOptimizer::OptimizeVertexFetch is every first use of a
+// vertex; any other code c is the zigzagged difference to the previous index plus one. In a
+// cache-optimized mesh both cases are nearly always a single byte.
+class IndexCompression
+{
+public:
+	// 16-bit when every index fits, 32-bit otherwise
+	static DXGI_FORMAT ChooseFormat(std::size_t nrOfVertices);
+	static std::size_t GetIndexSize(DXGI_FORMAT format);
+
+	static void Narrow(const unsigned int* indices, std::size_t nrOfIndices, std::vector<uint16_t>& narrowed);
+
+	static void Encode(const unsigned int* indices, std::size_t nrOfIndices, std::vector<unsigned char>& encoded);
+
+	// Decodes nrOfIndices indices of the given format into output, which must hold
+	// nrOfIndices * GetIndexSize(format) bytes. Returns false if the data is truncated, has
+	// trailing bytes or references a vertex at or past nrOfVertices.
+	static bool Decode(const unsigned char* encoded, std::size_t encodedSize, std::size_t nrOfIndices,
+		std::size_t nrOfVertices, DXGI_FORMAT format, void* output);
+};
@@ -10,7 +10,7 @@ InputLayoutD3D11::~InputLayoutD3D11()
 	}
 }
 
-void InputLayoutD3D11::AddInputElement(const std::string& semanticName, DXGI_FORMAT format)
+void InputLayoutD3D11::AddInputElement(const std::string& semanticName, DXGI_FORMAT format, UINT inputSlot)
 {
 	semanticNames.push_back(semanticName);
 
@@ -18,7 +18,7 @@ void InputLayoutD3D11::AddInputElement(const std::string& semanticName, DXGI_FOR
 	desc.SemanticName = nullptr;
 	desc.SemanticIndex = 0;
 	desc.Format = format;
-	desc.InputSlot = 0;
+	desc.InputSlot = inputSlot;
 	desc.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
 	desc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 	desc.InstanceDataStepRate = 0;
@@ -20,7 +20,8 @@ public:
 	InputLayoutD3D11(InputLayoutD3D11&& other) = delete;
 	InputLayoutD3D11& operator=(InputLayoutD3D11&& other) = delete;
 
-	void AddInputElement(const std::string& semanticName, DXGI_FORMAT format);
+	// Elements are packed in the order added, separately for every input slot
+	void AddInputElement(const std::string& semanticName, DXGI_FORMAT format, UINT inputSlot = 0);
 	void FinalizeInputLayout(ID3D11Device* device, const void* vsDataPtr, size_t vsDataSize);
 
 	ID3D11InputLayout* GetInputLayout() const;
@@ -0,0 +1,387 @@
+#pragma once
+
+#include <DirectXCollision.h>
+#include <DirectXMath.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "QuadTree.h"
+
+// Names an element of a LooseQuadTree. The generation changes when the element is removed and its
+// slot given to another, so a handle kept past Remove or Clear is ignored instead of moving the
+// wrong element.
+struct LooseQuadTreeHandle
+{
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+
+	bool IsValid() const { return index != UINT32_MAX; }
+	bool operator==(const LooseQuadTreeHandle& other) const = default;
+};
+
+// Quadtree for scenes that stay mostly still. Each element is stored once, in the deepest node
+// whose cell is at least as wide as the element along X and Z and holds its centre. Nodes are
+// tested against the frustum with their cell doubled along X and Z, the loose box, which then
+// contains every element the node holds, so nothing straddles nodes and Query needs no dedup.
+// Elements outside the world or taller than it fit no loose box and are kept in the root, which is
+// never culled as a whole.
+// Nodes use the QuadTree layout. Update only relinks an element when its node changes, which for
+// an element moving less than its cell is never, and keeps a count of the elements in each subtree
+// so Query skips empty ones; a frame's cost follows the number of elements that moved rather than
+// the number in the tree. Loose boxes inside the frustum report their subtree untested.
+template<typename T, int MaxDepth = 5>
+class LooseQuadTree
+{
+	static_assert(MaxDepth >= 0 && MaxDepth <= 10, "LooseQuadTree nodes are allocated for every level up to MaxDepth");
+
+public:
+	static constexpr int MAX_DEPTH = MaxDepth;
+	static constexpr std::size_t NODE_COUNT = QuadTreeCells::NodeCount(MaxDepth);
+	// Loose boxes are the node's cell scaled by this along X and Z
+	static constexpr float LOOSENESS = 2.0f;
+
+private:
+	static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+	struct Node
+	{
+		// Head of the list of elements held by the node itself
+		uint32_t firstSlot = NO_SLOT;
+		// Elements held by the node and every node below it
+		uint32_t nrInSubtree = 0;
+	};
+
+	struct Slot
+	{
+		T data{};
+		DirectX::BoundingBox boundingBox;
+		uint32_t code = 0;
+		int level = 0;
+		// Neighbours in the node's list; next links the free slots
+		uint32_t previous = NO_SLOT;
+		uint32_t next = NO_SLOT;
+		uint32_t generation = 0;
+		bool inUse = false;
+	};
+
+	DirectX::BoundingBox worldBounds;
+	// Loose box of every node, by LevelOffset(level) + Morton code; fixed by the world bounds
+	std::vector<DirectX::BoundingBox> nodeBoxes;
+	std::vector<Node> nodes;
+	std::vector<Slot> slots;
+	uint32_t firstFreeSlot = NO_SLOT;
+	std::size_t nrOfElements = 0;
+
+	Slot* FindSlot(LooseQuadTreeHandle handle);
+	void ChooseNode(const DirectX::BoundingBox& elementBox, int& level, uint32_t& code) const;
+	void Link(uint32_t slotIndex, int level, uint32_t code);
+	void Unlink(uint32_t slotIndex);
+	void ReportSubtree(int level, uint32_t code, std::vector<T>& result) const;
+	void Query(int level, uint32_t code, const DirectX::BoundingFrustum& frustum, std::vector<T>& result) const;
+
+public:
+	explicit LooseQuadTree(const DirectX::BoundingBox& worldBounds);
+	~LooseQuadTree() = default;
+	LooseQuadTree(const LooseQuadTree& other) = delete;
+	LooseQuadTree& operator=(const LooseQuadTree& other) = delete;
+	LooseQuadTree(LooseQuadTree&& other) = delete;
+	LooseQuadTree& operator=(LooseQuadTree&& other) = delete;
+
+	LooseQuadTreeHandle Insert(const T& element, const DirectX::BoundingBox& elementBox);
+	// Stores the element's new bounds, moving it to another node only if it no longer fits its
+	// own. Returns false, changing nothing, for stale handles.
+	bool Update(LooseQuadTreeHandle handle, const DirectX::BoundingBox& elementBox);
+	// Takes the element out of the tree; the handle goes stale
+	void Remove(LooseQuadTreeHandle handle);
+
+	// Unlike QuadTree::Query, only reads the tree, so queries may run on several threads at once
+	// as long as nothing modifies it meanwhile
+	void Query(const DirectX::BoundingFrustum& frustum, std::vector<T>& result) const;
+	// Removes every element, keeping the capacity; all handles go stale
+	void Clear();
+	// Moves to new world bounds, keeping the elements and their handles
+	void Rebuild(const DirectX::BoundingBox& worldBounds);
+
+	// Makes room for nrOfElements without reallocating while the tree is filled
+	void Reserve(std::size_t nrOfElements);
+	std::size_t GetNrOfElements() const;
+};
+
+// Template implementation must be in header
+template<typename T, int MaxDepth>
+LooseQuadTree<T, MaxDepth>::LooseQuadTree(const DirectX::BoundingBox& worldBounds)
+	: worldBounds(worldBounds), nodes(NODE_COUNT)
+{
+	QuadTreeCells::ComputeNodeBoxes(worldBounds, MaxDepth, LOOSENESS, nodeBoxes);
+}
+
+template<typename T, int MaxDepth>
+typename LooseQuadTree<T, MaxDepth>::Slot* LooseQuadTree<T, MaxDepth>::FindSlot(LooseQuadTreeHandle handle)
+{
+	if (handle.index >= slots.size())
+		return nullptr;
+
+	Slot& slot = slots[handle.index];
+	return slot.inUse && slot.generation == handle.generation ? &slot : nullptr;
+}
+
+// A cell at least as wide as the element, holding its centre, puts the element inside the loose
+// box, so the level only depends on the element's size and the node on where its centre is
+template<typename T, int MaxDepth>
+void LooseQuadTree<T, MaxDepth>::ChooseNode(const DirectX::BoundingBox& elementBox, int& level, uint32_t& code) const
+{
+	level = MaxDepth;
+	while (level > 0 && (elementBox.Extents.x > worldBounds.Extents.x / (1u << level) ||
+		elementBox.Extents.z > worldBounds.Extents.z / (1u << level)))
+	{
+		--level;
+	}
+
+	const float cellsPerSide = static_cast<float>(1u << level);
+	const float u = (elementBox.Center.x - worldBounds.Center.x + worldBounds.Extents.x) / (2.0f * worldBounds.Extents.x);
+	const float v = (elementBox.Center.z - worldBounds.Center.z + worldBounds.Extents.z) / (2.0f * worldBounds.Extents.z);
+	const uint32_t x = static_cast<uint32_t>((std::clamp)(u * cellsPerSide, 0.0f, cellsPerSide - 1.0f));
+	const uint32_t z = static_cast<uint32_t>((std::clamp)(v * cellsPerSide, 0.0f, cellsPerSide - 1.0f));
+	code = QuadTreeCells::SpreadBits(x) | (QuadTreeCells::SpreadBits(z) << 1);
+
+	// Clamping moved the centre into the world, the element reaches above or below it, or rounding
+	// put it just outside; parents' loose boxes contain their children's, so move up until it fits
+	while (level > 0 && nodeBoxes[QuadTreeCells::LevelOffset(level) + code].Contains(elementBox) != DirectX::CONTAINS)
+	{
+		--level;
+		code >>= 2;
+	}
+}
+
+template<typename T, int MaxDepth>
+void LooseQuadTree<T, MaxDepth>::Link(uint32_t slotIndex, int level, uint32_t code)
+{
+	Slot& slot = slots[slotIndex];
+	slot.level = level;
+	slot.code = code;
+
+	Node& node = nodes[QuadTreeCells::LevelOffset(level) + code];
+	slot.previous = NO_SLOT;
+	slot.next = node.firstSlot;
+	if (node.firstSlot != NO_SLOT)
+	{
+		slots[node.firstSlot].previous = slotIndex;
+	}
+	node.firstSlot = slotIndex;
+
+	for (int l = level; l >= 0; --l, code >>= 2)
+	{
+		nodes[QuadTreeCells::LevelOffset(l) + code].nrInSubtree++;
+	}
+}
+
+template<typename T, int MaxDepth>
+void LooseQuadTree<T, MaxDepth>::Unlink(uint32_t slotIndex)
+{
+	Slot& slot = slots[slotIndex];
+	Node& node = nodes[QuadTreeCells::LevelOffset(slot.level) + slot.code];
+	if (slot.previous != NO_SLOT)
+	{
+		slots[slot.previous].next = slot.next;
+	}
+	else
+	{
+		node.firstSlot = slot.next;
+	}
+	if (slot.next != NO_SLOT)
+	{
+		slots[slot.next].previous = slot.previous;
+	}
+
+	uint32_t code = slot.code;
+	for (int l = slot.level; l >= 0; --l, code >>= 2)
+	{
+		nodes[QuadTreeCells::LevelOffset(l) + code].nrInSubtree--;
+	}
+}
+
+template<typename T, int MaxDepth>
+LooseQuadTreeHandle LooseQuadTree<T, MaxDepth>::Insert(const T& element, const DirectX::BoundingBox& elementBox)
+{
+	uint32_t slotIndex = firstFreeSlot;
+	if (slotIndex != NO_SLOT)
+	{
+		firstFreeSlot = slots[slotIndex].next;
+	}
+	else
+	{
+		slotIndex = static_cast<uint32_t>(slots.size());
+		slots.emplace_back();
+	}
+
+	Slot& slot = slots[slotIndex];
+	slot.data = element;
+	slot.boundingBox = elementBox;
+	slot.inUse = true;
+
+	int level = 0;
+	uint32_t code = 0;
+	ChooseNode(elementBox, level, code);
+	Link(slotIndex, level, code);
+	nrOfElements++;
+
+	return { slotIndex, slot.generation };
+}
+
+template<typename T, int MaxDepth>
+bool LooseQuadTree<T, MaxDepth>::Update(LooseQuadTreeHandle handle, const DirectX::BoundingBox& elementBox)
+{
+	Slot* slot = FindSlot(handle);
+	if (!slot)
+		return false;
+
+	slot->boundingBox = elementBox;
+
+	int level = 0;
+	uint32_t code = 0;
+	ChooseNode(elementBox, level, code);
+	if (level != slot->level || code != slot->code)
+	{
+		Unlink(handle.index);
+		Link(handle.index, level, code);
+	}
+
+	return true;
+}
+
+template<typename T, int MaxDepth>
+void LooseQuadTree<T, MaxDepth>::Remove(LooseQuadTreeHandle handle)
+{
+	Slot* slot = FindSlot(handle);
+	if (!slot)
+		return;
+
+	Unlink(handle.index);
+	slot->data = T{};
+	slot->inUse = false;
+	slot->generation++;
+	slot->next = firstFreeSlot;
+	firstFreeSlot = handle.index;
+	nrOfElements--;
+}
+
+template<typename T, int MaxDepth>
+void LooseQuadTree<T, MaxDepth>::ReportSubtree(int level, uint32_t code, std::vector<T>& result) const
+{
+	const Node& node = nodes[QuadTreeCells::LevelOffset(level) + code];
+	if (node.nrInSubtree == 0)
+		return;
+
+	for (uint32_t i = node.firstSlot; i != NO_SLOT; i = slots[i].next)
+	{
+		result.push_back(slots[i].data);
+	}
+
+	if (level < MaxDepth)
+	{
+		for (uint32_t child = 0; child < 4; ++child)
+		{
+			ReportSubtree(level + 1, code * 4 + child, result);
+		}
+	}
+}
+
+template<typename T, int MaxDepth>
+void LooseQuadTree<T, MaxDepth>::Query(int level, uint32_t code, const DirectX::BoundingFrustum& frustum, std::vector<T>& result) const
+{
+	const std::size_t index = QuadTreeCells::LevelOffset(level) + code;
+	const Node& node = nodes[index];
+	if (node.nrInSubtree == 0)
+		return;
+
+	if (level > 0)
+	{
+		const DirectX::ContainmentType containment = frustum.Contains(nodeBoxes[index]);
+		if (containment == DirectX::DISJOINT)
+			return;
+
+		// Loose boxes contain their elements and their children's loose boxes
+		if (containment == DirectX::CONTAINS)
+		{
+			ReportSubtree(level, code, result);
+			return;
+		}
+	}
+
+	for (uint32_t i = node.firstSlot; i != NO_SLOT; i = slots[i].next)
+	{
+		if (frustum.Intersects(slots[i].boundingBox))
+		{
+			result.push_back(slots[i].data);
+		}
+	}
+
+	if (level < MaxDepth)
+	{
+		for (uint32_t child = 0; child < 4; ++child)
+		{
+			Query(level + 1, code * 4 + child, frustum, result);
+		}
+	}
+}
+
+template<typename T, int MaxDepth>
+void LooseQuadTree<T, MaxDepth>::Query(const DirectX::BoundingFrustum& frustum, std::vector<T>& result) const
+{
+	result.clear();
+	Query(0, 0, frustum, result);
+}
+
+template<typename T, int MaxDepth>
+void LooseQuadTree<T, MaxDepth>::Clear()
+{
+	firstFreeSlot = NO_SLOT;
+	for (uint32_t i = static_cast<uint32_t>(slots.size()); i-- > 0;)
+	{
+		Slot& slot = slots[i];
+		if (slot.inUse)
+		{
+			slot.data = T{};
+			slot.inUse = false;
+			slot.generation++;
+		}
+		slot.next = firstFreeSlot;
+		firstFreeSlot = i;
+	}
+
+	std::fill(nodes.begin(), nodes.end(), Node());
+	nrOfElements = 0;
+}
+
+template<typename T, int MaxDepth>
+void LooseQuadTree<T, MaxDepth>::Rebuild(const DirectX::BoundingBox& worldBounds)
+{
+	this->worldBounds = worldBounds;
+	QuadTreeCells::ComputeNodeBoxes(worldBounds, MaxDepth, LOOSENESS, nodeBoxes);
+
+	std::fill(nodes.begin(), nodes.end(), Node());
+	for (uint32_t i = 0; i < slots.size(); ++i)
+	{
+		if (!slots[i].inUse)
+			continue;
+
+		int level = 0;
+		uint32_t code = 0;
+		ChooseNode(slots[i].boundingBox, level, code);
+		Link(i, level, code);
+	}
+}
+
+template<typename T, int MaxDepth>
+void LooseQuadTree<T, MaxDepth>::Reserve(std::size_t nrOfElements)
+{
+	slots.reserve(nrOfElements);
+}
+
+template<typename T, int MaxDepth>
+std::size_t LooseQuadTree<T, MaxDepth>::GetNrOfElements() const
+{
+	return nrOfElements;
+}
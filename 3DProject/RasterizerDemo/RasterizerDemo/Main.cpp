@@ -1,5 +1,10 @@
 #include <Windows.h>
+#include <shellapi.h>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <string>
 #include <vector>
 #include "WindowHelper.h"
 #include "D3D11Helper.h"
@@ -8,13 +13,16 @@
 #include <DirectXMath.h>
 #include "CommonStructures.h"
 #include "ConstantBufferD3D11.h"
+#include "MaterialBufferD3D11.h"
 #include "CameraD3D11.h"
 #include "SamplerD3D11.h"
 #include "InputLayoutD3D11.h"
+#include "PackedVertexPipelineD3D11.h"
 #include "VertexBufferD3D11.h"
 #include "DepthBufferD3D11.h"
 #include "OBJParser.h"
 #include "MeshD3D11.h"
+#include "MeshResidency.h"
 #include "GBufferD3D11.h"
 #include "GameObject.h"
 #include "ShadowMapD3D11.h"
@@ -22,8 +30,14 @@
 #include "TextureLoader.h"
 #include "LightManager.h"
 #include "EnvironmentMapRenderer.h"
-#include "QuadTree.h"
+#include "LooseQuadTree.h"
+#include "FrustumCulling.h"
 #include "ParticleSystemD3D11.h"
+#include "Benchmarks.h"
+#include "BakedMesh.h"
+#include "Meshlets.h"
+#include "MeshParts.h"
+#include "MeshSimplifier.h"
 using namespace DirectX;
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -41,15 +55,8 @@ XMMATRIX VIEW_PROJ;
 // Debug culling parameters
 static float DEBUG_CULLING_FOV_MULTIPLIER = 0.6f;
 
-struct Material
-{
-    XMFLOAT3 ambient;
-    float    padding1;
-    XMFLOAT3 diffuse;
-    float    padding2;
-    XMFLOAT3 specular;
-    float    specularPower;
-};
+// GPU memory the scene's vertex, tangent and index buffers and textures may use before meshes are evicted
+static const size_t MESH_MEMORY_BUDGET = 64ull * 1024 * 1024;
 
 struct LightingToggles
 {
@@ -124,6 +131,25 @@ void CreateComputeOutputResources(ID3D11Device* device, UINT width, UINT height,
 
 }
 
+// Collect the command line arguments, excluding the executable path
+std::vector<std::wstring> GetCommandLineArguments()
+{
+    std::vector<std::wstring> arguments;
+
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (!argv)
+        return arguments;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        arguments.emplace_back(argv[i]);
+    }
+    LocalFree(argv);
+
+    return arguments;
+}
+
 // Add cleanup function before wWinMain
 void CleanupD3DResources(
 	ID3D11Device*& device,
@@ -139,6 +165,7 @@ void CleanupD3DResources(
 	ID3D11VertexShader*& tessVS,
 	ID3D11HullShader*& tessHS,
 	ID3D11DomainShader*& tessDS,
+	ID3D11VertexShader*& tangentVS,
 	ID3D11PixelShader*& reflectionPS,
 	ID3D11PixelShader*& cubeMapPS,
 	ID3D11PixelShader*& normalMapPS,
@@ -159,6 +186,7 @@ void CleanupD3DResources(
 	if (normalMapPS) { normalMapPS->Release(); normalMapPS = nullptr; }
 	if (cubeMapPS) { cubeMapPS->Release(); cubeMapPS = nullptr; }
 	if (reflectionPS) { reflectionPS->Release(); reflectionPS = nullptr; }
+	if (tangentVS) { tangentVS->Release(); tangentVS = nullptr; }
 	if (tessDS) { tessDS->Release(); tessDS = nullptr; }
 	if (tessHS) { tessHS->Release(); tessHS = nullptr; }
 	if (tessVS) { tessVS->Release(); tessVS = nullptr; }
@@ -180,6 +208,22 @@ void CleanupD3DResources(
 int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 {
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
+	auto startupStart = std::chrono::high_resolution_clock::now();
+
+	// Command line tools run without a window and exit when done
+	const std::vector<std::wstring> arguments = GetCommandLineArguments();
+	if (!arguments.empty() && arguments[0] == L"-benchmark")
+	{
+		RunBenchmarks();
+		return 0;
+	}
+	if (!arguments.empty() && arguments[0] == L"-bake")
+	{
+		// Bake every OBJ in the given directory (objects/ by default) and its textures ahead of time
+		const std::string directory = arguments.size() > 1 ? std::filesystem::path(arguments[1]).string() : defaultDirectory;
+		BakeDirectory(directory);
+		return 0;
+	}
 
 	const UINT WIDTH = 1024;
 	const UINT HEIGHT = 576;
@@ -245,6 +289,10 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 	// Parallax occlusion mapping shader
 	ID3D11PixelShader* parallaxPS = ShaderLoader::CreatePixelShader(device, "ParallaxPS.cso");
 
+	// Passes the imported tangent frames on to the two shaders above
+	std::string tangentVSByteCode;
+	ID3D11VertexShader* tangentVS = ShaderLoader::CreateVertexShader(device, "TangentVS.cso", &tangentVSByteCode);
+
 	// Compute shader
 	ID3D11ComputeShader* lightingCS = ShaderLoader::CreateComputeShader(device, "LightingCS.cso");
 
@@ -255,6 +303,21 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 	inputLayout.AddInputElement("TEXCOORD", DXGI_FORMAT_R32G32_FLOAT);
 	inputLayout.FinalizeInputLayout(device, vShaderByteCode.data(), vShaderByteCode.size());
 
+	// Same vertices, plus the tangents from the mesh's second vertex buffer
+	InputLayoutD3D11 tangentInputLayout;
+	if (tangentVS)
+	{
+		tangentInputLayout.AddInputElement("POSITION", DXGI_FORMAT_R32G32B32_FLOAT);
+		tangentInputLayout.AddInputElement("NORMAL", DXGI_FORMAT_R32G32B32_FLOAT);
+		tangentInputLayout.AddInputElement("TEXCOORD", DXGI_FORMAT_R32G32_FLOAT);
+		tangentInputLayout.AddInputElement("TANGENT", DXGI_FORMAT_R32G32B32A32_FLOAT, 1);
+		tangentInputLayout.FinalizeInputLayout(device, tangentVSByteCode.data(), tangentVSByteCode.size());
+	}
+
+	// Draws the meshes imported with packed vertices in the shadow and environment map passes
+	PackedVertexPipelineD3D11 packedVertexPipeline;
+	packedVertexPipeline.Initialize(device);
+
 	// Buffers
 	DepthBufferD3D11 depthBuffer(device, WIDTH, HEIGHT, false);
 	GBufferD3D11 gbuffer;
@@ -284,7 +347,7 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 		OutputDebugStringA("Failed to initialize Shadow Map!\n");
 		CleanupD3DResources(device, context, swapChain, rtv,
 			solidRasterizerState, wireframeRasterizerState, shadowRasterizerState, particleBlendState,
-			vShader, pShader, tessVS, tessHS, tessDS,
+			vShader, pShader, tessVS, tessHS, tessDS, tangentVS,
 			reflectionPS, cubeMapPS, normalMapPS, parallaxPS,
 			lightingCS, shadowSampler, whiteTexView, lightingTex, lightingUAV, lightingRTV);
 		return -1;
@@ -297,7 +360,7 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 		OutputDebugStringA("Failed to initialize Environment Map!\n");
 		CleanupD3DResources(device, context, swapChain, rtv,
 			solidRasterizerState, wireframeRasterizerState, shadowRasterizerState, particleBlendState,
-			vShader, pShader, tessVS, tessHS, tessDS,
+			vShader, pShader, tessVS, tessHS, tessDS, tangentVS,
 			reflectionPS, cubeMapPS, normalMapPS, parallaxPS,
 			lightingCS, shadowSampler, whiteTexView, lightingTex, lightingUAV, lightingRTV);
 		return -1;
@@ -307,31 +370,51 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 	LightManager lightManager;
 	lightManager.InitializeDefaultLights(device);
 
+	// Meshes not drawn for a while are evicted once their buffers and textures exceed this, and reloaded when seen again
+	meshResidency.SetBudget(MESH_MEMORY_BUDGET);
+
+	// Meshes are imported and their textures decoded on the loader pool,
+	// GPU resources are created here as each one finishes
+	auto meshLoadStart = std::chrono::high_resolution_clock::now();
+	std::vector<MeshRequest> meshRequests;
+	for (const char* meshFile : { "cube.obj", "SimpleCube.obj", "sphere.obj", "SimpleCubeNormal.obj",
+		"SimpleCubeParallax.obj", "GrassCube.obj", "Crate1.obj", "Warehousebox.obj" })
+	{
+		meshRequests.push_back(RequestMesh(meshFile));
+	}
+	for (MeshRequest& request : meshRequests)
+	{
+		FinishMesh(request, device);
+	}
+	{
+		double loadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - meshLoadStart).count();
+		std::string msg = "Loaded " + std::to_string(meshRequests.size()) + " meshes in " + std::to_string(loadMs) + " ms\n";
+		OutputDebugStringA(msg.c_str());
+		textureCache.ReportStatistics();
+		geometryCache.ReportStatistics();
+		msg = "Materials: " + std::to_string(materialTable.GetSize()) + " unique, " +
+			std::to_string(materialTable.GetNrOfSharedRegistrations()) + " shared; MTL files parsed " +
+			std::to_string(mtlLibraryCache.GetNrOfParses()) + ", reused " + std::to_string(mtlLibraryCache.GetNrOfHits()) + "\n";
+		OutputDebugStringA(msg.c_str());
+	}
+
 	// Meshes
-	const MeshD3D11* cubeMesh = GetMesh("cube.obj", device);
-	const MeshD3D11* simpleCubeMesh = GetMesh("SimpleCube.obj", device);
-	const MeshD3D11* sphereMesh = GetMesh("sphere.obj", device);
-	const MeshD3D11* simpleCubeNormal = GetMesh("SimpleCubeNormal.obj", device);
-	const MeshD3D11* simpleCubeParallax = GetMesh("SimpleCubeParallax.obj", device);
-	const MeshD3D11* GrassCubeMesh = GetMesh("GrassCube.obj", device);
-	const MeshD3D11* CrateMesh = GetMesh("Crate1.obj", device);
-	const MeshD3D11* WarehouseboxMesh = GetMesh("Warehousebox.obj", device);
+	MeshHandle cubeMesh = GetMesh("cube.obj", device);
+	MeshHandle simpleCubeMesh = GetMesh("SimpleCube.obj", device);
+	MeshHandle sphereMesh = GetMesh("sphere.obj", device);
+	MeshHandle simpleCubeNormal = GetMesh("SimpleCubeNormal.obj", device);
+	MeshHandle simpleCubeParallax = GetMesh("SimpleCubeParallax.obj", device);
+	MeshHandle GrassCubeMesh = GetMesh("GrassCube.obj", device);
+	MeshHandle CrateMesh = GetMesh("Crate1.obj", device);
+	MeshHandle WarehouseboxMesh = GetMesh("Warehousebox.obj", device);
 
 	// Material setup
-	Material mat = {
-		XMFLOAT3(0.2f, 0.2f, 0.2f), 0.f,
-		XMFLOAT3(0.5f, 0.5f, 0.5f), 0.f,
-		XMFLOAT3(0.5f, 0.5f, 0.5f), 100.f
-	};
-	if (cubeMesh && cubeMesh->GetNrOfSubMeshes() > 0)
+	MaterialBufferD3D11 materialBuffer;
+	materialBuffer.Initialize(device);
+	if (const MeshD3D11* cube = meshResidency.Acquire(cubeMesh); cube && cube->GetNrOfSubMeshes() > 0)
 	{
-		const auto& matData = cubeMesh->GetMaterial(0);
-		mat.ambient = matData.ambient;
-		mat.diffuse = matData.diffuse;
-		mat.specular = matData.specular;
-		mat.specularPower = matData.specularPower;
+		materialBuffer.Upload(context, cube->GetMaterialId(0));
 	}
-	ConstantBufferD3D11 materialBuffer(device, sizeof(Material), &mat);
 
 	// Lighting toggles
 	LightingToggles toggleData = { 0, 1, 1, 0 };
@@ -421,17 +504,32 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 	const size_t REFLECTIVE_OBJECT_INDEX = 1;
 	const size_t NORMAL_MAP_OBJECT_INDEX = 6;
 	const size_t PARALLAX_OBJECT_INDEX = 7;
+	// Everything else stays where it was placed, so only these are updated in the QuadTree
+	const size_t ROTATING_OBJECT_INDICES[] = { 2, NORMAL_MAP_OBJECT_INDEX, PARALLAX_OBJECT_INDEX };
 
 	// QuadTree setup
 	DirectX::BoundingBox worldBoundingBox(
 		DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f),
 		DirectX::XMFLOAT3(50.0f, 25.0f, 50.0f));
-	QuadTree<GameObject*> sceneTree(worldBoundingBox, 5, 8);
+	LooseQuadTree<GameObject*, 5> sceneTree(worldBoundingBox);
+	sceneTree.Reserve(gameObjects.size());
+
+	// By gameObjects index
+	std::vector<LooseQuadTreeHandle> sceneTreeHandles;
+	sceneTreeHandles.reserve(gameObjects.size());
+	for (auto& obj : gameObjects)
+	{
+		sceneTreeHandles.push_back(sceneTree.Insert(&obj, obj.GetWorldBoundingBox()));
+	}
 
+	// Every object's world box by gameObjects index, for culling the shadow casters of each light
+	BoundingBoxArray objectBoxes;
+	objectBoxes.Reserve(gameObjects.size());
 	for (auto& obj : gameObjects)
 	{
-		sceneTree.Insert(&obj, obj.GetWorldBoundingBox());
+		objectBoxes.Add(obj.GetWorldBoundingBox());
 	}
+	std::vector<uint32_t> shadowCasters;
 
 	// Controls output
 	OutputDebugStringA("===========================================\n");
@@ -445,20 +543,36 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 	OutputDebugStringA("4         - Toggle wireframe mode\n");
 	OutputDebugStringA("5         - Toggle tessellation\n");
 	OutputDebugStringA("6         - Toggle DEBUG CULLING (smaller frustum)\n");
+	OutputDebugStringA("7         - Toggle meshlet culling\n");
+	OutputDebugStringA("8         - Toggle LOD\n");
 	OutputDebugStringA("9         - Toggle particle emitter\n");
 	OutputDebugStringA("ESC       - Exit\n");
 	OutputDebugStringA("===========================================\n");
 
+	{
+		double startupMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startupStart).count();
+		std::string msg = "Startup took " + std::to_string(startupMs) + " ms\n";
+		OutputDebugStringA(msg.c_str());
+	}
+
 	// State
 	bool tessellationEnabled = false;
 	bool wireframeEnabled = false;
 	bool debugCullingEnabled = false;
+	bool meshletCullingEnabled = true;
+	std::vector<MeshDrawRange> visibleMeshletRanges;
+	std::vector<uint8_t> visibleParts;
+	std::vector<MeshDrawRange> visiblePartRanges;
+	std::vector<MeshDrawRange> partMeshletRanges;
+	bool lodEnabled = true;
+	// Pixels per world unit at distance 1, for turning LOD errors into screen-space errors
+	const float lodProjectionScale = HEIGHT / (2.0f * std::tan(FOV * 0.5f));
 	auto previousTime = std::chrono::high_resolution_clock::now();
 	float rotationAngle = 90.f;
 	const float mouseSens = 0.1f;
 
 	bool key1Prev = false, key2Prev = false, key3Prev = false, key4Prev = false, key5Prev = false, key6Prev = false;
-	bool key9Prev = false;
+	bool key7Prev = false, key8Prev = false, key9Prev = false;
 
 	// Main loop
 	MSG msg = {};
@@ -475,6 +589,9 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 		float dt = std::chrono::duration<float>(currentTime - previousTime).count();
 		previousTime = currentTime;
 
+		// Bring back meshes reloaded since the last frame, evict the ones not drawn lately
+		meshResidency.Update(device);
+
 		rotationAngle += XMConvertToRadians(30.f) * dt;
 		if (rotationAngle > XM_2PI) rotationAngle -= XM_2PI;
 
@@ -485,6 +602,8 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 		bool key4Now = (GetAsyncKeyState('4') & 0x8000) != 0;
 		bool key5Now = (GetAsyncKeyState('5') & 0x8000) != 0;
 		bool key6Now = (GetAsyncKeyState('6') & 0x8000) != 0;
+		bool key7Now = (GetAsyncKeyState('7') & 0x8000) != 0;
+		bool key8Now = (GetAsyncKeyState('8') & 0x8000) != 0;
 		bool key9Now = (GetAsyncKeyState('9') & 0x8000) != 0;
 
 		if (key1Now && !key1Prev) { toggleData.showAlbedoOnly = !toggleData.showAlbedoOnly; }
@@ -497,6 +616,8 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 		if (key4Now && !key4Prev) { wireframeEnabled = !wireframeEnabled; }
 		if (key5Now && !key5Prev) { tessellationEnabled = !tessellationEnabled; }
 		if (key6Now && !key6Prev) { debugCullingEnabled = !debugCullingEnabled; }
+		if (key7Now && !key7Prev) { meshletCullingEnabled = !meshletCullingEnabled; }
+		if (key8Now && !key8Prev) { lodEnabled = !lodEnabled; }
 
 		// Toggle particle emitter on 9
 		if (key9Now && !key9Prev)
@@ -506,7 +627,7 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 		}
 
 		key1Prev = key1Now; key2Prev = key2Now; key3Prev = key3Now; key4Prev = key4Now;
-		key5Prev = key5Now; key6Prev = key6Now; key9Prev = key9Now;
+		key5Prev = key5Now; key6Prev = key6Now; key7Prev = key7Now; key8Prev = key8Now; key9Prev = key9Now;
 
 		// Camera movement
 		const float camSpeed = 3.0f;
@@ -538,11 +659,11 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 		// Update particles
 		particleSystem.Update(context, dt);
 
-		// Update QuadTree
-		sceneTree.Clear();
-		for (auto& obj : gameObjects)
+		// Update QuadTree and culling boxes
+		for (size_t objIdx : ROTATING_OBJECT_INDICES)
 		{
-			sceneTree.Insert(&obj, obj.GetWorldBoundingBox());
+			sceneTree.Update(sceneTreeHandles[objIdx], gameObjects[objIdx].GetWorldBoundingBox());
+			objectBoxes.Set(objIdx, gameObjects[objIdx].GetWorldBoundingBox());
 		}
 
 		ID3D11DepthStencilView* myDSV = depthBuffer.GetDSV(0);
@@ -551,9 +672,7 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 
 		// ----- SHADOW PASS -----
 		{
-			context->IASetInputLayout(inputLayout.GetInputLayout());
 			context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-			context->VSSetShader(vShader, nullptr, 0);
 			context->HSSetShader(nullptr, nullptr, 0);
 			context->DSSetShader(nullptr, nullptr, 0);
 			context->PSSetShader(nullptr, nullptr, 0);
@@ -574,8 +693,13 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 
 				XMMATRIX lightVP = lightManager.GetLightViewProj(lightIdx);
 
-				for (auto& obj : gameObjects)
+				// Objects outside the light's frustum cast no shadow into its map
+				shadowCasters.clear();
+				FrustumCulling::Cull(FrustumCulling::GetPlanes(lightVP), objectBoxes, 0, objectBoxes.Size(), shadowCasters);
+
+				for (uint32_t objIdx : shadowCasters)
 				{
+					const GameObject& obj = gameObjects[objIdx];
 					MatrixPair shadowData;
 					XMStoreFloat4x4(&shadowData.world, XMMatrixTranspose(obj.GetWorldMatrix()));
 					XMStoreFloat4x4(&shadowData.viewProj, XMMatrixTranspose(lightVP));
@@ -584,7 +708,19 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 					const MeshD3D11* mesh = obj.GetMesh();
 					if (mesh)
 					{
-						mesh->BindMeshBuffers(context);
+						// Depth only needs positions, so meshes with packed vertices are drawn from those
+						if (packedVertexPipeline.IsInitialized() && mesh->HasPackedVertices())
+						{
+							packedVertexPipeline.Apply(context, mesh->GetPackedVertexFormat());
+							mesh->BindPackedMeshBuffers(context);
+						}
+						else
+						{
+							context->IASetInputLayout(inputLayout.GetInputLayout());
+							context->VSSetShader(vShader, nullptr, 0);
+							mesh->BindMeshBuffers(context);
+						}
+
 						for (size_t i = 0; i < mesh->GetNrOfSubMeshes(); ++i)
 							mesh->PerformSubMeshDrawCall(context, i);
 					}
@@ -600,7 +736,7 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 
 			envMapRenderer.RenderEnvironmentMap(
 				context, device, reflectivePos, gameObjects, REFLECTIVE_OBJECT_INDEX,
-				vShader, cubeMapPS, inputLayout.GetInputLayout(),
+				vShader, cubeMapPS, inputLayout.GetInputLayout(), packedVertexPipeline,
 				constantBuffer, materialBuffer, samplerState, whiteTexView);
 		}
 
@@ -622,7 +758,8 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 			ID3D11SamplerState* samplerPtr = samplerState.GetSamplerState();
 			context->PSSetSamplers(0, 1, &samplerPtr);
 
-			if (tessellationEnabled && tessVS && tessHS && tessDS)
+			const bool tessellating = tessellationEnabled && tessVS && tessHS && tessDS;
+			if (tessellating)
 			{
 				context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST);
 				context->VSSetShader(tessVS, nullptr, 0);
@@ -669,6 +806,29 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 			std::vector<GameObject*> visibleObjects;
 			sceneTree.Query(cullingFrustum, visibleObjects);
 
+			// Objects that start on the same material draw back to back, so it is uploaded once
+			auto FirstMaterialId = [](const GameObject* object)
+				{
+					const MeshD3D11* mesh = object->GetMesh();
+					return mesh && mesh->GetNrOfSubMeshes() > 0 ? mesh->GetMaterialId(0) : INVALID_MATERIAL_ID;
+				};
+			std::stable_sort(visibleObjects.begin(), visibleObjects.end(), [&](const GameObject* a, const GameObject* b)
+				{
+					return FirstMaterialId(a) < FirstMaterialId(b);
+				});
+
+			// The tessellation stages don't carry the tangent, so the normal and parallax mapped
+			// objects skip them; they are flat cubes that Phong tessellation leaves unchanged anyway
+			auto BindTangentPipeline = [&](bool enable)
+				{
+					const bool useTessellation = !enable && tessellating;
+					context->IASetInputLayout(enable ? tangentInputLayout.GetInputLayout() : inputLayout.GetInputLayout());
+					context->IASetPrimitiveTopology(useTessellation ? D3D11_PRIMITIVE_TOPOLOGY_3_CONTROL_POINT_PATCHLIST : D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+					context->VSSetShader(enable ? tangentVS : (useTessellation ? tessVS : vShader), nullptr, 0);
+					context->HSSetShader(useTessellation ? tessHS : nullptr, nullptr, 0);
+					context->DSSetShader(useTessellation ? tessDS : nullptr, nullptr, 0);
+				};
+
 			for (GameObject* objPtr : visibleObjects)
 			{
 				size_t objIdx = (size_t)(objPtr - &gameObjects[0]);
@@ -686,13 +846,14 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 					context->PSSetShaderResources(1, 1, &nullSRV);
 					context->PSSetShader(pShader, nullptr, 0);
 				}
-				else if (objIdx == NORMAL_MAP_OBJECT_INDEX && normalMapPS)
+				else if (objIdx == NORMAL_MAP_OBJECT_INDEX && normalMapPS && tangentVS)
 				{
-					context->PSSetShader(normalMapPS, nullptr, 0);
-
 					const MeshD3D11* mesh = objPtr->GetMesh();
 					if (!mesh) continue;
 
+					context->PSSetShader(normalMapPS, nullptr, 0);
+					BindTangentPipeline(true);
+
 					ID3D11ShaderResourceView* normalMapSRV = nullptr;
 					if (mesh->GetNrOfSubMeshes() > 0)
 						normalMapSRV = mesh->GetNormalHeightSRV(0);
@@ -707,13 +868,7 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 
 					for (size_t i = 0; i < mesh->GetNrOfSubMeshes(); ++i)
 					{
-						const auto& meshMat = mesh->GetMaterial(i);
-						Material matData;
-						matData.ambient = meshMat.ambient;
-						matData.diffuse = meshMat.diffuse;
-						matData.specular = meshMat.specular;
-						matData.specularPower = meshMat.specularPower;
-						materialBuffer.UpdateBuffer(context, &matData);
+						materialBuffer.Upload(context, mesh->GetMaterialId(i));
 
 						ID3D11ShaderResourceView* texture = mesh->GetDiffuseSRV(i);
 						if (!texture) texture = whiteTexView;
@@ -728,14 +883,16 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 					ID3D11ShaderResourceView* nullSRV = nullptr;
 					context->PSSetShaderResources(1, 1, &nullSRV);
 					context->PSSetShader(pShader, nullptr, 0);
+					BindTangentPipeline(false);
 				}
-				else if (objIdx == PARALLAX_OBJECT_INDEX && parallaxPS)
+				else if (objIdx == PARALLAX_OBJECT_INDEX && parallaxPS && tangentVS)
 				{
-					context->PSSetShader(parallaxPS, nullptr, 0);
-
 					const MeshD3D11* mesh = objPtr->GetMesh();
 					if (!mesh) continue;
 
+					context->PSSetShader(parallaxPS, nullptr, 0);
+					BindTangentPipeline(true);
+
 					ID3D11ShaderResourceView* normalHeightSRV = nullptr;
 					if (mesh->GetNrOfSubMeshes() > 0)
 						normalHeightSRV = mesh->GetNormalHeightSRV(0);
@@ -750,13 +907,7 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 
 					for (size_t i = 0; i < mesh->GetNrOfSubMeshes(); ++i)
 					{
-						const auto& meshMat = mesh->GetMaterial(i);
-						Material matData;
-						matData.ambient = meshMat.ambient;
-						matData.diffuse = meshMat.diffuse;
-						matData.specular = meshMat.specular;
-						matData.specularPower = meshMat.specularPower;
-						materialBuffer.UpdateBuffer(context, &matData);
+						materialBuffer.Upload(context, mesh->GetMaterialId(i));
 
 						ID3D11ShaderResourceView* texture = mesh->GetDiffuseSRV(i);
 						if (!texture) texture = whiteTexView;
@@ -771,10 +922,93 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 					ID3D11ShaderResourceView* nullSRVs[2] = { nullptr, nullptr };
 					context->PSSetShaderResources(0, 2, nullSRVs);
 					context->PSSetShader(pShader, nullptr, 0);
+					BindTangentPipeline(false);
 				}
 				else
 				{
-					objPtr->Draw(context, constantBuffer, materialBuffer, VIEW_PROJ, whiteTexView);
+					const MeshD3D11* mesh = objPtr->GetMesh();
+
+					// A mesh made of several objects or groups drops the ones out of view before the finer
+					// tests below; when every part is in view there is nothing to drop
+					bool cullParts = false;
+					if (mesh && mesh->GetParts().size() > 1)
+					{
+						const size_t nrOfVisibleParts = MeshParts::Cull(mesh->GetParts(), objPtr->GetWorldMatrix(), cullingFrustum, visibleParts);
+						if (nrOfVisibleParts == 0)
+							continue;
+						cullParts = nrOfVisibleParts < mesh->GetParts().size();
+					}
+
+					// Far enough away, a reduced level differs from the full mesh by under a pixel
+					size_t lodLevel = 0;
+					if (lodEnabled && mesh && !mesh->GetLODs().empty())
+					{
+						const XMMATRIX world = objPtr->GetWorldMatrix();
+						const float worldScale = (std::max)({ XMVectorGetX(XMVector3Length(world.r[0])),
+							XMVectorGetX(XMVector3Length(world.r[1])), XMVectorGetX(XMVector3Length(world.r[2])) });
+
+						const BoundingBox worldBox = objPtr->GetWorldBoundingBox();
+						const float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&worldBox.Center),
+							XMLoadFloat3(&camera.GetPosition())))) - XMVectorGetX(XMVector3Length(XMLoadFloat3(&worldBox.Extents)));
+
+						lodLevel = MeshSimplifier::SelectLOD(mesh->GetLODs(), distance, worldScale, lodProjectionScale);
+					}
+
+					if (lodLevel > 0)
+					{
+						const std::vector<MeshDrawRange>& lodRanges = mesh->GetLODs()[lodLevel - 1].ranges;
+						if (cullParts)
+						{
+							MeshParts::FilterRanges(mesh->GetParts(), visibleParts, lodRanges, visiblePartRanges);
+						}
+
+						objPtr->Draw(context, constantBuffer, materialBuffer, VIEW_PROJ, whiteTexView, cullParts ? &visiblePartRanges : &lodRanges);
+					}
+					else if (meshletCullingEnabled && mesh && mesh->GetMeshlets().size() > 1)
+					{
+						// Past the object test, drop the clusters that are out of view or facing away
+						const std::vector<Meshlet>& meshlets = mesh->GetMeshlets();
+						if (cullParts)
+						{
+							// Only the meshlets of parts in view are tested
+							const std::vector<MeshPart>& parts = mesh->GetParts();
+							visibleMeshletRanges.clear();
+							for (size_t p = 0; p < parts.size(); ++p)
+							{
+								if (!visibleParts[p])
+									continue;
+
+								Meshlets::Cull(meshlets.data() + parts[p].firstMeshlet, parts[p].nrOfMeshlets, objPtr->GetWorldMatrix(),
+									cullingFrustum, camera.GetPosition(), partMeshletRanges);
+								visibleMeshletRanges.insert(visibleMeshletRanges.end(), partMeshletRanges.begin(), partMeshletRanges.end());
+							}
+						}
+						else
+						{
+							Meshlets::Cull(meshlets.data(), meshlets.size(), objPtr->GetWorldMatrix(), cullingFrustum,
+								camera.GetPosition(), visibleMeshletRanges);
+						}
+
+						objPtr->Draw(context, constantBuffer, materialBuffer, VIEW_PROJ, whiteTexView, &visibleMeshletRanges);
+					}
+					else if (cullParts)
+					{
+						visiblePartRanges.clear();
+						for (size_t p = 0; p < mesh->GetParts().size(); ++p)
+						{
+							const MeshPart& part = mesh->GetParts()[p];
+							for (uint32_t s = 0; visibleParts[p] && s < part.nrOfSubMeshes; ++s)
+							{
+								visiblePartRanges.push_back(mesh->GetSubMeshRange(part.firstSubMesh + s));
+							}
+						}
+
+						objPtr->Draw(context, constantBuffer, materialBuffer, VIEW_PROJ, whiteTexView, &visiblePartRanges);
+					}
+					else
+					{
+						objPtr->Draw(context, constantBuffer, materialBuffer, VIEW_PROJ, whiteTexView);
+					}
 				}
 			}
 		}
@@ -833,10 +1067,12 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow)
 		swapChain->Present(0, 0);
 	}
 
+	meshResidency.ReportStatistics();
+
 	// Cleanup
 	CleanupD3DResources(device, context, swapChain, rtv,
 		solidRasterizerState, wireframeRasterizerState, shadowRasterizerState, particleBlendState,
-		vShader, pShader, tessVS, tessHS, tessDS,
+		vShader, pShader, tessVS, tessHS, tessDS, tangentVS,
 		reflectionPS, cubeMapPS, normalMapPS, parallaxPS,
 		lightingCS, shadowSampler, whiteTexView, lightingTex, lightingUAV, lightingRTV);
 
@@ -0,0 +1,77 @@
+#include "MaterialBufferD3D11.h"
+#include "OBJParser.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Register layout of the material cbuffer in the pixel shaders
+	struct MaterialPadding
+	{
+		XMFLOAT3 ambient;
+		float    padding1;
+		XMFLOAT3 diffuse;
+		float    padding2;
+		XMFLOAT3 specular;
+		float    specularPower;
+	};
+
+	MaterialPadding ToConstants(const MaterialInfo& material)
+	{
+		MaterialPadding matData;
+		matData.ambient = material.ambient;
+		matData.padding1 = 0.0f;
+		matData.diffuse = material.diffuse;
+		matData.padding2 = 0.0f;
+		matData.specular = material.specular;
+		matData.specularPower = material.specularPower;
+		return matData;
+	}
+}
+
+void MaterialBufferD3D11::Initialize(ID3D11Device* device)
+{
+	MaterialPadding matData = ToConstants(MaterialInfo{});
+	buffer.Initialize(device, sizeof(MaterialPadding), &matData);
+	uploadedMaterial = INVALID_MATERIAL_ID;
+}
+
+void MaterialBufferD3D11::Upload(ID3D11DeviceContext* context, MaterialId id)
+{
+	if (id != INVALID_MATERIAL_ID && id == uploadedMaterial)
+	{
+		nrOfSkippedUploads++;
+		return;
+	}
+
+	const MaterialPadding matData = ToConstants(id != INVALID_MATERIAL_ID ? materialTable.Get(id) : MaterialInfo{});
+	buffer.UpdateBuffer(context, &matData);
+	uploadedMaterial = id;
+	nrOfUploads++;
+}
+
+void MaterialBufferD3D11::Invalidate()
+{
+	uploadedMaterial = INVALID_MATERIAL_ID;
+}
+
+ID3D11Buffer* MaterialBufferD3D11::GetBuffer() const
+{
+	return buffer.GetBuffer();
+}
+
+size_t MaterialBufferD3D11::GetNrOfUploads() const
+{
+	return nrOfUploads;
+}
+
+size_t MaterialBufferD3D11::GetNrOfSkippedUploads() const
+{
+	return nrOfSkippedUploads;
+}
+
+void MaterialBufferD3D11::ResetStatistics()
+{
+	nrOfUploads = 0;
+	nrOfSkippedUploads = 0;
+}
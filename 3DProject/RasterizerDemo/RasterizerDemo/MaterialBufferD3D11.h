@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+
+#include <d3d11_4.h>
+
+#include "ConstantBufferD3D11.h"
+#include "MaterialLibrary.h"
+
+// The material constant buffer, tagged with the materialTable entry it currently holds. Draws bind
+// materials by ID, so consecutive submeshes sharing a material, in one mesh or across meshes,
+// upload it once.
+class MaterialBufferD3D11
+{
+private:
+	ConstantBufferD3D11 buffer;
+	MaterialId uploadedMaterial = INVALID_MATERIAL_ID;
+	size_t nrOfUploads = 0;
+	size_t nrOfSkippedUploads = 0;
+
+public:
+	MaterialBufferD3D11() = default;
+	~MaterialBufferD3D11() = default;
+	MaterialBufferD3D11(const MaterialBufferD3D11& other) = delete;
+	MaterialBufferD3D11& operator=(const MaterialBufferD3D11& other) = delete;
+	MaterialBufferD3D11(MaterialBufferD3D11&& other) = delete;
+	MaterialBufferD3D11& operator=(MaterialBufferD3D11&& other) = delete;
+
+	// Starts out holding the default material
+	void Initialize(ID3D11Device* device);
+
+	// Uploads the material unless the buffer already holds it. INVALID_MATERIAL_ID uploads the
+	// default material.
+	void Upload(ID3D11DeviceContext* context, MaterialId id);
+	// Forces the next Upload through, needed after materialTable.Clear reuses IDs
+	void Invalidate();
+
+	ID3D11Buffer* GetBuffer() const;
+
+	size_t GetNrOfUploads() const;
+	size_t GetNrOfSkippedUploads() const;
+	void ResetStatistics();
+};
@@ -0,0 +1,201 @@
+#include "MaterialLibrary.h"
+#include "OBJParser.h"
+#include "MemoryMappedFile.h"
+#include "TextureCache.h"
+
+namespace
+{
+	std::string_view Trim(std::string_view str)
+	{
+		const auto start = str.find_first_not_of(" \t\r\n");
+		const auto end = str.find_last_not_of(" \t\r\n");
+		if (start == std::string_view::npos || end == std::string_view::npos)
+		{
+			return {};
+		}
+		return str.substr(start, end - start + 1);
+	}
+
+	// Identity of a material: its constants bit for bit and its texture paths as the texture
+	// cache would resolve them. The name is left out.
+	std::string MakeContentsKey(const MaterialInfo& material)
+	{
+		const float constants[10] = {
+			material.ambient.x, material.ambient.y, material.ambient.z,
+			material.diffuse.x, material.diffuse.y, material.diffuse.z,
+			material.specular.x, material.specular.y, material.specular.z,
+			material.specularPower };
+
+		std::string key(reinterpret_cast<const char*>(constants), sizeof(constants));
+		for (const std::string* texPath : { &material.mapKa, &material.mapKd, &material.mapKs, &material.mapBump })
+		{
+			if (!texPath->empty())
+			{
+				key += TextureCache::NormalizePath(*texPath);
+			}
+			key += '\0';
+		}
+		return key;
+	}
+}
+
+MaterialTable::MaterialTable() = default;
+
+MaterialTable::~MaterialTable() = default;
+
+MaterialId MaterialTable::Register(const MaterialInfo& material)
+{
+	std::string key = MakeContentsKey(material);
+
+	std::lock_guard<std::mutex> lock(tableMutex);
+	auto [entry, inserted] = idsByContents.try_emplace(std::move(key), static_cast<MaterialId>(materials.size()));
+	if (inserted)
+	{
+		materials.push_back(std::make_unique<MaterialInfo>(material));
+	}
+	else
+	{
+		nrOfSharedRegistrations++;
+	}
+	return entry->second;
+}
+
+const MaterialInfo& MaterialTable::Get(MaterialId id) const
+{
+	std::lock_guard<std::mutex> lock(tableMutex);
+	return *materials[id];
+}
+
+std::size_t MaterialTable::GetSize() const
+{
+	std::lock_guard<std::mutex> lock(tableMutex);
+	return materials.size();
+}
+
+std::size_t MaterialTable::GetNrOfSharedRegistrations() const
+{
+	std::lock_guard<std::mutex> lock(tableMutex);
+	return nrOfSharedRegistrations;
+}
+
+void MaterialTable::Clear()
+{
+	std::lock_guard<std::mutex> lock(tableMutex);
+	materials.clear();
+	idsByContents.clear();
+	nrOfSharedRegistrations = 0;
+}
+
+std::shared_ptr<const std::vector<MaterialInfo>> MtlLibraryCache::Load(const std::string& path)
+{
+	const std::string key = TextureCache::NormalizePath(path);
+
+	std::error_code error;
+	const std::filesystem::file_time_type lastWriteTime = std::filesystem::last_write_time(path, error);
+	if (error)
+		return nullptr;
+
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		auto cached = libraries.find(key);
+		if (cached != libraries.end() && cached->second.lastWriteTime == lastWriteTime)
+		{
+			nrOfHits++;
+			return cached->second.materials;
+		}
+	}
+
+	// Parsed outside the lock; two threads that miss at once both parse and the later one's copy is kept
+	MemoryMappedFile mtlFile(path);
+	if (!mtlFile.IsOpen())
+		return nullptr;
+
+	auto materials = std::make_shared<std::vector<MaterialInfo>>();
+	ParseMtlContents(mtlFile.GetView(), *materials);
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	nrOfParses++;
+	libraries[key] = Library{ lastWriteTime, materials };
+	return materials;
+}
+
+std::size_t MtlLibraryCache::GetNrOfParses() const
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	return nrOfParses;
+}
+
+std::size_t MtlLibraryCache::GetNrOfHits() const
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	return nrOfHits;
+}
+
+void MtlLibraryCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	libraries.clear();
+	nrOfParses = 0;
+	nrOfHits = 0;
+}
+
+void ParseMtlContents(std::string_view contents, std::vector<MaterialInfo>& materials)
+{
+	size_t contentPos = 0;
+	MaterialInfo* current = nullptr;
+
+	while (contentPos < contents.size())
+	{
+		std::string_view line = GetNextLine(contents, contentPos);
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		size_t pos = 0;
+		std::string_view type = GetLineString(line, pos);
+
+		if (type == "newmtl")
+		{
+			materials.push_back(MaterialInfo{});
+			current = &materials.back();
+			current->name = Trim(line.substr(pos));
+		}
+		else if (current && type == "Ka")
+		{
+			current->ambient.x = GetLineFloat(line, pos);
+			current->ambient.y = GetLineFloat(line, pos);
+			current->ambient.z = GetLineFloat(line, pos);
+		}
+		else if (current && type == "Kd")
+		{
+			current->diffuse.x = GetLineFloat(line, pos);
+			current->diffuse.y = GetLineFloat(line, pos);
+			current->diffuse.z = GetLineFloat(line, pos);
+		}
+		else if (current && type == "Ks")
+		{
+			current->specular.x = GetLineFloat(line, pos);
+			current->specular.y = GetLineFloat(line, pos);
+			current->specular.z = GetLineFloat(line, pos);
+		}
+		else if (current && type == "Ns")
+		{
+			current->specularPower = GetLineFloat(line, pos);
+		}
+		else if (current && type == "map_Ka")
+		{
+			current->mapKa = Trim(line.substr(pos));
+		}
+		else if (current && type == "map_Kd")
+		{
+			current->mapKd = Trim(line.substr(pos));
+		}
+		else if (current && type == "map_Ks")
+		{
+			current->mapKs = Trim(line.substr(pos));
+		}
+		else if (current && (type == "map_Bump" || type == "bump"))
+		{
+			current->mapBump = Trim(line.substr(pos));
+		}
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct MaterialInfo;
+
+using MaterialId = uint32_t;
+constexpr MaterialId INVALID_MATERIAL_ID = 0xFFFFFFFFu;
+
+// Process-wide table of every material in use. Materials with the same constants and texture
+// paths are one entry with one ID, whichever mesh or MTL file they came from and whatever they
+// are called, so draws can be sorted and batched by ID. Thread safe; IDs and references stay
+// valid until Clear.
+class MaterialTable
+{
+private:
+	// Boxed so references survive growth
+	std::vector<std::unique_ptr<MaterialInfo>> materials;
+	// Constants and normalized texture paths -> ID
+	std::unordered_map<std::string, MaterialId> idsByContents;
+	std::size_t nrOfSharedRegistrations = 0;
+
+	mutable std::mutex tableMutex;
+
+public:
+	MaterialTable();
+	~MaterialTable();
+	MaterialTable(const MaterialTable& other) = delete;
+	MaterialTable& operator=(const MaterialTable& other) = delete;
+	MaterialTable(MaterialTable&& other) = delete;
+	MaterialTable& operator=(MaterialTable&& other) = delete;
+
+	// Returns the ID of an identical material, adding this one if there is none
+	MaterialId Register(const MaterialInfo& material);
+	// The first material registered with id's contents, name included
+	const MaterialInfo& Get(MaterialId id) const;
+
+	std::size_t GetSize() const;
+	// Register calls that found an identical material already in the table
+	std::size_t GetNrOfSharedRegistrations() const;
+	void Clear();
+};
+
+// Parses every MTL file once per process and hands the same materials to each OBJ that names it.
+// A file that changed on disk since it was parsed is parsed again. Thread safe.
+class MtlLibraryCache
+{
+private:
+	struct Library
+	{
+		std::filesystem::file_time_type lastWriteTime;
+		std::shared_ptr<const std::vector<MaterialInfo>> materials;
+	};
+
+	std::unordered_map<std::string, Library> libraries;
+	std::size_t nrOfParses = 0;
+	std::size_t nrOfHits = 0;
+
+	mutable std::mutex cacheMutex;
+
+public:
+	MtlLibraryCache() = default;
+	~MtlLibraryCache() = default;
+	MtlLibraryCache(const MtlLibraryCache& other) = delete;
+	MtlLibraryCache& operator=(const MtlLibraryCache& other) = delete;
+	MtlLibraryCache(MtlLibraryCache&& other) = delete;
+	MtlLibraryCache& operator=(MtlLibraryCache&& other) = delete;
+
+	// The materials in the MTL file at path, in file order. nullptr if it cannot be opened.
+	std::shared_ptr<const std::vector<MaterialInfo>> Load(const std::string& path);
+
+	std::size_t GetNrOfParses() const;
+	std::size_t GetNrOfHits() const;
+	void Clear();
+};
+
+// MTL text to materials, one per newmtl record
+void ParseMtlContents(std::string_view contents, std::vector<MaterialInfo>& materials);
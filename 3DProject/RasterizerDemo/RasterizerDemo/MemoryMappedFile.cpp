@@ -0,0 +1,134 @@
+#include "MemoryMappedFile.h"
+#include <Windows.h>
+
+MemoryMappedFile::MemoryMappedFile(const std::string& path)
+{
+	Open(path);
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+	Close();
+}
+
+MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other) noexcept
+	: fileHandle(other.fileHandle)
+	, mappingHandle(other.mappingHandle)
+	, data(other.data)
+	, size(other.size)
+	, isOpen(other.isOpen)
+{
+	other.fileHandle = nullptr;
+	other.mappingHandle = nullptr;
+	other.data = nullptr;
+	other.size = 0;
+	other.isOpen = false;
+}
+
+MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+
+		fileHandle = other.fileHandle;
+		mappingHandle = other.mappingHandle;
+		data = other.data;
+		size = other.size;
+		isOpen = other.isOpen;
+
+		other.fileHandle = nullptr;
+		other.mappingHandle = nullptr;
+		other.data = nullptr;
+		other.size = 0;
+		other.isOpen = false;
+	}
+	return *this;
+}
+
+bool MemoryMappedFile::Open(const std::string& path)
+{
+	Close();
+
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	size = static_cast<size_t>(fileSize.QuadPart);
+	isOpen = true;
+
+	// Empty files cannot be mapped, but they are still valid (empty) views
+	if (size == 0)
+	{
+		return true;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		Close();
+		return false;
+	}
+	mappingHandle = mapping;
+
+	data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!data)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MemoryMappedFile::Close()
+{
+	if (data)
+	{
+		UnmapViewOfFile(data);
+		data = nullptr;
+	}
+	if (mappingHandle)
+	{
+		CloseHandle(mappingHandle);
+		mappingHandle = nullptr;
+	}
+	if (fileHandle)
+	{
+		CloseHandle(fileHandle);
+		fileHandle = nullptr;
+	}
+	size = 0;
+	isOpen = false;
+}
+
+bool MemoryMappedFile::IsOpen() const
+{
+	return isOpen;
+}
+
+const char* MemoryMappedFile::GetData() const
+{
+	return data;
+}
+
+size_t MemoryMappedFile::GetSize() const
+{
+	return size;
+}
+
+std::string_view MemoryMappedFile::GetView() const
+{
+	return data ? std::string_view(data, size) : std::string_view();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Read-only view of a whole file mapped into the address space
+class MemoryMappedFile
+{
+private:
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+	const char* data = nullptr;
+	size_t size = 0;
+	bool isOpen = false;
+
+public:
+	MemoryMappedFile() = default;
+	MemoryMappedFile(const std::string& path);
+	~MemoryMappedFile();
+	MemoryMappedFile(const MemoryMappedFile& other) = delete;
+	MemoryMappedFile& operator=(const MemoryMappedFile& other) = delete;
+	MemoryMappedFile(MemoryMappedFile&& other) noexcept;
+	MemoryMappedFile& operator=(MemoryMappedFile&& other) noexcept;
+
+	// Returns false if the file could not be opened or mapped
+	bool Open(const std::string& path);
+	void Close();
+
+	bool IsOpen() const;
+	const char* GetData() const;
+	size_t GetSize() const;
+	std::string_view GetView() const;
+};
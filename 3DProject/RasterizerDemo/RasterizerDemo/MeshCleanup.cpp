@@ -0,0 +1,338 @@
+#include "MeshCleanup.h"
+#include "OBJParser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace DirectX;
+
+namespace
+{
+	constexpr unsigned int NO_VERTEX = UINT32_MAX;
+
+	// Triangles whose squared corner sine is below this have no area, relative to their size
+	constexpr float AREA_EPSILON = 1.0e-12f;
+
+	// Integer cell of the welding grid
+	struct CellKey
+	{
+		int64_t x;
+		int64_t y;
+		int64_t z;
+		bool operator==(const CellKey& other) const { return x == other.x && y == other.y && z == other.z; }
+	};
+	struct CellKeyHash
+	{
+		std::size_t operator()(const CellKey& key) const
+		{
+			return static_cast<std::size_t>((key.x * 73856093) ^ (key.y * 19349663) ^ (key.z * 83492791));
+		}
+	};
+
+	// A triangle's corners rotated so the smallest index comes first, keeping the winding
+	struct TriangleKey
+	{
+		unsigned int corners[3];
+		bool operator==(const TriangleKey& other) const
+		{
+			return corners[0] == other.corners[0] && corners[1] == other.corners[1] && corners[2] == other.corners[2];
+		}
+	};
+	struct TriangleKeyHash
+	{
+		std::size_t operator()(const TriangleKey& key) const
+		{
+			return (key.corners[0] * 73856093u) ^ (key.corners[1] * 19349663u) ^ (key.corners[2] * 83492791u);
+		}
+	};
+
+	TriangleKey MakeTriangleKey(unsigned int a, unsigned int b, unsigned int c)
+	{
+		if (b < a && b < c)
+			return { { b, c, a } };
+		if (c < a && c < b)
+			return { { c, a, b } };
+		return { { a, b, c } };
+	}
+
+	bool IsDegenerate(const std::vector<Vertex>& vertices, unsigned int a, unsigned int b, unsigned int c)
+	{
+		if (a == b || b == c || a == c)
+			return true;
+
+		const XMVECTOR p0 = XMLoadFloat3(&vertices[a].Position);
+		const XMVECTOR e0 = XMVectorSubtract(XMLoadFloat3(&vertices[b].Position), p0);
+		const XMVECTOR e1 = XMVectorSubtract(XMLoadFloat3(&vertices[c].Position), p0);
+
+		// |e0 x e1|^2 = |e0|^2 |e1|^2 sin^2, so the test does not depend on the mesh's scale
+		const float crossSq = XMVectorGetX(XMVector3LengthSq(XMVector3Cross(e0, e1)));
+		return crossSq <= AREA_EPSILON * XMVectorGetX(XMVector3LengthSq(e0)) * XMVectorGetX(XMVector3LengthSq(e1));
+	}
+
+	bool AttributesMatch(const Vertex& a, const Vertex& b)
+	{
+		return std::fabs(a.Normal.x - b.Normal.x) <= MeshCleanup::NORMAL_EPSILON &&
+			std::fabs(a.Normal.y - b.Normal.y) <= MeshCleanup::NORMAL_EPSILON &&
+			std::fabs(a.Normal.z - b.Normal.z) <= MeshCleanup::NORMAL_EPSILON &&
+			std::fabs(a.UV.x - b.UV.x) <= MeshCleanup::UV_EPSILON &&
+			std::fabs(a.UV.y - b.UV.y) <= MeshCleanup::UV_EPSILON;
+	}
+
+	// Compacts vertices to the referenced ones in their current order. Returns the number dropped.
+	std::size_t RemoveUnreferencedVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+	{
+		std::vector<unsigned int> newIndex(vertices.size(), NO_VERTEX);
+		for (unsigned int index : indices)
+		{
+			newIndex[index] = 0;
+		}
+
+		unsigned int kept = 0;
+		for (std::size_t v = 0; v < vertices.size(); ++v)
+		{
+			if (newIndex[v] == NO_VERTEX)
+				continue;
+
+			newIndex[v] = kept;
+			vertices[kept++] = vertices[v];
+		}
+
+		const std::size_t removed = vertices.size() - kept;
+		vertices.resize(kept);
+		for (unsigned int& index : indices)
+		{
+			index = newIndex[index];
+		}
+		return removed;
+	}
+}
+
+std::size_t MeshCleanup::WeldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, float epsilon)
+{
+	// Cells several times epsilon wide, so a match is in the vertex's own cell unless the vertex
+	// is within epsilon of a side, and only the cells across those sides need searching. Exact
+	// duplicates always share a cell whatever its size.
+	const double cellSize = epsilon > 0.0f ? 4.0 * epsilon : 1.0;
+	const float epsilonSq = epsilon * epsilon;
+
+	std::unordered_map<CellKey, unsigned int, CellKeyHash> cellHeads;
+	cellHeads.reserve(vertices.size());
+	std::vector<unsigned int> nextInCell(vertices.size(), NO_VERTEX);
+	std::vector<unsigned int> remap(vertices.size());
+
+	auto FindInCell = [&](const CellKey& cell, const Vertex& vertex)
+		{
+			const auto head = cellHeads.find(cell);
+			if (head == cellHeads.end())
+				return NO_VERTEX;
+
+			for (unsigned int other = head->second; other != NO_VERTEX; other = nextInCell[other])
+			{
+				const XMFLOAT3& p = vertices[other].Position;
+				const float dx = p.x - vertex.Position.x;
+				const float dy = p.y - vertex.Position.y;
+				const float dz = p.z - vertex.Position.z;
+				if (dx * dx + dy * dy + dz * dz <= epsilonSq && AttributesMatch(vertices[other], vertex))
+					return other;
+			}
+			return NO_VERTEX;
+		};
+
+	for (std::size_t v = 0; v < vertices.size(); ++v)
+	{
+		const Vertex& vertex = vertices[v];
+		remap[v] = static_cast<unsigned int>(v);
+
+		if (!std::isfinite(vertex.Position.x) || !std::isfinite(vertex.Position.y) || !std::isfinite(vertex.Position.z))
+			continue;
+
+		const double position[3] = { vertex.Position.x, vertex.Position.y, vertex.Position.z };
+		int64_t coordinates[3];
+		int low[3];
+		int high[3];
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const double cellPosition = std::floor(position[axis] / cellSize);
+			const double offset = position[axis] - cellPosition * cellSize;
+			coordinates[axis] = static_cast<int64_t>(cellPosition);
+			low[axis] = epsilon > 0.0f && offset <= epsilon ? -1 : 0;
+			high[axis] = epsilon > 0.0f && offset >= cellSize - epsilon ? 1 : 0;
+		}
+		const CellKey cell = { coordinates[0], coordinates[1], coordinates[2] };
+
+		// Most duplicates share the cell, so it is searched before any neighbour
+		unsigned int found = FindInCell(cell, vertex);
+		for (int dz = low[2]; dz <= high[2] && found == NO_VERTEX; ++dz)
+		{
+			for (int dy = low[1]; dy <= high[1] && found == NO_VERTEX; ++dy)
+			{
+				for (int dx = low[0]; dx <= high[0] && found == NO_VERTEX; ++dx)
+				{
+					if (dx != 0 || dy != 0 || dz != 0)
+					{
+						found = FindInCell({ cell.x + dx, cell.y + dy, cell.z + dz }, vertex);
+					}
+				}
+			}
+		}
+
+		if (found != NO_VERTEX)
+		{
+			remap[v] = found;
+			continue;
+		}
+
+		auto [head, inserted] = cellHeads.try_emplace(cell, static_cast<unsigned int>(v));
+		if (!inserted)
+		{
+			nextInCell[v] = head->second;
+			head->second = static_cast<unsigned int>(v);
+		}
+	}
+
+	for (unsigned int& index : indices)
+	{
+		index = remap[index];
+	}
+
+	return RemoveUnreferencedVertices(vertices, indices);
+}
+
+void MeshCleanup::RebuildSubMeshes(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+	std::vector<SubMeshInfo>& subMeshes, std::vector<MeshPart>& parts, MeshCleanupStatistics* statistics)
+{
+	const std::size_t nrOfSubMeshes = subMeshes.size();
+
+	// Submeshes are only merged within a run that no part starts inside of
+	std::vector<uint8_t> startsRun(nrOfSubMeshes + 1, 0);
+	startsRun[0] = 1;
+	for (const MeshPart& part : parts)
+	{
+		if (part.firstSubMesh < nrOfSubMeshes)
+		{
+			startsRun[part.firstSubMesh] = 1;
+		}
+	}
+
+	MeshCleanupStatistics counts;
+	std::vector<unsigned int> rebuilt;
+	rebuilt.reserve(indices.size());
+	std::vector<SubMeshInfo> merged;
+	std::vector<uint32_t> newFirstSubMesh(nrOfSubMeshes + 1, 0);
+	std::vector<std::size_t> materials;
+	std::unordered_set<TriangleKey, TriangleKeyHash> seen;
+
+	std::size_t runStart = 0;
+	while (runStart < nrOfSubMeshes)
+	{
+		std::size_t runEnd = runStart + 1;
+		while (runEnd < nrOfSubMeshes && !startsRun[runEnd])
+		{
+			runEnd++;
+		}
+		newFirstSubMesh[runStart] = static_cast<uint32_t>(merged.size());
+
+		materials.clear();
+		for (std::size_t s = runStart; s < runEnd; ++s)
+		{
+			if (std::find(materials.begin(), materials.end(), subMeshes[s].currentSubMeshMaterial) == materials.end())
+			{
+				materials.push_back(subMeshes[s].currentSubMeshMaterial);
+			}
+		}
+
+		for (std::size_t material : materials)
+		{
+			SubMeshInfo subMesh;
+			subMesh.startIndexValue = rebuilt.size();
+			subMesh.currentSubMeshMaterial = material;
+			seen.clear();
+
+			for (std::size_t s = runStart; s < runEnd; ++s)
+			{
+				if (subMeshes[s].currentSubMeshMaterial != material)
+					continue;
+
+				const std::size_t start = (std::min)(subMeshes[s].startIndexValue, indices.size());
+				const std::size_t end = start + (std::min)(subMeshes[s].nrOfIndicesInSubMesh, indices.size() - start) / 3 * 3;
+				for (std::size_t i = start; i < end; i += 3)
+				{
+					const unsigned int a = indices[i];
+					const unsigned int b = indices[i + 1];
+					const unsigned int c = indices[i + 2];
+					if (IsDegenerate(vertices, a, b, c))
+					{
+						counts.degenerateTriangles++;
+						continue;
+					}
+
+					// The reverse winding is the back of a two-sided surface and is kept
+					if (!seen.insert(MakeTriangleKey(a, b, c)).second)
+					{
+						counts.duplicateTriangles++;
+						continue;
+					}
+
+					rebuilt.push_back(a);
+					rebuilt.push_back(b);
+					rebuilt.push_back(c);
+				}
+			}
+
+			subMesh.nrOfIndicesInSubMesh = rebuilt.size() - subMesh.startIndexValue;
+			if (subMesh.nrOfIndicesInSubMesh > 0)
+			{
+				merged.push_back(subMesh);
+			}
+		}
+
+		runStart = runEnd;
+	}
+	newFirstSubMesh[nrOfSubMeshes] = static_cast<uint32_t>(merged.size());
+
+	// A part whose submeshes all emptied starts where the next one does; as in MeshParts::Begin,
+	// the later part keeps the submeshes
+	std::size_t keptParts = 0;
+	for (std::size_t p = 0; p < parts.size(); ++p)
+	{
+		MeshPart& part = parts[p];
+		part.firstSubMesh = part.firstSubMesh < nrOfSubMeshes ? newFirstSubMesh[part.firstSubMesh] : static_cast<uint32_t>(merged.size());
+		if (keptParts > 0 && parts[keptParts - 1].firstSubMesh == part.firstSubMesh)
+		{
+			keptParts--;
+		}
+		if (keptParts != p)
+		{
+			parts[keptParts] = std::move(part);
+		}
+		keptParts++;
+	}
+	parts.resize(keptParts);
+
+	counts.removedSubMeshes = nrOfSubMeshes - merged.size();
+	indices = std::move(rebuilt);
+	subMeshes = std::move(merged);
+
+	if (statistics)
+	{
+		statistics->degenerateTriangles += counts.degenerateTriangles;
+		statistics->duplicateTriangles += counts.duplicateTriangles;
+		statistics->removedSubMeshes += counts.removedSubMeshes;
+	}
+}
+
+void MeshCleanup::Clean(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, std::vector<SubMeshInfo>& subMeshes,
+	std::vector<MeshPart>& parts, float epsilon, MeshCleanupStatistics* statistics)
+{
+	std::size_t removedVertices = WeldVertices(vertices, indices, epsilon);
+	RebuildSubMeshes(vertices, indices, subMeshes, parts, statistics);
+	removedVertices += RemoveUnreferencedVertices(vertices, indices);
+
+	if (statistics)
+	{
+		statistics->removedVertices += removedVertices;
+	}
+}
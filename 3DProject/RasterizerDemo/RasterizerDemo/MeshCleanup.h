@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+struct Vertex;
+struct SubMeshInfo;
+struct MeshPart;
+
+// What MeshCleanup removed, added to by every call so an import can sum its passes
+struct MeshCleanupStatistics
+{
+	// Welded into another vertex or left unreferenced
+	std::size_t removedVertices = 0;
+	// Repeated corners or no area, as fans over collinear n-gon corners produce
+	std::size_t degenerateTriangles = 0;
+	// The same corners in the same winding as a triangle earlier in the submesh
+	std::size_t duplicateTriangles = 0;
+	// Draw calls saved by merging submeshes with the same material or dropping empty ones
+	std::size_t removedSubMeshes = 0;
+};
+
+// Repairs what the OBJ face dedup cannot see, since it only matches exact v/t/n index triples:
+// the same corner written under different indices, zero-area triangles, and a usemtl switching
+// back to an earlier material, which would otherwise cost a draw call per switch.
+class MeshCleanup
+{
+public:
+	// Normals further apart than this per component are a hard edge and never welded
+	static constexpr float NORMAL_EPSILON = 1.0e-3f;
+	// UVs further apart than this per component are a texture seam and never welded
+	static constexpr float UV_EPSILON = 1.0e-5f;
+
+	// Points every index at the first vertex within epsilon of its position whose normal and UV
+	// also match, then drops the vertices nothing references, keeping their order. An epsilon
+	// of 0 welds exact duplicates only. Returns the number of vertices removed.
+	static std::size_t WeldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, float epsilon);
+
+	// Rewrites indices so each part's submeshes with the same material form one contiguous
+	// submesh, in the order the materials first appear, leaving out degenerate and duplicate
+	// triangles. Submeshes left empty are dropped. parts are the ones begun by MeshParts::Begin
+	// and not yet built; their first submeshes are renumbered and no submesh crosses them.
+	static void RebuildSubMeshes(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+		std::vector<SubMeshInfo>& subMeshes, std::vector<MeshPart>& parts, MeshCleanupStatistics* statistics = nullptr);
+
+	// WeldVertices, RebuildSubMeshes, then drops the vertices only removed triangles used
+	static void Clean(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, std::vector<SubMeshInfo>& subMeshes,
+		std::vector<MeshPart>& parts, float epsilon, MeshCleanupStatistics* statistics = nullptr);
+};
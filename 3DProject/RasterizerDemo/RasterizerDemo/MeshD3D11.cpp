@@ -3,23 +3,27 @@
 
 void MeshD3D11::Initialize(ID3D11Device* device, const MeshData& meshInfo)
 {
-	vertexBuffer.Initialize(
-		device,
-		static_cast<UINT>(meshInfo.vertexInfo.sizeOfVertex),
-		static_cast<UINT>(meshInfo.vertexInfo.nrOfVerticesInBuffer),
-		meshInfo.vertexInfo.vertexData
-	);
-
-	indexBuffer.Initialize(
-		device,
-		meshInfo.indexInfo.nrOfIndicesInBuffer,
-		meshInfo.indexInfo.indexData
-	);
+	if (meshInfo.geometry)
+	{
+		geometry = meshInfo.geometry;
+	}
+	else
+	{
+		auto ownGeometry = std::make_shared<MeshGeometryD3D11>();
+		ownGeometry->Initialize(device, meshInfo);
+		geometry = std::move(ownGeometry);
+	}
+
+	meshlets.assign(meshInfo.meshletInfo.meshletData, meshInfo.meshletInfo.meshletData + meshInfo.meshletInfo.nrOfMeshlets);
+	lods = meshInfo.lods;
+	parts = meshInfo.parts;
 
 	subMeshes.clear();
 	subMeshes.reserve(meshInfo.subMeshInfo.size());
 	subMeshMaterials.clear();
 	subMeshMaterials.reserve(meshInfo.subMeshInfo.size());
+	subMeshMaterialIds.clear();
+	subMeshMaterialIds.reserve(meshInfo.subMeshInfo.size());
 
 	for (const auto& sm : meshInfo.subMeshInfo)
 	{
@@ -35,11 +39,16 @@ void MeshD3D11::Initialize(ID3D11Device* device, const MeshData& meshInfo)
 
 		subMeshes.push_back(std::move(subMesh));
 		subMeshMaterials.push_back(sm.material);
+		subMeshMaterialIds.push_back(sm.materialId);
 
 	}
 
 	// Calculate local-space bounding box from vertex data
-	if (meshInfo.vertexInfo.vertexData && meshInfo.vertexInfo.nrOfVerticesInBuffer > 0)
+	if (meshInfo.hasLocalBoundingBox)
+	{
+		localBoundingBox = meshInfo.localBoundingBox;
+	}
+	else if (meshInfo.vertexInfo.vertexData && meshInfo.vertexInfo.nrOfVerticesInBuffer > 0)
 	{
 		const float* vertexData = static_cast<const float*>(meshInfo.vertexInfo.vertexData);
 		size_t vertexStride = meshInfo.vertexInfo.sizeOfVertex / sizeof(float);
@@ -82,13 +91,12 @@ void MeshD3D11::Initialize(ID3D11Device* device, const MeshData& meshInfo)
 
 void MeshD3D11::BindMeshBuffers(ID3D11DeviceContext* context) const
 {
-	UINT stride = vertexBuffer.GetVertexSize();
-	UINT offset = 0;
-
-	ID3D11Buffer* vb = vertexBuffer.GetBuffer();
-	context->IASetVertexBuffers(0, 1, &vb, &stride, &offset);
+	geometry->Bind(context);
+}
 
-	context->IASetIndexBuffer(indexBuffer.GetBuffer(), DXGI_FORMAT_R32_UINT, 0);
+void MeshD3D11::BindPackedMeshBuffers(ID3D11DeviceContext* context) const
+{
+	geometry->BindPacked(context);
 }
 
 void MeshD3D11::PerformSubMeshDrawCall(ID3D11DeviceContext* context, size_t subMeshIndex) const
@@ -96,11 +104,23 @@ void MeshD3D11::PerformSubMeshDrawCall(ID3D11DeviceContext* context, size_t subM
 	subMeshes[subMeshIndex].PerformDrawCall(context);
 }
 
+void MeshD3D11::PerformRangeDrawCall(ID3D11DeviceContext* context, const MeshDrawRange& range) const
+{
+	context->DrawIndexed(range.nrOfIndices, range.startIndex, 0);
+}
+
 size_t MeshD3D11::GetNrOfSubMeshes() const
 {
 	return subMeshes.size();
 }
 
+MeshDrawRange MeshD3D11::GetSubMeshRange(size_t subMeshIndex) const
+{
+	const SubMeshD3D11& subMesh = subMeshes[subMeshIndex];
+	return { static_cast<uint32_t>(subMeshIndex), static_cast<uint32_t>(subMesh.GetStartIndex()),
+		static_cast<uint32_t>(subMesh.GetNrOfIndices()) };
+}
+
 ID3D11ShaderResourceView* MeshD3D11::GetAmbientSRV(size_t subMeshIndex) const
 {
 	return subMeshes[subMeshIndex].GetAmbientSRV();
@@ -124,4 +144,9 @@ ID3D11ShaderResourceView* MeshD3D11::GetNormalHeightSRV(size_t subMeshIndex) con
 const MeshData::MaterialData& MeshD3D11::GetMaterial(size_t subMeshIndex) const
 {
 	return subMeshMaterials[subMeshIndex];
+}
+
+MaterialId MeshD3D11::GetMaterialId(size_t subMeshIndex) const
+{
+	return subMeshMaterialIds[subMeshIndex];
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 #include <d3d11_4.h>
@@ -7,8 +9,12 @@
 #include <DirectXCollision.h>
 
 #include "SubMeshD3D11.h"
-#include "VertexBufferD3D11.h"
-#include "IndexBufferD3D11.h"
+#include "MeshGeometryD3D11.h"
+#include "Meshlets.h"
+#include "MeshSimplifier.h"
+#include "MeshParts.h"
+#include "MaterialLibrary.h"
+#include "VertexPacking.h"
 
 struct MeshData
 {
@@ -24,13 +30,37 @@ struct MeshData
 	{
 		size_t sizeOfVertex;
 		size_t nrOfVerticesInBuffer;
-		void* vertexData;
+		const void* vertexData;
 	}vertexInfo;
+	struct TangentInfo
+	{
+		// One per vertex, or null for meshes without tangents
+		const DirectX::XMFLOAT4* tangentData;
+	} tangentInfo;
+	struct PackedVertexInfo
+	{
+		// nrOfVerticesInBuffer * format.GetStride() bytes, or null for meshes without a packed copy
+		const void* packedVertexData;
+		PackedVertexFormat format;
+	} packedVertexInfo;
 	struct IndexInfo
 	{
 		size_t nrOfIndicesInBuffer;
-		uint32_t* indexData;
+		// uint16_t or uint32_t elements, matching indexFormat
+		const void* indexData;
+		DXGI_FORMAT indexFormat = DXGI_FORMAT_R32_UINT;
 	} indexInfo;
+	struct MeshletInfo
+	{
+		size_t nrOfMeshlets;
+		const Meshlet* meshletData;
+	} meshletInfo;
+
+	// Ranges into the same index buffer, coarsest last
+	std::vector<MeshLOD> lods;
+
+	// Separately culled objects and groups, empty for a mesh culled as a whole
+	std::vector<MeshPart> parts;
 
 	struct SubMeshInfo
 	{
@@ -42,9 +72,21 @@ struct MeshData
 		ID3D11ShaderResourceView* normalHeightTextureSRV;
 		MaterialData material;
 		size_t materialIndex;
+		// Entry in materialTable, shared with every identical material of other meshes
+		MaterialId materialId = INVALID_MATERIAL_ID;
 	};
 
 	std::vector<SubMeshInfo> subMeshInfo;
+
+	// Set when the bounds are already known (baked meshes), otherwise computed from the vertices
+	bool hasLocalBoundingBox = false;
+	DirectX::BoundingBox localBoundingBox;
+
+	// Hash of the vertex, tangent and index payloads, 0 when not hashed
+	uint64_t geometryHash = 0;
+	// Buffers shared with every mesh of the same geometryHash; uploaded from vertexInfo,
+	// tangentInfo and indexInfo when null
+	std::shared_ptr<const MeshGeometryD3D11> geometry;
 };
 
 class MeshD3D11
@@ -52,8 +94,11 @@ class MeshD3D11
 private:
 	std::vector<SubMeshD3D11> subMeshes;
 	std::vector<MeshData::MaterialData> subMeshMaterials;
-	VertexBufferD3D11 vertexBuffer;
-	IndexBufferD3D11 indexBuffer;
+	std::vector<MaterialId> subMeshMaterialIds;
+	std::shared_ptr<const MeshGeometryD3D11> geometry;
+	std::vector<Meshlet> meshlets;
+	std::vector<MeshLOD> lods;
+	std::vector<MeshPart> parts;
 	DirectX::BoundingBox localBoundingBox;
 
 public:
@@ -66,15 +111,31 @@ public:
 
 	void Initialize(ID3D11Device* device, const MeshData& meshInfo);
 
+	// Binds the vertices to slot 0 and the tangents, if any, to slot 1
 	void BindMeshBuffers(ID3D11DeviceContext* context) const;
+	// Binds the packed vertices to slot 0 instead, for PackedVertexVS; only if HasPackedVertices
+	void BindPackedMeshBuffers(ID3D11DeviceContext* context) const;
 	void PerformSubMeshDrawCall(ID3D11DeviceContext* context, size_t subMeshIndex) const;
+	// Draws part of a submesh, from meshlet culling or a LOD level
+	void PerformRangeDrawCall(ID3D11DeviceContext* context, const MeshDrawRange& range) const;
 
 	size_t GetNrOfSubMeshes() const;
+	// The whole submesh as a range, for drawing it alongside culled ones
+	MeshDrawRange GetSubMeshRange(size_t subMeshIndex) const;
 	ID3D11ShaderResourceView* GetAmbientSRV(size_t subMeshIndex) const;
 	ID3D11ShaderResourceView* GetDiffuseSRV(size_t subMeshIndex) const;
 	ID3D11ShaderResourceView* GetSpecularSRV(size_t subMeshIndex) const;
 	ID3D11ShaderResourceView* GetNormalHeightSRV(size_t subMeshIndex) const;
 	const MeshData::MaterialData& GetMaterial(size_t subMeshIndex) const;
+	MaterialId GetMaterialId(size_t subMeshIndex) const;
 
 	const DirectX::BoundingBox& GetLocalBoundingBox() const { return localBoundingBox; }
+	bool HasTangents() const { return geometry->HasTangents(); }
+	bool HasPackedVertices() const { return geometry->HasPackedVertices(); }
+	const PackedVertexFormat& GetPackedVertexFormat() const { return geometry->GetPackedVertexFormat(); }
+	// Possibly shared with other meshes
+	const MeshGeometryD3D11& GetGeometry() const { return *geometry; }
+	const std::vector<Meshlet>& GetMeshlets() const { return meshlets; }
+	const std::vector<MeshLOD>& GetLODs() const { return lods; }
+	const std::vector<MeshPart>& GetParts() const { return parts; }
 };
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "MeshGeometryD3D11.h"
+#include "MeshD3D11.h"
+
+void MeshGeometryD3D11::Initialize(ID3D11Device* device, const MeshData& meshInfo)
+{
+	nrOfVertices = meshInfo.vertexInfo.nrOfVerticesInBuffer;
+	nrOfIndices = meshInfo.indexInfo.nrOfIndicesInBuffer;
+
+	vertexBuffer.Initialize(
+		device,
+		static_cast<UINT>(meshInfo.vertexInfo.sizeOfVertex),
+		static_cast<UINT>(meshInfo.vertexInfo.nrOfVerticesInBuffer),
+		meshInfo.vertexInfo.vertexData
+	);
+	sizeInBytes = meshInfo.vertexInfo.sizeOfVertex * meshInfo.vertexInfo.nrOfVerticesInBuffer;
+
+	if (meshInfo.tangentInfo.tangentData)
+	{
+		tangentBuffer.Initialize(
+			device,
+			static_cast<UINT>(sizeof(DirectX::XMFLOAT4)),
+			static_cast<UINT>(meshInfo.vertexInfo.nrOfVerticesInBuffer),
+			meshInfo.tangentInfo.tangentData
+		);
+		sizeInBytes += sizeof(DirectX::XMFLOAT4) * meshInfo.vertexInfo.nrOfVerticesInBuffer;
+	}
+
+	if (meshInfo.packedVertexInfo.packedVertexData)
+	{
+		packedVertexFormat = meshInfo.packedVertexInfo.format;
+		packedVertexBuffer.Initialize(
+			device,
+			static_cast<UINT>(packedVertexFormat.GetStride()),
+			static_cast<UINT>(meshInfo.vertexInfo.nrOfVerticesInBuffer),
+			meshInfo.packedVertexInfo.packedVertexData
+		);
+		sizeInBytes += packedVertexFormat.GetStride() * meshInfo.vertexInfo.nrOfVerticesInBuffer;
+	}
+
+	indexBuffer.Initialize(
+		device,
+		meshInfo.indexInfo.nrOfIndicesInBuffer,
+		meshInfo.indexInfo.indexData,
+		meshInfo.indexInfo.indexFormat
+	);
+	sizeInBytes += meshInfo.indexInfo.nrOfIndicesInBuffer * (meshInfo.indexInfo.indexFormat == DXGI_FORMAT_R16_UINT ? 2 : 4);
+}
+
+bool MeshGeometryD3D11::Matches(const MeshData& meshInfo) const
+{
+	return nrOfVertices == meshInfo.vertexInfo.nrOfVerticesInBuffer
+		&& nrOfIndices == meshInfo.indexInfo.nrOfIndicesInBuffer
+		&& HasTangents() == (meshInfo.tangentInfo.tangentData != nullptr)
+		&& HasPackedVertices() == (meshInfo.packedVertexInfo.packedVertexData != nullptr);
+}
+
+void MeshGeometryD3D11::Bind(ID3D11DeviceContext* context) const
+{
+	UINT stride = vertexBuffer.GetVertexSize();
+	UINT offset = 0;
+
+	ID3D11Buffer* vb = vertexBuffer.GetBuffer();
+	context->IASetVertexBuffers(0, 1, &vb, &stride, &offset);
+
+	// Left unbound when the mesh has none, the tangent input layout then reads zeros
+	UINT tangentStride = sizeof(DirectX::XMFLOAT4);
+	ID3D11Buffer* tb = tangentBuffer.GetBuffer();
+	context->IASetVertexBuffers(1, 1, &tb, &tangentStride, &offset);
+
+	context->IASetIndexBuffer(indexBuffer.GetBuffer(), indexBuffer.GetFormat(), 0);
+}
+
+void MeshGeometryD3D11::BindPacked(ID3D11DeviceContext* context) const
+{
+	UINT stride = packedVertexBuffer.GetVertexSize();
+	UINT offset = 0;
+
+	ID3D11Buffer* vb = packedVertexBuffer.GetBuffer();
+	context->IASetVertexBuffers(0, 1, &vb, &stride, &offset);
+
+	context->IASetIndexBuffer(indexBuffer.GetBuffer(), indexBuffer.GetFormat(), 0);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+
+#include <d3d11_4.h>
+
+#include "VertexBufferD3D11.h"
+#include "IndexBufferD3D11.h"
+#include "VertexPacking.h"
+
+struct MeshData;
+
+// The GPU buffers of a mesh, kept apart from its submeshes and materials so that meshes with
+// identical geometry can share one set (see GeometryCache)
+class MeshGeometryD3D11
+{
+private:
+	VertexBufferD3D11 vertexBuffer;
+	VertexBufferD3D11 tangentBuffer;
+	VertexBufferD3D11 packedVertexBuffer;
+	PackedVertexFormat packedVertexFormat;
+	IndexBufferD3D11 indexBuffer;
+	size_t nrOfVertices = 0;
+	size_t nrOfIndices = 0;
+	size_t sizeInBytes = 0;
+
+public:
+	MeshGeometryD3D11() = default;
+	~MeshGeometryD3D11() = default;
+	MeshGeometryD3D11(const MeshGeometryD3D11& other) = delete;
+	MeshGeometryD3D11& operator=(const MeshGeometryD3D11& other) = delete;
+	MeshGeometryD3D11(MeshGeometryD3D11&& other) = delete;
+	MeshGeometryD3D11& operator=(MeshGeometryD3D11&& other) = delete;
+
+	// Uploads meshInfo's vertices, tangents, packed vertices and indices
+	void Initialize(ID3D11Device* device, const MeshData& meshInfo);
+
+	// Binds the vertices to slot 0 and the tangents, if any, to slot 1
+	void Bind(ID3D11DeviceContext* context) const;
+	// Binds the packed vertices to slot 0, for the passes drawing through PackedVertexVS
+	void BindPacked(ID3D11DeviceContext* context) const;
+
+	// Whether meshInfo describes buffers of this shape, to tell a GeometryCache hash collision
+	// from a share
+	bool Matches(const MeshData& meshInfo) const;
+
+	bool HasTangents() const { return tangentBuffer.GetBuffer() != nullptr; }
+	bool HasPackedVertices() const { return packedVertexBuffer.GetBuffer() != nullptr; }
+	const PackedVertexFormat& GetPackedVertexFormat() const { return packedVertexFormat; }
+	size_t GetSizeInBytes() const { return sizeInBytes; }
+};
@@ -0,0 +1,461 @@
+#include "MeshOptimizer.h"
+#include "OBJParser.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+using namespace DirectX;
+
+namespace
+{
+	// Forsyth's tuning: scores for a 32-entry LRU cache, the three most recent vertices share a
+	// flat score so the next triangle is not biased towards one edge of the last one
+	constexpr int FORSYTH_CACHE_SIZE = 32;
+	constexpr float CACHE_DECAY_POWER = 1.5f;
+	constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+	constexpr float VALENCE_BOOST_SCALE = 2.0f;
+	constexpr float VALENCE_BOOST_POWER = 0.5f;
+	constexpr unsigned int VALENCE_TABLE_SIZE = 32;
+
+	constexpr unsigned int NO_TRIANGLE = 0xFFFFFFFFu;
+
+	struct ScoreTables
+	{
+		std::array<float, FORSYTH_CACHE_SIZE> cache;
+		std::array<float, VALENCE_TABLE_SIZE> valence;
+	};
+
+	const ScoreTables& GetScoreTables()
+	{
+		static const ScoreTables tables = []()
+			{
+				ScoreTables values = {};
+				for (int position = 0; position < FORSYTH_CACHE_SIZE; ++position)
+				{
+					if (position < 3)
+					{
+						values.cache[position] = LAST_TRIANGLE_SCORE;
+					}
+					else
+					{
+						const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+						values.cache[position] = std::pow(1.0f - (position - 3) * scaler, CACHE_DECAY_POWER);
+					}
+				}
+				for (unsigned int valence = 0; valence < VALENCE_TABLE_SIZE; ++valence)
+				{
+					values.valence[valence] = valence == 0 ? 0.0f :
+						VALENCE_BOOST_SCALE * std::pow(static_cast<float>(valence), -VALENCE_BOOST_POWER);
+				}
+				return values;
+			}();
+		return tables;
+	}
+
+	// Vertices no remaining triangle uses score -1 so they never attract a triangle
+	float ScoreVertex(int cachePosition, unsigned int remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+			return -1.0f;
+
+		const ScoreTables& tables = GetScoreTables();
+		float score = cachePosition >= 0 ? tables.cache[cachePosition] : 0.0f;
+		score += remainingTriangles < VALENCE_TABLE_SIZE ? tables.valence[remainingTriangles] :
+			VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+		return score;
+	}
+
+	// Dense 0-based ids for the vertices a range references, so per-range work is sized by the
+	// range and not by the whole vertex buffer. Returns the number of distinct vertices.
+	std::size_t BuildLocalIds(const unsigned int* indices, std::size_t nrOfIndices, std::vector<unsigned int>& localIds)
+	{
+		std::vector<unsigned int> distinct(indices, indices + nrOfIndices);
+		std::sort(distinct.begin(), distinct.end());
+		distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+
+		localIds.resize(nrOfIndices);
+		for (std::size_t i = 0; i < nrOfIndices; ++i)
+		{
+			localIds[i] = static_cast<unsigned int>(std::lower_bound(distinct.begin(), distinct.end(), indices[i]) - distinct.begin());
+		}
+		return distinct.size();
+	}
+
+	// FIFO cache simulation by timestamps: a vertex is cached while fewer than cacheSize
+	// misses happened since it was loaded
+	class FifoCache
+	{
+	private:
+		std::vector<unsigned int> timestamps;
+		unsigned int cacheSize;
+		unsigned int time;
+
+	public:
+		FifoCache(std::size_t nrOfVertices, unsigned int cacheSize)
+			: timestamps(nrOfVertices, 0), cacheSize(cacheSize), time(cacheSize + 1)
+		{
+		}
+
+		// Returns 1 on a miss
+		unsigned int Access(unsigned int vertex)
+		{
+			if (time - timestamps[vertex] <= cacheSize)
+				return 0;
+
+			timestamps[vertex] = time++;
+			return 1;
+		}
+
+		void Flush()
+		{
+			time += cacheSize + 1;
+		}
+	};
+
+	struct Cluster
+	{
+		std::size_t firstTriangle;
+		std::size_t nrOfTriangles;
+		float sortKey;
+	};
+}
+
+VertexCacheStatistics MeshOptimizer::AnalyzeVertexCache(const unsigned int* indices, std::size_t nrOfIndices,
+	std::size_t nrOfVertices, unsigned int cacheSize)
+{
+	VertexCacheStatistics statistics;
+	if (nrOfIndices < 3 || nrOfVertices == 0)
+		return statistics;
+
+	FifoCache cache(nrOfVertices, cacheSize);
+	std::vector<bool> referenced(nrOfVertices, false);
+	std::size_t nrOfMisses = 0;
+	std::size_t nrOfReferenced = 0;
+
+	for (std::size_t i = 0; i < nrOfIndices; ++i)
+	{
+		nrOfMisses += cache.Access(indices[i]);
+		if (!referenced[indices[i]])
+		{
+			referenced[indices[i]] = true;
+			++nrOfReferenced;
+		}
+	}
+
+	statistics.acmr = static_cast<float>(nrOfMisses) / static_cast<float>(nrOfIndices / 3);
+	statistics.atvr = static_cast<float>(nrOfMisses) / static_cast<float>(nrOfReferenced);
+	return statistics;
+}
+
+void MeshOptimizer::OptimizeVertexCache(unsigned int* indices, std::size_t nrOfIndices)
+{
+	const std::size_t nrOfTriangles = nrOfIndices / 3;
+	if (nrOfTriangles < 2)
+		return;
+
+	std::vector<unsigned int> localIds;
+	const std::size_t nrOfVertices = BuildLocalIds(indices, nrOfTriangles * 3, localIds);
+
+	// Triangles per vertex as a flat adjacency list; remaining[v] shrinks as triangles are emitted
+	std::vector<unsigned int> remaining(nrOfVertices, 0);
+	for (std::size_t i = 0; i < nrOfTriangles * 3; ++i)
+	{
+		remaining[localIds[i]]++;
+	}
+
+	std::vector<std::size_t> adjacencyOffsets(nrOfVertices + 1, 0);
+	for (std::size_t v = 0; v < nrOfVertices; ++v)
+	{
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remaining[v];
+	}
+
+	std::vector<unsigned int> adjacency(nrOfTriangles * 3);
+	{
+		std::vector<std::size_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (std::size_t t = 0; t < nrOfTriangles; ++t)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				adjacency[fill[localIds[t * 3 + k]]++] = static_cast<unsigned int>(t);
+			}
+		}
+	}
+
+	std::vector<int> cachePositions(nrOfVertices, -1);
+	std::vector<float> vertexScores(nrOfVertices);
+	for (std::size_t v = 0; v < nrOfVertices; ++v)
+	{
+		vertexScores[v] = ScoreVertex(-1, remaining[v]);
+	}
+
+	std::vector<float> triangleScores(nrOfTriangles);
+	std::vector<bool> emitted(nrOfTriangles, false);
+	unsigned int bestTriangle = 0;
+	for (std::size_t t = 0; t < nrOfTriangles; ++t)
+	{
+		triangleScores[t] = vertexScores[localIds[t * 3]] + vertexScores[localIds[t * 3 + 1]] + vertexScores[localIds[t * 3 + 2]];
+		if (triangleScores[t] > triangleScores[bestTriangle])
+		{
+			bestTriangle = static_cast<unsigned int>(t);
+		}
+	}
+
+	std::vector<unsigned int> output;
+	output.reserve(nrOfTriangles * 3);
+
+	// Three extra slots hold the vertices pushed out by the newest triangle until their scores are updated
+	std::array<unsigned int, FORSYTH_CACHE_SIZE + 3> cache;
+	std::array<unsigned int, FORSYTH_CACHE_SIZE + 3> nextCache;
+	std::size_t cacheLength = 0;
+	std::size_t inputCursor = 0;
+
+	for (std::size_t nrOfEmitted = 0; nrOfEmitted < nrOfTriangles; ++nrOfEmitted)
+	{
+		// No cached vertex has triangles left: restart from the next triangle in input order
+		if (bestTriangle == NO_TRIANGLE)
+		{
+			while (emitted[inputCursor])
+			{
+				++inputCursor;
+			}
+			bestTriangle = static_cast<unsigned int>(inputCursor);
+		}
+
+		const unsigned int triangle = bestTriangle;
+		emitted[triangle] = true;
+
+		const unsigned int* corners = &localIds[static_cast<std::size_t>(triangle) * 3];
+		for (int k = 0; k < 3; ++k)
+		{
+			output.push_back(indices[static_cast<std::size_t>(triangle) * 3 + k]);
+
+			// Swap the triangle out of the vertex's live adjacency
+			const unsigned int v = corners[k];
+			unsigned int* list = &adjacency[adjacencyOffsets[v]];
+			for (unsigned int j = 0; j < remaining[v]; ++j)
+			{
+				if (list[j] == triangle)
+				{
+					std::swap(list[j], list[remaining[v] - 1]);
+					break;
+				}
+			}
+			remaining[v]--;
+		}
+
+		// The triangle's vertices move to the front, everything else shifts back
+		std::size_t nextLength = 0;
+		for (int k = 0; k < 3; ++k)
+		{
+			nextCache[nextLength++] = corners[k];
+		}
+		for (std::size_t i = 0; i < cacheLength; ++i)
+		{
+			const unsigned int v = cache[i];
+			if (v != corners[0] && v != corners[1] && v != corners[2])
+			{
+				nextCache[nextLength++] = v;
+			}
+		}
+
+		bestTriangle = NO_TRIANGLE;
+		float bestScore = -1.0f;
+		for (std::size_t i = 0; i < nextLength; ++i)
+		{
+			const unsigned int v = nextCache[i];
+			cachePositions[v] = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+
+			const float score = ScoreVertex(cachePositions[v], remaining[v]);
+			const float delta = score - vertexScores[v];
+			vertexScores[v] = score;
+
+			const unsigned int* list = &adjacency[adjacencyOffsets[v]];
+			for (unsigned int j = 0; j < remaining[v]; ++j)
+			{
+				const unsigned int t = list[j];
+				triangleScores[t] += delta;
+				if (triangleScores[t] > bestScore)
+				{
+					bestScore = triangleScores[t];
+					bestTriangle = t;
+				}
+			}
+		}
+
+		cacheLength = (std::min)(nextLength, static_cast<std::size_t>(FORSYTH_CACHE_SIZE));
+		std::copy(nextCache.begin(), nextCache.begin() + cacheLength, cache.begin());
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+void MeshOptimizer::OptimizeOverdraw(unsigned int* indices, std::size_t nrOfIndices, const std::vector<Vertex>& vertices,
+	float threshold)
+{
+	const std::size_t nrOfTriangles = nrOfIndices / 3;
+	if (nrOfTriangles < 2)
+		return;
+
+	std::vector<unsigned int> localIds;
+	const std::size_t nrOfVertices = BuildLocalIds(indices, nrOfTriangles * 3, localIds);
+
+	// Hard boundaries: a triangle that misses on all three vertices starts over anyway
+	std::vector<std::size_t> hardStarts;
+	{
+		FifoCache cache(nrOfVertices, STATISTICS_CACHE_SIZE);
+		for (std::size_t t = 0; t < nrOfTriangles; ++t)
+		{
+			unsigned int misses = cache.Access(localIds[t * 3]) + cache.Access(localIds[t * 3 + 1]) + cache.Access(localIds[t * 3 + 2]);
+			if (misses == 3)
+			{
+				hardStarts.push_back(t);
+			}
+		}
+	}
+	hardStarts.push_back(nrOfTriangles);
+
+	// Soft boundaries: split a hard cluster wherever its prefix is already within threshold of the
+	// cluster's own ACMR, so the smaller clusters can be reordered without losing cache reuse
+	std::vector<Cluster> clusters;
+	FifoCache cache(nrOfVertices, STATISTICS_CACHE_SIZE);
+	for (std::size_t h = 0; h + 1 < hardStarts.size(); ++h)
+	{
+		const std::size_t start = hardStarts[h];
+		const std::size_t end = hardStarts[h + 1];
+
+		cache.Flush();
+		std::size_t clusterMisses = 0;
+		for (std::size_t t = start; t < end; ++t)
+		{
+			clusterMisses += cache.Access(localIds[t * 3]) + cache.Access(localIds[t * 3 + 1]) + cache.Access(localIds[t * 3 + 2]);
+		}
+		const float clusterThreshold = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+		cache.Flush();
+		std::size_t softStart = start;
+		std::size_t softMisses = 0;
+		for (std::size_t t = start; t < end; ++t)
+		{
+			softMisses += cache.Access(localIds[t * 3]) + cache.Access(localIds[t * 3 + 1]) + cache.Access(localIds[t * 3 + 2]);
+
+			const float prefixAcmr = static_cast<float>(softMisses) / static_cast<float>(t + 1 - softStart);
+			if (t + 1 < end && prefixAcmr <= clusterThreshold)
+			{
+				clusters.push_back({ softStart, t + 1 - softStart, 0.0f });
+				softStart = t + 1;
+				softMisses = 0;
+				cache.Flush();
+			}
+		}
+		clusters.push_back({ softStart, end - softStart, 0.0f });
+	}
+
+	if (clusters.size() < 2)
+		return;
+
+	// Area-weighted centroids and normals of every cluster and of the whole range
+	std::vector<XMFLOAT3> clusterCentroids(clusters.size());
+	std::vector<XMFLOAT3> clusterNormals(clusters.size());
+	XMVECTOR meshCentroid = XMVectorZero();
+	float meshArea = 0.0f;
+
+	for (std::size_t c = 0; c < clusters.size(); ++c)
+	{
+		XMVECTOR centroid = XMVectorZero();
+		XMVECTOR normal = XMVectorZero();
+		float area = 0.0f;
+
+		for (std::size_t t = clusters[c].firstTriangle; t < clusters[c].firstTriangle + clusters[c].nrOfTriangles; ++t)
+		{
+			XMVECTOR p0 = XMLoadFloat3(&vertices[indices[t * 3]].Position);
+			XMVECTOR p1 = XMLoadFloat3(&vertices[indices[t * 3 + 1]].Position);
+			XMVECTOR p2 = XMLoadFloat3(&vertices[indices[t * 3 + 2]].Position);
+
+			XMVECTOR faceNormal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+			float faceArea = XMVectorGetX(XMVector3Length(faceNormal)) * 0.5f;
+
+			centroid = XMVectorAdd(centroid, XMVectorScale(XMVectorAdd(XMVectorAdd(p0, p1), p2), faceArea / 3.0f));
+			normal = XMVectorAdd(normal, faceNormal);
+			area += faceArea;
+		}
+
+		meshCentroid = XMVectorAdd(meshCentroid, centroid);
+		meshArea += area;
+
+		XMStoreFloat3(&clusterCentroids[c], area > 0.0f ? XMVectorScale(centroid, 1.0f / area) : centroid);
+		XMStoreFloat3(&clusterNormals[c], XMVector3Normalize(normal));
+	}
+
+	if (meshArea > 0.0f)
+	{
+		meshCentroid = XMVectorScale(meshCentroid, 1.0f / meshArea);
+	}
+
+	// Clusters far out along their own normal face away from the rest of the mesh and hide it
+	for (std::size_t c = 0; c < clusters.size(); ++c)
+	{
+		XMVECTOR offset = XMVectorSubtract(XMLoadFloat3(&clusterCentroids[c]), meshCentroid);
+		clusters[c].sortKey = XMVectorGetX(XMVector3Dot(offset, XMLoadFloat3(&clusterNormals[c])));
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(),
+		[](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+	std::vector<unsigned int> output;
+	output.reserve(nrOfTriangles * 3);
+	for (const Cluster& cluster : clusters)
+	{
+		output.insert(output.end(), indices + cluster.firstTriangle * 3,
+			indices + (cluster.firstTriangle + cluster.nrOfTriangles) * 3);
+	}
+	std::copy(output.begin(), output.end(), indices);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	constexpr unsigned int UNUSED = 0xFFFFFFFFu;
+
+	std::vector<unsigned int> remap(vertices.size(), UNUSED);
+	std::vector<Vertex> reordered;
+	reordered.reserve(vertices.size());
+
+	for (unsigned int& index : indices)
+	{
+		if (remap[index] == UNUSED)
+		{
+			remap[index] = static_cast<unsigned int>(reordered.size());
+			reordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	vertices.swap(reordered);
+}
+
+void MeshOptimizer::Optimize(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+	const std::vector<SubMeshInfo>& subMeshes, VertexCacheStatistics* before, VertexCacheStatistics* after)
+{
+	if (before)
+	{
+		*before = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+	}
+
+	for (const SubMeshInfo& subMesh : subMeshes)
+	{
+		if (subMesh.nrOfIndicesInSubMesh < 3 || subMesh.startIndexValue + subMesh.nrOfIndicesInSubMesh > indices.size())
+			continue;
+
+		unsigned int* range = indices.data() + subMesh.startIndexValue;
+		OptimizeVertexCache(range, subMesh.nrOfIndicesInSubMesh);
+		OptimizeOverdraw(range, subMesh.nrOfIndicesInSubMesh, vertices);
+	}
+
+	OptimizeVertexFetch(vertices, indices);
+
+	if (after)
+	{
+		*after = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+	}
+}
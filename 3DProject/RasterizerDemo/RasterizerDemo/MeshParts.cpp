@@ -0,0 +1,168 @@
+#include "MeshParts.h"
+#include "OBJParser.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+
+void MeshParts::Begin(std::string_view name, std::size_t firstSubMesh, std::vector<MeshPart>& parts)
+{
+	if (!parts.empty() && parts.back().firstSubMesh == firstSubMesh)
+	{
+		parts.back().name = name;
+		return;
+	}
+
+	MeshPart part;
+	part.name = name;
+	part.firstSubMesh = static_cast<uint32_t>(firstSubMesh);
+	parts.push_back(std::move(part));
+}
+
+void MeshParts::Build(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+	const std::vector<SubMeshInfo>& subMeshes, const std::vector<Meshlet>& meshlets, std::vector<MeshPart>& parts)
+{
+	// A part begun after the last submesh has no faces
+	while (!parts.empty() && parts.back().firstSubMesh >= subMeshes.size())
+	{
+		parts.pop_back();
+	}
+
+	if (!parts.empty() && parts.front().firstSubMesh > 0)
+	{
+		parts.insert(parts.begin(), MeshPart{});
+	}
+
+	if (parts.size() < 2)
+	{
+		parts.clear();
+		return;
+	}
+
+	// Marks the vertices already gathered for the current part
+	std::vector<uint32_t> vertexStamp(vertices.size(), 0);
+	std::vector<XMFLOAT3> points;
+	std::size_t meshlet = 0;
+
+	for (std::size_t p = 0; p < parts.size(); ++p)
+	{
+		MeshPart& part = parts[p];
+		const std::size_t endSubMesh = p + 1 < parts.size() ? parts[p + 1].firstSubMesh : subMeshes.size();
+		part.nrOfSubMeshes = static_cast<uint32_t>(endSubMesh - part.firstSubMesh);
+
+		while (meshlet < meshlets.size() && meshlets[meshlet].subMeshIndex < part.firstSubMesh)
+		{
+			meshlet++;
+		}
+		part.firstMeshlet = static_cast<uint32_t>(meshlet);
+		while (meshlet < meshlets.size() && meshlets[meshlet].subMeshIndex < endSubMesh)
+		{
+			meshlet++;
+		}
+		part.nrOfMeshlets = static_cast<uint32_t>(meshlet - part.firstMeshlet);
+
+		points.clear();
+		const uint32_t stamp = static_cast<uint32_t>(p + 1);
+		for (std::size_t s = part.firstSubMesh; s < endSubMesh; ++s)
+		{
+			const std::size_t start = (std::min)(subMeshes[s].startIndexValue, indices.size());
+			const std::size_t end = start + (std::min)(subMeshes[s].nrOfIndicesInSubMesh, indices.size() - start);
+			for (std::size_t i = start; i < end; ++i)
+			{
+				const unsigned int vertex = indices[i];
+				if (vertexStamp[vertex] != stamp)
+				{
+					vertexStamp[vertex] = stamp;
+					points.push_back(vertices[vertex].Position);
+				}
+			}
+		}
+
+		if (points.empty())
+		{
+			part.boundingBox = BoundingBox(XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 0));
+			part.boundingSphere = BoundingSphere(XMFLOAT3(0, 0, 0), 0.0f);
+			continue;
+		}
+
+		BoundingBox::CreateFromPoints(part.boundingBox, points.size(), points.data(), sizeof(XMFLOAT3));
+		BoundingSphere::CreateFromPoints(part.boundingSphere, points.size(), points.data(), sizeof(XMFLOAT3));
+	}
+}
+
+std::size_t MeshParts::Cull(const std::vector<MeshPart>& parts, const XMMATRIX& world,
+	const BoundingFrustum& frustum, std::vector<uint8_t>& visibleParts, MeshPartCullStatistics* statistics)
+{
+	visibleParts.assign(parts.size(), 0);
+
+	// World planes (pointing out of the frustum) into mesh-local space, as in Meshlets::Cull
+	XMVECTOR planes[6];
+	frustum.GetPlanes(&planes[0], &planes[1], &planes[2], &planes[3], &planes[4], &planes[5]);
+	const XMMATRIX worldTranspose = XMMatrixTranspose(world);
+	for (XMVECTOR& plane : planes)
+	{
+		plane = XMPlaneNormalize(XMVector4Transform(plane, worldTranspose));
+	}
+
+	MeshPartCullStatistics counts;
+	for (std::size_t p = 0; p < parts.size(); ++p)
+	{
+		const MeshPart& part = parts[p];
+		const XMVECTOR sphereCenter = XMLoadFloat3(&part.boundingSphere.Center);
+		const XMVECTOR boxCenter = XMLoadFloat3(&part.boundingBox.Center);
+		const XMVECTOR boxExtents = XMLoadFloat3(&part.boundingBox.Extents);
+
+		bool outside = false;
+		for (const XMVECTOR& plane : planes)
+		{
+			if (XMVectorGetX(XMPlaneDotCoord(plane, sphereCenter)) > part.boundingSphere.Radius)
+			{
+				outside = true;
+				break;
+			}
+
+			// The box reaches |n| . extents along the plane normal
+			const float reach = XMVectorGetX(XMVector3Dot(XMVectorAbs(plane), boxExtents));
+			if (XMVectorGetX(XMPlaneDotCoord(plane, boxCenter)) > reach)
+			{
+				outside = true;
+				break;
+			}
+		}
+
+		if (outside)
+		{
+			++counts.culled;
+			continue;
+		}
+
+		++counts.visible;
+		visibleParts[p] = 1;
+	}
+
+	if (statistics)
+	{
+		*statistics = counts;
+	}
+	return counts.visible;
+}
+
+void MeshParts::FilterRanges(const std::vector<MeshPart>& parts, const std::vector<uint8_t>& visibleParts,
+	const std::vector<MeshDrawRange>& ranges, std::vector<MeshDrawRange>& result)
+{
+	result.clear();
+
+	std::size_t p = 0;
+	for (const MeshDrawRange& range : ranges)
+	{
+		while (p < parts.size() && range.subMeshIndex >= parts[p].firstSubMesh + parts[p].nrOfSubMeshes)
+		{
+			p++;
+		}
+
+		if (p < parts.size() && visibleParts[p])
+		{
+			result.push_back(range);
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+#include "Meshlets.h"
+
+struct Vertex;
+struct SubMeshInfo;
+
+// An OBJ object or group (o, g): consecutive submeshes with their own bounds, so the parts of a
+// large mesh that are out of view can be skipped without testing their meshlets
+struct MeshPart
+{
+	std::string name;
+	uint32_t firstSubMesh = 0;
+	uint32_t nrOfSubMeshes = 0;
+	// Meshlets follow submesh order, so a part's meshlets are consecutive too
+	uint32_t firstMeshlet = 0;
+	uint32_t nrOfMeshlets = 0;
+
+	// Mesh-local, over the full-detail triangles
+	DirectX::BoundingBox boundingBox;
+	DirectX::BoundingSphere boundingSphere;
+};
+
+struct MeshPartCullStatistics
+{
+	std::size_t culled = 0;
+	std::size_t visible = 0;
+};
+
+// Splits meshes along their object and group records at import and culls the parts per frame.
+// A mesh with a single part keeps none, the object test already covers it.
+class MeshParts
+{
+public:
+	// Starts a part at firstSubMesh. A part that would be left without submeshes, as with an o
+	// record directly followed by a g record, is renamed instead, so the last name wins.
+	static void Begin(std::string_view name, std::size_t firstSubMesh, std::vector<MeshPart>& parts);
+
+	// Closes the parts started with Begin, adds an unnamed part for any submeshes before the
+	// first record and computes the bounds and meshlet ranges. Clears parts when there is only one.
+	static void Build(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+		const std::vector<SubMeshInfo>& subMeshes, const std::vector<Meshlet>& meshlets, std::vector<MeshPart>& parts);
+
+	// Tests each part's sphere and then box against the frustum in mesh-local space, so any affine
+	// world matrix works. visibleParts gets one entry per part, nonzero when it may be visible.
+	// Returns the number of those.
+	static std::size_t Cull(const std::vector<MeshPart>& parts, const DirectX::XMMATRIX& world,
+		const DirectX::BoundingFrustum& frustum, std::vector<uint8_t>& visibleParts, MeshPartCullStatistics* statistics = nullptr);
+
+	// The ranges belonging to visible parts; ranges must be in submesh order, as LOD levels and
+	// Meshlets::Cull produce them
+	static void FilterRanges(const std::vector<MeshPart>& parts, const std::vector<uint8_t>& visibleParts,
+		const std::vector<MeshDrawRange>& ranges, std::vector<MeshDrawRange>& result);
+};
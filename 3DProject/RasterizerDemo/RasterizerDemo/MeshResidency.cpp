@@ -0,0 +1,371 @@
+#include "MeshResidency.h"
+
+#include <Windows.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+
+namespace
+{
+	// The geometry and the distinct textures of a mesh, each once, with the memory they use
+	void GetResources(const MeshD3D11& mesh, std::vector<std::pair<const void*, size_t>>& resources)
+	{
+		resources.clear();
+		resources.push_back({ &mesh.GetGeometry(), mesh.GetGeometry().GetSizeInBytes() });
+
+		for (size_t i = 0; i < mesh.GetNrOfSubMeshes(); ++i)
+		{
+			const ID3D11ShaderResourceView* textures[] = { mesh.GetAmbientSRV(i), mesh.GetDiffuseSRV(i),
+				mesh.GetSpecularSRV(i), mesh.GetNormalHeightSRV(i) };
+			for (const ID3D11ShaderResourceView* texture : textures)
+			{
+				if (!texture)
+					continue;
+
+				const bool seen = std::any_of(resources.begin(), resources.end(),
+					[texture](const std::pair<const void*, size_t>& resource) { return resource.first == texture; });
+				if (!seen)
+				{
+					resources.push_back({ texture, textureCache.GetSizeInBytes(texture) });
+				}
+			}
+		}
+	}
+}
+
+MeshResidencyManager::Entry* MeshResidencyManager::FindEntry(MeshHandle handle)
+{
+	if (handle.index >= entries.size())
+	{
+		return nullptr;
+	}
+
+	Entry& entry = entries[handle.index];
+	return entry.inUse && entry.generation == handle.generation ? &entry : nullptr;
+}
+
+const MeshResidencyManager::Entry* MeshResidencyManager::FindEntry(MeshHandle handle) const
+{
+	if (handle.index >= entries.size())
+	{
+		return nullptr;
+	}
+
+	const Entry& entry = entries[handle.index];
+	return entry.inUse && entry.generation == handle.generation ? &entry : nullptr;
+}
+
+void MeshResidencyManager::Charge(const MeshD3D11& mesh)
+{
+	std::vector<std::pair<const void*, size_t>> resources;
+	GetResources(mesh, resources);
+
+	for (const auto& [key, sizeInBytes] : resources)
+	{
+		SharedResource& resource = sharedResources[key];
+		if (resource.nrOfUsers++ == 0)
+		{
+			resource.sizeInBytes = sizeInBytes;
+			residentBytes += sizeInBytes;
+		}
+	}
+}
+
+void MeshResidencyManager::Discharge(const MeshD3D11& mesh)
+{
+	std::vector<std::pair<const void*, size_t>> resources;
+	GetResources(mesh, resources);
+
+	// Released by the size recorded in Charge; a texture may have left textureCache since
+	for (const auto& resource : resources)
+	{
+		auto found = sharedResources.find(resource.first);
+		if (found == sharedResources.end())
+		{
+			continue;
+		}
+
+		if (--found->second.nrOfUsers == 0)
+		{
+			residentBytes -= found->second.sizeInBytes;
+			sharedResources.erase(found);
+		}
+	}
+}
+
+void MeshResidencyManager::Evict(Entry& entry)
+{
+	Discharge(*entry.mesh);
+	entry.mesh.reset();
+	nrOfEvictions++;
+}
+
+MeshHandle MeshResidencyManager::Add(const std::string& path, std::unique_ptr<MeshD3D11> mesh)
+{
+	uint32_t index = 0;
+	auto found = slotsByPath.find(path);
+	if (found != slotsByPath.end())
+	{
+		index = found->second;
+		Entry& entry = entries[index];
+		if (entry.mesh)
+		{
+			Discharge(*entry.mesh);
+		}
+		else
+		{
+			nrOfReloads++;
+		}
+	}
+	else
+	{
+		if (!freeSlots.empty())
+		{
+			index = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else
+		{
+			index = static_cast<uint32_t>(entries.size());
+			entries.emplace_back();
+		}
+
+		Entry& entry = entries[index];
+		entry.path = path;
+		entry.inUse = true;
+		slotsByPath.emplace(path, index);
+	}
+
+	Entry& entry = entries[index];
+	Charge(*mesh);
+	entry.mesh = std::move(mesh);
+	entry.localBoundingBox = entry.mesh->GetLocalBoundingBox();
+	entry.lastUsedFrame = currentFrame;
+
+	return { index, entry.generation };
+}
+
+MeshHandle MeshResidencyManager::Find(const std::string& path) const
+{
+	auto found = slotsByPath.find(path);
+	if (found == slotsByPath.end())
+	{
+		return {};
+	}
+
+	return { found->second, entries[found->second].generation };
+}
+
+bool MeshResidencyManager::IsResident(const std::string& path) const
+{
+	auto found = slotsByPath.find(path);
+	return found != slotsByPath.end() && entries[found->second].mesh != nullptr;
+}
+
+const MeshD3D11* MeshResidencyManager::Acquire(MeshHandle handle)
+{
+	Entry* entry = FindEntry(handle);
+	if (!entry)
+	{
+		return nullptr;
+	}
+
+	// A mesh is drawn several times a frame (shadows, sorting, the pass itself) but counted once
+	const bool firstUseThisFrame = entry->lastUsedFrame != currentFrame;
+	entry->lastUsedFrame = currentFrame;
+
+	if (entry->mesh)
+	{
+		if (firstUseThisFrame) nrOfHits++;
+		return entry->mesh.get();
+	}
+
+	if (firstUseThisFrame) nrOfMisses++;
+	if (!entry->reload.pending.valid())
+	{
+		entry->reload = RequestMesh(entry->path);
+	}
+	return nullptr;
+}
+
+DirectX::BoundingBox MeshResidencyManager::GetLocalBoundingBox(MeshHandle handle) const
+{
+	const Entry* entry = FindEntry(handle);
+	if (!entry)
+	{
+		return DirectX::BoundingBox(DirectX::XMFLOAT3(0, 0, 0), DirectX::XMFLOAT3(0, 0, 0));
+	}
+
+	return entry->localBoundingBox;
+}
+
+void MeshResidencyManager::Update(ID3D11Device* device)
+{
+	for (Entry& entry : entries)
+	{
+		if (!entry.reload.pending.valid() ||
+			entry.reload.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			continue;
+		}
+
+		// Refills the entry through Add, unless another load of the file already did
+		try
+		{
+			FinishMesh(entry.reload, device);
+		}
+		catch (const std::exception& e)
+		{
+			// Left evicted; the next Acquire tries again
+			std::string msg = "Reloading " + entry.path + " failed: " + e.what() + "\n";
+			OutputDebugStringA(msg.c_str());
+		}
+	}
+
+	currentFrame++;
+
+	if (budgetBytes == 0 || residentBytes <= budgetBytes)
+	{
+		return;
+	}
+
+	std::vector<Entry*> candidates;
+	for (Entry& entry : entries)
+	{
+		if (entry.inUse && entry.mesh && entry.lastUsedFrame + 1 < currentFrame)
+		{
+			candidates.push_back(&entry);
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [](const Entry* a, const Entry* b)
+		{
+			return a->lastUsedFrame < b->lastUsedFrame;
+		});
+
+	size_t nrEvicted = 0;
+	for (Entry* entry : candidates)
+	{
+		if (residentBytes <= budgetBytes)
+		{
+			break;
+		}
+
+		Evict(*entry);
+		nrEvicted++;
+	}
+
+	// The evicted meshes released their texture and geometry references, this drops the caches' own
+	if (nrEvicted > 0)
+	{
+		textureCache.ReleaseUnreferenced();
+		geometryCache.ReleaseUnreferenced();
+	}
+}
+
+void MeshResidencyManager::SetBudget(size_t bytes)
+{
+	budgetBytes = bytes;
+}
+
+size_t MeshResidencyManager::GetBudget() const
+{
+	return budgetBytes;
+}
+
+size_t MeshResidencyManager::GetResidentBytes() const
+{
+	return residentBytes;
+}
+
+void MeshResidencyManager::Release(MeshHandle handle)
+{
+	Entry* entry = FindEntry(handle);
+	if (!entry)
+	{
+		return;
+	}
+
+	if (entry->mesh)
+	{
+		Discharge(*entry->mesh);
+		entry->mesh.reset();
+	}
+
+	// An import still running finishes on its own and is dropped
+	entry->reload = {};
+	slotsByPath.erase(entry->path);
+	entry->path.clear();
+	entry->inUse = false;
+	entry->generation++;
+	freeSlots.push_back(handle.index);
+}
+
+void MeshResidencyManager::Clear()
+{
+	for (uint32_t i = 0; i < entries.size(); ++i)
+	{
+		Entry& entry = entries[i];
+		if (!entry.inUse)
+		{
+			continue;
+		}
+
+		// The caches the import writes to are usually cleared next
+		if (entry.reload.pending.valid())
+		{
+			entry.reload.pending.wait();
+		}
+		Release({ i, entry.generation });
+	}
+
+	ResetStatistics();
+}
+
+MeshResidencyStatistics MeshResidencyManager::GetStatistics() const
+{
+	MeshResidencyStatistics statistics;
+	statistics.hits = nrOfHits;
+	statistics.misses = nrOfMisses;
+	statistics.evictions = nrOfEvictions;
+	statistics.reloads = nrOfReloads;
+	statistics.nrOfMeshes = slotsByPath.size();
+	statistics.residentBytes = residentBytes;
+	statistics.budgetBytes = budgetBytes;
+
+	for (const Entry& entry : entries)
+	{
+		if (entry.inUse && entry.mesh)
+		{
+			statistics.nrOfResidentMeshes++;
+		}
+	}
+
+	return statistics;
+}
+
+void MeshResidencyManager::ResetStatistics()
+{
+	nrOfHits = 0;
+	nrOfMisses = 0;
+	nrOfEvictions = 0;
+	nrOfReloads = 0;
+}
+
+void MeshResidencyManager::ReportStatistics() const
+{
+	const MeshResidencyStatistics statistics = GetStatistics();
+
+	char budget[64] = "no budget";
+	if (statistics.budgetBytes > 0)
+	{
+		std::snprintf(budget, sizeof(budget), "budget %.1f KB", statistics.budgetBytes / 1024.0);
+	}
+
+	char buffer[256];
+	std::snprintf(buffer, sizeof(buffer), "Mesh residency: %zu of %zu meshes resident (%.1f KB, %s), %zu hits, %zu misses, %zu evictions, %zu reloads\n",
+		statistics.nrOfResidentMeshes, statistics.nrOfMeshes, statistics.residentBytes / 1024.0, budget,
+		statistics.hits, statistics.misses, statistics.evictions, statistics.reloads);
+	OutputDebugStringA(buffer);
+}
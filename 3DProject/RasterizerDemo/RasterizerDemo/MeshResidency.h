@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <d3d11.h>
+#include <DirectXCollision.h>
+
+#include "OBJParser.h"
+#include "MeshD3D11.h"
+
+// Names a mesh held by the MeshResidencyManager. The mesh behind a handle may be evicted and
+// reloaded any number of times; the generation only changes when the mesh is released and its
+// slot given to another file, so a handle kept past that resolves to nothing instead of the
+// wrong mesh.
+struct MeshHandle
+{
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+
+	bool IsValid() const { return index != UINT32_MAX; }
+	bool operator==(const MeshHandle& other) const = default;
+};
+
+struct MeshResidencyStatistics
+{
+	// Per mesh and frame: the first Acquire that found it resident, or that had to reload it
+	size_t hits = 0;
+	size_t misses = 0;
+	size_t evictions = 0;
+	// Evicted meshes brought back, by a miss or by loading the file again
+	size_t reloads = 0;
+
+	size_t nrOfMeshes = 0;
+	size_t nrOfResidentMeshes = 0;
+	size_t residentBytes = 0;
+	size_t budgetBytes = 0;
+};
+
+// Owns every loaded mesh and keeps the GPU memory they use under a budget. Meshes are counted by
+// the size of their vertex, tangent and index buffers and of their textures. Buffers shared
+// through geometryCache and textures shared through textureCache are counted once, while any
+// resident mesh uses them. Neither cache keeps them alive on its own (geometryCache holds its
+// buffers weakly, textureCache drops unreferenced textures after evicting), so evicting a mesh
+// frees exactly what it stops counting. Over budget, the meshes drawn longest ago are evicted,
+// keeping their bounds so they can still be culled, and the next Acquire reloads them on the
+// loader pool, from the baked mesh cache when there is one.
+// Device thread only.
+class MeshResidencyManager
+{
+private:
+	struct Entry
+	{
+		std::string path;
+		uint32_t generation = 0;
+		bool inUse = false;
+		// Null while evicted
+		std::unique_ptr<MeshD3D11> mesh;
+		// Started by a miss, picked up by Update
+		MeshRequest reload;
+		uint64_t lastUsedFrame = 0;
+		DirectX::BoundingBox localBoundingBox;
+	};
+
+	// A geometry or texture used by resident meshes
+	struct SharedResource
+	{
+		size_t nrOfUsers = 0;
+		size_t sizeInBytes = 0;
+	};
+
+	std::vector<Entry> entries;
+	std::vector<uint32_t> freeSlots;
+	std::unordered_map<std::string, uint32_t> slotsByPath;
+	std::unordered_map<const void*, SharedResource> sharedResources;
+
+	size_t budgetBytes = 0;
+	size_t residentBytes = 0;
+	uint64_t currentFrame = 1;
+
+	size_t nrOfHits = 0;
+	size_t nrOfMisses = 0;
+	size_t nrOfEvictions = 0;
+	size_t nrOfReloads = 0;
+
+	Entry* FindEntry(MeshHandle handle);
+	const Entry* FindEntry(MeshHandle handle) const;
+	// Count the mesh's geometry and textures toward residentBytes, or stop counting them
+	void Charge(const MeshD3D11& mesh);
+	void Discharge(const MeshD3D11& mesh);
+	void Evict(Entry& entry);
+
+public:
+	MeshResidencyManager() = default;
+	~MeshResidencyManager() = default;
+	MeshResidencyManager(const MeshResidencyManager& other) = delete;
+	MeshResidencyManager& operator=(const MeshResidencyManager& other) = delete;
+	MeshResidencyManager(MeshResidencyManager&& other) = delete;
+	MeshResidencyManager& operator=(MeshResidencyManager&& other) = delete;
+
+	// Takes the mesh created for path, giving it a new slot or refilling the one it was evicted
+	// from. Counts as used this frame.
+	MeshHandle Add(const std::string& path, std::unique_ptr<MeshD3D11> mesh);
+	// The handle for path whether or not it is resident, invalid if it was never added
+	MeshHandle Find(const std::string& path) const;
+	bool IsResident(const std::string& path) const;
+
+	// The mesh to draw this frame, or nullptr while it is being reloaded and for stale handles.
+	// Marks the mesh as used this frame, so it is not evicted at the next Update.
+	const MeshD3D11* Acquire(MeshHandle handle);
+	// The mesh's local bounds, also while it is evicted; an empty box for stale handles
+	DirectX::BoundingBox GetLocalBoundingBox(MeshHandle handle) const;
+
+	// Once per frame, before anything is drawn: creates the meshes whose reloads have finished,
+	// then evicts the least recently drawn until the resident bytes fit the budget. Meshes drawn
+	// in the previous frame are never evicted, so a budget smaller than what one frame draws is
+	// exceeded rather than reloading the same meshes every frame.
+	void Update(ID3D11Device* device);
+
+	// 0, the default, is no budget
+	void SetBudget(size_t bytes);
+	size_t GetBudget() const;
+	size_t GetResidentBytes() const;
+
+	// Unloads the mesh and frees its slot; handles to it go stale
+	void Release(MeshHandle handle);
+	// Releases every mesh, waiting for reloads in flight
+	void Clear();
+
+	MeshResidencyStatistics GetStatistics() const;
+	void ResetStatistics();
+	// Writes the statistics to the debug output
+	void ReportStatistics() const;
+};
+
+// Every mesh loaded through GetMesh, FinishMesh and ParseOBJ
+extern MeshResidencyManager meshResidency;
@@ -0,0 +1,583 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "OBJParser.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace DirectX;
+
+namespace
+{
+	constexpr unsigned int NO_VERTEX = 0xFFFFFFFFu;
+
+	// Weight of the planes that hold borders and seams in place, relative to the surface planes
+	constexpr double BOUNDARY_WEIGHT = 10.0;
+
+	// Cosine of the largest turn a collapse may give a surviving triangle; anything more folds it over
+	constexpr float MAX_NORMAL_TURN = 0.25f;
+
+	// A level keeping more than this share of the previous level's triangles is not stored
+	constexpr float MIN_LOD_REDUCTION = 0.85f;
+
+	enum class VertexKind : unsigned char
+	{
+		Manifold,	// interior vertex with one set of attributes, collapses onto any neighbour
+		Border,		// on an open edge of the mesh, slides along it
+		Seam,		// one of two vertices splitting attributes along an edge, slides with its twin
+		Locked,		// corner, crossing seams or shared between submeshes; never moves
+	};
+
+	// Sum of squared distances to a set of weighted planes, as a symmetric 4x4 matrix
+	struct Quadric
+	{
+		double a00 = 0.0, a11 = 0.0, a22 = 0.0;
+		double a01 = 0.0, a02 = 0.0, a12 = 0.0;
+		double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+		double c = 0.0;
+		double weight = 0.0;
+
+		// Plane n.p + d = 0 with unit n
+		void AddPlane(double nx, double ny, double nz, double d, double w)
+		{
+			a00 += w * nx * nx; a11 += w * ny * ny; a22 += w * nz * nz;
+			a01 += w * nx * ny; a02 += w * nx * nz; a12 += w * ny * nz;
+			b0 += w * nx * d; b1 += w * ny * d; b2 += w * nz * d;
+			c += w * d * d;
+			weight += w;
+		}
+
+		void Add(const Quadric& other)
+		{
+			a00 += other.a00; a11 += other.a11; a22 += other.a22;
+			a01 += other.a01; a02 += other.a02; a12 += other.a12;
+			b0 += other.b0; b1 += other.b1; b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+		}
+
+		// Weighted sum of squared plane distances, not yet divided by the weight
+		double Evaluate(const XMFLOAT3& position) const
+		{
+			const double x = position.x, y = position.y, z = position.z;
+			const double r = a00 * x * x + a11 * y * y + a22 * z * z +
+				2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+				2.0 * (b0 * x + b1 * y + b2 * z) + c;
+			return std::fabs(r);
+		}
+	};
+
+	// Mean squared distance of position to the planes of both quadrics
+	double CollapseError(const Quadric& from, const Quadric& to, const XMFLOAT3& position)
+	{
+		const double weight = from.weight + to.weight;
+		return weight > 0.0 ? (from.Evaluate(position) + to.Evaluate(position)) / weight : 0.0;
+	}
+
+	// For every vertex, the first vertex with the same position, so seam twins share a quadric
+	void BuildPositionRemap(const std::vector<XMFLOAT3>& positions, std::vector<unsigned int>& remap)
+	{
+		struct PositionKey
+		{
+			uint32_t bits[3];
+			bool operator==(const PositionKey& other) const { return std::memcmp(bits, other.bits, sizeof(bits)) == 0; }
+		};
+		struct PositionKeyHash
+		{
+			std::size_t operator()(const PositionKey& key) const
+			{
+				return (key.bits[0] * 73856093u) ^ (key.bits[1] * 19349663u) ^ (key.bits[2] * 83492791u);
+			}
+		};
+
+		std::unordered_map<PositionKey, unsigned int, PositionKeyHash> firstVertex;
+		firstVertex.reserve(positions.size());
+		remap.resize(positions.size());
+
+		for (std::size_t v = 0; v < positions.size(); ++v)
+		{
+			// Adding zero turns -0 into +0 so both hash alike
+			const float position[3] = { positions[v].x + 0.0f, positions[v].y + 0.0f, positions[v].z + 0.0f };
+			PositionKey key;
+			std::memcpy(key.bits, position, sizeof(key.bits));
+			remap[v] = firstVertex.emplace(key, static_cast<unsigned int>(v)).first->second;
+		}
+	}
+
+	// Triangles around each vertex in compressed rows
+	void BuildTriangleAdjacency(const std::vector<unsigned int>& indices, std::size_t nrOfVertices,
+		std::vector<unsigned int>& offsets, std::vector<unsigned int>& triangles, std::vector<unsigned int>& fill)
+	{
+		offsets.assign(nrOfVertices + 1, 0);
+		for (unsigned int index : indices)
+		{
+			++offsets[index + 1];
+		}
+		for (std::size_t v = 0; v < nrOfVertices; ++v)
+		{
+			offsets[v + 1] += offsets[v];
+		}
+
+		fill.assign(offsets.begin(), offsets.end() - 1);
+		triangles.resize(indices.size());
+		for (std::size_t i = 0; i < indices.size(); ++i)
+		{
+			triangles[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+		}
+	}
+
+	// True if moving from onto to turns over a triangle around from that survives the collapse
+	bool CollapseFlipsTriangle(const std::vector<XMFLOAT3>& positions, const std::vector<unsigned int>& indices,
+		const std::vector<unsigned int>& offsets, const std::vector<unsigned int>& triangles, unsigned int from, unsigned int to)
+	{
+		const XMVECTOR target = XMLoadFloat3(&positions[to]);
+		for (unsigned int k = offsets[from]; k < offsets[from + 1]; ++k)
+		{
+			const unsigned int* corner = &indices[triangles[k] * 3];
+			if (corner[0] == to || corner[1] == to || corner[2] == to)
+				continue;
+
+			XMVECTOR before[3];
+			XMVECTOR after[3];
+			for (int c = 0; c < 3; ++c)
+			{
+				before[c] = XMLoadFloat3(&positions[corner[c]]);
+				after[c] = corner[c] == from ? target : before[c];
+			}
+
+			XMVECTOR normalBefore = XMVector3Cross(XMVectorSubtract(before[1], before[0]), XMVectorSubtract(before[2], before[0]));
+			XMVECTOR normalAfter = XMVector3Cross(XMVectorSubtract(after[1], after[0]), XMVectorSubtract(after[2], after[0]));
+			const float lengthBefore = XMVectorGetX(XMVector3Length(normalBefore));
+			if (lengthBefore <= 0.0f)
+				continue;
+
+			if (XMVectorGetX(XMVector3Dot(normalBefore, normalAfter)) <= MAX_NORMAL_TURN * lengthBefore * XMVectorGetX(XMVector3Length(normalAfter)))
+				return true;
+		}
+		return false;
+	}
+
+	uint64_t EdgeKey(unsigned int from, unsigned int to)
+	{
+		return (static_cast<uint64_t>(from) << 32) | to;
+	}
+}
+
+float MeshSimplifier::Simplify(const std::vector<Vertex>& vertices, const unsigned int* indices, std::size_t nrOfIndices,
+	std::size_t targetIndexCount, float targetError, const std::vector<unsigned char>* lockedVertices,
+	std::vector<unsigned int>& destination)
+{
+	// Start from the non-degenerate triangles
+	destination.clear();
+	for (std::size_t i = 0; i + 2 < nrOfIndices; i += 3)
+	{
+		const unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+		if (a != b && b != c && a != c)
+		{
+			destination.insert(destination.end(), { a, b, c });
+		}
+	}
+
+	if (destination.size() <= targetIndexCount)
+		return 0.0f;
+
+	// Work on the vertices these triangles use, numbered in their original order, so the cost
+	// follows the submesh rather than the whole vertex buffer
+	std::vector<unsigned int> localToGlobal(destination.begin(), destination.end());
+	std::sort(localToGlobal.begin(), localToGlobal.end());
+	localToGlobal.erase(std::unique(localToGlobal.begin(), localToGlobal.end()), localToGlobal.end());
+	for (unsigned int& index : destination)
+	{
+		index = static_cast<unsigned int>(std::lower_bound(localToGlobal.begin(), localToGlobal.end(), index) - localToGlobal.begin());
+	}
+
+	const std::size_t nrOfVertices = localToGlobal.size();
+	std::vector<XMFLOAT3> positions(nrOfVertices);
+	for (std::size_t v = 0; v < nrOfVertices; ++v)
+	{
+		positions[v] = vertices[localToGlobal[v]].Position;
+	}
+
+	std::vector<unsigned int> remap;
+	BuildPositionRemap(positions, remap);
+
+	// Open edges have no reverse twin; a directed edge seen twice makes both ends non-manifold
+	std::unordered_set<uint64_t> edges;
+	edges.reserve(destination.size());
+	std::vector<unsigned char> nonManifold(nrOfVertices, 0);
+	for (std::size_t i = 0; i < destination.size(); i += 3)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			const unsigned int a = destination[i + k];
+			const unsigned int b = destination[i + (k + 1) % 3];
+			if (!edges.insert(EdgeKey(a, b)).second)
+			{
+				nonManifold[a] = 1;
+				nonManifold[b] = 1;
+			}
+		}
+	}
+
+	std::vector<unsigned int> openOut(nrOfVertices, NO_VERTEX);
+	std::vector<unsigned int> openIn(nrOfVertices, NO_VERTEX);
+	std::vector<unsigned char> openOutCount(nrOfVertices, 0);
+	std::vector<unsigned char> openInCount(nrOfVertices, 0);
+	std::vector<Quadric> quadrics(nrOfVertices);
+
+	for (std::size_t i = 0; i < destination.size(); i += 3)
+	{
+		const unsigned int* corner = &destination[i];
+		const XMVECTOR p0 = XMLoadFloat3(&positions[corner[0]]);
+		const XMVECTOR p1 = XMLoadFloat3(&positions[corner[1]]);
+		const XMVECTOR p2 = XMLoadFloat3(&positions[corner[2]]);
+
+		XMVECTOR normal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+		const float doubleArea = XMVectorGetX(XMVector3Length(normal));
+		if (doubleArea > 0.0f)
+		{
+			normal = XMVectorScale(normal, 1.0f / doubleArea);
+			XMFLOAT3 n;
+			XMStoreFloat3(&n, normal);
+			const double d = -XMVectorGetX(XMVector3Dot(normal, p0));
+			for (int k = 0; k < 3; ++k)
+			{
+				quadrics[remap[corner[k]]].AddPlane(n.x, n.y, n.z, d, doubleArea * 0.5);
+			}
+		}
+
+		for (int k = 0; k < 3; ++k)
+		{
+			const unsigned int a = corner[k];
+			const unsigned int b = corner[(k + 1) % 3];
+			if (edges.count(EdgeKey(b, a)))
+				continue;
+
+			openOut[a] = b;
+			openIn[b] = a;
+			openOutCount[a] = static_cast<unsigned char>((std::min)(openOutCount[a] + 1, 2));
+			openInCount[b] = static_cast<unsigned char>((std::min)(openInCount[b] + 1, 2));
+
+			// A plane through the open edge, perpendicular to the triangle, keeps the edge in place
+			if (doubleArea > 0.0f)
+			{
+				const XMVECTOR pa = XMLoadFloat3(&positions[a]);
+				const XMVECTOR edge = XMVectorSubtract(XMLoadFloat3(&positions[b]), pa);
+				const float edgeLengthSq = XMVectorGetX(XMVector3LengthSq(edge));
+				const XMVECTOR edgeNormal = XMVector3Normalize(XMVector3Cross(edge, normal));
+				XMFLOAT3 n;
+				XMStoreFloat3(&n, edgeNormal);
+				const double d = -XMVectorGetX(XMVector3Dot(edgeNormal, pa));
+				quadrics[remap[a]].AddPlane(n.x, n.y, n.z, d, edgeLengthSq * BOUNDARY_WEIGHT);
+				quadrics[remap[b]].AddPlane(n.x, n.y, n.z, d, edgeLengthSq * BOUNDARY_WEIGHT);
+			}
+		}
+	}
+
+	// Vertices sharing a position, linked in a ring
+	std::vector<unsigned int> wedge(nrOfVertices);
+	{
+		std::vector<unsigned int> lastInRing(nrOfVertices, NO_VERTEX);
+		for (unsigned int v = 0; v < nrOfVertices; ++v)
+		{
+			wedge[v] = v;
+			const unsigned int first = remap[v];
+			if (lastInRing[first] == NO_VERTEX)
+			{
+				lastInRing[first] = v;
+				continue;
+			}
+
+			// Insert v after the ring's last member
+			const unsigned int previous = lastInRing[first];
+			wedge[v] = wedge[previous];
+			wedge[previous] = v;
+			lastInRing[first] = v;
+		}
+	}
+
+	std::vector<VertexKind> kinds(nrOfVertices, VertexKind::Locked);
+	for (unsigned int v = 0; v < nrOfVertices; ++v)
+	{
+		if (nonManifold[v] || (lockedVertices && (*lockedVertices)[localToGlobal[v]]))
+			continue;
+
+		const unsigned int twin = wedge[v];
+		if (twin == v)
+		{
+			if (openOutCount[v] == 0 && openInCount[v] == 0)
+				kinds[v] = VertexKind::Manifold;
+			else if (openOutCount[v] == 1 && openInCount[v] == 1)
+				kinds[v] = VertexKind::Border;
+		}
+		else if (wedge[twin] == v && !nonManifold[twin] && !(lockedVertices && (*lockedVertices)[localToGlobal[twin]]) &&
+			openOutCount[v] == 1 && openInCount[v] == 1 && openOutCount[twin] == 1 && openInCount[twin] == 1 &&
+			remap[openOut[v]] == remap[openIn[twin]] && remap[openIn[v]] == remap[openOut[twin]])
+		{
+			kinds[v] = VertexKind::Seam;
+		}
+	}
+
+	auto CanCollapse = [&](unsigned int from, unsigned int to)
+		{
+			switch (kinds[from])
+			{
+			case VertexKind::Manifold:
+				return true;
+			case VertexKind::Border:
+			case VertexKind::Seam:
+				return kinds[to] != VertexKind::Manifold && (openOut[from] == to || openIn[from] == to);
+			default:
+				return false;
+			}
+		};
+
+	struct Collapse
+	{
+		unsigned int from;
+		unsigned int to;
+		double error;
+	};
+
+	std::vector<Collapse> candidates;
+	std::vector<unsigned int> offsets, triangles, fill;
+	std::vector<unsigned int> collapseTarget(nrOfVertices);
+	std::vector<unsigned char> touched(nrOfVertices);
+	const double errorLimit = static_cast<double>(targetError) * targetError;
+	double largestError = 0.0;
+
+	// Each pass collapses the cheapest edges whose neighbourhoods do not overlap
+	while (destination.size() > targetIndexCount)
+	{
+		BuildTriangleAdjacency(destination, nrOfVertices, offsets, triangles, fill);
+
+		candidates.clear();
+		for (std::size_t i = 0; i < destination.size(); i += 3)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				const unsigned int a = destination[i + k];
+				const unsigned int b = destination[i + (k + 1) % 3];
+				if (remap[a] == remap[b])
+					continue;
+
+				const double errorAB = CanCollapse(a, b) ? CollapseError(quadrics[remap[a]], quadrics[remap[b]], positions[b]) : DBL_MAX;
+				const double errorBA = CanCollapse(b, a) ? CollapseError(quadrics[remap[b]], quadrics[remap[a]], positions[a]) : DBL_MAX;
+				if (errorAB == DBL_MAX && errorBA == DBL_MAX)
+					continue;
+
+				candidates.push_back(errorAB <= errorBA ? Collapse{ a, b, errorAB } : Collapse{ b, a, errorBA });
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [](const Collapse& x, const Collapse& y) { return x.error < y.error; });
+
+		for (unsigned int v = 0; v < nrOfVertices; ++v)
+		{
+			collapseTarget[v] = v;
+		}
+		std::fill(touched.begin(), touched.end(), 0);
+
+		const std::size_t trianglesToRemove = (destination.size() - targetIndexCount) / 3;
+		std::size_t removed = 0;
+		std::size_t nrOfCollapses = 0;
+
+		for (const Collapse& collapse : candidates)
+		{
+			if (collapse.error > errorLimit || removed >= trianglesToRemove)
+				break;
+
+			const unsigned int from = collapse.from;
+			const unsigned int to = collapse.to;
+			if (touched[remap[from]] || touched[remap[to]])
+				continue;
+
+			// A seam vertex takes its twin along to the vertex at the same position on the other side
+			unsigned int twinFrom = NO_VERTEX;
+			unsigned int twinTo = NO_VERTEX;
+			if (kinds[from] == VertexKind::Seam)
+			{
+				twinFrom = wedge[from];
+				twinTo = openOut[from] == to ? openIn[twinFrom] : openOut[twinFrom];
+				if (twinTo == NO_VERTEX || remap[twinTo] != remap[to])
+					continue;
+			}
+
+			if (CollapseFlipsTriangle(positions, destination, offsets, triangles, from, to) ||
+				(twinFrom != NO_VERTEX && CollapseFlipsTriangle(positions, destination, offsets, triangles, twinFrom, twinTo)))
+			{
+				continue;
+			}
+
+			for (unsigned int side = 0; side < 2; ++side)
+			{
+				const unsigned int moving = side == 0 ? from : twinFrom;
+				const unsigned int target = side == 0 ? to : twinTo;
+				if (moving == NO_VERTEX)
+					continue;
+
+				collapseTarget[moving] = target;
+				for (unsigned int k = offsets[moving]; k < offsets[moving + 1]; ++k)
+				{
+					const unsigned int* corner = &destination[triangles[k] * 3];
+					removed += (corner[0] == target || corner[1] == target || corner[2] == target) ? 1 : 0;
+					touched[remap[corner[0]]] = 1;
+					touched[remap[corner[1]]] = 1;
+					touched[remap[corner[2]]] = 1;
+				}
+
+				// Keep the open-edge links current for the next pass
+				if (kinds[moving] != VertexKind::Manifold)
+				{
+					const unsigned int previous = openIn[moving];
+					const unsigned int next = openOut[moving];
+					if (target == next && previous != NO_VERTEX)
+					{
+						openOut[previous] = target;
+						openIn[target] = previous;
+					}
+					else if (target == previous && next != NO_VERTEX)
+					{
+						openIn[next] = target;
+						openOut[target] = next;
+					}
+				}
+			}
+
+			quadrics[remap[to]].Add(quadrics[remap[from]]);
+			largestError = (std::max)(largestError, collapse.error);
+			++nrOfCollapses;
+		}
+
+		if (nrOfCollapses == 0)
+			break;
+
+		std::size_t write = 0;
+		for (std::size_t i = 0; i < destination.size(); i += 3)
+		{
+			const unsigned int a = collapseTarget[destination[i]];
+			const unsigned int b = collapseTarget[destination[i + 1]];
+			const unsigned int c = collapseTarget[destination[i + 2]];
+			if (a == b || b == c || a == c)
+				continue;
+
+			destination[write++] = a;
+			destination[write++] = b;
+			destination[write++] = c;
+		}
+		destination.resize(write);
+	}
+
+	for (unsigned int& index : destination)
+	{
+		index = localToGlobal[index];
+	}
+
+	return static_cast<float>(std::sqrt(largestError));
+}
+
+void MeshSimplifier::GenerateLODs(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+	const std::vector<SubMeshInfo>& subMeshes, std::vector<MeshLOD>& lods)
+{
+	lods.clear();
+
+	// Positions used by more than one submesh stay put, so levels never open cracks between materials
+	std::vector<XMFLOAT3> positions(vertices.size());
+	for (std::size_t v = 0; v < vertices.size(); ++v)
+	{
+		positions[v] = vertices[v].Position;
+	}
+
+	std::vector<unsigned int> remap;
+	BuildPositionRemap(positions, remap);
+	std::vector<unsigned int> owner(vertices.size(), NO_VERTEX);
+	std::vector<unsigned char> shared(vertices.size(), 0);
+
+	const std::size_t fullIndexCount = indices.size();
+	std::size_t previousTriangles = 0;
+	for (std::size_t s = 0; s < subMeshes.size(); ++s)
+	{
+		const std::size_t start = (std::min)(subMeshes[s].startIndexValue, fullIndexCount);
+		const std::size_t count = (std::min)(subMeshes[s].nrOfIndicesInSubMesh, fullIndexCount - start);
+		previousTriangles += count / 3;
+
+		for (std::size_t i = start; i < start + count; ++i)
+		{
+			unsigned int& first = owner[remap[indices[i]]];
+			if (first == NO_VERTEX)
+				first = static_cast<unsigned int>(s);
+			else if (first != s)
+				shared[remap[indices[i]]] = 1;
+		}
+	}
+
+	std::vector<unsigned char> locked(vertices.size(), 0);
+	for (std::size_t v = 0; v < vertices.size(); ++v)
+	{
+		locked[v] = shared[remap[v]];
+	}
+
+	std::vector<unsigned int> simplified;
+	std::vector<unsigned int> levelIndices;
+	float previousError = 0.0f;
+
+	for (float ratio : LOD_RATIOS)
+	{
+		MeshLOD lod;
+		levelIndices.clear();
+
+		for (std::size_t s = 0; s < subMeshes.size(); ++s)
+		{
+			const std::size_t start = (std::min)(subMeshes[s].startIndexValue, fullIndexCount);
+			const std::size_t count = (std::min)(subMeshes[s].nrOfIndicesInSubMesh, fullIndexCount - start);
+			const std::size_t target = static_cast<std::size_t>(count / 3 * ratio) * 3;
+
+			// Every level starts from the full mesh so errors do not compound
+			const float error = Simplify(vertices, indices.data() + start, count, target, FLT_MAX, &locked, simplified);
+			if (simplified.empty())
+				continue;
+
+			MeshOptimizer::OptimizeVertexCache(simplified.data(), simplified.size());
+			lod.ranges.push_back({ static_cast<uint32_t>(s), static_cast<uint32_t>(levelIndices.size()), static_cast<uint32_t>(simplified.size()) });
+			levelIndices.insert(levelIndices.end(), simplified.begin(), simplified.end());
+			lod.error = (std::max)(lod.error, error);
+		}
+
+		const std::size_t levelTriangles = levelIndices.size() / 3;
+		if (levelTriangles > previousTriangles * MIN_LOD_REDUCTION)
+			break;
+
+		// Coarser levels never claim less error than finer ones, so selection can stop at the first miss
+		lod.error = (std::max)(lod.error, previousError);
+		for (MeshDrawRange& range : lod.ranges)
+		{
+			range.startIndex += static_cast<uint32_t>(indices.size());
+		}
+		indices.insert(indices.end(), levelIndices.begin(), levelIndices.end());
+
+		previousTriangles = levelTriangles;
+		previousError = lod.error;
+		lods.push_back(std::move(lod));
+	}
+}
+
+std::size_t MeshSimplifier::SelectLOD(const std::vector<MeshLOD>& lods, float distance, float worldScale,
+	float projectionScale, float maxPixelError)
+{
+	const float pixelsPerUnit = worldScale * projectionScale / (std::max)(distance, 1.0e-4f);
+
+	std::size_t level = 0;
+	for (std::size_t i = 0; i < lods.size(); ++i)
+	{
+		if (lods[i].error * pixelsPerUnit > maxPixelError)
+			break;
+
+		level = i + 1;
+	}
+	return level;
+}
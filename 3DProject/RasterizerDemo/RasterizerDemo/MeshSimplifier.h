@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Meshlets.h"
+
+struct Vertex;
+struct SubMeshInfo;
+
+// One reduced level of a mesh. Its indices live in the mesh's index buffer after the full
+// detail ones and reference the same vertices, so switching level only changes the ranges drawn.
+struct MeshLOD
+{
+	// Largest distance from the full-detail surface, in model units
+	float error = 0.0f;
+	// One range per submesh with triangles left, in submesh order
+	std::vector<MeshDrawRange> ranges;
+};
+
+// Import-time level of detail through quadric-error edge collapses (Garland-Heckbert), each
+// vertex moving onto a neighbour so no vertices are added. Vertices on a UV or normal seam only
+// slide along the seam together with their twin, border vertices only along the border, and
+// vertices where submeshes meet or several seams cross stay put, so textures and materials
+// keep their boundaries at every level.
+class MeshSimplifier
+{
+public:
+	// Fractions of the full triangle count the generated levels aim for
+	static constexpr float LOD_RATIOS[] = { 0.5f, 0.25f, 0.125f };
+
+	// Collapses edges cheapest first until at most targetIndexCount indices remain, no collapse
+	// under targetError is left or the topology allows no more. lockedVertices, if given, marks
+	// vertices that must not move. Returns the error introduced, in model units.
+	static float Simplify(const std::vector<Vertex>& vertices, const unsigned int* indices, std::size_t nrOfIndices,
+		std::size_t targetIndexCount, float targetError, const std::vector<unsigned char>* lockedVertices,
+		std::vector<unsigned int>& destination);
+
+	// Simplifies every submesh to each of LOD_RATIOS, appends the results to indices and
+	// describes them in lods. Stops early once a level barely reduces the previous one.
+	static void GenerateLODs(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+		const std::vector<SubMeshInfo>& subMeshes, std::vector<MeshLOD>& lods);
+
+	// Coarsest level whose error, projected to the screen, stays within maxPixelError.
+	// projectionScale is viewport height / (2 tan(fovY / 2)); 0 means full detail, i means lods[i - 1].
+	static std::size_t SelectLOD(const std::vector<MeshLOD>& lods, float distance, float worldScale,
+		float projectionScale, float maxPixelError = 1.0f);
+};
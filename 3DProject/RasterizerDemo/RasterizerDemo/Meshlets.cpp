@@ -0,0 +1,242 @@
+#include "Meshlets.h"
+#include "OBJParser.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	// Cones wider than about 84 degrees either way almost never cull, so they are not kept
+	constexpr float CONE_MIN_DOT = 0.1f;
+	constexpr float NO_CONE_CUTOFF = 2.0f;
+
+	// Below this ratio of |cross product| to longest edge squared the facing of a triangle is
+	// float rounding; such slivers cover no pixels and are left out of the cone
+	constexpr float SLIVER_RATIO = 1.0e-5f;
+
+	// Scratch shared by every meshlet of a Build call
+	struct MeshletScratch
+	{
+		std::vector<XMFLOAT3> points;
+		std::vector<XMFLOAT3> normals;
+		std::vector<XMFLOAT3> planePoints;
+	};
+
+	Meshlet MakeMeshlet(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+		std::size_t start, std::size_t end, std::size_t subMeshIndex, const std::vector<unsigned int>& meshletVertices,
+		MeshletScratch& scratch)
+	{
+		Meshlet meshlet = {};
+		meshlet.startIndex = static_cast<uint32_t>(start);
+		meshlet.nrOfIndices = static_cast<uint32_t>(end - start);
+		meshlet.subMeshIndex = static_cast<uint32_t>(subMeshIndex);
+		meshlet.nrOfVertices = static_cast<uint32_t>(meshletVertices.size());
+
+		scratch.points.clear();
+		for (unsigned int vertex : meshletVertices)
+		{
+			scratch.points.push_back(vertices[vertex].Position);
+		}
+
+		BoundingSphere sphere;
+		BoundingSphere::CreateFromPoints(sphere, scratch.points.size(), scratch.points.data(), sizeof(XMFLOAT3));
+		meshlet.center = sphere.Center;
+		meshlet.radius = sphere.Radius;
+
+		// Facing normals from the winding D3D11 treats as front (clockwise in a left-handed view)
+		scratch.normals.clear();
+		scratch.planePoints.clear();
+		XMVECTOR normalSum = XMVectorZero();
+		for (std::size_t i = start; i < end; i += 3)
+		{
+			XMVECTOR p0 = XMLoadFloat3(&vertices[indices[i]].Position);
+			XMVECTOR p1 = XMLoadFloat3(&vertices[indices[i + 1]].Position);
+			XMVECTOR p2 = XMLoadFloat3(&vertices[indices[i + 2]].Position);
+
+			XMVECTOR edge0 = XMVectorSubtract(p1, p0);
+			XMVECTOR edge1 = XMVectorSubtract(p2, p0);
+			XMVECTOR normal = XMVector3Cross(edge0, edge1);
+			float length = XMVectorGetX(XMVector3Length(normal));
+			float longestEdgeSq = (std::max)({ XMVectorGetX(XMVector3LengthSq(edge0)), XMVectorGetX(XMVector3LengthSq(edge1)),
+				XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(p2, p1))) });
+			if (length <= SLIVER_RATIO * longestEdgeSq)
+				continue;
+
+			normal = XMVectorScale(normal, 1.0f / length);
+			normalSum = XMVectorAdd(normalSum, normal);
+
+			XMFLOAT3 storedNormal;
+			XMStoreFloat3(&storedNormal, normal);
+			scratch.normals.push_back(storedNormal);
+			scratch.planePoints.push_back(vertices[indices[i]].Position);
+		}
+
+		meshlet.coneCutoff = NO_CONE_CUTOFF;
+		meshlet.coneApex = meshlet.center;
+		if (scratch.normals.empty() || XMVectorGetX(XMVector3LengthSq(normalSum)) <= 0.0f)
+			return meshlet;
+
+		const XMVECTOR axis = XMVector3Normalize(normalSum);
+		XMStoreFloat3(&meshlet.coneAxis, axis);
+
+		float minDot = 1.0f;
+		for (const XMFLOAT3& normal : scratch.normals)
+		{
+			minDot = (std::min)(minDot, XMVectorGetX(XMVector3Dot(axis, XMLoadFloat3(&normal))));
+		}
+
+		if (minDot <= CONE_MIN_DOT)
+			return meshlet;
+
+		// The apex sits behind every triangle's plane: from there along the axis, each triangle
+		// is seen from its back or edge-on, and so is it from anywhere inside the cone
+		const XMVECTOR center = XMLoadFloat3(&meshlet.center);
+		float apexDistance = 0.0f;
+		bool first = true;
+		for (std::size_t t = 0; t < scratch.normals.size(); ++t)
+		{
+			XMVECTOR normal = XMLoadFloat3(&scratch.normals[t]);
+			float planeDistance = XMVectorGetX(XMVector3Dot(XMVectorSubtract(XMLoadFloat3(&scratch.planePoints[t]), center), normal));
+			float distance = planeDistance / XMVectorGetX(XMVector3Dot(axis, normal));
+			apexDistance = first ? distance : (std::min)(apexDistance, distance);
+			first = false;
+		}
+
+		XMStoreFloat3(&meshlet.coneApex, XMVectorAdd(center, XMVectorScale(axis, apexDistance)));
+		meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+		return meshlet;
+	}
+}
+
+void Meshlets::Build(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+	const std::vector<SubMeshInfo>& subMeshes, std::vector<Meshlet>& meshlets)
+{
+	meshlets.clear();
+
+	// Marks the vertices the current meshlet already references
+	std::vector<uint32_t> vertexStamp(vertices.size(), 0);
+	uint32_t stamp = 0;
+
+	std::vector<unsigned int> meshletVertices;
+	meshletVertices.reserve(MAX_VERTICES);
+	MeshletScratch scratch;
+
+	for (std::size_t s = 0; s < subMeshes.size(); ++s)
+	{
+		const std::size_t start = (std::min)(subMeshes[s].startIndexValue, indices.size());
+		const std::size_t count = (std::min)(subMeshes[s].nrOfIndicesInSubMesh, indices.size() - start);
+		const std::size_t end = start + count - count % 3;
+
+		std::size_t meshletStart = start;
+		meshletVertices.clear();
+		++stamp;
+
+		for (std::size_t i = start; i < end; i += 3)
+		{
+			const unsigned int a = indices[i];
+			const unsigned int b = indices[i + 1];
+			const unsigned int c = indices[i + 2];
+			const std::size_t newVertices = (vertexStamp[a] != stamp) +
+				(vertexStamp[b] != stamp && b != a) +
+				(vertexStamp[c] != stamp && c != a && c != b);
+
+			if (meshletVertices.size() + newVertices > MAX_VERTICES || (i - meshletStart) / 3 >= MAX_TRIANGLES)
+			{
+				meshlets.push_back(MakeMeshlet(vertices, indices, meshletStart, i, s, meshletVertices, scratch));
+				meshletStart = i;
+				meshletVertices.clear();
+				++stamp;
+			}
+
+			for (unsigned int vertex : { a, b, c })
+			{
+				if (vertexStamp[vertex] != stamp)
+				{
+					vertexStamp[vertex] = stamp;
+					meshletVertices.push_back(vertex);
+				}
+			}
+		}
+
+		if (end > meshletStart)
+		{
+			meshlets.push_back(MakeMeshlet(vertices, indices, meshletStart, end, s, meshletVertices, scratch));
+		}
+	}
+}
+
+void Meshlets::Cull(const Meshlet* meshlets, std::size_t nrOfMeshlets, const XMMATRIX& world,
+	const BoundingFrustum& frustum, const XMFLOAT3& cameraPosition,
+	std::vector<MeshDrawRange>& ranges, MeshletCullStatistics* statistics)
+{
+	ranges.clear();
+
+	// World planes (pointing out of the frustum) into mesh-local space; a plane transforms by
+	// the transpose of the matrix that takes local points to world
+	XMVECTOR planes[6];
+	frustum.GetPlanes(&planes[0], &planes[1], &planes[2], &planes[3], &planes[4], &planes[5]);
+	const XMMATRIX worldTranspose = XMMatrixTranspose(world);
+	for (XMVECTOR& plane : planes)
+	{
+		plane = XMPlaneNormalize(XMVector4Transform(plane, worldTranspose));
+	}
+
+	// A mirroring world matrix flips the winding the rasterizer sees, so cones would cull the
+	// wrong side
+	XMVECTOR determinant;
+	const XMMATRIX inverseWorld = XMMatrixInverse(&determinant, world);
+	const bool testCones = XMVectorGetX(determinant) > 0.0f;
+	const XMVECTOR camera = XMVector3TransformCoord(XMLoadFloat3(&cameraPosition), inverseWorld);
+
+	MeshletCullStatistics counts;
+	for (std::size_t m = 0; m < nrOfMeshlets; ++m)
+	{
+		const Meshlet& meshlet = meshlets[m];
+		const XMVECTOR center = XMLoadFloat3(&meshlet.center);
+
+		bool outside = false;
+		for (const XMVECTOR& plane : planes)
+		{
+			if (XMVectorGetX(XMPlaneDotCoord(plane, center)) > meshlet.radius)
+			{
+				outside = true;
+				break;
+			}
+		}
+
+		if (outside)
+		{
+			++counts.frustumCulled;
+			continue;
+		}
+
+		if (testCones && meshlet.coneCutoff <= 1.0f)
+		{
+			const XMVECTOR toApex = XMVectorSubtract(XMLoadFloat3(&meshlet.coneApex), camera);
+			const float alongAxis = XMVectorGetX(XMVector3Dot(toApex, XMLoadFloat3(&meshlet.coneAxis)));
+			if (alongAxis >= meshlet.coneCutoff * XMVectorGetX(XMVector3Length(toApex)))
+			{
+				++counts.backfaceCulled;
+				continue;
+			}
+		}
+
+		++counts.visible;
+		if (!ranges.empty() && ranges.back().subMeshIndex == meshlet.subMeshIndex &&
+			ranges.back().startIndex + ranges.back().nrOfIndices == meshlet.startIndex)
+		{
+			ranges.back().nrOfIndices += meshlet.nrOfIndices;
+		}
+		else
+		{
+			ranges.push_back({ meshlet.subMeshIndex, meshlet.startIndex, meshlet.nrOfIndices });
+		}
+	}
+
+	if (statistics)
+	{
+		*statistics = counts;
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+struct Vertex;
+struct SubMeshInfo;
+
+// A run of consecutive triangles in a mesh's index buffer, never crossing a submesh, with
+// bounds for culling it on its own. Stored as is in baked meshes.
+struct Meshlet
+{
+	uint32_t startIndex;
+	uint32_t nrOfIndices;
+	uint32_t subMeshIndex;
+	uint32_t nrOfVertices;
+
+	// Mesh-local bounding sphere
+	DirectX::XMFLOAT3 center;
+	float radius;
+
+	// Every triangle is backfacing for cameras inside the cone from coneApex along coneAxis
+	// with dot(normalize(coneApex - camera), coneAxis) >= coneCutoff. coneCutoff is above 1
+	// when the triangles face too many ways for the test to ever pass.
+	DirectX::XMFLOAT3 coneApex;
+	float coneCutoff;
+	DirectX::XMFLOAT3 coneAxis;
+	float padding;
+};
+
+// Part of one submesh to draw: visible meshlets merged by Meshlets::Cull, or a LOD level
+struct MeshDrawRange
+{
+	uint32_t subMeshIndex;
+	uint32_t startIndex;
+	uint32_t nrOfIndices;
+};
+
+struct MeshletCullStatistics
+{
+	std::size_t frustumCulled = 0;
+	std::size_t backfaceCulled = 0;
+	std::size_t visible = 0;
+};
+
+// Splits meshes into small clusters at import and culls them per frame, so a large mesh that
+// is only partly in view or mostly facing away draws only the parts that can be visible.
+// Meshlets are consecutive triangles of the index buffer rather than a reordering of it, which
+// keeps the vertex cache order from MeshOptimizer and lets a visible run draw with one call.
+class Meshlets
+{
+public:
+	static constexpr std::size_t MAX_VERTICES = 64;
+	static constexpr std::size_t MAX_TRIANGLES = 124;
+
+	// Scans every submesh's triangles in order, starting a new meshlet whenever the next
+	// triangle would exceed either limit
+	static void Build(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+		const std::vector<SubMeshInfo>& subMeshes, std::vector<Meshlet>& meshlets);
+
+	// Tests each meshlet against the frustum and, unless world mirrors the mesh, the camera
+	// position for backfacing; both happen in mesh-local space so any affine world matrix works.
+	// The frustum and camera are in world space, as CameraD3D11 returns them.
+	static void Cull(const Meshlet* meshlets, std::size_t nrOfMeshlets, const DirectX::XMMATRIX& world,
+		const DirectX::BoundingFrustum& frustum, const DirectX::XMFLOAT3& cameraPosition,
+		std::vector<MeshDrawRange>& ranges, MeshletCullStatistics* statistics = nullptr);
+};
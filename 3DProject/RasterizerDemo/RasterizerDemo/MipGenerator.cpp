@@ -0,0 +1,300 @@
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <xmmintrin.h>
+
+namespace
+{
+	constexpr int LANCZOS_TAPS = 8;
+	constexpr int LINEAR_TO_SRGB_STEPS = 4096;
+
+	// RGBA, 4 floats per texel
+	struct FloatImage
+	{
+		int width = 0;
+		int height = 0;
+		std::vector<float> texels;
+
+		void Resize(int newWidth, int newHeight)
+		{
+			width = newWidth;
+			height = newHeight;
+			texels.resize(static_cast<size_t>(width) * height * 4);
+		}
+
+		float* Texel(int x, int y) { return texels.data() + (static_cast<size_t>(y) * width + x) * 4; }
+		const float* Texel(int x, int y) const { return texels.data() + (static_cast<size_t>(y) * width + x) * 4; }
+	};
+
+	const std::array<float, 256>& SrgbToLinearTable()
+	{
+		static const std::array<float, 256> table = []()
+			{
+				std::array<float, 256> values = {};
+				for (int i = 0; i < 256; ++i)
+				{
+					float c = i / 255.0f;
+					values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+				}
+				return values;
+			}();
+		return table;
+	}
+
+	const std::array<unsigned char, LINEAR_TO_SRGB_STEPS + 1>& LinearToSrgbTable()
+	{
+		static const std::array<unsigned char, LINEAR_TO_SRGB_STEPS + 1> table = []()
+			{
+				std::array<unsigned char, LINEAR_TO_SRGB_STEPS + 1> values = {};
+				for (int i = 0; i <= LINEAR_TO_SRGB_STEPS; ++i)
+				{
+					float c = static_cast<float>(i) / LINEAR_TO_SRGB_STEPS;
+					float s = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+					values[i] = static_cast<unsigned char>(s * 255.0f + 0.5f);
+				}
+				return values;
+			}();
+		return table;
+	}
+
+	unsigned char ToUnorm8(float value)
+	{
+		return static_cast<unsigned char>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+
+	void DecodeLevel(const unsigned char* source, int width, int height, MipContent content, FloatImage& target)
+	{
+		target.Resize(width, height);
+		const std::array<float, 256>& toLinear = SrgbToLinearTable();
+		const size_t nrOfTexels = static_cast<size_t>(width) * height;
+
+		for (size_t i = 0; i < nrOfTexels; ++i)
+		{
+			const unsigned char* in = source + i * 4;
+			float* out = target.texels.data() + i * 4;
+
+			for (int c = 0; c < 3; ++c)
+			{
+				switch (content)
+				{
+				case MipContent::Color:  out[c] = toLinear[in[c]]; break;
+				case MipContent::Normal: out[c] = in[c] * (2.0f / 255.0f) - 1.0f; break;
+				case MipContent::Data:   out[c] = in[c] * (1.0f / 255.0f); break;
+				}
+			}
+			out[3] = in[3] * (1.0f / 255.0f);
+		}
+	}
+
+	// Clamp negative lobes, and bring normals back to unit length, before the level is used again
+	void FinishLevel(FloatImage& image, MipContent content)
+	{
+		const size_t nrOfTexels = static_cast<size_t>(image.width) * image.height;
+		for (size_t i = 0; i < nrOfTexels; ++i)
+		{
+			float* texel = image.texels.data() + i * 4;
+
+			if (content == MipContent::Normal)
+			{
+				float length = std::sqrt(texel[0] * texel[0] + texel[1] * texel[1] + texel[2] * texel[2]);
+				if (length > 1e-6f)
+				{
+					texel[0] /= length;
+					texel[1] /= length;
+					texel[2] /= length;
+				}
+				else
+				{
+					// Opposing normals cancelled out, fall back to the surface normal
+					texel[0] = 0.0f;
+					texel[1] = 0.0f;
+					texel[2] = 1.0f;
+				}
+			}
+			else
+			{
+				texel[0] = std::clamp(texel[0], 0.0f, 1.0f);
+				texel[1] = std::clamp(texel[1], 0.0f, 1.0f);
+				texel[2] = std::clamp(texel[2], 0.0f, 1.0f);
+			}
+			texel[3] = std::clamp(texel[3], 0.0f, 1.0f);
+		}
+	}
+
+	void EncodeLevel(const FloatImage& source, MipContent content, unsigned char* target)
+	{
+		const std::array<unsigned char, LINEAR_TO_SRGB_STEPS + 1>& toSrgb = LinearToSrgbTable();
+		const size_t nrOfTexels = static_cast<size_t>(source.width) * source.height;
+
+		for (size_t i = 0; i < nrOfTexels; ++i)
+		{
+			const float* in = source.texels.data() + i * 4;
+			unsigned char* out = target + i * 4;
+
+			for (int c = 0; c < 3; ++c)
+			{
+				switch (content)
+				{
+				case MipContent::Color:  out[c] = toSrgb[static_cast<int>(in[c] * LINEAR_TO_SRGB_STEPS + 0.5f)]; break;
+				case MipContent::Normal: out[c] = ToUnorm8(in[c] * 0.5f + 0.5f); break;
+				case MipContent::Data:   out[c] = ToUnorm8(in[c]); break;
+				}
+			}
+			out[3] = ToUnorm8(in[3]);
+		}
+	}
+
+	// Each target texel is the mean of its 2x2 source footprint, one SSE register per texel.
+	// Odd source sizes clamp the last row/column.
+	void DownsampleBox(const FloatImage& source, FloatImage& target)
+	{
+		const __m128 quarter = _mm_set1_ps(0.25f);
+
+		for (int y = 0; y < target.height; ++y)
+		{
+			const int y0 = (std::min)(y * 2, source.height - 1);
+			const int y1 = (std::min)(y * 2 + 1, source.height - 1);
+
+			for (int x = 0; x < target.width; ++x)
+			{
+				const int x0 = (std::min)(x * 2, source.width - 1);
+				const int x1 = (std::min)(x * 2 + 1, source.width - 1);
+
+				__m128 sum = _mm_add_ps(
+					_mm_add_ps(_mm_loadu_ps(source.Texel(x0, y0)), _mm_loadu_ps(source.Texel(x1, y0))),
+					_mm_add_ps(_mm_loadu_ps(source.Texel(x0, y1)), _mm_loadu_ps(source.Texel(x1, y1))));
+
+				_mm_storeu_ps(target.Texel(x, y), _mm_mul_ps(sum, quarter));
+			}
+		}
+	}
+
+	// Lanczos-2 weights for a 2:1 reduction: source texel centers sit at +-0.5, +-1.5, +-2.5
+	// and +-3.5 target-space half texels from the target center
+	const std::array<float, LANCZOS_TAPS>& LanczosWeights()
+	{
+		static const std::array<float, LANCZOS_TAPS> weights = []()
+			{
+				constexpr float PI = 3.14159265358979f;
+				auto Sinc = [&](float x) { return x == 0.0f ? 1.0f : std::sin(PI * x) / (PI * x); };
+
+				std::array<float, LANCZOS_TAPS> values = {};
+				float sum = 0.0f;
+				for (int i = 0; i < LANCZOS_TAPS; ++i)
+				{
+					float distance = (i - LANCZOS_TAPS / 2 + 0.5f) * 0.5f;
+					values[i] = Sinc(distance) * Sinc(distance * 0.5f);
+					sum += values[i];
+				}
+				for (float& value : values)
+				{
+					value /= sum;
+				}
+				return values;
+			}();
+		return weights;
+	}
+
+	// Separable filter: horizontal pass into scratch, vertical pass into target.
+	// An axis that is already 1 texel wide is copied instead of filtered.
+	void DownsampleLanczos(const FloatImage& source, FloatImage& target, FloatImage& scratch)
+	{
+		const std::array<float, LANCZOS_TAPS>& weights = LanczosWeights();
+		const bool filterX = target.width < source.width;
+		const bool filterY = target.height < source.height;
+
+		scratch.Resize(target.width, source.height);
+		for (int y = 0; y < source.height; ++y)
+		{
+			for (int x = 0; x < target.width; ++x)
+			{
+				if (!filterX)
+				{
+					_mm_storeu_ps(scratch.Texel(x, y), _mm_loadu_ps(source.Texel(x, y)));
+					continue;
+				}
+
+				__m128 sum = _mm_setzero_ps();
+				const int first = x * 2 - LANCZOS_TAPS / 2 + 1;
+				for (int tap = 0; tap < LANCZOS_TAPS; ++tap)
+				{
+					const int sx = std::clamp(first + tap, 0, source.width - 1);
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(source.Texel(sx, y)), _mm_set1_ps(weights[tap])));
+				}
+				_mm_storeu_ps(scratch.Texel(x, y), sum);
+			}
+		}
+
+		for (int y = 0; y < target.height; ++y)
+		{
+			const int first = y * 2 - LANCZOS_TAPS / 2 + 1;
+			for (int x = 0; x < target.width; ++x)
+			{
+				if (!filterY)
+				{
+					_mm_storeu_ps(target.Texel(x, y), _mm_loadu_ps(scratch.Texel(x, y)));
+					continue;
+				}
+
+				__m128 sum = _mm_setzero_ps();
+				for (int tap = 0; tap < LANCZOS_TAPS; ++tap)
+				{
+					const int sy = std::clamp(first + tap, 0, source.height - 1);
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(scratch.Texel(x, sy)), _mm_set1_ps(weights[tap])));
+				}
+				_mm_storeu_ps(target.Texel(x, y), sum);
+			}
+		}
+	}
+}
+
+int MipGenerator::GetFullMipCount(int width, int height)
+{
+	int levels = 1;
+	int size = (std::max)(width, height);
+	while (size > 1)
+	{
+		size /= 2;
+		++levels;
+	}
+	return levels;
+}
+
+void MipGenerator::GenerateMips(ImageData& image, MipContent content, MipFilter filter)
+{
+	if (!image.IsValid() || image.IsBlockCompressed())
+		return;
+
+	const int nrOfLevels = GetFullMipCount(image.width, image.height);
+
+	// Drop any previous chain, then make room for the new one in one allocation
+	image.mipLevels = 1;
+	image.pixels.resize(image.GetLevelOffset(1));
+	image.mipLevels = nrOfLevels;
+	image.pixels.resize(image.GetLevelOffset(nrOfLevels));
+
+	FloatImage current;
+	FloatImage next;
+	FloatImage scratch;
+	DecodeLevel(image.pixels.data(), image.width, image.height, content, current);
+
+	for (int level = 1; level < nrOfLevels; ++level)
+	{
+		next.Resize(image.GetLevelWidth(level), image.GetLevelHeight(level));
+
+		if (filter == MipFilter::Box)
+		{
+			DownsampleBox(current, next);
+		}
+		else
+		{
+			DownsampleLanczos(current, next, scratch);
+		}
+
+		FinishLevel(next, content);
+		EncodeLevel(next, content, image.pixels.data() + image.GetLevelOffset(level));
+		std::swap(current, next);
+	}
+}
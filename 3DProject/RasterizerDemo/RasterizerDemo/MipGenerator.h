@@ -0,0 +1,30 @@
+#pragma once
+
+#include "TextureLoader.h"
+
+// How texels combine when a level is downsampled
+enum class MipContent
+{
+	Color,	// sRGB-encoded color, averaged in linear light
+	Normal,	// tangent-space normal in RGB, renormalized on every level
+	Data	// linear values such as height or roughness, averaged as stored
+};
+
+enum class MipFilter
+{
+	Box,	// 2x2 average
+	Lanczos	// separable 8-tap Lanczos-2, keeps more detail and aliases less than the box
+};
+
+// Builds mip chains on the CPU so textures can be uploaded complete with all levels.
+// Works in 32-bit float per channel and has no device dependency.
+class MipGenerator
+{
+public:
+	// Levels from the base size down to 1x1
+	static int GetFullMipCount(int width, int height);
+
+	// Replaces any existing mips with the full chain. Level 0 is left untouched.
+	// Block-compressed images are left as they are, their chain is built before compression.
+	static void GenerateMips(ImageData& image, MipContent content, MipFilter filter);
+};
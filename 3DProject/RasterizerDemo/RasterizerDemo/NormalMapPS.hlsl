@@ -1,6 +1,6 @@
 // NORMAL MAP PIXEL SHADER
-// Demonstrates normal mapping with derivative-based TBN matrix construction
-// Key technique: Screen-space derivatives for tangent-space basis without vertex attributes
+// Demonstrates normal mapping with per-vertex tangent frames from TangentGenerator, falling
+// back to a derivative-based TBN matrix for meshes imported without tangents
 
 cbuffer MaterialBuffer : register(b2)
 {
@@ -18,6 +18,7 @@ struct PS_INPUT
     float3 worldPosition : WORLD_POSITION;
     float3 worldNormal : NORMAL;
     float2 uv : TEXCOORD0;
+    float4 worldTangent : TANGENT;
 };
 
 struct PS_OUTPUT
@@ -67,11 +68,25 @@ PS_OUTPUT main(PS_INPUT input)
     // Normal map stores normals in tangent space with [0,1] encoding
     float3 normalMapSample = normalMapTexture.Sample(samplerState, input.uv).rgb;
     float3 tangentNormal = normalMapSample * 2.0f - 1.0f;
+    // BC5 normal maps only store x and y, rebuild z (matches the stored z for uncompressed maps)
+    tangentNormal.z = sqrt(saturate(1.0f - dot(tangentNormal.xy, tangentNormal.xy)));
     
     float3 normalizedNormal = normalize(input.worldNormal);
  
-    // Build TBN matrix on-the-fly using derivatives
-    float3x3 TBN = ComputeTBN(input.worldPosition, normalizedNormal, input.uv);
+    // Interpolated tangent frame; w is zero when the mesh has no tangents
+    float3x3 TBN;
+    if (abs(input.worldTangent.w) > 0.5f)
+    {
+        float3 tangent = normalize(input.worldTangent.xyz - normalizedNormal * dot(normalizedNormal, input.worldTangent.xyz));
+        // Same flip as ComputeTBN: the bitangent points along decreasing v
+        float3 bitangent = -input.worldTangent.w * cross(normalizedNormal, tangent);
+        TBN = float3x3(tangent, bitangent, normalizedNormal);
+    }
+    else
+    {
+        // Build TBN matrix on-the-fly using derivatives
+        TBN = ComputeTBN(input.worldPosition, normalizedNormal, input.uv);
+    }
     
     // Transform perturbed normal from tangent space to world space
     float3 worldNormal = normalize(mul(tangentNormal, TBN));
@@ -0,0 +1,287 @@
+#include "OBJParallelParser.h"
+#include "OBJParser.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+	// Several chunks per thread so a chunk full of long face lines does not stall the others
+	constexpr unsigned int CHUNKS_PER_THREAD = 4;
+
+	// mtllib, usemtl, o and g records, replayed in file order once the chunk's index offset is known
+	struct ChunkDirective
+	{
+		enum class Type
+		{
+			MtlLib,
+			UseMtl,
+			Group,
+		};
+
+		Type type = Type::UseMtl;
+		std::string_view argument;
+		std::size_t indexPosition = 0;
+	};
+
+	struct OBJChunk
+	{
+		std::string_view text;
+
+		// Only positions, texCoords and normals are used
+		ParseData attributes;
+		std::size_t positionOffset = 0;
+		std::size_t texCoordOffset = 0;
+		std::size_t normalOffset = 0;
+
+		// Chunk-local deduplication, uniqueKeys[i] is the resolved triple of local vertex i
+		VertexCacheTable vertexCache;
+		std::vector<VertexData> uniqueKeys;
+		std::vector<uint32_t> localIndices;
+		std::vector<ChunkDirective> directives;
+
+		// Local vertex index to final vertex index
+		std::vector<uint32_t> remap;
+		std::size_t indexOffset = 0;
+	};
+
+	// Split contents into roughly equal pieces that each end after a newline
+	std::vector<std::string_view> SplitAtLines(std::string_view contents, std::size_t nrOfChunks)
+	{
+		std::vector<std::string_view> chunks;
+		chunks.reserve(nrOfChunks);
+
+		const std::size_t targetSize = contents.size() / nrOfChunks + 1;
+		std::size_t start = 0;
+		while (start < contents.size())
+		{
+			std::size_t end = start + targetSize;
+			if (end >= contents.size())
+			{
+				end = contents.size();
+			}
+			else
+			{
+				const void* newline = std::memchr(contents.data() + end, '\n', contents.size() - end);
+				end = newline ? static_cast<const char*>(newline) - contents.data() + 1 : contents.size();
+			}
+
+			chunks.push_back(contents.substr(start, end - start));
+			start = end;
+		}
+
+		return chunks;
+	}
+
+	// Phase one: vertex attributes, which every face in later chunks may reference
+	void ParseChunkAttributes(OBJChunk& chunk)
+	{
+		size_t contentPos = 0;
+		while (contentPos < chunk.text.size())
+		{
+			std::string_view line = GetNextLine(chunk.text, contentPos);
+			if (line.empty() || line[0] == '#') continue;
+
+			size_t pos = 0;
+			std::string_view type = GetLineString(line, pos);
+
+			if (type == "v")       ParsePosition(line.substr(pos), chunk.attributes);
+			else if (type == "vt") ParseTexCoord(line.substr(pos), chunk.attributes);
+			else if (type == "vn") ParseNormal(line.substr(pos), chunk.attributes);
+		}
+	}
+
+	// Phase two: faces and material records, with indices relative to the chunk
+	void ParseChunkFaces(OBJChunk& chunk)
+	{
+		// Running attribute counts so negative indices resolve against what precedes the face
+		int nrOfPositions = static_cast<int>(chunk.positionOffset);
+		int nrOfTexCoords = static_cast<int>(chunk.texCoordOffset);
+		int nrOfNormals = static_cast<int>(chunk.normalOffset);
+
+		std::vector<VertexData> faceVertices;
+
+		size_t contentPos = 0;
+		while (contentPos < chunk.text.size())
+		{
+			std::string_view line = GetNextLine(chunk.text, contentPos);
+			if (line.empty() || line[0] == '#') continue;
+
+			size_t pos = 0;
+			std::string_view type = GetLineString(line, pos);
+
+			if (type == "v")       ++nrOfPositions;
+			else if (type == "vt") ++nrOfTexCoords;
+			else if (type == "vn") ++nrOfNormals;
+			else if (type == "mtllib" || type == "usemtl" || type == "o" || type == "g")
+			{
+				ChunkDirective directive;
+				directive.type = type == "mtllib" ? ChunkDirective::Type::MtlLib :
+					type == "usemtl" ? ChunkDirective::Type::UseMtl : ChunkDirective::Type::Group;
+				directive.argument = line.substr(pos);
+				directive.indexPosition = chunk.localIndices.size();
+				chunk.directives.push_back(directive);
+			}
+			else if (type == "f")
+			{
+				ParseFaceCorners(line.substr(pos), faceVertices);
+				if (faceVertices.size() < 3) continue;
+
+				for (size_t i = 1; i < faceVertices.size() - 1; ++i)
+				{
+					const VertexData triangle[3] = {
+						faceVertices[0],
+						faceVertices[i],
+						faceVertices[i + 1]
+					};
+
+					for (VertexData vdata : triangle)
+					{
+						if (vdata.vInd < 0) vdata.vInd = nrOfPositions + vdata.vInd + 1;
+						if (vdata.tInd < 0) vdata.tInd = nrOfTexCoords + vdata.tInd + 1;
+						if (vdata.nInd < 0) vdata.nInd = nrOfNormals + vdata.nInd + 1;
+
+						bool inserted = false;
+						uint32_t index = chunk.vertexCache.FindOrInsert(
+							static_cast<uint32_t>(vdata.vInd), static_cast<uint32_t>(vdata.tInd), static_cast<uint32_t>(vdata.nInd),
+							static_cast<uint32_t>(chunk.uniqueKeys.size()), inserted);
+
+						if (inserted)
+						{
+							chunk.uniqueKeys.push_back(vdata);
+						}
+
+						chunk.localIndices.push_back(index);
+					}
+				}
+			}
+		}
+	}
+
+	template<typename T>
+	void ConcatenateAttributes(std::vector<OBJChunk>& chunks, unsigned int nrOfThreads,
+		std::vector<T>& destination, std::vector<T> ParseData::* member, std::size_t OBJChunk::* offset)
+	{
+		std::size_t total = 0;
+		for (OBJChunk& chunk : chunks)
+		{
+			chunk.*offset = total;
+			total += (chunk.attributes.*member).size();
+		}
+
+		destination.resize(total);
+		ParallelFor(chunks.size(), nrOfThreads, [&](std::size_t i)
+		{
+			const std::vector<T>& source = chunks[i].attributes.*member;
+			std::copy(source.begin(), source.end(), destination.begin() + chunks[i].*offset);
+		});
+	}
+}
+
+void ParseOBJParallel(std::string_view contents, ParseData& data, unsigned int nrOfThreads)
+{
+	const std::vector<std::string_view> pieces = SplitAtLines(contents, static_cast<std::size_t>(nrOfThreads) * CHUNKS_PER_THREAD);
+
+	std::vector<OBJChunk> chunks(pieces.size());
+	for (size_t i = 0; i < pieces.size(); ++i)
+	{
+		chunks[i].text = pieces[i];
+	}
+
+	ParallelFor(chunks.size(), nrOfThreads, [&](std::size_t i)
+	{
+		ParseChunkAttributes(chunks[i]);
+	});
+
+	ConcatenateAttributes(chunks, nrOfThreads, data.positions, &ParseData::positions, &OBJChunk::positionOffset);
+	ConcatenateAttributes(chunks, nrOfThreads, data.texCoords, &ParseData::texCoords, &OBJChunk::texCoordOffset);
+	ConcatenateAttributes(chunks, nrOfThreads, data.normals, &ParseData::normals, &OBJChunk::normalOffset);
+
+	ParallelFor(chunks.size(), nrOfThreads, [&](std::size_t i)
+	{
+		OBJChunk& chunk = chunks[i];
+		chunk.attributes = ParseData();
+		ParseChunkFaces(chunk);
+	});
+
+	// Merge in file order: the first chunk to use a triple owns its vertex, as in the serial parser
+	std::size_t nrOfIndices = 0;
+	std::size_t maxVertices = 0;
+	for (OBJChunk& chunk : chunks)
+	{
+		chunk.indexOffset = nrOfIndices;
+		nrOfIndices += chunk.localIndices.size();
+		maxVertices += chunk.uniqueKeys.size();
+	}
+
+	std::vector<VertexData> vertexKeys;
+	vertexKeys.reserve(maxVertices);
+	data.vertexCache.Reserve(maxVertices);
+
+	for (OBJChunk& chunk : chunks)
+	{
+		chunk.remap.resize(chunk.uniqueKeys.size());
+		for (size_t i = 0; i < chunk.uniqueKeys.size(); ++i)
+		{
+			const VertexData& key = chunk.uniqueKeys[i];
+
+			bool inserted = false;
+			chunk.remap[i] = data.vertexCache.FindOrInsert(
+				static_cast<uint32_t>(key.vInd), static_cast<uint32_t>(key.tInd), static_cast<uint32_t>(key.nInd),
+				static_cast<uint32_t>(vertexKeys.size()), inserted);
+
+			if (inserted)
+			{
+				vertexKeys.push_back(key);
+			}
+		}
+	}
+
+	// Build vertices and remap indices in parallel, each writes a disjoint range
+	data.vertices.resize(vertexKeys.size());
+	data.indexData.resize(nrOfIndices);
+
+	const std::size_t nrOfVertexBatches = chunks.size();
+	const std::size_t verticesPerBatch = vertexKeys.size() / nrOfVertexBatches + 1;
+	ParallelFor(nrOfVertexBatches, nrOfThreads, [&](std::size_t batch)
+	{
+		const std::size_t begin = (std::min)(batch * verticesPerBatch, vertexKeys.size());
+		const std::size_t end = (std::min)(begin + verticesPerBatch, vertexKeys.size());
+		for (size_t i = begin; i < end; ++i)
+		{
+			const VertexData& key = vertexKeys[i];
+			data.vertices[i] = MakeVertex(data, key.vInd, key.tInd, key.nInd);
+		}
+
+		const OBJChunk& chunk = chunks[batch];
+		unsigned int* destination = data.indexData.data() + chunk.indexOffset;
+		for (size_t i = 0; i < chunk.localIndices.size(); ++i)
+		{
+			destination[i] = chunk.remap[chunk.localIndices[i]];
+		}
+	});
+
+	// Replay material and group records now that their absolute index positions are known
+	for (const OBJChunk& chunk : chunks)
+	{
+		for (const ChunkDirective& directive : chunk.directives)
+		{
+			const std::size_t indexPosition = chunk.indexOffset + directive.indexPosition;
+			if (directive.type == ChunkDirective::Type::MtlLib)
+			{
+				ParseMtlLib(directive.argument, data);
+			}
+			else if (directive.type == ChunkDirective::Type::UseMtl)
+			{
+				size_t pos = 0;
+				BeginSubMesh(GetLineString(directive.argument, pos), indexPosition, data);
+			}
+			else
+			{
+				BeginPart(directive.argument, indexPosition, data);
+			}
+		}
+	}
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string_view>
+
+struct ParseData;
+
+// Parses OBJ text on nrOfThreads threads and fills data exactly like the serial ParseLine loop.
+// The file is split into chunks at line boundaries; attributes and faces are parsed per chunk and
+// merged in file order, so vertex order, index order and submesh ranges do not depend on timing.
+// Expects data to already hold the default material.
+void ParseOBJParallel(std::string_view contents, ParseData& data, unsigned int nrOfThreads);
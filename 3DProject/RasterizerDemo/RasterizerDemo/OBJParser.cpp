@@ -1,253 +1,620 @@
 #include "OBJParser.h"
 #include "MeshD3D11.h"
-#include "stb_image.h"
+#include "MemoryMappedFile.h"
+#include "BakedMesh.h"
+#include "OBJParallelParser.h"
+#include "OBJStreamingParser.h"
+#include "GLBParser.h"
+#include "MeshOptimizer.h"
+#include "TangentGenerator.h"
+#include "IndexCompression.h"
+#include "ThreadPool.h"
+#include "ContentHash.h"
+#include "MeshResidency.h"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
+#include <emmintrin.h>
 
 // Default directory for loading objects
 std::string defaultDirectory = "objects/";
-// Cache for loaded meshes to avoid reloading
-std::unordered_map<std::string, MeshD3D11*> loadedMeshes;
+// Every loaded mesh, kept under the mesh memory budget
+MeshResidencyManager meshResidency;
+// Options applied to every OBJ import
+OBJImportSettings objImportSettings;
+// Textures shared by all meshes
+TextureCache textureCache;
+// GPU buffers shared by all meshes with the same geometry
+GeometryCache geometryCache;
+// Materials shared by all meshes, and the MTL files they came from
+MaterialTable materialTable;
+MtlLibraryCache mtlLibraryCache;
 
 namespace
 {
 	// Trim whitespace from start and end of a string
-	std::string Trim(const std::string& str)
+	std::string_view Trim(std::string_view str)
 	{
 		const auto start = str.find_first_not_of(" \t\r\n");
 		const auto end = str.find_last_not_of(" \t\r\n");
-		if (start == std::string::npos || end == std::string::npos)
+		if (start == std::string_view::npos || end == std::string_view::npos)
 		{
-			return "";
+			return {};
 		}
 		return str.substr(start, end - start + 1);
 	}
+
+	bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\t';
+	}
+
+	bool IsDigit(char c)
+	{
+		return static_cast<unsigned char>(c - '0') < 10;
+	}
+
+	// Length of the run of ASCII digits starting at first, tested 16 characters at a time
+	size_t DigitRunLength(const char* first, const char* last)
+	{
+		// Biasing by 0x80 - '0' moves '0'..'9' to the bottom of the signed range,
+		// so a single signed compare classifies all 16 lanes
+		const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80 - '0'));
+		const __m128i limit = _mm_set1_epi8(static_cast<char>(0x80 + 10));
+
+		const char* current = first;
+		while (last - current >= 16)
+		{
+			__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+			__m128i isDigit = _mm_cmplt_epi8(_mm_add_epi8(chunk, bias), limit);
+			unsigned int nonDigitMask = ~static_cast<unsigned int>(_mm_movemask_epi8(isDigit)) & 0xFFFFu;
+			if (nonDigitMask != 0)
+			{
+				return static_cast<size_t>(current - first) + std::countr_zero(nonDigitMask);
+			}
+			current += 16;
+		}
+
+		while (current < last && IsDigit(*current))
+		{
+			current++;
+		}
+		return static_cast<size_t>(current - first);
+	}
 }
 
 // Release all loaded meshes
 void UnloadMeshes()
 {
-	for (auto& pair : loadedMeshes)
+	meshResidency.Clear();
+
+	// Meshes released their texture references above, this drops the cache's own
+	textureCache.Clear();
+	geometryCache.Clear();
+	materialTable.Clear();
+	mtlLibraryCache.Clear();
+}
+
+// Extract the next line (without line terminator) and advance past it
+std::string_view GetNextLine(std::string_view contents, size_t& currentPos)
+{
+	const char* lineStart = contents.data() + currentPos;
+	const size_t remaining = contents.size() - currentPos;
+
+	const char* lineEnd = static_cast<const char*>(std::memchr(lineStart, '\n', remaining));
+	size_t lineLength = lineEnd ? static_cast<size_t>(lineEnd - lineStart) : remaining;
+	currentPos += lineEnd ? lineLength + 1 : lineLength;
+
+	if (lineLength > 0 && lineStart[lineLength - 1] == '\r')
 	{
-		if (pair.second)
-		{
-			delete pair.second;
-			pair.second = nullptr;
-		}
+		lineLength--;
 	}
-	loadedMeshes.clear();
+
+	return std::string_view(lineStart, lineLength);
 }
 
 // Extract a floating-point number from a line of text
-float GetLineFloat(const std::string& line, size_t& currentLinePos)
+float GetLineFloat(std::string_view line, size_t& currentLinePos)
 {
-	while (currentLinePos < line.size() && line[currentLinePos] == ' ')
+	while (currentLinePos < line.size() && IsSpace(line[currentLinePos]))
 	{
 		currentLinePos++;
 	}
 
-	size_t numberStart = currentLinePos;
+	const char* numberStart = line.data() + currentLinePos;
+	const char* lineEnd = line.data() + line.size();
 
-	while (currentLinePos < line.size() && line[currentLinePos] != ' ')
+	// from_chars does not accept an explicit plus sign
+	if (numberStart < lineEnd && *numberStart == '+')
 	{
-		currentLinePos++;
+		numberStart++;
+	}
+
+	float extractedAndConvertedFloat = 0.0f;
+	auto [numberEnd, error] = std::from_chars(numberStart, lineEnd, extractedAndConvertedFloat);
+	if (error != std::errc())
+	{
+		extractedAndConvertedFloat = 0.0f;
+		numberEnd = numberStart;
 	}
 
-	std::string part = line.substr(numberStart, currentLinePos - numberStart);
-	float extractedAndConvertedFloat = std::stof(part);
+	// Skip anything left of a malformed token
+	while (numberEnd < lineEnd && !IsSpace(*numberEnd))
+	{
+		numberEnd++;
+	}
+	currentLinePos = static_cast<size_t>(numberEnd - line.data());
 
 	return extractedAndConvertedFloat;
 }
 
 // Extract an integer from a line of text
-int GetLineInt(const std::string& line, size_t& currentLinePos)
+int GetLineInt(std::string_view line, size_t& currentLinePos)
 {
-	size_t numberStart = currentLinePos;
+	const char* current = line.data() + currentLinePos;
+	const char* lineEnd = line.data() + line.size();
 
-	while (currentLinePos < line.size() && line[currentLinePos] != ' ' && line[currentLinePos] != '/')
+	bool negative = false;
+	if (current < lineEnd && (*current == '-' || *current == '+'))
 	{
-		currentLinePos++;
+		negative = *current == '-';
+		current++;
 	}
 
-	std::string part = line.substr(numberStart, currentLinePos - numberStart);
-	int extractedAndConvertedInteger = std::stoi(part);
+	const size_t digitCount = DigitRunLength(current, lineEnd);
+	int extractedAndConvertedInteger = 0;
+	for (size_t i = 0; i < digitCount; ++i)
+	{
+		extractedAndConvertedInteger = extractedAndConvertedInteger * 10 + (current[i] - '0');
+	}
+	current += digitCount;
 
-	return extractedAndConvertedInteger;
+	// Skip anything left of a malformed token
+	while (current < lineEnd && !IsSpace(*current) && *current != '/')
+	{
+		current++;
+	}
+	currentLinePos = static_cast<size_t>(current - line.data());
+
+	return negative ? -extractedAndConvertedInteger : extractedAndConvertedInteger;
 }
 
 // Extract a string from a line of text
-std::string GetLineString(const std::string& line, size_t& currentLinePos)
+std::string_view GetLineString(std::string_view line, size_t& currentLinePos)
 {
-	while (currentLinePos < line.size() && line[currentLinePos] == ' ')
+	while (currentLinePos < line.size() && IsSpace(line[currentLinePos]))
 	{
 		currentLinePos++;
 	}
 
 	size_t numberStart = currentLinePos;
 
-	while (currentLinePos < line.size() && line[currentLinePos] != ' ')
+	while (currentLinePos < line.size() && !IsSpace(line[currentLinePos]))
 	{
 		currentLinePos++;
 	}
-	std::string extractedString = line.substr(numberStart, currentLinePos - numberStart);
 
-	return extractedString;
+	return line.substr(numberStart, currentLinePos - numberStart);
 }
 
 // Get a mesh by file path, loading it if necessary
-const MeshD3D11* GetMesh(const std::string& path, ID3D11Device* device) {
+MeshHandle GetMesh(const std::string& path, ID3D11Device* device) {
 	// Check if the mesh is already loaded
-	if (loadedMeshes.find(path) == loadedMeshes.end())
+	if (!meshResidency.IsResident(path))
 	{
-		std::string fileData;
-		ReadFile(path, fileData);
-		ParseOBJ(path, fileData, device);
+		MeshRequest request = RequestMesh(path);
+		return FinishMesh(request, device);
 	}
 
-	return loadedMeshes[path];
+	return meshResidency.Find(path);
+}
+
+// Pool shared by all asynchronous imports, created on first use
+ThreadPool& GetAssetLoadPool()
+{
+	static ThreadPool pool;
+	return pool;
 }
 
-// Read the entire contents of a file into a string
-void ReadFile(const std::string& path, std::string& toFill)
+MipContent GetBumpMapContent(const std::string& texPath)
 {
-	std::ifstream reader;
-	reader.open(defaultDirectory + path);
-	if (!reader.is_open())
+	std::string lowered = texPath;
+	std::transform(lowered.begin(), lowered.end(), lowered.begin(),
+		[](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+	return lowered.find("normal") != std::string::npos ? MipContent::Normal : MipContent::Data;
+}
+
+// Everything that does not need the device: file mapping, baked load or parse, texture decode
+std::unique_ptr<PendingMesh> ImportMesh(const std::string& path)
+{
+	auto pending = std::make_unique<PendingMesh>();
+	pending->identifier = path;
+
+	const std::string objPath = defaultDirectory + path;
+	const std::string bakedPath = GetBakedMeshPath(objPath);
+
+	std::error_code sizeError;
+	const std::uintmax_t fileSize = std::filesystem::file_size(objPath, sizeError);
+	if (IsGLBPath(path))
 	{
-		throw std::runtime_error("Failed to open file: " + path);
+		// Already binary, so there is nothing to bake; the import may point into the mapping
+		if (!pending->sourceFile.Open(objPath))
+		{
+			throw std::runtime_error("Failed to open file: " + path);
+		}
+
+		std::string textureDirectory = std::filesystem::path(path).parent_path().generic_string();
+		if (!textureDirectory.empty())
+		{
+			textureDirectory += '/';
+		}
+
+		GLBImportStatistics statistics;
+		ParseGLBContents(pending->sourceFile.GetView(), textureDirectory, pending->data, pending->import, &statistics);
+		if (statistics.nrOfSkippedImages > 0)
+		{
+			OutputDebugStringA((path + ": " + std::to_string(statistics.nrOfSkippedImages) +
+				" embedded images skipped, only image files next to the .glb are loaded\n").c_str());
+		}
 	}
+	else if (!sizeError && UseStreamingImport(static_cast<std::size_t>(fileSize)))
+	{
+		// Too large to map and parse whole next to its parse data, so it is read in blocks
+		OBJFileScan scan;
+		if (!ScanOBJFile(objPath, scan))
+		{
+			throw std::runtime_error("Failed to open file: " + path);
+		}
 
-	reader.seekg(0, std::ios::end);
-	toFill.reserve(static_cast<unsigned int>(reader.tellg()));
-	reader.seekg(0, std::ios::beg);
+		if (!pending->baked.Load(bakedPath, scan.contentHash, pending->import))
+		{
+			OBJStreamingStatistics statistics;
+			ParseOBJStreaming(objPath, scan, pending->data, &statistics);
+			OutputDebugStringA(("Streamed " + path + ": " + std::to_string(statistics.nrOfBlocks) + " blocks, " +
+				std::to_string(statistics.nrOfFlushedSubMeshes) + " submeshes, peak " +
+				std::to_string(statistics.peakTrackedBytes / (1024 * 1024)) + " MB held, " +
+				std::to_string(statistics.peakWorkingSetBytes / (1024 * 1024)) + " MB working set\n").c_str());
+
+			if (!WriteBakedMesh(bakedPath, pending->data, HashMeshSource(scan.contentHash, pending->data.materialLibraries)))
+			{
+				OutputDebugStringA(("Could not write baked mesh: " + bakedPath + "\n").c_str());
+			}
 
-	toFill.assign((std::istreambuf_iterator<char>(reader)),
-		std::istreambuf_iterator<char>());
+			BuildMeshImport(pending->data, pending->import);
+		}
+	}
+	else
+	{
+		// The file is tokenized in place, so the mapping only has to outlive the parse
+		MemoryMappedFile objFile(objPath);
+		if (!objFile.IsOpen())
+		{
+			throw std::runtime_error("Failed to open file: " + path);
+		}
+
+		// Use the baked copy if it was built from this exact source by this parser version
+		if (!pending->baked.Load(bakedPath, objFile.GetView(), pending->import))
+		{
+			ParseOBJContents(objFile.GetView(), pending->data);
+
+			if (!WriteBakedMesh(bakedPath, pending->data, HashMeshSource(objFile.GetView(), pending->data.materialLibraries)))
+			{
+				OutputDebugStringA(("Could not write baked mesh: " + bakedPath + "\n").c_str());
+			}
+
+			BuildMeshImport(pending->data, pending->import);
+		}
+	}
+
+	const MeshCleanupStatistics& cleanup = pending->data.cleanup;
+	if (cleanup.removedVertices + cleanup.degenerateTriangles + cleanup.duplicateTriangles + cleanup.removedSubMeshes > 0)
+	{
+		OutputDebugStringA(("Cleaned " + path + ": " + std::to_string(cleanup.removedVertices) + " vertices, " +
+			std::to_string(cleanup.degenerateTriangles) + " degenerate and " + std::to_string(cleanup.duplicateTriangles) +
+			" duplicate triangles, " + std::to_string(cleanup.removedSubMeshes) + " draws removed\n").c_str());
+	}
+
+	// Hashed here on the loader thread, so spotting a repeat costs the device thread nothing
+	pending->import.geometryHash = HashMeshGeometry(pending->import);
+
+	// Decode each referenced texture once; failures and already uploaded textures are left out
+	for (const MaterialInfo& material : pending->import.materials)
+	{
+		for (const std::string* texPath : { &material.mapKa, &material.mapKd, &material.mapKs, &material.mapBump })
+		{
+			if (texPath->empty() || pending->images.find(*texPath) != pending->images.end())
+				continue;
+
+			const MipContent content = texPath == &material.mapBump ? GetBumpMapContent(*texPath) : MipContent::Color;
+			std::shared_ptr<const ImageData> image = textureCache.Decode(defaultDirectory + *texPath, content);
+			if (image)
+			{
+				pending->images.emplace(*texPath, std::move(image));
+			}
+		}
+	}
+
+	return pending;
 }
 
-// Parse the OBJ file contents
-void ParseOBJ(const std::string& identifier, const std::string& contents, ID3D11Device* device)
+MeshRequest RequestMesh(const std::string& path)
 {
-	std::istringstream lineStream(contents);
-	ParseData data;
+	MeshRequest request;
+	request.path = path;
+
+	if (!meshResidency.IsResident(path))
+	{
+		request.pending = GetAssetLoadPool().Submit([path]() { return ImportMesh(path); });
+	}
+
+	return request;
+}
+
+MeshHandle FinishMesh(MeshRequest& request, ID3D11Device* device)
+{
+	if (request.pending.valid())
+	{
+		// Rethrows anything the import threw, as a synchronous load would have
+		std::unique_ptr<PendingMesh> pending = request.pending.get();
+
+		// Another request for the same file may have finished first
+		if (!meshResidency.IsResident(request.path))
+		{
+			meshResidency.Add(request.path, CreateMeshFromImport(pending->import, pending->images, device));
+		}
+	}
+
+	return meshResidency.Find(request.path);
+}
+
+// Count v/vt/vn/f records so the parse arrays never have to grow
+void ReserveParseData(std::string_view contents, ParseData& data)
+{
+	size_t nrOfPositions = 0;
+	size_t nrOfTexCoords = 0;
+	size_t nrOfNormals = 0;
+	size_t nrOfFaces = 0;
+
+	size_t contentPos = 0;
+	while (contentPos < contents.size())
+	{
+		std::string_view line = GetNextLine(contents, contentPos);
+		if (line.size() < 2)
+			continue;
+
+		if (line[0] == 'f' && IsSpace(line[1]))
+			nrOfFaces++;
+		else if (line[0] == 'v')
+		{
+			if (IsSpace(line[1]))
+				nrOfPositions++;
+			else if (line[1] == 't')
+				nrOfTexCoords++;
+			else if (line[1] == 'n')
+				nrOfNormals++;
+		}
+	}
+
+	data.positions.reserve(nrOfPositions);
+	data.texCoords.reserve(nrOfTexCoords);
+	data.normals.reserve(nrOfNormals);
+
+	// Every face is at least one triangle, and most corners reuse a position
+	data.indexData.reserve(nrOfFaces * 3);
+	data.vertices.reserve(nrOfPositions);
+	data.vertexCache.Reserve((std::max)(nrOfPositions, nrOfFaces));
+}
 
+// Parse the OBJ text, splitting large files across all cores
+void ParseOBJContents(std::string_view contents, ParseData& data)
+{
 	// Default material in case the OBJ doesn't reference one
 	data.parsedMaterials.push_back(MaterialInfo{});
 
-	std::string line;
-	while (std::getline(lineStream, line))
+	unsigned int nrOfThreads = objImportSettings.maxParseThreads;
+	if (nrOfThreads == 0)
+	{
+		nrOfThreads = (std::max)(1u, std::thread::hardware_concurrency());
+	}
+
+	if (nrOfThreads > 1 && contents.size() >= objImportSettings.parallelParseMinBytes)
 	{
-		ParseLine(line, data);
+		ParseOBJParallel(contents, data, nrOfThreads);
+	}
+	else
+	{
+		ReserveParseData(contents, data);
+
+		size_t contentPos = 0;
+		while (contentPos < contents.size())
+		{
+			ParseLine(GetNextLine(contents, contentPos), data);
+		}
 	}
+
 	PushBackCurrentSubmesh(data);
+	ProcessParseData(data);
+}
+
+// Clean up, optimize, add tangents, LODs, meshlets and packed vertices, in the order each pass needs
+void ProcessParseData(ParseData& data)
+{
+	// Merging submeshes renumbers them, so this goes before anything that refers to one
+	if (objImportSettings.cleanMeshes)
+	{
+		MeshCleanup::Clean(data.vertices, data.indexData, data.finishedSubMeshes, data.parts,
+			objImportSettings.weldEpsilon, &data.cleanup);
+	}
 
+	if (objImportSettings.optimizeMeshes)
+	{
+		MeshOptimizer::Optimize(data.vertices, data.indexData, data.finishedSubMeshes);
+	}
+
+	// Mirrored UVs can add vertices, so tangents come before anything that records vertex counts
+	if (objImportSettings.generateTangents)
+	{
+		TangentGenerator::Generate(data.vertices, data.indexData, data.tangents, objImportSettings.maxParseThreads);
+	}
+
+	// Levels go after the full-detail indices, so meshlets below only ever cover the full mesh
+	if (objImportSettings.generateLODs)
+	{
+		MeshSimplifier::GenerateLODs(data.vertices, data.indexData, data.finishedSubMeshes, data.lods);
+	}
+
+	Meshlets::Build(data.vertices, data.indexData, data.finishedSubMeshes, data.meshlets);
+	MeshParts::Build(data.vertices, data.indexData, data.finishedSubMeshes, data.meshlets, data.parts);
+
+	// Last, once no pass changes the vertices anymore
+	if (objImportSettings.packVertices)
+	{
+		PackParseData(data);
+	}
+}
+
+// The compact copy PackedVertexVS reads, next to the full vertices the other passes use
+void PackParseData(ParseData& data)
+{
+	data.packedFormat = VertexPacking::ChooseFormat(data.vertices.data(), data.vertices.size(), objImportSettings.vertexPacking);
+	VertexPacking::Pack(data.vertices.data(), data.vertices.size(), data.packedFormat, data.packedVertices);
+}
+
+// Parse the OBJ file contents
+void ParseOBJ(const std::string& identifier, std::string_view contents, ID3D11Device* device)
+{
+	ParseData data;
+	ParseOBJContents(contents, data);
+
+	MeshImport import;
+	BuildMeshImport(data, import);
+	import.geometryHash = HashMeshGeometry(import);
+	meshResidency.Add(identifier, CreateMeshFromImport(import, {}, device));
+}
+
+// View the parse results as an import without copying the vertex and index arrays
+void BuildMeshImport(const ParseData& data, MeshImport& import)
+{
+	import.vertices = data.vertices.data();
+	import.nrOfVertices = data.vertices.size();
+	import.indices = data.indexData.data();
+	import.nrOfIndices = data.indexData.size();
+	import.indexFormat = DXGI_FORMAT_R32_UINT;
+	import.tangents = data.tangents.empty() ? nullptr : data.tangents.data();
+	import.packedVertices = data.packedVertices.empty() ? nullptr : data.packedVertices.data();
+	import.packedFormat = data.packedFormat;
+	import.subMeshes = data.finishedSubMeshes;
+	import.materials = data.parsedMaterials;
+	import.meshlets = data.meshlets.data();
+	import.nrOfMeshlets = data.meshlets.size();
+	import.lods = data.lods;
+	import.parts = data.parts;
+	import.hasLocalBoundingBox = false;
+}
+
+// Content address of the GPU buffers: a size header, then the vertex, tangent, packed vertex
+// and index bytes. Indices are hashed as 32-bit values whatever their format, since parsed
+// indices are only narrowed to 16 bits at upload while baked ones are stored narrowed, and both
+// must find the same buffers.
+uint64_t HashMeshGeometry(const MeshImport& import)
+{
+	const uint64_t header[3] = { import.nrOfVertices, import.nrOfIndices,
+		(import.tangents ? 0x100u : 0u) | (import.packedVertices ? 0x200u : 0u) };
+
+	uint64_t hash = HashBytes(std::string_view(reinterpret_cast<const char*>(header), sizeof(header)));
+	hash = HashBytes(std::string_view(reinterpret_cast<const char*>(import.vertices), import.nrOfVertices * sizeof(Vertex)), hash);
+	if (import.tangents)
+	{
+		hash = HashBytes(std::string_view(reinterpret_cast<const char*>(import.tangents), import.nrOfVertices * sizeof(DirectX::XMFLOAT4)), hash);
+	}
+	if (import.packedVertices)
+	{
+		hash = HashBytes(std::string_view(reinterpret_cast<const char*>(import.packedVertices), import.nrOfVertices * import.packedFormat.GetStride()), hash);
+	}
+
+	const unsigned int* indices = static_cast<const unsigned int*>(import.indices);
+	std::vector<unsigned int> widenedIndices;
+	if (import.indexFormat == DXGI_FORMAT_R16_UINT)
+	{
+		const uint16_t* narrowIndices = static_cast<const uint16_t*>(import.indices);
+		widenedIndices.assign(narrowIndices, narrowIndices + import.nrOfIndices);
+		indices = widenedIndices.data();
+	}
+	hash = HashBytes(std::string_view(reinterpret_cast<const char*>(indices), import.nrOfIndices * sizeof(unsigned int)), hash);
+
+	// 0 is reserved for "not hashed"
+	return hash != 0 ? hash : 1;
+}
+
+// Create the GPU mesh for an import, whether it came from the parser or a baked file
+std::unique_ptr<MeshD3D11> CreateMeshFromImport(const MeshImport& import,
+	const std::unordered_map<std::string, std::shared_ptr<const ImageData>>& images, ID3D11Device* device)
+{
 	// 1. Create a MeshData struct to transfer data to the MeshD3D11
 	MeshData meshInfo = {};
 
 	// 2. Fill Vertex Info
 	meshInfo.vertexInfo.sizeOfVertex = sizeof(Vertex);
-	meshInfo.vertexInfo.nrOfVerticesInBuffer = data.vertices.size();
-	meshInfo.vertexInfo.vertexData = data.vertices.data();
+	meshInfo.vertexInfo.nrOfVerticesInBuffer = import.nrOfVertices;
+	meshInfo.vertexInfo.vertexData = import.vertices;
+	meshInfo.tangentInfo.tangentData = import.tangents;
+	meshInfo.packedVertexInfo.packedVertexData = import.packedVertices;
+	meshInfo.packedVertexInfo.format = import.packedFormat;
+
+	// 3. Fill Index Info, narrowing parsed indices to 16 bits when every vertex is reachable
+	meshInfo.indexInfo.nrOfIndicesInBuffer = import.nrOfIndices;
+	meshInfo.indexInfo.indexData = import.indices;
+	meshInfo.indexInfo.indexFormat = import.indexFormat;
+
+	std::vector<uint16_t> narrowedIndices;
+	if (import.indexFormat == DXGI_FORMAT_R32_UINT && IndexCompression::ChooseFormat(import.nrOfVertices) == DXGI_FORMAT_R16_UINT)
+	{
+		IndexCompression::Narrow(static_cast<const unsigned int*>(import.indices), import.nrOfIndices, narrowedIndices);
+		meshInfo.indexInfo.indexData = narrowedIndices.data();
+		meshInfo.indexInfo.indexFormat = DXGI_FORMAT_R16_UINT;
+	}
 
-	// 3. Fill Index Info
-	meshInfo.indexInfo.nrOfIndicesInBuffer = data.indexData.size();
-	meshInfo.indexInfo.indexData = data.indexData.data();
+	meshInfo.meshletInfo.nrOfMeshlets = import.nrOfMeshlets;
+	meshInfo.meshletInfo.meshletData = import.meshlets;
+	meshInfo.lods = import.lods;
+	meshInfo.parts = import.parts;
 
-	// Helper to create a default white 1x1 texture
-	auto CreateDefaultWhiteTexture = [&]() -> ID3D11ShaderResourceView*
-		{
-			unsigned char whitePixel[4] = { 255, 255, 255, 255 };
-
-			D3D11_TEXTURE2D_DESC desc = {};
-			desc.Width = 1;
-			desc.Height = 1;
-			desc.MipLevels = 1;
-			desc.ArraySize = 1;
-			desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-			desc.SampleDesc.Count = 1;
-			desc.Usage = D3D11_USAGE_DEFAULT;
-			desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-
-			D3D11_SUBRESOURCE_DATA texData = {};
-			texData.pSysMem = whitePixel;
-			texData.SysMemPitch = 4;
-
-			ID3D11Texture2D* tex = nullptr;
-			HRESULT hr = device->CreateTexture2D(&desc, &texData, &tex);
-			if (FAILED(hr) || !tex)
-			{
-				if (tex) tex->Release();
-				return nullptr;
-			}
+	// Baked meshes carry their bounds, so the vertices are not walked again
+	meshInfo.hasLocalBoundingBox = import.hasLocalBoundingBox;
+	meshInfo.localBoundingBox = import.localBoundingBox;
 
-			ID3D11ShaderResourceView* srv = nullptr;
-			hr = device->CreateShaderResourceView(tex, nullptr, &srv);
-			tex->Release();
-
-			if (FAILED(hr))
-			{
-				if (srv) srv->Release();
-				return nullptr;
-			}
+	// A mesh whose geometry is already on the GPU under another name shares those buffers
+	meshInfo.geometryHash = import.geometryHash;
+	meshInfo.geometry = geometryCache.Acquire(device, meshInfo);
 
-			return srv;
+	// Every submesh without a texture shares the cache's 1x1 white texture
+	auto GetDefaultWhiteTexture = [&]() -> ID3D11ShaderResourceView*
+		{
+			return textureCache.AcquireFallback(device);
 		};
 
-	// Helper to load a texture file into an SRV (returns nullptr on failure)
-	auto LoadTextureSRV = [&](const std::string& texPath) -> ID3D11ShaderResourceView*
+	// Helper to get a shared texture SRV, uploading the pre-decoded image on first use (returns nullptr on failure)
+	auto LoadTextureSRV = [&](const std::string& texPath, MipContent content) -> ID3D11ShaderResourceView*
 		{
 			if (texPath.empty())
 				return nullptr;
 
-			std::string fullPath = defaultDirectory + texPath;
+			auto decoded = images.find(texPath);
+			const ImageData* image = decoded != images.end() ? decoded->second.get() : nullptr;
 
-			int w = 0, h = 0, channels = 0;
-			unsigned char* imageData = stbi_load(fullPath.c_str(), &w, &h, &channels, 4);
-			if (!imageData)
-			{
-				// failed to load image
-				return nullptr;
-			}
-
-			D3D11_TEXTURE2D_DESC desc = {};
-			desc.Width = static_cast<UINT>(w);
-			desc.Height = static_cast<UINT>(h);
-			desc.MipLevels = 1;
-			desc.ArraySize = 1;
-			desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-			desc.SampleDesc.Count = 1;
-			desc.Usage = D3D11_USAGE_DEFAULT;
-			desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-			desc.CPUAccessFlags = 0;
-			desc.MiscFlags = 0;
-
-			D3D11_SUBRESOURCE_DATA texData = {};
-			texData.pSysMem = imageData;
-			texData.SysMemPitch = w * 4;
-
-			ID3D11Texture2D* tex = nullptr;
-			HRESULT hr = device->CreateTexture2D(&desc, &texData, &tex);
-			stbi_image_free(imageData);
-
-			if (FAILED(hr) || !tex)
-			{
-				if (tex) tex->Release();
-				return nullptr;
-			}
-
-			ID3D11ShaderResourceView* srv = nullptr;
-			hr = device->CreateShaderResourceView(tex, nullptr, &srv);
-			tex->Release();
-
-			if (FAILED(hr))
-			{
-				if (srv) srv->Release();
-				return nullptr;
-			}
-
-			return srv;
+			return textureCache.Acquire(device, defaultDirectory + texPath, content, image);
 		};
 
-	// 4. Fill SubMesh Info
-	for (const auto& sub : data.finishedSubMeshes)
+	// 4. Fill SubMesh Info; each material is registered once however many submeshes use it
+	std::vector<MaterialId> materialIds(import.materials.size(), INVALID_MATERIAL_ID);
+	for (const auto& sub : import.subMeshes)
 	{
 		MeshData::SubMeshInfo sm = {};
 		sm.startIndexValue = sub.startIndexValue;
@@ -258,65 +625,71 @@ void ParseOBJ(const std::string& identifier, const std::string& contents, ID3D11
 		sm.normalHeightTextureSRV = nullptr;
 		sm.materialIndex = sub.currentSubMeshMaterial;
 
-		const auto& material = data.parsedMaterials[sm.materialIndex];
+		const auto& material = import.materials[sm.materialIndex];
 		sm.material.ambient = material.ambient;
 		sm.material.diffuse = material.diffuse;
 		sm.material.specular = material.specular;
 		sm.material.specularPower = material.specularPower;
 
+		if (materialIds[sm.materialIndex] == INVALID_MATERIAL_ID)
+		{
+			materialIds[sm.materialIndex] = materialTable.Register(material);
+		}
+		sm.materialId = materialIds[sm.materialIndex];
+
 		// Load ambient texture (map_Ka) - use default white if not specified
 		if (!material.mapKa.empty())
 		{
-			sm.ambientTextureSRV = LoadTextureSRV(material.mapKa);
+			sm.ambientTextureSRV = LoadTextureSRV(material.mapKa, MipContent::Color);
 		}
 		if (!sm.ambientTextureSRV)
 		{
-			sm.ambientTextureSRV = CreateDefaultWhiteTexture();
+			sm.ambientTextureSRV = GetDefaultWhiteTexture();
 		}
 
 		// Load diffuse texture (map_Kd) - use default white if not specified
 		if (!material.mapKd.empty())
 		{
-			sm.diffuseTextureSRV = LoadTextureSRV(material.mapKd);
+			sm.diffuseTextureSRV = LoadTextureSRV(material.mapKd, MipContent::Color);
 		}
 		if (!sm.diffuseTextureSRV)
 		{
-			sm.diffuseTextureSRV = CreateDefaultWhiteTexture();
+			sm.diffuseTextureSRV = GetDefaultWhiteTexture();
 		}
 
 		// Load specular texture (map_Ks) - use default white if not specified
 		if (!material.mapKs.empty())
 		{
-			sm.specularTextureSRV = LoadTextureSRV(material.mapKs);
+			sm.specularTextureSRV = LoadTextureSRV(material.mapKs, MipContent::Color);
 		}
 		if (!sm.specularTextureSRV)
 		{
-			sm.specularTextureSRV = CreateDefaultWhiteTexture();
+			sm.specularTextureSRV = GetDefaultWhiteTexture();
 		}
 
 		// Load normal/height map (map_Bump) - no default needed, nullptr is acceptable
 		if (!material.mapBump.empty())
 		{
-			sm.normalHeightTextureSRV = LoadTextureSRV(material.mapBump);
+			sm.normalHeightTextureSRV = LoadTextureSRV(material.mapBump, GetBumpMapContent(material.mapBump));
 		}
 
 		meshInfo.subMeshInfo.push_back(sm);
 	}
 
 	// 5. Initialize the mesh
-	MeshD3D11* toAdd = new MeshD3D11();
+	auto toAdd = std::make_unique<MeshD3D11>();
 	toAdd->Initialize(device, meshInfo);
 
-	loadedMeshes[identifier] = toAdd;
+	return toAdd;
 }
 
 // Parse a single line of OBJ file data
-void ParseLine(const std::string& line, ParseData& data)
+void ParseLine(std::string_view line, ParseData& data)
 {
 	if (line.empty() || line[0] == '#') return;
 
 	size_t pos = 0;
-	std::string type = GetLineString(line, pos);
+	std::string_view type = GetLineString(line, pos);
 
 	if (type == "v")       ParsePosition(line.substr(pos), data);
 	else if (type == "vt") ParseTexCoord(line.substr(pos), data);
@@ -324,10 +697,11 @@ void ParseLine(const std::string& line, ParseData& data)
 	else if (type == "f")  ParseFace(line.substr(pos), data);
 	else if (type == "mtllib") ParseMtlLib(line.substr(pos), data);
 	else if (type == "usemtl") ParseUseMtl(line.substr(pos), data);
+	else if (type == "o" || type == "g") ParseGroup(line.substr(pos), data);
 }
 
 // Parse vertex position data
-void ParsePosition(const std::string& dataSection, ParseData& data)
+void ParsePosition(std::string_view dataSection, ParseData& data)
 {
 	size_t currentPos = 0;
 
@@ -342,7 +716,7 @@ void ParsePosition(const std::string& dataSection, ParseData& data)
 }
 
 // Parse texture coordinate data
-void ParseTexCoord(const std::string& dataSection, ParseData& data)
+void ParseTexCoord(std::string_view dataSection, ParseData& data)
 {
 	size_t pos = 0;
 	float u = GetLineFloat(dataSection, pos);
@@ -352,7 +726,7 @@ void ParseTexCoord(const std::string& dataSection, ParseData& data)
 }
 
 // Parse vertex normal data
-void ParseNormal(const std::string& dataSection, ParseData& data)
+void ParseNormal(std::string_view dataSection, ParseData& data)
 {
 	size_t pos = 0;
 	float x = GetLineFloat(dataSection, pos);
@@ -363,15 +737,8 @@ void ParseNormal(const std::string& dataSection, ParseData& data)
 	data.normals.push_back({ x, y, z });
 }
 
-// Store the index data for a single vertex in a face
-struct VertexData
-{
-	int vInd;
-	int tInd;
-	int nInd;
-};
-
-VertexData ParseFaceVertex(const std::string& dataSection, size_t& pos)
+// Parse a single v, v/t, v//n or v/t/n corner of a face
+VertexData ParseFaceVertex(std::string_view dataSection, size_t& pos)
 {
 	VertexData vertex = { 0, 0, 0 };
 
@@ -399,17 +766,16 @@ VertexData ParseFaceVertex(const std::string& dataSection, size_t& pos)
 	return vertex;
 }
 
-// Parse face data and extract vertex indices
-void ParseFace(const std::string& dataSection, ParseData& data)
+// Parse all corners of a face line into faceVertices
+void ParseFaceCorners(std::string_view dataSection, std::vector<VertexData>& faceVertices)
 {
 	size_t pos = 0;
-	std::vector<VertexData> faceVertices;
+	faceVertices.clear();
 
-	// Parse all vertices in the face
 	while (pos < dataSection.size() && dataSection[pos] != '\0')
 	{
 		// Skip leading whitespace
-		while (pos < dataSection.size() && dataSection[pos] == ' ')
+		while (pos < dataSection.size() && IsSpace(dataSection[pos]))
 			pos++;
 
 		if (pos >= dataSection.size())
@@ -418,6 +784,30 @@ void ParseFace(const std::string& dataSection, ParseData& data)
 		VertexData vertex = ParseFaceVertex(dataSection, pos);
 		faceVertices.push_back(vertex);
 	}
+}
+
+// Build a vertex from resolved 1-based indices; out-of-range indices leave the attribute zeroed
+Vertex MakeVertex(const ParseData& data, int vInd, int tInd, int nInd)
+{
+	Vertex newVert = {};
+
+	if (vInd > 0 && vInd <= (int)data.positions.size())
+		newVert.Position = data.positions[vInd - 1];
+
+	if (tInd > 0 && tInd <= (int)data.texCoords.size())
+		newVert.UV = data.texCoords[tInd - 1];
+
+	if (nInd > 0 && nInd <= (int)data.normals.size())
+		newVert.Normal = data.normals[nInd - 1];
+
+	return newVert;
+}
+
+// Parse face data and extract vertex indices
+void ParseFace(std::string_view dataSection, ParseData& data)
+{
+	std::vector<VertexData>& faceVertices = data.faceVertices;
+	ParseFaceCorners(dataSection, faceVertices);
 
 	// OBJ faces can be triangles or quads; triangulate if needed
 	if (faceVertices.size() >= 3)
@@ -425,7 +815,7 @@ void ParseFace(const std::string& dataSection, ParseData& data)
 		// Fan triangulation for quads and n-gons
 		for (size_t i = 1; i < faceVertices.size() - 1; ++i)
 		{
-			std::vector<VertexData> triangle = {
+			const VertexData triangle[3] = {
 				faceVertices[0],
 				faceVertices[i],
 				faceVertices[i + 1]
@@ -433,170 +823,119 @@ void ParseFace(const std::string& dataSection, ParseData& data)
 
 			for (const auto& vdata : triangle)
 			{
-				// Create cache key (e.g., "1/1/1")
-				std::string token = std::to_string(vdata.vInd) + "/" +
-					std::to_string(vdata.tInd) + "/" +
-					std::to_string(vdata.nInd);
-
-				// Check cache
-				if (data.vertexCache.find(token) != data.vertexCache.end())
-				{
-					data.indexData.push_back(data.vertexCache[token]);
-					continue;
-				}
-
-				// Create new vertex
-				Vertex newVert = {};
-
 				// Handle negative indices (relative) and 1-based indices
 				int vInd = vdata.vInd;
 				int tInd = vdata.tInd;
 				int nInd = vdata.nInd;
 
 				if (vInd < 0) vInd = (int)data.positions.size() + vInd + 1;
-				if (tInd < 0) tInd = (int)data.texCoords.size() + vInd + 1;
-				if (nInd < 0) nInd = (int)data.normals.size() + vInd + 1;
-
-				// Assign vertex data (1-based indexing in OBJ)
-				if (vInd > 0 && vInd <= (int)data.positions.size())
-					newVert.Position = data.positions[vInd - 1];
+				if (tInd < 0) tInd = (int)data.texCoords.size() + tInd + 1;
+				if (nInd < 0) nInd = (int)data.normals.size() + nInd + 1;
 
-				if (tInd > 0 && tInd <= (int)data.texCoords.size())
-					newVert.UV = data.texCoords[tInd - 1];
+				// Single lookup: returns the cached index or claims the next one
+				bool inserted = false;
+				unsigned int index = data.vertexCache.FindOrInsert(
+					static_cast<uint32_t>(vInd), static_cast<uint32_t>(tInd), static_cast<uint32_t>(nInd),
+					static_cast<uint32_t>(data.vertices.size()), inserted);
 
-				if (nInd > 0 && nInd <= (int)data.normals.size())
-					newVert.Normal = data.normals[nInd - 1];
+				if (inserted)
+				{
+					data.vertices.push_back(MakeVertex(data, vInd, tInd, nInd));
+				}
 
-				// Add to buffer and cache
-				unsigned int newIndex = (unsigned int)data.vertices.size();
-				data.vertices.push_back(newVert);
-				data.indexData.push_back(newIndex);
-				data.vertexCache[token] = newIndex;
+				data.indexData.push_back(index);
 			}
 		}
 	}
 }
 
 // Parse material library file specified in the OBJ
-void ParseMtlLib(const std::string& dataSection, ParseData& data)
+void ParseMtlLib(std::string_view dataSection, ParseData& data)
 {
-	const std::string mtlPath = Trim(dataSection);
+	const std::string mtlPath(Trim(dataSection));
 	if (mtlPath.empty())
 	{
 		return;
 	}
 
-	// Construct full path: defaultDirectory is already "objects/"
-	std::string fullMtlPath = defaultDirectory + mtlPath;
-
-	std::string fileContents;
-	// ReadFile will prepend defaultDirectory, but mtlPath already includes it, so pass relative path
-	ReadFile(mtlPath, fileContents);
-
-	std::istringstream mtlStream(fileContents);
-	std::string line;
-	MaterialInfo* current = nullptr;
-
-	while (std::getline(mtlStream, line))
+	// MTL paths are relative to the OBJ, which lives in defaultDirectory; every OBJ naming the
+	// same file shares one parse of it
+	const std::shared_ptr<const std::vector<MaterialInfo>> library = mtlLibraryCache.Load(defaultDirectory + mtlPath);
+	if (!library)
 	{
-		if (line.empty() || line[0] == '#')
-			continue;
-
-		std::istringstream lineStream(line);
-		std::string type;
-		lineStream >> type;
+		throw std::runtime_error("Failed to open file: " + mtlPath);
+	}
+	data.materialLibraries.push_back(mtlPath);
 
-		if (type == "newmtl")
-		{
-			std::string name;
-			std::getline(lineStream, name);
-			name = Trim(name);
-			data.parsedMaterials.push_back(MaterialInfo{});
-			current = &data.parsedMaterials.back();
-			current->name = name;
-		}
-		else if (current && type == "Ka")
-		{
-			lineStream >> current->ambient.x >> current->ambient.y >> current->ambient.z;
-		}
-		else if (current && type == "Kd")
-		{
-			lineStream >> current->diffuse.x >> current->diffuse.y >> current->diffuse.z;
-		}
-		else if (current && type == "Ks")
-		{
-			lineStream >> current->specular.x >> current->specular.y >> current->specular.z;
-		}
-		else if (current && type == "Ns")
-		{
-			lineStream >> current->specularPower;
-		}
-		else if (current && type == "map_Ka")
-		{
-			std::getline(lineStream, current->mapKa);
-			current->mapKa = Trim(current->mapKa);
-		}
-		else if (current && type == "map_Kd")
-		{
-			std::getline(lineStream, current->mapKd);
-			current->mapKd = Trim(current->mapKd);
-		}
-		else if (current && type == "map_Ks")
-		{
-			std::getline(lineStream, current->mapKs);
-			current->mapKs = Trim(current->mapKs);
-		}
-		else if (current && (type == "map_Bump" || type == "bump"))
-		{
-			std::getline(lineStream, current->mapBump);
-			current->mapBump = Trim(current->mapBump);
-		}
+	for (const MaterialInfo& material : *library)
+	{
+		data.materialLookup.emplace(material.name, data.parsedMaterials.size());
+		data.parsedMaterials.push_back(material);
 	}
 }
 
 // Parse the usemtl line to set the current material
-void ParseUseMtl(const std::string& dataSection, ParseData& data)
+void ParseUseMtl(std::string_view dataSection, ParseData& data)
 {
 	size_t pos = 0;
-	std::string mtlName = GetLineString(dataSection, pos);
+	std::string_view mtlName = GetLineString(dataSection, pos);
 
+	BeginSubMesh(mtlName, data.indexData.size(), data);
+}
+
+// Parse an o or g line, starting a part named after the rest of the line
+void ParseGroup(std::string_view dataSection, ParseData& data)
+{
+	BeginPart(dataSection, data.indexData.size(), data);
+}
+
+// Find the material matching mtlName, falling back to the default material
+size_t FindMaterialIndex(std::string_view mtlName, const ParseData& data)
+{
+	const auto found = data.materialLookup.find(mtlName);
+	return found != data.materialLookup.end() ? found->second : 0;
+}
+
+// End the current submesh at indexPosition and start a new one with the named material
+void BeginSubMesh(std::string_view mtlName, size_t indexPosition, ParseData& data)
+{
 	// If we have indices, push the previous submesh
-	if (data.indexData.size() > data.currentSubmeshStartIndex)
+	if (indexPosition > data.currentSubmeshStartIndex)
 	{
-		PushBackCurrentSubmesh(data);
-		data.currentSubmeshStartIndex = data.indexData.size();
+		PushBackCurrentSubmesh(data, indexPosition);
+		data.currentSubmeshStartIndex = indexPosition;
 	}
 
-	// Find material index in data.parsedMaterials matching mtlName
-	size_t materialIndex = 0;
-	bool found = false;
-	for (size_t i = 0; i < data.parsedMaterials.size(); ++i)
-	{
-		if (data.parsedMaterials[i].name == mtlName)
-		{
-			materialIndex = i;
-			found = true;
-			break;
-		}
-	}
+	data.currentSubMeshMaterial = FindMaterialIndex(mtlName, data);
+}
 
-	if (!found)
+// End the current submesh at indexPosition and start a new part that continues its material
+void BeginPart(std::string_view name, size_t indexPosition, ParseData& data)
+{
+	if (indexPosition > data.currentSubmeshStartIndex)
 	{
-		materialIndex = 0;
+		PushBackCurrentSubmesh(data, indexPosition);
+		data.currentSubmeshStartIndex = indexPosition;
 	}
 
-	data.currentSubMeshMaterial = materialIndex;
+	MeshParts::Begin(Trim(name), data.finishedSubMeshes.size(), data.parts);
 }
 
 // Add the current submesh to the finished list
 void PushBackCurrentSubmesh(ParseData& data)
 {
-	if (data.indexData.size() <= data.currentSubmeshStartIndex)
+	PushBackCurrentSubmesh(data, data.indexData.size());
+}
+
+// Add the current submesh, ending at endIndex, to the finished list
+void PushBackCurrentSubmesh(ParseData& data, size_t endIndex)
+{
+	if (endIndex <= data.currentSubmeshStartIndex)
 		return;
 
 	SubMeshInfo toAdd;
 	toAdd.startIndexValue = data.currentSubmeshStartIndex;
-	toAdd.nrOfIndicesInSubMesh = data.indexData.size() - toAdd.startIndexValue;
+	toAdd.nrOfIndicesInSubMesh = endIndex - toAdd.startIndexValue;
 	toAdd.currentSubMeshMaterial = data.currentSubMeshMaterial;
 
 	// Set texture SRVs to nullptr
@@ -607,4 +946,3 @@ void PushBackCurrentSubmesh(ParseData& data)
 
 	data.finishedSubMeshes.push_back(toAdd);
 }
-
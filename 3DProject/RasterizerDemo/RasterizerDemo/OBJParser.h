@@ -1,15 +1,30 @@
 #pragma once
 
+#include <future>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
-#include <sstream>
-#include <fstream>
 #include <DirectXMath.h>
+#include <DirectXCollision.h>
 #include <d3d11.h>
 
+#include "VertexCacheTable.h"
+#include "BakedMesh.h"
+#include "MemoryMappedFile.h"
+#include "TextureCache.h"
+#include "GeometryCache.h"
+#include "Meshlets.h"
+#include "MeshParts.h"
+#include "MeshSimplifier.h"
+#include "MeshCleanup.h"
+#include "MaterialLibrary.h"
+#include "VertexPacking.h"
+
 // Forward declarations
 class MeshD3D11;
+struct MeshHandle;
 struct ID3D11ShaderResourceView;
 
 // Vertex structure matching the OBJ file format (position, normal, UV)
@@ -50,6 +65,21 @@ struct SubMeshInfo
 	std::size_t currentSubMeshMaterial = 0;
 };
 
+// Index data for a single corner of a face (v/t/n, 1-based, may be negative)
+struct VertexData
+{
+	int vInd;
+	int tInd;
+	int nInd;
+};
+
+// Lets the material lookup take the string_view from a usemtl line without copying it
+struct MaterialNameHash
+{
+	using is_transparent = void;
+	std::size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+};
+
 // Intermediate data structure used during OBJ parsing
 struct ParseData
 {
@@ -57,52 +87,227 @@ struct ParseData
 	std::vector<DirectX::XMFLOAT3> normals;
 	std::vector<DirectX::XMFLOAT2> texCoords;
 
-	std::unordered_map<std::string, unsigned int> vertexCache;
+	// Deduplicates face corners by their resolved (v, t, n) triple
+	VertexCacheTable vertexCache;
+
+	// Corners of the face being parsed, reused between faces to avoid allocations
+	std::vector<VertexData> faceVertices;
 
 	std::vector<Vertex> vertices;
 	std::vector<unsigned int> indexData;
 
+	// One TangentGenerator frame per vertex, empty unless objImportSettings.generateTangents
+	std::vector<DirectX::XMFLOAT4> tangents;
+
+	// The vertices again in packedFormat, empty unless objImportSettings.packVertices
+	std::vector<unsigned char> packedVertices;
+	PackedVertexFormat packedFormat;
+
 	std::vector<MaterialInfo> parsedMaterials;
+	// Name -> index into parsedMaterials; the first library defining a name wins
+	std::unordered_map<std::string, std::size_t, MaterialNameHash, std::equal_to<>> materialLookup;
 	std::vector<SubMeshInfo> finishedSubMeshes;
 
+	// Culling clusters over indexData, built after the optimization passes
+	std::vector<Meshlet> meshlets;
+
+	// Reduced levels, their indices appended to indexData after the full-detail submeshes
+	std::vector<MeshLOD> lods;
+
+	// Object and group records, begun by ParseGroup and finished by MeshParts::Build
+	std::vector<MeshPart> parts;
+
+	// What MeshCleanup removed, summed over the import's passes
+	MeshCleanupStatistics cleanup;
+
+	// mtllib paths in file order, part of the baked mesh cache key
+	std::vector<std::string> materialLibraries;
+
 	std::size_t currentSubmeshStartIndex = 0;
 	std::size_t currentSubMeshMaterial = 0;
 };
 
-// Global mesh cache and default directory for OBJ files
+// CPU-side result of an import. Vertices and indices point into a ParseData, a memory-mapped
+// baked mesh or a memory-mapped .glb, which must outlive the call that creates the GPU mesh.
+struct MeshImport
+{
+	const Vertex* vertices = nullptr;
+	std::size_t nrOfVertices = 0;
+	// uint16_t or uint32_t elements, matching indexFormat
+	const void* indices = nullptr;
+	std::size_t nrOfIndices = 0;
+	DXGI_FORMAT indexFormat = DXGI_FORMAT_R32_UINT;
+	// nrOfVertices entries, or null when the mesh has no tangents
+	const DirectX::XMFLOAT4* tangents = nullptr;
+	// nrOfVertices * packedFormat.GetStride() bytes, or null when the mesh has no packed copy
+	const unsigned char* packedVertices = nullptr;
+	PackedVertexFormat packedFormat;
+
+	std::vector<SubMeshInfo> subMeshes;
+	std::vector<MaterialInfo> materials;
+
+	const Meshlet* meshlets = nullptr;
+	std::size_t nrOfMeshlets = 0;
+
+	std::vector<MeshLOD> lods;
+
+	// Empty for meshes culled as a whole
+	std::vector<MeshPart> parts;
+
+	bool hasLocalBoundingBox = false;
+	DirectX::BoundingBox localBoundingBox;
+
+	// HashMeshGeometry of the above, the GeometryCache key; 0 when not hashed
+	uint64_t geometryHash = 0;
+};
+
+// CPU-side result of loading a mesh file, produced on a loader thread.
+// import points into data, baked or sourceFile, so a PendingMesh is never moved once filled.
+struct PendingMesh
+{
+	std::string identifier;
+	ParseData data;
+	BakedMesh baked;
+	// Kept open for formats whose buffers the import uses in place (.glb)
+	MemoryMappedFile sourceFile;
+	MeshImport import;
+
+	// Decoded textures keyed by the path used in the material; textures that were
+	// already uploaded when the import ran are not decoded again and are left out
+	std::unordered_map<std::string, std::shared_ptr<const ImageData>> images;
+};
+
+// Handle to a mesh being imported on the loader pool
+struct MeshRequest
+{
+	std::string path;
+	std::future<std::unique_ptr<PendingMesh>> pending;
+};
+
+// Bump whenever the parser output changes for the same input, so stale baked meshes are rebuilt
+constexpr unsigned int OBJ_PARSER_VERSION = 3;
+
+// Options applied to every OBJ import
+struct OBJImportSettings
+{
+	// Files at least this large are split at line boundaries and parsed on all cores
+	std::size_t parallelParseMinBytes = 4 * 1024 * 1024;
+	// Upper bound on parse threads, 0 uses every hardware thread
+	unsigned int maxParseThreads = 0;
+	// Files at least this large are read block by block instead of mapped and finished one
+	// submesh at a time (see ParseOBJStreaming); 0 never streams
+	std::size_t streamingImportMinBytes = 512ull * 1024 * 1024;
+	// Bytes read per block by the streaming import, rounded up to whole megabytes
+	std::size_t streamingBlockBytes = 8 * 1024 * 1024;
+	// A streaming import that would hold more than this many bytes fails instead of running the
+	// process out of memory; 0 is no limit
+	std::size_t streamingMemoryLimit = 0;
+	// Weld duplicate vertices, drop degenerate and duplicate triangles and merge submeshes that
+	// share a material, before any other pass
+	bool cleanMeshes = true;
+	// Vertices closer than this, in file units, with matching normals and UVs are welded
+	float weldEpsilon = 1.0e-6f;
+	// Reorder triangles and vertices for the post-transform cache, overdraw and vertex fetch
+	bool optimizeMeshes = true;
+	// Store baked indices with the IndexCompression varint encoding instead of raw
+	bool compressBakedIndices = true;
+	// Per-vertex MikkTSpace tangents for normal mapping, in a second vertex stream
+	bool generateTangents = true;
+	// Simplify every mesh into MeshSimplifier::LOD_RATIOS levels that share its vertex buffer
+	bool generateLODs = true;
+	// Keep a VertexPacking copy of the vertices, which the shadow and environment map passes
+	// draw instead of the full ones
+	bool packVertices = true;
+	VertexPackingOptions vertexPacking;
+};
+
+// Default directory for OBJ files; the loaded meshes are held by meshResidency (MeshResidency.h)
 extern std::string defaultDirectory;
-extern std::unordered_map<std::string, MeshD3D11*> loadedMeshes;
+extern OBJImportSettings objImportSettings;
+
+extern TextureCache textureCache;
+extern GeometryCache geometryCache;
+extern MaterialTable materialTable;
+extern MtlLibraryCache mtlLibraryCache;
+
+// Token parsing utilities, operating in place on views into the mapped file
+std::string_view GetNextLine(std::string_view contents, std::size_t& currentPos);
+float GetLineFloat(std::string_view line, std::size_t& currentLinePos);
+int GetLineInt(std::string_view line, std::size_t& currentLinePos);
+std::string_view GetLineString(std::string_view line, std::size_t& currentLinePos);
+
+// Retrieves or loads a mesh, reloading it now if it was evicted
+MeshHandle GetMesh(const std::string& path, ID3D11Device* device);
+
+// Asynchronous loading: RequestMesh starts the file and texture work on the loader pool and
+// returns immediately; FinishMesh waits for it and creates the GPU resources, so it must be
+// called on the thread that owns the device. Requests for resident meshes finish instantly.
+MeshRequest RequestMesh(const std::string& path);
+MeshHandle FinishMesh(MeshRequest& request, ID3D11Device* device);
+
+// map_Bump holds either a normal map or a height map, told apart by the usual "_Normal" file suffix
+MipContent GetBumpMapContent(const std::string& texPath);
 
-struct TextureResource;
-extern std::unordered_map<std::string, TextureResource> loadedTextures;
+// The device-free part of a load, safe to call from any thread
+std::unique_ptr<PendingMesh> ImportMesh(const std::string& path);
 
-// Token parsing utilities
-float GetLineFloat(const std::string& line, std::size_t& currentLinePos);
-int GetLineInt(const std::string& line, std::size_t& currentLinePos);
-std::string GetLineString(const std::string& line, std::size_t& currentLinePos);
+// Counts the records in the file and reserves the parse arrays and vertex cache up front
+void ReserveParseData(std::string_view contents, ParseData& data);
 
-// Retrieves or loads a mesh from cache
-const MeshD3D11* GetMesh(const std::string& path, ID3D11Device* device);
+// Parses OBJ text into data; large files are parsed in parallel with identical results. The
+// faces then go through ProcessParseData, whose passes may reorder data.vertices, so
+// data.vertexCache no longer matches the vertex order afterwards.
+void ParseOBJContents(std::string_view contents, ParseData& data);
 
-// File I/O
-void ReadFile(const std::string& path, std::string& toFill);
+// The objImportSettings passes ParseOBJContents runs once the faces are in, for any importer
+// that fills data.vertices, indexData and finishedSubMeshes
+void ProcessParseData(ParseData& data);
 
-// OBJ parsing entry point
-void ParseOBJ(const std::string& identifier, const std::string& contents, ID3D11Device* device);
+// Fills data.packedVertices and packedFormat from data.vertices with objImportSettings.vertexPacking
+void PackParseData(ParseData& data);
+
+// OBJ parsing entry point, contents is usually a view of a memory-mapped file. The mesh is
+// added to meshResidency under identifier.
+void ParseOBJ(const std::string& identifier, std::string_view contents, ID3D11Device* device);
+
+// Views parsed data as an import; data must stay alive while the import is used
+void BuildMeshImport(const ParseData& data, MeshImport& import);
+
+// Content hash of an import's vertices, tangents and indices, the same for 16- and 32-bit
+// indices of equal value; equal hashes mean meshes can share GPU buffers. Never 0.
+uint64_t HashMeshGeometry(const MeshImport& import);
+
+// Creates the GPU mesh for the caller to hand to meshResidency. Textures come from textureCache,
+// which uploads the ones found in images and decodes any others on this thread, and the
+// buffers from geometryCache when a live mesh has the same import.geometryHash.
+std::unique_ptr<MeshD3D11> CreateMeshFromImport(const MeshImport& import,
+	const std::unordered_map<std::string, std::shared_ptr<const ImageData>>& images, ID3D11Device* device);
 
 // Line-by-line parsing dispatcher
-void ParseLine(const std::string& line, ParseData& data);
+void ParseLine(std::string_view line, ParseData& data);
 
 // OBJ element parsers
-void ParsePosition(const std::string& dataSection, ParseData& data);
-void ParseTexCoord(const std::string& dataSection, ParseData& data);
-void ParseNormal(const std::string& dataSection, ParseData& data);
-void ParseFace(const std::string& dataSection, ParseData& data);
-void ParseMtlLib(const std::string& dataSection, ParseData& data);
-void ParseUseMtl(const std::string& dataSection, ParseData& data);
+void ParsePosition(std::string_view dataSection, ParseData& data);
+void ParseTexCoord(std::string_view dataSection, ParseData& data);
+void ParseNormal(std::string_view dataSection, ParseData& data);
+void ParseFace(std::string_view dataSection, ParseData& data);
+VertexData ParseFaceVertex(std::string_view dataSection, std::size_t& pos);
+void ParseFaceCorners(std::string_view dataSection, std::vector<VertexData>& faceVertices);
+Vertex MakeVertex(const ParseData& data, int vInd, int tInd, int nInd);
+void ParseMtlLib(std::string_view dataSection, ParseData& data);
+void ParseUseMtl(std::string_view dataSection, ParseData& data);
+void ParseGroup(std::string_view dataSection, ParseData& data);
+
+// Material lookup and submesh switching shared by the serial and parallel parsers
+std::size_t FindMaterialIndex(std::string_view mtlName, const ParseData& data);
+void BeginSubMesh(std::string_view mtlName, std::size_t indexPosition, ParseData& data);
+// Ends the current submesh at indexPosition and starts a part named by the trimmed line
+// remainder, keeping the material
+void BeginPart(std::string_view name, std::size_t indexPosition, ParseData& data);
 
 // Finalizes the current submesh and adds it to the list
 void PushBackCurrentSubmesh(ParseData& data);
+void PushBackCurrentSubmesh(ParseData& data, std::size_t endIndex);
 
 // Cleanup for cached meshes
 void UnloadMeshes();
\ No newline at end of file
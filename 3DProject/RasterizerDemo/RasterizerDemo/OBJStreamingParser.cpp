@@ -0,0 +1,365 @@
+#include "OBJStreamingParser.h"
+#include "OBJParser.h"
+#include "BakedMesh.h"
+#include "ContentHash.h"
+#include "MeshCleanup.h"
+#include "MeshOptimizer.h"
+#include "TangentGenerator.h"
+
+#include <Windows.h>
+#include <Psapi.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+	// The cache key hashes the file in pieces of this size at fixed offsets, so blocks are
+	// rounded up to a multiple of it
+	constexpr std::size_t HASH_CHUNK_BYTES = 1024 * 1024;
+
+	std::size_t GetBlockBytes()
+	{
+		const std::size_t chunks = (objImportSettings.streamingBlockBytes + HASH_CHUNK_BYTES - 1) / HASH_CHUNK_BYTES;
+		return (std::max)(chunks, std::size_t{ 1 }) * HASH_CHUNK_BYTES;
+	}
+
+	std::size_t GetWorkingSetBytes()
+	{
+		PROCESS_MEMORY_COUNTERS counters = {};
+		counters.cb = sizeof(counters);
+		return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.WorkingSetSize : 0;
+	}
+
+	// Reads a file one fixed-size block at a time and hands out the whole lines in it. A line
+	// cut by the end of a block is carried over to the front of the next one.
+	class BlockLineReader
+	{
+	private:
+		std::ifstream file;
+		std::vector<char> buffer;
+		std::size_t blockBytes = 0;
+		std::size_t carried = 0;
+		std::size_t filled = 0;
+		std::size_t linesEnd = 0;
+		bool endOfFile = false;
+
+	public:
+		bool Open(const std::string& path, std::size_t newBlockBytes)
+		{
+			file.open(path, std::ios::binary);
+			blockBytes = newBlockBytes;
+			return file.is_open();
+		}
+
+		// Returns false once the file is exhausted
+		bool ReadBlock()
+		{
+			carried = filled - linesEnd;
+			if (carried > 0)
+			{
+				std::memmove(buffer.data(), buffer.data() + linesEnd, carried);
+			}
+
+			// Only a line longer than a block makes the buffer grow
+			if (buffer.size() < carried + blockBytes)
+			{
+				buffer.resize(carried + blockBytes);
+			}
+
+			std::size_t read = 0;
+			if (!endOfFile)
+			{
+				file.read(buffer.data() + carried, static_cast<std::streamsize>(blockBytes));
+				read = static_cast<std::size_t>(file.gcount());
+				endOfFile = read < blockBytes;
+			}
+
+			filled = carried + read;
+			if (filled == 0)
+			{
+				linesEnd = 0;
+				return false;
+			}
+
+			linesEnd = filled;
+			if (!endOfFile)
+			{
+				while (linesEnd > 0 && buffer[linesEnd - 1] != '\n')
+				{
+					--linesEnd;
+				}
+			}
+			return true;
+		}
+
+		// The bytes the last ReadBlock took from the file
+		std::string_view GetBlock() const { return std::string_view(buffer.data() + carried, filled - carried); }
+		std::string_view GetLines() const { return std::string_view(buffer.data(), linesEnd); }
+		std::size_t GetMemoryUsage() const { return buffer.capacity(); }
+	};
+
+	// Submeshes already flushed, in the final layout
+	struct StreamedMesh
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		std::vector<DirectX::XMFLOAT4> tangents;
+		std::vector<SubMeshInfo> subMeshes;
+	};
+
+	template <typename T>
+	std::size_t CapacityBytes(const std::vector<T>& vector)
+	{
+		return vector.capacity() * sizeof(T);
+	}
+
+	std::size_t HeldBytes(const ParseData& data, const StreamedMesh& mesh, const BlockLineReader& reader)
+	{
+		return reader.GetMemoryUsage() +
+			CapacityBytes(data.positions) + CapacityBytes(data.normals) + CapacityBytes(data.texCoords) +
+			data.vertexCache.GetMemoryUsage() + CapacityBytes(data.vertices) + CapacityBytes(data.indexData) +
+			CapacityBytes(data.tangents) + CapacityBytes(data.meshlets) + CapacityBytes(data.packedVertices) +
+			CapacityBytes(mesh.vertices) + CapacityBytes(mesh.indices) + CapacityBytes(mesh.tangents);
+	}
+
+	// An o or g record
+	bool IsGroupLine(std::string_view line)
+	{
+		return !line.empty() && (line[0] == 'o' || line[0] == 'g') && (line.size() == 1 || line[1] == ' ' || line[1] == '\t');
+	}
+
+	// The rest of an o or g line without surrounding whitespace
+	std::string_view GetGroupName(std::string_view line)
+	{
+		const std::size_t start = line.find_first_not_of(" \t\r", 1);
+		if (start == std::string_view::npos)
+			return {};
+
+		return line.substr(start, line.find_last_not_of(" \t\r") + 1 - start);
+	}
+
+	// Finishes the submesh held in data and appends it to mesh, leaving data ready for the next
+	void FlushSubMesh(ParseData& data, StreamedMesh& mesh)
+	{
+		if (data.indexData.empty())
+			return;
+
+		// Starts at 0 in data's arrays until it is appended below
+		SubMeshInfo subMesh;
+		subMesh.nrOfIndicesInSubMesh = data.indexData.size();
+		subMesh.currentSubMeshMaterial = data.currentSubMeshMaterial;
+
+		// Welds within the submesh only; merging with earlier submeshes waits for the end of the file
+		if (objImportSettings.cleanMeshes)
+		{
+			std::vector<SubMeshInfo> subMeshes = { subMesh };
+			std::vector<MeshPart> noParts;
+			MeshCleanup::Clean(data.vertices, data.indexData, subMeshes, noParts, objImportSettings.weldEpsilon, &data.cleanup);
+			if (subMeshes.empty())
+			{
+				data.vertices.clear();
+				data.indexData.clear();
+				data.vertexCache.Clear();
+				return;
+			}
+			subMesh = subMeshes.front();
+		}
+
+		if (objImportSettings.optimizeMeshes)
+		{
+			MeshOptimizer::Optimize(data.vertices, data.indexData, { subMesh });
+		}
+
+		if (objImportSettings.generateTangents)
+		{
+			TangentGenerator::Generate(data.vertices, data.indexData, data.tangents, objImportSettings.maxParseThreads);
+			mesh.tangents.insert(mesh.tangents.end(), data.tangents.begin(), data.tangents.end());
+		}
+
+		const unsigned int baseVertex = static_cast<unsigned int>(mesh.vertices.size());
+		subMesh.startIndexValue = mesh.indices.size();
+		for (unsigned int index : data.indexData)
+		{
+			mesh.indices.push_back(baseVertex + index);
+		}
+		mesh.vertices.insert(mesh.vertices.end(), data.vertices.begin(), data.vertices.end());
+		mesh.subMeshes.push_back(subMesh);
+
+		// Capacity is kept for the next submesh
+		data.vertices.clear();
+		data.indexData.clear();
+		data.tangents.clear();
+		data.vertexCache.Clear();
+	}
+}
+
+bool UseStreamingImport(std::size_t fileSize)
+{
+	return objImportSettings.streamingImportMinBytes > 0 && fileSize >= objImportSettings.streamingImportMinBytes;
+}
+
+bool ScanOBJFile(const std::string& path, OBJFileScan& scan)
+{
+	BlockLineReader reader;
+	if (!reader.Open(path, GetBlockBytes()))
+		return false;
+
+	scan = {};
+	scan.contentHash = HashImportSettings();
+	std::vector<VertexData> faceVertices;
+
+	while (reader.ReadBlock())
+	{
+		const std::string_view block = reader.GetBlock();
+		for (std::size_t offset = 0; offset < block.size(); offset += HASH_CHUNK_BYTES)
+		{
+			scan.contentHash = HashBytes(block.substr(offset, HASH_CHUNK_BYTES), scan.contentHash);
+		}
+
+		const std::string_view lines = reader.GetLines();
+		std::size_t linePos = 0;
+		while (linePos < lines.size())
+		{
+			const std::string_view line = GetNextLine(lines, linePos);
+			if (line.size() < 2 || (line[1] != ' ' && line[1] != '\t' && line[1] != 't' && line[1] != 'n'))
+				continue;
+
+			if (line[0] == 'f' && (line[1] == ' ' || line[1] == '\t'))
+			{
+				ParseFaceCorners(line.substr(2), faceVertices);
+				scan.nrOfTriangles += faceVertices.size() >= 3 ? faceVertices.size() - 2 : 0;
+			}
+			else if (line[0] == 'v')
+			{
+				if (line[1] == 't')
+					scan.nrOfTexCoords++;
+				else if (line[1] == 'n')
+					scan.nrOfNormals++;
+				else
+					scan.nrOfPositions++;
+			}
+		}
+	}
+
+	return true;
+}
+
+void ParseOBJStreaming(const std::string& path, const OBJFileScan& scan, ParseData& data, OBJStreamingStatistics* statistics)
+{
+	BlockLineReader reader;
+	if (!reader.Open(path, GetBlockBytes()))
+	{
+		throw std::runtime_error("Failed to open file: " + path);
+	}
+
+	OBJStreamingStatistics stats;
+	StreamedMesh mesh;
+
+	auto CheckMemory = [&]()
+		{
+			const std::size_t held = HeldBytes(data, mesh, reader);
+			stats.peakTrackedBytes = (std::max)(stats.peakTrackedBytes, held);
+			stats.peakWorkingSetBytes = (std::max)(stats.peakWorkingSetBytes, GetWorkingSetBytes());
+
+			if (objImportSettings.streamingMemoryLimit > 0 && held > objImportSettings.streamingMemoryLimit)
+			{
+				throw std::runtime_error("Streaming import of " + path + " needs more than the " +
+					std::to_string(objImportSettings.streamingMemoryLimit / (1024 * 1024)) + " MB memory limit");
+			}
+		};
+
+	// Exact sizes from the scan, so the attribute and index arrays never reallocate
+	data.positions.reserve(scan.nrOfPositions);
+	data.texCoords.reserve(scan.nrOfTexCoords);
+	data.normals.reserve(scan.nrOfNormals);
+	mesh.indices.reserve(scan.nrOfTriangles * 3);
+
+	// Default material in case the OBJ doesn't reference one
+	data.parsedMaterials.push_back(MaterialInfo{});
+
+	while (reader.ReadBlock())
+	{
+		stats.bytesRead += reader.GetBlock().size();
+		stats.nrOfBlocks++;
+
+		const std::string_view lines = reader.GetLines();
+		std::size_t linePos = 0;
+		while (linePos < lines.size())
+		{
+			const std::string_view line = GetNextLine(lines, linePos);
+
+			// The open submesh ends where the next material starts
+			if (line.starts_with("usemtl"))
+			{
+				const std::size_t subMeshesBefore = mesh.subMeshes.size();
+				FlushSubMesh(data, mesh);
+				stats.nrOfFlushedSubMeshes += mesh.subMeshes.size() - subMeshesBefore;
+			}
+
+			// So does the next object or group, whose part starts with the next submesh flushed
+			if (IsGroupLine(line))
+			{
+				const std::size_t subMeshesBefore = mesh.subMeshes.size();
+				FlushSubMesh(data, mesh);
+				stats.nrOfFlushedSubMeshes += mesh.subMeshes.size() - subMeshesBefore;
+
+				MeshParts::Begin(GetGroupName(line), mesh.subMeshes.size(), data.parts);
+				continue;
+			}
+
+			ParseLine(line, data);
+		}
+
+		CheckMemory();
+	}
+
+	const std::size_t subMeshesBefore = mesh.subMeshes.size();
+	FlushSubMesh(data, mesh);
+	stats.nrOfFlushedSubMeshes += mesh.subMeshes.size() - subMeshesBefore;
+	CheckMemory();
+
+	// Faces are resolved, so the attribute arrays and vertex cache can go before the whole-mesh passes
+	data.positions = {};
+	data.normals = {};
+	data.texCoords = {};
+	data.vertexCache = VertexCacheTable();
+	data.vertices = std::move(mesh.vertices);
+	data.indexData = std::move(mesh.indices);
+	data.tangents = std::move(mesh.tangents);
+	data.finishedSubMeshes = std::move(mesh.subMeshes);
+
+	// Triangles only move between the index ranges, so the flushed vertices and tangents stay
+	if (objImportSettings.cleanMeshes)
+	{
+		MeshCleanup::RebuildSubMeshes(data.vertices, data.indexData, data.finishedSubMeshes, data.parts, &data.cleanup);
+		CheckMemory();
+	}
+
+	// Levels go after the full-detail indices, so meshlets below only ever cover the full mesh
+	if (objImportSettings.generateLODs)
+	{
+		MeshSimplifier::GenerateLODs(data.vertices, data.indexData, data.finishedSubMeshes, data.lods);
+		CheckMemory();
+	}
+
+	Meshlets::Build(data.vertices, data.indexData, data.finishedSubMeshes, data.meshlets);
+	CheckMemory();
+	MeshParts::Build(data.vertices, data.indexData, data.finishedSubMeshes, data.meshlets, data.parts);
+	CheckMemory();
+
+	if (objImportSettings.packVertices)
+	{
+		PackParseData(data);
+		CheckMemory();
+	}
+
+	if (statistics)
+	{
+		*statistics = stats;
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct ParseData;
+
+// Record counts and cache key of an OBJ file, gathered by ScanOBJFile in one pass
+struct OBJFileScan
+{
+	// OBJ part of the baked mesh cache key, for HashMeshSource and BakedMesh::Load
+	uint64_t contentHash = 0;
+	std::size_t nrOfPositions = 0;
+	std::size_t nrOfTexCoords = 0;
+	std::size_t nrOfNormals = 0;
+	std::size_t nrOfTriangles = 0;
+};
+
+struct OBJStreamingStatistics
+{
+	std::size_t bytesRead = 0;
+	std::size_t nrOfBlocks = 0;
+	std::size_t nrOfFlushedSubMeshes = 0;
+	// Largest total of the buffers the import held at once, what streamingMemoryLimit bounds
+	std::size_t peakTrackedBytes = 0;
+	// Largest process working set sampled between blocks and passes
+	std::size_t peakWorkingSetBytes = 0;
+};
+
+// Whether objImportSettings sends a file of this size through the streaming import
+bool UseStreamingImport(std::size_t fileSize);
+
+// Reads the file in objImportSettings.streamingBlockBytes blocks; returns false if it cannot be
+// opened. The hash does not depend on the block size.
+bool ScanOBJFile(const std::string& path, OBJFileScan& scan);
+
+// Bounded-memory counterpart of ParseOBJContents for files too large to map and parse whole.
+// The file is read block by block and never held in full. Every submesh gets its own vertex
+// cache and is optimized and given tangents as soon as its last face is read, so those passes
+// only ever see one submesh; LODs and meshlets run once all submeshes are in. A vertex shared by
+// two submeshes is stored once per submesh. Throws std::runtime_error if the file cannot be read
+// or the import would hold more than objImportSettings.streamingMemoryLimit bytes.
+void ParseOBJStreaming(const std::string& path, const OBJFileScan& scan, ParseData& data,
+	OBJStreamingStatistics* statistics = nullptr);
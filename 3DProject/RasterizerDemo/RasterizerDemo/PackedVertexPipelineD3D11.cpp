@@ -0,0 +1,52 @@
+#include "PackedVertexPipelineD3D11.h"
+#include "ShaderLoader.h"
+
+PackedVertexPipelineD3D11::~PackedVertexPipelineD3D11()
+{
+	if (vertexShader)
+	{
+		vertexShader->Release();
+		vertexShader = nullptr;
+	}
+}
+
+size_t PackedVertexPipelineD3D11::GetLayoutIndex(const PackedVertexFormat& format)
+{
+	return (format.quantizedPositions ? 2 : 0) + (format.unormTexCoords ? 1 : 0);
+}
+
+bool PackedVertexPipelineD3D11::Initialize(ID3D11Device* device, const std::string& shaderFile)
+{
+	std::string byteCode;
+	vertexShader = ShaderLoader::CreateVertexShader(device, shaderFile, &byteCode);
+	if (!vertexShader)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < NR_OF_LAYOUTS; ++i)
+	{
+		PackedVertexFormat format;
+		format.quantizedPositions = (i & 2) != 0;
+		format.unormTexCoords = (i & 1) != 0;
+
+		InputLayoutD3D11& layout = inputLayouts[GetLayoutIndex(format)];
+		VertexPacking::AddInputElements(format, layout);
+		layout.FinalizeInputLayout(device, byteCode.data(), byteCode.size());
+	}
+
+	constantBuffer.Initialize(device, sizeof(PackedVertexConstants));
+	return true;
+}
+
+void PackedVertexPipelineD3D11::Apply(ID3D11DeviceContext* context, const PackedVertexFormat& format)
+{
+	const PackedVertexConstants constants = VertexPacking::GetShaderConstants(format);
+	constantBuffer.UpdateBuffer(context, &constants);
+
+	context->IASetInputLayout(inputLayouts[GetLayoutIndex(format)].GetInputLayout());
+	context->VSSetShader(vertexShader, nullptr, 0);
+
+	ID3D11Buffer* cb1 = constantBuffer.GetBuffer();
+	context->VSSetConstantBuffers(1, 1, &cb1);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include <d3d11_4.h>
+
+#include "VertexPacking.h"
+#include "InputLayoutD3D11.h"
+#include "ConstantBufferD3D11.h"
+
+// PackedVertexVS with an input layout for every PackedVertexFormat, for the passes that draw
+// meshes from their packed vertices (see OBJImportSettings::packVertices). Its output matches
+// VertexShader.hlsl, so the pixel shaders of those passes work with either.
+class PackedVertexPipelineD3D11
+{
+private:
+	// One per combination of quantizedPositions and unormTexCoords
+	static constexpr size_t NR_OF_LAYOUTS = 4;
+
+	ID3D11VertexShader* vertexShader = nullptr;
+	InputLayoutD3D11 inputLayouts[NR_OF_LAYOUTS];
+	ConstantBufferD3D11 constantBuffer;
+
+	static size_t GetLayoutIndex(const PackedVertexFormat& format);
+
+public:
+	PackedVertexPipelineD3D11() = default;
+	~PackedVertexPipelineD3D11();
+	PackedVertexPipelineD3D11(const PackedVertexPipelineD3D11& other) = delete;
+	PackedVertexPipelineD3D11& operator=(const PackedVertexPipelineD3D11& other) = delete;
+	PackedVertexPipelineD3D11(PackedVertexPipelineD3D11&& other) = delete;
+	PackedVertexPipelineD3D11& operator=(PackedVertexPipelineD3D11&& other) = delete;
+
+	// Returns false, leaving the pipeline unusable, if the shader cannot be loaded
+	bool Initialize(ID3D11Device* device, const std::string& shaderFile = "PackedVertexVS.cso");
+	bool IsInitialized() const { return vertexShader != nullptr; }
+
+	// Binds the shader, the input layout for format and its dequantization constants (VS b1).
+	// The caller binds the packed buffers and, after the mesh, its own shader and layout again.
+	void Apply(ID3D11DeviceContext* context, const PackedVertexFormat& format);
+};
@@ -0,0 +1,56 @@
+// Packed Vertex Shader
+// Same output as VertexShader.hlsl for meshes stored in the VertexPacking format
+
+cbuffer MatrixBuffer : register(b0)
+{
+    float4x4 worldMatrix;
+    float4x4 viewProjMatrix;
+};
+
+// Dequantization of 16-bit positions; offset 0 and scale 1 for float positions
+cbuffer PackedVertexBuffer : register(b1)
+{
+    float3 positionOffset;
+    float padding0;
+    float3 positionScale;
+    float padding1;
+};
+
+struct VS_INPUT
+{
+    float3 position : POSITION;
+    float2 octNormal : NORMAL;
+    float2 uv : TEXCOORD0;
+};
+
+struct VS_OUTPUT
+{
+    float4 clipPosition : SV_POSITION;
+    float3 worldPosition : WORLD_POSITION;
+    float3 worldNormal : NORMAL;
+    float2 uv : TEXCOORD0;
+};
+
+// Inverse of VertexPacking::EncodeOctahedral
+float3 DecodeOctahedral(float2 encoded)
+{
+    float3 v = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float t = saturate(-v.z);
+    v.xy += (v.xy >= 0.0f) ? -t : t;
+    return normalize(v);
+}
+
+VS_OUTPUT main(VS_INPUT input)
+{
+    VS_OUTPUT output;
+
+    float3 position = positionOffset + input.position * positionScale;
+    float4 worldPosition = mul(float4(position, 1.0f), worldMatrix);
+    output.worldPosition = worldPosition.xyz;
+    output.clipPosition = mul(worldPosition, viewProjMatrix);
+
+    output.worldNormal = normalize(mul(float4(DecodeOctahedral(input.octNormal), 0.0f), worldMatrix).xyz);
+    output.uv = input.uv;
+
+    return output;
+}
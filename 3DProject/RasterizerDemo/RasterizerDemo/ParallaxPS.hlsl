@@ -1,4 +1,5 @@
 // PARALLAX OCCLUSION MAPPING PIXEL SHADER
+// Uses the per-vertex tangent frame when the mesh has one, derivatives otherwise
 
 cbuffer MaterialBuffer : register(b2)
 {
@@ -22,6 +23,7 @@ struct PS_INPUT
     float3 worldPosition : WORLD_POSITION;
     float3 worldNormal : NORMAL;
     float2 uv : TEXCOORD0;
+    float4 worldTangent : TANGENT;
 };
 
 struct PS_OUTPUT
@@ -139,8 +141,17 @@ PS_OUTPUT main(PS_INPUT input)
     float2 gradientX = ddx(input.uv);
     float2 gradientY = ddy(input.uv);
     
-    // Build orthonormal TBN matrix
-    float3x3 TBN = ComputeTBN(input.worldPosition, normalizedNormal, input.uv);
+    // Build orthonormal TBN matrix, from the interpolated tangent when there is one (w is zero otherwise)
+    float3x3 TBN;
+    if (abs(input.worldTangent.w) > 0.5f)
+    {
+        float3 tangent = normalize(input.worldTangent.xyz - normalizedNormal * dot(normalizedNormal, input.worldTangent.xyz));
+        TBN = float3x3(tangent, input.worldTangent.w * cross(normalizedNormal, tangent), normalizedNormal);
+    }
+    else
+    {
+        TBN = ComputeTBN(input.worldPosition, normalizedNormal, input.uv);
+    }
     
     // Transform view direction to tangent space
     float3 viewDirWorld = normalize(cameraPosition - input.worldPosition);
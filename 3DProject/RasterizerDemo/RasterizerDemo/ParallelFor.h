@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Calls func(i) for every i in [0, count) using up to nrOfThreads threads, including the caller.
+// Items are handed out one at a time from a shared counter, so uneven items balance themselves.
+// Returns once every item has finished.
+template<typename Func>
+void ParallelFor(std::size_t count, unsigned int nrOfThreads, Func&& func)
+{
+	if (nrOfThreads == 0)
+	{
+		nrOfThreads = (std::max)(1u, std::thread::hardware_concurrency());
+	}
+
+	const std::size_t nrOfWorkers = (std::min)(static_cast<std::size_t>(nrOfThreads), count);
+	if (nrOfWorkers <= 1)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			func(i);
+		}
+		return;
+	}
+
+	std::atomic<std::size_t> nextItem = 0;
+	auto worker = [&]()
+	{
+		for (std::size_t i = nextItem++; i < count; i = nextItem++)
+		{
+			func(i);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(nrOfWorkers - 1);
+	for (std::size_t i = 1; i < nrOfWorkers; ++i)
+	{
+		threads.emplace_back(worker);
+	}
+
+	worker();
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
@@ -2,9 +2,14 @@
 
 #include <DirectXCollision.h>
 #include <DirectXMath.h>
-#include <memory>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
 #include <vector>
-#include <unordered_set>
+
+#include "FrustumCulling.h"
+#include "ParallelFor.h"
 
 // Helper structure to store element with its bounding box
 template<typename T>
@@ -18,231 +23,478 @@ struct QuadTreeElement
 	}
 };
 
-// Spatial partitioning structure for efficient frustum culling
-template<typename T>
+// Node layout shared by the quadtrees: level l's 4^l nodes follow the levels above, in the Morton
+// order of their X/Z cell, so a node's children are neighbours and its parent is code >> 2
+namespace QuadTreeCells
+{
+	// Index of a level's first node
+	constexpr std::size_t LevelOffset(int level)
+	{
+		return ((std::size_t{ 1 } << (2 * level)) - 1) / 3;
+	}
+
+	constexpr std::size_t NodeCount(int maxDepth)
+	{
+		return LevelOffset(maxDepth + 1);
+	}
+
+	// Moves the low 16 bits of value to the even bits
+	inline uint32_t SpreadBits(uint32_t value)
+	{
+		value &= 0x0000ffff;
+		value = (value | (value << 8)) & 0x00ff00ff;
+		value = (value | (value << 4)) & 0x0f0f0f0f;
+		value = (value | (value << 2)) & 0x33333333;
+		value = (value | (value << 1)) & 0x55555555;
+		return value;
+	}
+
+	// Gathers the even bits of value into the low 16
+	inline uint32_t CompactBits(uint32_t value)
+	{
+		value &= 0x55555555;
+		value = (value | (value >> 1)) & 0x33333333;
+		value = (value | (value >> 2)) & 0x0f0f0f0f;
+		value = (value | (value >> 4)) & 0x00ff00ff;
+		value = (value | (value >> 8)) & 0x0000ffff;
+		return value;
+	}
+
+	// Children halve their parent along X and Z and keep the world's full height. Node boxes are
+	// the cells scaled by looseness along X and Z, 1 for cells that tile the world exactly.
+	inline void ComputeNodeBoxes(const DirectX::BoundingBox& worldBounds, int maxDepth, float looseness,
+		std::vector<DirectX::BoundingBox>& nodeBoxes)
+	{
+		const DirectX::XMFLOAT3 minimum(worldBounds.Center.x - worldBounds.Extents.x, worldBounds.Center.y,
+			worldBounds.Center.z - worldBounds.Extents.z);
+
+		nodeBoxes.resize(NodeCount(maxDepth));
+		for (int level = 0; level <= maxDepth; ++level)
+		{
+			const uint32_t cellsPerSide = 1u << level;
+			const float extentX = worldBounds.Extents.x / cellsPerSide;
+			const float extentZ = worldBounds.Extents.z / cellsPerSide;
+
+			for (uint32_t code = 0; code < cellsPerSide * cellsPerSide; ++code)
+			{
+				const uint32_t x = CompactBits(code);
+				const uint32_t z = CompactBits(code >> 1);
+
+				DirectX::BoundingBox& box = nodeBoxes[LevelOffset(level) + code];
+				box.Center = DirectX::XMFLOAT3(minimum.x + (2 * x + 1) * extentX, minimum.y, minimum.z + (2 * z + 1) * extentZ);
+				box.Extents = DirectX::XMFLOAT3(extentX * looseness, worldBounds.Extents.y, extentZ * looseness);
+			}
+		}
+	}
+}
+
+// Spatial partitioning structure for efficient frustum culling. A node splits into four once
+// more than MaxElementsPerNode elements overlap it, down to MaxDepth, and each element is kept
+// in every leaf it overlaps.
+// Nodes live in one array: level l's 4^l nodes follow the levels above in the Morton order of
+// their X/Z cell, so a node's children are neighbours and need no pointers. Insert only records
+// the element; the next Query (or Build) sorts the elements by the Morton code of their centre
+// and hands them out to the leaves in one depth-first pass, which writes every subtree's leaf
+// entries contiguously into a shared pool. Clear keeps all capacity, so a tree refilled every
+// frame stops allocating once it has reached its size. Query builds on demand, so it must not
+// run on several threads at once.
+// An element overlapping several leaves is reported once: Query stamps each element it reports
+// with a number it changes every call, instead of hashing them. Nodes inside the frustum report
+// their whole subtree's entries without testing the elements. Leaves crossing the frustum are
+// collected, merging neighbours in elementIndices, and tested in one FrustumCulling pass per run
+// against a copy of the boxes laid out like the leaf entries.
+template<typename T, int MaxDepth = 5, int MaxElementsPerNode = 8>
 class QuadTree
 {
+	static_assert(MaxDepth >= 0 && MaxDepth <= 10, "QuadTree nodes are allocated for every level up to MaxDepth");
+	static_assert(MaxElementsPerNode > 0, "QuadTree nodes must hold at least one element");
+
+public:
+	static constexpr int MAX_DEPTH = MaxDepth;
+	static constexpr std::size_t MAX_ELEMENTS_PER_NODE = MaxElementsPerNode;
+	static constexpr std::size_t NODE_COUNT = QuadTreeCells::NodeCount(MaxDepth);
+	// Builds with fewer elements sort on the calling thread, starting threads would cost more
+	static constexpr std::size_t PARALLEL_BUILD_MIN_ELEMENTS = 16384;
+
 private:
 	struct Node
 	{
-		DirectX::BoundingBox boundingBox;
-		std::unique_ptr<Node> children[4];
-		std::vector<QuadTreeElement<T>> elements;
+		// The subtree's leaf entries in elementIndices
+		uint32_t first = 0;
+		uint32_t count = 0;
 		bool isLeaf = true;
 	};
 
-	std::unique_ptr<Node> root;
-	int maxDepth;
-	int maxElementsPerNode;
+	// Consecutive entries in elementIndices
+	struct EntryRange
+	{
+		uint32_t first;
+		uint32_t count;
+	};
+
+	// The deepest-level cells an element's box covers, inclusive
+	struct CellRange
+	{
+		uint16_t minX;
+		uint16_t minZ;
+		uint16_t maxX;
+		uint16_t maxZ;
+	};
 
-	void Subdivide(Node* node, int currentDepth);
-	void Insert(Node* node, const QuadTreeElement<T>& element, int currentDepth);
-	void Query(Node* node, const DirectX::BoundingFrustum& frustum, std::unordered_set<T>& visited, std::vector<T>& result) const;
-	void Clear(Node* node);
+	DirectX::BoundingBox worldBounds;
+	// Every node of every level, by LevelOffset(level) + Morton code; fixed by the world bounds
+	std::vector<DirectX::BoundingBox> nodeBoxes;
+
+	// Filled by BuildNodes, which Query calls on demand
+	mutable std::vector<Node> nodes;
+	mutable std::vector<QuadTreeElement<T>> elements;
+	mutable std::vector<uint32_t> elementIndices;
+	// The box of each entry in elementIndices
+	mutable BoundingBoxArray leafBoxes;
+	mutable bool isBuilt = true;
+
+	// The queryStamp of the last Query that reported each element
+	mutable std::vector<uint32_t> visitStamps;
+	mutable uint32_t queryStamp = 0;
+	// Query scratch: entries of the leaves crossing the frustum, and the positions of the visible ones
+	mutable std::vector<EntryRange> leafRanges;
+	mutable std::vector<uint32_t> leafVisible;
+
+	// Build scratch, kept so rebuilding does not allocate
+	mutable std::vector<uint32_t> mortonCodes;
+	mutable std::vector<uint32_t> codeOffsets;
+	mutable std::vector<uint32_t> sortedOrder;
+	mutable std::vector<QuadTreeElement<T>> sortedElements;
+	mutable std::vector<uint32_t> candidates;
+	mutable std::vector<CellRange> cellRanges;
+
+	void ComputeNodeBoxes();
+	uint32_t GetCellX(float x) const;
+	uint32_t GetCellZ(float z) const;
+	void SortElements(unsigned int nrOfThreads) const;
+	void BuildNodes(unsigned int nrOfThreads) const;
+	void Distribute(int level, uint32_t code, std::size_t begin, std::size_t end) const;
+	void Report(uint32_t element, std::vector<T>& result) const;
+	void Query(int level, uint32_t code, const DirectX::BoundingFrustum& frustum, std::vector<T>& result) const;
 
 public:
-	QuadTree(const DirectX::BoundingBox& worldBounds, int maxDepth = 5, int maxElementsPerNode = 8);
-	~QuadTree();
+	explicit QuadTree(const DirectX::BoundingBox& worldBounds);
+	~QuadTree() = default;
 
 	void Insert(const T& element, const DirectX::BoundingBox& elementBox);
 	void Query(const DirectX::BoundingFrustum& frustum, std::vector<T>& result) const;
 	void Clear();
 	void Rebuild(const DirectX::BoundingBox& worldBounds);
+
+	// Sorts and distributes the elements inserted since the last build, the sort on up to
+	// nrOfThreads threads (0 uses every hardware thread) for large trees
+	void Build(unsigned int nrOfThreads = 0);
+	// Makes room for nrOfElements without reallocating while the tree is filled and built
+	void Reserve(std::size_t nrOfElements);
 };
 
 // Template implementation must be in header
-template<typename T>
-QuadTree<T>::QuadTree(const DirectX::BoundingBox& worldBounds, int maxDepth, int maxElementsPerNode)
-	: maxDepth(maxDepth), maxElementsPerNode(maxElementsPerNode)
+template<typename T, int MaxDepth, int MaxElementsPerNode>
+QuadTree<T, MaxDepth, MaxElementsPerNode>::QuadTree(const DirectX::BoundingBox& worldBounds)
+	: worldBounds(worldBounds), nodeBoxes(NODE_COUNT), nodes(NODE_COUNT)
 {
-	root = std::make_unique<Node>();
-	root->boundingBox = worldBounds;
-	root->isLeaf = true;
+	ComputeNodeBoxes();
 }
 
-template<typename T>
-QuadTree<T>::~QuadTree()
+template<typename T, int MaxDepth, int MaxElementsPerNode>
+void QuadTree<T, MaxDepth, MaxElementsPerNode>::ComputeNodeBoxes()
 {
-	Clear();
+	QuadTreeCells::ComputeNodeBoxes(worldBounds, MaxDepth, 1.0f, nodeBoxes);
 }
 
-template<typename T>
-void QuadTree<T>::Subdivide(Node* node, int currentDepth)
+// Column and row of the deepest-level cell holding a coordinate, clamped to the world
+template<typename T, int MaxDepth, int MaxElementsPerNode>
+uint32_t QuadTree<T, MaxDepth, MaxElementsPerNode>::GetCellX(float x) const
 {
-	if (!node->isLeaf || currentDepth >= maxDepth)
-		return;
+	constexpr float CELLS_PER_SIDE = static_cast<float>(1u << MaxDepth);
 
-	node->isLeaf = false;
+	const float u = (x - worldBounds.Center.x + worldBounds.Extents.x) / (2.0f * worldBounds.Extents.x);
+	return static_cast<uint32_t>((std::clamp)(u * CELLS_PER_SIDE, 0.0f, CELLS_PER_SIDE - 1.0f));
+}
+
+template<typename T, int MaxDepth, int MaxElementsPerNode>
+uint32_t QuadTree<T, MaxDepth, MaxElementsPerNode>::GetCellZ(float z) const
+{
+	constexpr float CELLS_PER_SIDE = static_cast<float>(1u << MaxDepth);
+
+	const float v = (z - worldBounds.Center.z + worldBounds.Extents.z) / (2.0f * worldBounds.Extents.z);
+	return static_cast<uint32_t>((std::clamp)(v * CELLS_PER_SIDE, 0.0f, CELLS_PER_SIDE - 1.0f));
+}
 
-	DirectX::XMFLOAT3 center = node->boundingBox.Center;
-	DirectX::XMFLOAT3 extents = node->boundingBox.Extents;
+// Reorders elements by the Morton code of their centre, so the elements of a node are close
+// together and the leaves are filled in the order Query visits them. The codes have only
+// 2 * MaxDepth bits, so this is a single counting sort: each thread counts the codes in its slice,
+// and each slice's elements of a code go after the earlier slices' ones, which keeps the order
+// the same whatever the number of threads.
+template<typename T, int MaxDepth, int MaxElementsPerNode>
+void QuadTree<T, MaxDepth, MaxElementsPerNode>::SortElements(unsigned int nrOfThreads) const
+{
+	constexpr std::size_t NR_OF_CODES = std::size_t{ 1 } << (2 * MaxDepth);
 
-	float halfX = extents.x * 0.5f;
-	float halfZ = extents.z * 0.5f;
+	const std::size_t nrOfElements = elements.size();
+	if (nrOfThreads == 0)
+	{
+		nrOfThreads = (std::max)(1u, std::thread::hardware_concurrency());
+	}
+	if (nrOfElements < PARALLEL_BUILD_MIN_ELEMENTS)
+	{
+		nrOfThreads = 1;
+	}
 
-	// Top-Left (-X, +Z)
-	node->children[0] = std::make_unique<Node>();
-	node->children[0]->boundingBox.Center = DirectX::XMFLOAT3(center.x - halfX, center.y, center.z + halfZ);
-	node->children[0]->boundingBox.Extents = DirectX::XMFLOAT3(halfX, extents.y, halfZ);
-	node->children[0]->isLeaf = true;
+	const std::size_t nrOfSlices = nrOfThreads;
+	const std::size_t sliceSize = (nrOfElements + nrOfSlices - 1) / nrOfSlices;
+	mortonCodes.resize(nrOfElements);
+	codeOffsets.assign(nrOfSlices * NR_OF_CODES, 0);
 
-	// Top-Right (+X, +Z)
-	node->children[1] = std::make_unique<Node>();
-	node->children[1]->boundingBox.Center = DirectX::XMFLOAT3(center.x + halfX, center.y, center.z + halfZ);
-	node->children[1]->boundingBox.Extents = DirectX::XMFLOAT3(halfX, extents.y, halfZ);
-	node->children[1]->isLeaf = true;
+	ParallelFor(nrOfSlices, nrOfThreads, [&](std::size_t slice)
+		{
+			uint32_t* counts = codeOffsets.data() + slice * NR_OF_CODES;
+			const std::size_t end = (std::min)(nrOfElements, (slice + 1) * sliceSize);
+			for (std::size_t i = slice * sliceSize; i < end; ++i)
+			{
+				const DirectX::XMFLOAT3& center = elements[i].boundingBox.Center;
+				mortonCodes[i] = QuadTreeCells::SpreadBits(GetCellX(center.x)) | (QuadTreeCells::SpreadBits(GetCellZ(center.z)) << 1);
+				counts[mortonCodes[i]]++;
+			}
+		});
 
-	// Bottom-Left (-X, -Z)
-	node->children[2] = std::make_unique<Node>();
-	node->children[2]->boundingBox.Center = DirectX::XMFLOAT3(center.x - halfX, center.y, center.z - halfZ);
-	node->children[2]->boundingBox.Extents = DirectX::XMFLOAT3(halfX, extents.y, halfZ);
-	node->children[2]->isLeaf = true;
+	uint32_t offset = 0;
+	for (std::size_t code = 0; code < NR_OF_CODES; ++code)
+	{
+		for (std::size_t slice = 0; slice < nrOfSlices; ++slice)
+		{
+			const uint32_t count = codeOffsets[slice * NR_OF_CODES + code];
+			codeOffsets[slice * NR_OF_CODES + code] = offset;
+			offset += count;
+		}
+	}
 
-	// Bottom-Right (+X, -Z)
-	node->children[3] = std::make_unique<Node>();
-	node->children[3]->boundingBox.Center = DirectX::XMFLOAT3(center.x + halfX, center.y, center.z - halfZ);
-	node->children[3]->boundingBox.Extents = DirectX::XMFLOAT3(halfX, extents.y, halfZ);
-	node->children[3]->isLeaf = true;
+	sortedOrder.resize(nrOfElements);
+	ParallelFor(nrOfSlices, nrOfThreads, [&](std::size_t slice)
+		{
+			uint32_t* offsets = codeOffsets.data() + slice * NR_OF_CODES;
+			const std::size_t end = (std::min)(nrOfElements, (slice + 1) * sliceSize);
+			for (std::size_t i = slice * sliceSize; i < end; ++i)
+			{
+				sortedOrder[offsets[mortonCodes[i]]++] = static_cast<uint32_t>(i);
+			}
+		});
 
-	node->elements.clear();
+	sortedElements.clear();
+	for (uint32_t index : sortedOrder)
+	{
+		sortedElements.push_back(elements[index]);
+	}
+	elements.swap(sortedElements);
 }
 
-template<typename T>
-void QuadTree<T>::Insert(Node* node, const QuadTreeElement<T>& element, int currentDepth)
+template<typename T, int MaxDepth, int MaxElementsPerNode>
+void QuadTree<T, MaxDepth, MaxElementsPerNode>::BuildNodes(unsigned int nrOfThreads) const
 {
-	if (!node)
-		return;
+	SortElements(nrOfThreads);
 
-	if (!node->boundingBox.Intersects(element.boundingBox))
-		return;
-
-	if (node->isLeaf)
+	// Elements outside the world are left out, as if no node accepted them. Below the root, boxes
+	// only need comparing with node boxes along X and Z, which their cell ranges do exactly.
+	candidates.clear();
+	cellRanges.resize(elements.size());
+	for (uint32_t i = 0; i < elements.size(); ++i)
 	{
-		if (node->elements.size() < static_cast<size_t>(maxElementsPerNode) || currentDepth >= maxDepth)
-		{
-			node->elements.push_back(element);
-		}
-		else
-		{
-			std::vector<QuadTreeElement<T>> oldElements = node->elements;
+		const DirectX::BoundingBox& box = elements[i].boundingBox;
+		if (!nodeBoxes[0].Intersects(box))
+			continue;
+
+		candidates.push_back(i);
+		cellRanges[i] = {
+			static_cast<uint16_t>(GetCellX(box.Center.x - box.Extents.x)), static_cast<uint16_t>(GetCellZ(box.Center.z - box.Extents.z)),
+			static_cast<uint16_t>(GetCellX(box.Center.x + box.Extents.x)), static_cast<uint16_t>(GetCellZ(box.Center.z + box.Extents.z)) };
+	}
 
-			Subdivide(node, currentDepth);
+	elementIndices.clear();
+	leafBoxes.Clear();
+	Distribute(0, 0, 0, candidates.size());
+	// Sorting moved the elements, but their stamps are all older than the next query's
+	visitStamps.resize(elements.size(), 0);
+	isBuilt = true;
+}
 
-			for (const auto& elem : oldElements)
-			{
-				for (int i = 0; i < 4; ++i)
-				{
-					if (node->children[i])
-					{
-						Insert(node->children[i].get(), elem, currentDepth + 1);
-					}
-				}
-			}
+// candidates[begin, end) are the elements overlapping the node. A node over capacity passes
+// each of them on to the children it overlaps; nodes below a leaf are never visited, so what
+// they held in an earlier build does not need clearing.
+template<typename T, int MaxDepth, int MaxElementsPerNode>
+void QuadTree<T, MaxDepth, MaxElementsPerNode>::Distribute(int level, uint32_t code, std::size_t begin, std::size_t end) const
+{
+	Node& node = nodes[QuadTreeCells::LevelOffset(level) + code];
+	node.first = static_cast<uint32_t>(elementIndices.size());
 
-			for (int i = 0; i < 4; ++i)
-			{
-				if (node->children[i])
-				{
-					Insert(node->children[i].get(), element, currentDepth + 1);
-				}
-			}
+	if (end - begin <= static_cast<std::size_t>(MaxElementsPerNode) || level >= MaxDepth)
+	{
+		node.isLeaf = true;
+		elementIndices.insert(elementIndices.end(), candidates.begin() + begin, candidates.begin() + end);
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			leafBoxes.Add(elements[candidates[i]].boundingBox);
 		}
-		
+		node.count = static_cast<uint32_t>(elementIndices.size() - node.first);
+		return;
 	}
-	else
+
+	node.isLeaf = false;
+	const uint32_t shift = MaxDepth - (level + 1);
+	for (uint32_t child = 0; child < 4; ++child)
 	{
-		for (int i = 0; i < 4; ++i)
+		const uint32_t childCode = code * 4 + child;
+		const uint32_t childX = QuadTreeCells::CompactBits(childCode);
+		const uint32_t childZ = QuadTreeCells::CompactBits(childCode >> 1);
+
+		// The child's candidates go after the parent's and are dropped once it is done
+		const std::size_t childBegin = candidates.size();
+		for (std::size_t i = begin; i < end; ++i)
 		{
-			if (node->children[i])
+			const uint32_t element = candidates[i];
+			const CellRange& range = cellRanges[element];
+			if ((range.minX >> shift) <= childX && childX <= (range.maxX >> shift) &&
+				(range.minZ >> shift) <= childZ && childZ <= (range.maxZ >> shift))
 			{
-				Insert(node->children[i].get(), element, currentDepth + 1);
+				candidates.push_back(element);
 			}
 		}
+
+		Distribute(level + 1, childCode, childBegin, candidates.size());
+		candidates.resize(childBegin);
 	}
+
+	node.count = static_cast<uint32_t>(elementIndices.size() - node.first);
 }
 
-template<typename T>
-void QuadTree<T>::Insert(const T& element, const DirectX::BoundingBox& elementBox)
+template<typename T, int MaxDepth, int MaxElementsPerNode>
+void QuadTree<T, MaxDepth, MaxElementsPerNode>::Insert(const T& element, const DirectX::BoundingBox& elementBox)
 {
-	QuadTreeElement<T> treeElement(element, elementBox);
-	Insert(root.get(), treeElement, 0);
+	elements.emplace_back(element, elementBox);
+	isBuilt = false;
 }
 
-template<typename T>
-void QuadTree<T>::Query(Node* node, const DirectX::BoundingFrustum& frustum, std::unordered_set<T>& visited, std::vector<T>& result) const
+template<typename T, int MaxDepth, int MaxElementsPerNode>
+void QuadTree<T, MaxDepth, MaxElementsPerNode>::Report(uint32_t element, std::vector<T>& result) const
+{
+	if (visitStamps[element] != queryStamp)
+	{
+		visitStamps[element] = queryStamp;
+		result.push_back(elements[element].data);
+	}
+}
+
+template<typename T, int MaxDepth, int MaxElementsPerNode>
+void QuadTree<T, MaxDepth, MaxElementsPerNode>::Query(int level, uint32_t code, const DirectX::BoundingFrustum& frustum,
+	std::vector<T>& result) const
 {
-	if (!node)
+	const std::size_t index = QuadTreeCells::LevelOffset(level) + code;
+	const Node& node = nodes[index];
+	if (node.count == 0)
 		return;
 
-	if (!frustum.Intersects(node->boundingBox))
+	const DirectX::ContainmentType containment = frustum.Contains(nodeBoxes[index]);
+	if (containment == DirectX::DISJOINT)
 		return;
 
-	if (node->isLeaf)
+	// Every element in the subtree overlaps a node inside the frustum, so it is visible
+	if (containment == DirectX::CONTAINS)
 	{
-		for (const auto& elem : node->elements)
+		for (uint32_t i = node.first; i < node.first + node.count; ++i)
 		{
-			if (frustum.Intersects(elem.boundingBox))
-			{
-				if (visited.find(elem.data) == visited.end())
-				{
-					visited.insert(elem.data);
-					result.push_back(elem.data);
-				}
-			}
+			Report(elementIndices[i], result);
+		}
+	}
+	else if (node.isLeaf)
+	{
+		if (!leafRanges.empty() && leafRanges.back().first + leafRanges.back().count == node.first)
+		{
+			leafRanges.back().count += node.count;
+		}
+		else
+		{
+			leafRanges.push_back({ node.first, node.count });
 		}
 	}
 	else
 	{
-		for (int i = 0; i < 4; ++i)
+		for (uint32_t child = 0; child < 4; ++child)
 		{
-			if (node->children[i])
-			{
-				Query(node->children[i].get(), frustum, visited, result);
-			}
+			Query(level + 1, code * 4 + child, frustum, result);
 		}
 	}
 }
 
-template<typename T>
-void QuadTree<T>::Query(const DirectX::BoundingFrustum& frustum, std::vector<T>& result) const
+template<typename T, int MaxDepth, int MaxElementsPerNode>
+void QuadTree<T, MaxDepth, MaxElementsPerNode>::Query(const DirectX::BoundingFrustum& frustum, std::vector<T>& result) const
 {
-	result.clear();
-	std::unordered_set<T> visited;
-	Query(root.get(), frustum, visited, result);
-}
+	if (!isBuilt)
+	{
+		BuildNodes(0);
+	}
 
-template<typename T>
-void QuadTree<T>::Clear(Node* node)
-{
-	if (!node)
-		return;
+	// Stamps only need to differ from the ones already stored, so they are cleared when the
+	// counter wraps around
+	if (++queryStamp == 0)
+	{
+		std::fill(visitStamps.begin(), visitStamps.end(), 0);
+		queryStamp = 1;
+	}
+
+	result.clear();
+	leafRanges.clear();
+	Query(0, 0, frustum, result);
 
-	for (int i = 0; i < 4; ++i)
+	const CullingPlanes planes = FrustumCulling::GetPlanes(frustum);
+	leafVisible.clear();
+	for (const EntryRange& range : leafRanges)
 	{
-		if (node->children[i])
-		{
-			Clear(node->children[i].get());
-			node->children[i].reset();
-		}
+		FrustumCulling::CullExact(frustum, planes, leafBoxes, range.first, range.first + range.count, leafVisible);
+	}
+	for (uint32_t i : leafVisible)
+	{
+		Report(elementIndices[i], result);
 	}
+}
 
-	node->elements.clear();
-	node->isLeaf = true;
+template<typename T, int MaxDepth, int MaxElementsPerNode>
+void QuadTree<T, MaxDepth, MaxElementsPerNode>::Clear()
+{
+	elements.clear();
+	isBuilt = false;
 }
 
-template<typename T>
-void QuadTree<T>::Clear()
+template<typename T, int MaxDepth, int MaxElementsPerNode>
+void QuadTree<T, MaxDepth, MaxElementsPerNode>::Rebuild(const DirectX::BoundingBox& worldBounds)
+{
+	Clear();
+	this->worldBounds = worldBounds;
+	ComputeNodeBoxes();
+}
+
+template<typename T, int MaxDepth, int MaxElementsPerNode>
+void QuadTree<T, MaxDepth, MaxElementsPerNode>::Build(unsigned int nrOfThreads)
 {
-	if (root)
+	if (!isBuilt)
 	{
-		Clear(root.get());
+		BuildNodes(nrOfThreads);
 	}
 }
 
-template<typename T>
-void QuadTree<T>::Rebuild(const DirectX::BoundingBox& worldBounds)
+template<typename T, int MaxDepth, int MaxElementsPerNode>
+void QuadTree<T, MaxDepth, MaxElementsPerNode>::Reserve(std::size_t nrOfElements)
 {
-	Clear();
-	root->boundingBox = worldBounds;
-	root->isLeaf = true;
+	elements.reserve(nrOfElements);
+	sortedElements.reserve(nrOfElements);
+	mortonCodes.reserve(nrOfElements);
+	sortedOrder.reserve(nrOfElements);
+	elementIndices.reserve(nrOfElements);
+	leafBoxes.Reserve(nrOfElements);
+	visitStamps.reserve(nrOfElements);
+	candidates.reserve(nrOfElements);
+	cellRanges.reserve(nrOfElements);
 }
@@ -33,6 +33,9 @@ public:
 
 	void PerformDrawCall(ID3D11DeviceContext* context) const;
 
+	size_t GetStartIndex() const { return startIndex; }
+	size_t GetNrOfIndices() const { return nrOfIndices; }
+
 	ID3D11ShaderResourceView* GetAmbientSRV() const;
 	ID3D11ShaderResourceView* GetDiffuseSRV() const;
 	ID3D11ShaderResourceView* GetSpecularSRV() const;
@@ -0,0 +1,243 @@
+#include "TangentGenerator.h"
+#include "OBJParser.h"
+#include "ContentHash.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+
+using namespace DirectX;
+
+namespace
+{
+	constexpr std::size_t TRIANGLES_PER_TASK = 4096;
+	constexpr std::size_t VERTICES_PER_TASK = 4096;
+	constexpr unsigned int NO_VERTEX = 0xFFFFFFFFu;
+
+	// MikkTSpace keeps separate frames for the two UV orientations meeting at a vertex
+	constexpr int PRESERVING = 0;
+	constexpr int MIRRORED = 1;
+
+	struct TriangleTangent
+	{
+		// Unit dP/du, zero when the triangle has no UV or position area
+		XMFLOAT3 tangent;
+		// Orientation of the UV mapping relative to the winding
+		int orientation;
+	};
+
+	struct VertexFrames
+	{
+		XMFLOAT3 tangent[2];
+		bool used[2];
+	};
+
+	std::string_view VertexBytes(const Vertex& vertex)
+	{
+		return std::string_view(reinterpret_cast<const char*>(&vertex), sizeof(Vertex));
+	}
+
+	// Vertices with identical attributes are one MikkTSpace vertex, whichever OBJ indices made them
+	void WeldIdenticalVertices(const std::vector<Vertex>& vertices, std::vector<unsigned int>& weld)
+	{
+		struct VertexBytesHash
+		{
+			std::size_t operator()(std::string_view bytes) const { return static_cast<std::size_t>(HashBytes(bytes)); }
+		};
+
+		std::unordered_map<std::string_view, unsigned int, VertexBytesHash> firstVertex;
+		firstVertex.reserve(vertices.size());
+		weld.resize(vertices.size());
+		for (std::size_t v = 0; v < vertices.size(); ++v)
+		{
+			weld[v] = firstVertex.emplace(VertexBytes(vertices[v]), static_cast<unsigned int>(v)).first->second;
+		}
+	}
+
+	XMVECTOR NormalizeOrZero(FXMVECTOR vector)
+	{
+		const float lengthSq = XMVectorGetX(XMVector3LengthSq(vector));
+		return lengthSq > 0.0f ? XMVectorScale(vector, 1.0f / std::sqrt(lengthSq)) : XMVectorZero();
+	}
+
+	XMVECTOR ProjectOnPlane(FXMVECTOR normal, FXMVECTOR vector)
+	{
+		return XMVectorSubtract(vector, XMVectorScale(normal, XMVectorGetX(XMVector3Dot(normal, vector))));
+	}
+
+	// Any unit vector orthogonal to normal, for vertices whose triangles carry no UV information
+	XMVECTOR AnyTangent(FXMVECTOR normal)
+	{
+		XMFLOAT3 n;
+		XMStoreFloat3(&n, normal);
+		const XMVECTOR axis = std::fabs(n.x) < 0.5f ? XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+		const XMVECTOR tangent = NormalizeOrZero(ProjectOnPlane(normal, axis));
+		return XMVectorGetX(XMVector3LengthSq(tangent)) > 0.0f ? tangent : XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
+	}
+
+	XMFLOAT4 MakeTangent(FXMVECTOR tangent, int orientation)
+	{
+		XMFLOAT4 result;
+		XMStoreFloat4(&result, XMVectorSetW(tangent, orientation == PRESERVING ? 1.0f : -1.0f));
+		return result;
+	}
+}
+
+void TangentGenerator::Generate(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+	std::vector<XMFLOAT4>& tangents, unsigned int nrOfThreads)
+{
+	const std::size_t nrOfTriangles = indices.size() / 3;
+	const std::size_t nrOfVertices = vertices.size();
+	const unsigned int threads = nrOfTriangles >= PARALLEL_MIN_TRIANGLES ? nrOfThreads : 1;
+
+	// 1. dP/du and UV orientation of every triangle
+	std::vector<TriangleTangent> triangles(nrOfTriangles);
+	ParallelFor((nrOfTriangles + TRIANGLES_PER_TASK - 1) / TRIANGLES_PER_TASK, threads, [&](std::size_t task)
+		{
+			const std::size_t end = (std::min)((task + 1) * TRIANGLES_PER_TASK, nrOfTriangles);
+			for (std::size_t t = task * TRIANGLES_PER_TASK; t < end; ++t)
+			{
+				const Vertex& v0 = vertices[indices[t * 3]];
+				const Vertex& v1 = vertices[indices[t * 3 + 1]];
+				const Vertex& v2 = vertices[indices[t * 3 + 2]];
+
+				const XMVECTOR p0 = XMLoadFloat3(&v0.Position);
+				const XMVECTOR d1 = XMVectorSubtract(XMLoadFloat3(&v1.Position), p0);
+				const XMVECTOR d2 = XMVectorSubtract(XMLoadFloat3(&v2.Position), p0);
+				const float t21x = v1.UV.x - v0.UV.x, t21y = v1.UV.y - v0.UV.y;
+				const float t31x = v2.UV.x - v0.UV.x, t31y = v2.UV.y - v0.UV.y;
+				const float signedArea = t21x * t31y - t21y * t31x;
+
+				// dP/du up to the 1/signedArea factor, whose sign is applied after normalizing
+				XMVECTOR tangent = NormalizeOrZero(XMVectorSubtract(XMVectorScale(d1, t31y), XMVectorScale(d2, t21y)));
+				if (signedArea < 0.0f)
+					tangent = XMVectorNegate(tangent);
+				if (signedArea == 0.0f || XMVectorGetX(XMVector3LengthSq(XMVector3Cross(d1, d2))) == 0.0f)
+					tangent = XMVectorZero();
+
+				XMStoreFloat3(&triangles[t].tangent, tangent);
+				triangles[t].orientation = signedArea > 0.0f ? PRESERVING : MIRRORED;
+			}
+		});
+
+	// 2. Corners of every welded vertex, in index order so the sums below are deterministic
+	std::vector<unsigned int> weld;
+	WeldIdenticalVertices(vertices, weld);
+
+	std::vector<unsigned int> cornerOffsets(nrOfVertices + 1, 0);
+	for (std::size_t i = 0; i < nrOfTriangles * 3; ++i)
+	{
+		++cornerOffsets[weld[indices[i]] + 1];
+	}
+	for (std::size_t v = 0; v < nrOfVertices; ++v)
+	{
+		cornerOffsets[v + 1] += cornerOffsets[v];
+	}
+
+	std::vector<unsigned int> corners(nrOfTriangles * 3);
+	{
+		std::vector<unsigned int> fill(cornerOffsets.begin(), cornerOffsets.end() - 1);
+		for (std::size_t i = 0; i < nrOfTriangles * 3; ++i)
+		{
+			corners[fill[weld[indices[i]]]++] = static_cast<unsigned int>(i);
+		}
+	}
+
+	// 3. Per welded vertex and orientation, the corner-angle weighted sum of the triangle
+	// tangents projected onto the vertex normal's plane
+	std::vector<VertexFrames> frames(nrOfVertices);
+	ParallelFor((nrOfVertices + VERTICES_PER_TASK - 1) / VERTICES_PER_TASK, threads, [&](std::size_t task)
+		{
+			const std::size_t end = (std::min)((task + 1) * VERTICES_PER_TASK, nrOfVertices);
+			for (std::size_t v = task * VERTICES_PER_TASK; v < end; ++v)
+			{
+				if (weld[v] != v)
+					continue;
+
+				const XMVECTOR normal = NormalizeOrZero(XMLoadFloat3(&vertices[v].Normal));
+				XMVECTOR sums[2] = { XMVectorZero(), XMVectorZero() };
+				VertexFrames& frame = frames[v];
+				frame.used[PRESERVING] = false;
+				frame.used[MIRRORED] = false;
+
+				for (unsigned int c = cornerOffsets[v]; c < cornerOffsets[v + 1]; ++c)
+				{
+					const std::size_t triangle = corners[c] / 3;
+					const std::size_t corner = corners[c] % 3;
+					const TriangleTangent& triangleTangent = triangles[triangle];
+					const XMVECTOR tangent = XMLoadFloat3(&triangleTangent.tangent);
+					if (XMVectorGetX(XMVector3LengthSq(tangent)) == 0.0f)
+						continue;
+
+					const XMVECTOR position = XMLoadFloat3(&vertices[indices[triangle * 3 + corner]].Position);
+					const XMVECTOR next = XMLoadFloat3(&vertices[indices[triangle * 3 + (corner + 1) % 3]].Position);
+					const XMVECTOR previous = XMLoadFloat3(&vertices[indices[triangle * 3 + (corner + 2) % 3]].Position);
+					const XMVECTOR edge0 = NormalizeOrZero(ProjectOnPlane(normal, XMVectorSubtract(next, position)));
+					const XMVECTOR edge1 = NormalizeOrZero(ProjectOnPlane(normal, XMVectorSubtract(previous, position)));
+					const float cosAngle = (std::max)(-1.0f, (std::min)(1.0f, XMVectorGetX(XMVector3Dot(edge0, edge1))));
+
+					const int orientation = triangleTangent.orientation;
+					const XMVECTOR projected = NormalizeOrZero(ProjectOnPlane(normal, tangent));
+					sums[orientation] = XMVectorAdd(sums[orientation], XMVectorScale(projected, std::acos(cosAngle)));
+					frame.used[orientation] = true;
+				}
+
+				for (int orientation : { PRESERVING, MIRRORED })
+				{
+					XMVECTOR tangent = NormalizeOrZero(sums[orientation]);
+					if (XMVectorGetX(XMVector3LengthSq(tangent)) == 0.0f)
+						tangent = AnyTangent(normal);
+					XMStoreFloat3(&frame.tangent[orientation], tangent);
+				}
+			}
+		});
+
+	// 4. Hand out the frames; the first orientation a vertex is used with keeps the vertex, the
+	// other one gets a copy. Triangles without UV area join whichever frame the vertex has.
+	tangents.resize(nrOfVertices);
+	std::vector<signed char> vertexOrientation(nrOfVertices, -1);
+	std::vector<unsigned int> mirroredCopy(nrOfVertices, NO_VERTEX);
+
+	for (std::size_t i = 0; i < nrOfTriangles * 3; ++i)
+	{
+		const unsigned int v = indices[i];
+		const VertexFrames& frame = frames[weld[v]];
+		const TriangleTangent& triangleTangent = triangles[i / 3];
+
+		int orientation = triangleTangent.orientation;
+		if (XMVectorGetX(XMVector3LengthSq(XMLoadFloat3(&triangleTangent.tangent))) == 0.0f)
+		{
+			orientation = vertexOrientation[v] >= 0 ? vertexOrientation[v] : (frame.used[MIRRORED] && !frame.used[PRESERVING] ? MIRRORED : PRESERVING);
+		}
+
+		if (vertexOrientation[v] < 0)
+		{
+			vertexOrientation[v] = static_cast<signed char>(orientation);
+			tangents[v] = MakeTangent(XMLoadFloat3(&frame.tangent[orientation]), orientation);
+		}
+		else if (vertexOrientation[v] != orientation)
+		{
+			if (mirroredCopy[v] == NO_VERTEX)
+			{
+				const Vertex copy = vertices[v];
+				mirroredCopy[v] = static_cast<unsigned int>(vertices.size());
+				vertices.push_back(copy);
+				tangents.push_back(MakeTangent(XMLoadFloat3(&frame.tangent[orientation]), orientation));
+			}
+			indices[i] = mirroredCopy[v];
+		}
+	}
+
+	// Vertices no triangle uses still get a valid frame
+	for (std::size_t v = 0; v < nrOfVertices; ++v)
+	{
+		if (vertexOrientation[v] < 0)
+		{
+			tangents[v] = MakeTangent(AnyTangent(NormalizeOrZero(XMLoadFloat3(&vertices[v].Normal))), PRESERVING);
+		}
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <DirectXMath.h>
+
+struct Vertex;
+
+// Per-vertex tangent frames computed the way MikkTSpace does, so normal maps baked by tools that
+// use it (Blender, Substance, xNormal) shade without seams. Every tangent is a unit vector along
+// increasing u, orthogonal to the vertex normal, with w = +1 or -1 such that the bitangent along
+// increasing v is w * cross(normal, tangent).
+class TangentGenerator
+{
+public:
+	// Smaller meshes are done on the calling thread
+	static constexpr std::size_t PARALLEL_MIN_TRIANGLES = 32 * 1024;
+
+	// Fills tangents with one entry per vertex. A vertex shared by triangles with mirrored UVs
+	// needs two frames, so it is copied to the end of vertices and the mirrored corners are pointed
+	// at the copy. The result is the same for any nrOfThreads (0 uses every hardware thread).
+	static void Generate(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+		std::vector<DirectX::XMFLOAT4>& tangents, unsigned int nrOfThreads = 0);
+};
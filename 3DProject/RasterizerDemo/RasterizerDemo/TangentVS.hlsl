@@ -0,0 +1,44 @@
+// Tangent Vertex Shader
+// VertexShader.hlsl plus the per-vertex tangent frame from the second vertex stream, for the
+// normal mapping and parallax shaders
+
+cbuffer MatrixBuffer : register(b0)
+{
+    float4x4 worldMatrix;
+    float4x4 viewProjMatrix;
+};
+
+struct VS_INPUT
+{
+    float3 position : POSITION;
+    float3 normal : NORMAL;
+    float2 uv : TEXCOORD0;
+    // xyz along increasing u, w = bitangent sign (MikkTSpace); all zero when the mesh has none
+    float4 tangent : TANGENT;
+};
+
+struct VS_OUTPUT
+{
+    float4 clipPosition : SV_POSITION;
+    float3 worldPosition : WORLD_POSITION;
+    float3 worldNormal : NORMAL;
+    float2 uv : TEXCOORD0;
+    float4 worldTangent : TANGENT;
+};
+
+VS_OUTPUT main(VS_INPUT input)
+{
+    VS_OUTPUT output;
+
+    float4 worldPosition = mul(float4(input.position, 1.0f), worldMatrix);
+    output.worldPosition = worldPosition.xyz;
+    output.clipPosition = mul(worldPosition, viewProjMatrix);
+
+    output.worldNormal = normalize(mul(float4(input.normal, 0.0f), worldMatrix).xyz);
+    output.uv = input.uv;
+
+    // Not normalized: a missing tangent must stay zero so the pixel shader can tell
+    output.worldTangent = float4(mul(float4(input.tangent.xyz, 0.0f), worldMatrix).xyz, input.tangent.w);
+
+    return output;
+}
@@ -0,0 +1,247 @@
+#include "TextureCache.h"
+#include "BakedTexture.h"
+
+#include <Windows.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+
+TextureCache::~TextureCache()
+{
+	Clear();
+}
+
+std::string TextureCache::NormalizePath(const std::string& path)
+{
+	std::string normalized = path;
+	std::replace(normalized.begin(), normalized.end(), '\\', '/');
+	normalized = std::filesystem::path(normalized).lexically_normal().generic_string();
+
+	// Windows paths are case-insensitive, "Crate_1.JPG" is the same file as "crate_1.jpg"
+	std::transform(normalized.begin(), normalized.end(), normalized.begin(),
+		[](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+	return normalized;
+}
+
+std::shared_ptr<const ImageData> TextureCache::Decode(const std::string& path, MipContent content)
+{
+	const std::string key = NormalizePath(path);
+
+	std::promise<std::shared_ptr<const ImageData>> promise;
+	std::shared_future<std::shared_ptr<const ImageData>> result;
+	bool isDecoder = false;
+	MipFilter filter;
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		if (textures.find(key) != textures.end())
+			return nullptr;
+
+		filter = mipFilter;
+
+		auto pending = pendingDecodes.find(key);
+		if (pending != pendingDecodes.end())
+		{
+			result = pending->second;
+			nrOfSharedDecodes++;
+		}
+		else
+		{
+			result = promise.get_future().share();
+			pendingDecodes.emplace(key, result);
+			nrOfDecodes++;
+			isDecoder = true;
+		}
+	}
+
+	if (isDecoder)
+	{
+		// Failures are stored too, so a missing file is only tried once
+		auto image = std::make_shared<ImageData>();
+		if (!ImportTexture(path, content, filter, *image))
+		{
+			image.reset();
+		}
+		promise.set_value(image);
+	}
+
+	return result.get();
+}
+
+ID3D11ShaderResourceView* TextureCache::Acquire(ID3D11Device* device, const std::string& path, MipContent content,
+	const ImageData* decoded)
+{
+	const std::string key = NormalizePath(path);
+
+	std::shared_future<std::shared_ptr<const ImageData>> pending;
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		auto cached = textures.find(key);
+		if (cached != textures.end())
+		{
+			Entry& entry = cached->second;
+			entry.srv->AddRef();
+			entry.nrOfAcquires++;
+			bytesSaved += entry.sizeInBytes;
+			return entry.srv;
+		}
+
+		auto decoding = pendingDecodes.find(key);
+		if (decoding != pendingDecodes.end())
+		{
+			pending = decoding->second;
+		}
+	}
+
+	std::shared_ptr<const ImageData> image;
+	if (!decoded)
+	{
+		image = pending.valid() ? pending.get() : Decode(path, content);
+		decoded = image.get();
+	}
+	if (!decoded)
+		return nullptr;
+
+	ID3D11ShaderResourceView* srv = TextureLoader::CreateTextureFromImage(device, *decoded);
+	if (!srv)
+		return nullptr;
+
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+
+		Entry entry;
+		entry.srv = srv;
+		entry.sizeInBytes = decoded->pixels.size();
+		entry.nrOfAcquires = 1;
+		textures.emplace(key, entry);
+
+		// The pixels are on the GPU now, later requests hit the texture map instead
+		pendingDecodes.erase(key);
+	}
+
+	// One reference stays with the cache, one goes to the caller
+	srv->AddRef();
+	return srv;
+}
+
+ID3D11ShaderResourceView* TextureCache::AcquireFallback(ID3D11Device* device)
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	if (!fallback.srv)
+	{
+		fallback.srv = TextureLoader::CreateWhiteTexture(device);
+		if (!fallback.srv)
+			return nullptr;
+
+		fallback.sizeInBytes = 4;
+	}
+	else
+	{
+		bytesSaved += fallback.sizeInBytes;
+	}
+
+	fallback.nrOfAcquires++;
+	fallback.srv->AddRef();
+	return fallback.srv;
+}
+
+void TextureCache::SetMipFilter(MipFilter filter)
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	mipFilter = filter;
+}
+
+size_t TextureCache::GetReferenceCount(const std::string& path) const
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	auto cached = textures.find(NormalizePath(path));
+	if (cached == textures.end())
+		return 0;
+
+	// COM only reports the count from AddRef/Release; discount the cache's own reference
+	ID3D11ShaderResourceView* srv = cached->second.srv;
+	srv->AddRef();
+	return srv->Release() - 1;
+}
+
+size_t TextureCache::GetSizeInBytes(const ID3D11ShaderResourceView* srv) const
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	if (srv == fallback.srv)
+		return fallback.sizeInBytes;
+
+	for (const auto& pair : textures)
+	{
+		if (pair.second.srv == srv)
+			return pair.second.sizeInBytes;
+	}
+	return 0;
+}
+
+void TextureCache::ReleaseUnreferenced()
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	for (auto it = textures.begin(); it != textures.end();)
+	{
+		ID3D11ShaderResourceView* srv = it->second.srv;
+		srv->AddRef();
+		if (srv->Release() == 1)
+		{
+			srv->Release();
+			it = textures.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+	pendingDecodes.clear();
+}
+
+void TextureCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	for (auto& pair : textures)
+	{
+		pair.second.srv->Release();
+	}
+	textures.clear();
+	pendingDecodes.clear();
+
+	if (fallback.srv)
+	{
+		fallback.srv->Release();
+		fallback = Entry();
+	}
+}
+
+void TextureCache::ReportStatistics() const
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+
+	size_t residentBytes = fallback.sizeInBytes;
+	size_t nrOfReuses = fallback.nrOfAcquires > 0 ? fallback.nrOfAcquires - 1 : 0;
+	for (const auto& pair : textures)
+	{
+		residentBytes += pair.second.sizeInBytes;
+		nrOfReuses += pair.second.nrOfAcquires - 1;
+	}
+
+	char buffer[256];
+	std::snprintf(buffer, sizeof(buffer),
+		"Texture cache: %zu textures (%.1f KB), %zu decodes, %zu shared decodes, %zu reuses, %.1f KB saved\n",
+		textures.size(), residentBytes / 1024.0, nrOfDecodes, nrOfSharedDecodes, nrOfReuses, bytesSaved / 1024.0);
+	OutputDebugStringA(buffer);
+}
+
+size_t TextureCache::GetBytesSaved() const
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	return bytesSaved;
+}
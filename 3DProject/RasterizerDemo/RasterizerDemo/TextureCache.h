@@ -0,0 +1,81 @@
+#pragma once
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <d3d11.h>
+
+#include "TextureLoader.h"
+#include "MipGenerator.h"
+
+// Shares textures between every mesh that references the same image file.
+// Images are decoded at most once, even when several loader threads ask for them at the
+// same time, and uploaded once. The cache owns one COM reference per texture and every
+// Acquire hands out another, so SubMeshD3D11 keeps releasing its textures as before.
+class TextureCache
+{
+private:
+	struct Entry
+	{
+		ID3D11ShaderResourceView* srv = nullptr;
+		size_t sizeInBytes = 0;
+		size_t nrOfAcquires = 0;
+	};
+
+	std::unordered_map<std::string, Entry> textures;
+	// Decodes that have started but whose result has not been uploaded yet
+	std::unordered_map<std::string, std::shared_future<std::shared_ptr<const ImageData>>> pendingDecodes;
+	Entry fallback;
+
+	MipFilter mipFilter = MipFilter::Lanczos;
+
+	size_t nrOfDecodes = 0;
+	size_t nrOfSharedDecodes = 0;
+	size_t bytesSaved = 0;
+
+	mutable std::mutex cacheMutex;
+
+public:
+	TextureCache() = default;
+	~TextureCache();
+	TextureCache(const TextureCache& other) = delete;
+	TextureCache& operator=(const TextureCache& other) = delete;
+	TextureCache(TextureCache&& other) = delete;
+	TextureCache& operator=(TextureCache&& other) = delete;
+
+	// Lowercase, forward slashes, "." and ".." resolved: "objects/../textures/Crate_1.jpg" -> "textures/crate_1.jpg"
+	static std::string NormalizePath(const std::string& path);
+
+	// Any thread. Loads the baked, block-compressed image (decoding, building the mip chain and
+	// baking it the first time) unless it is already uploaded
+	// (returns nullptr) or being decoded by another thread (waits for and shares that result).
+	// nullptr also on failure.
+	std::shared_ptr<const ImageData> Decode(const std::string& path, MipContent content);
+
+	// Device thread. Returns the texture for path with a reference the caller must Release,
+	// uploading decoded (or decoding now) the first time. nullptr if the image cannot be loaded.
+	ID3D11ShaderResourceView* Acquire(ID3D11Device* device, const std::string& path, MipContent content,
+		const ImageData* decoded = nullptr);
+
+	// Device thread. The shared 1x1 white texture, with a reference the caller must Release.
+	ID3D11ShaderResourceView* AcquireFallback(ID3D11Device* device);
+
+	// Filter used for mip chains decoded from now on
+	void SetMipFilter(MipFilter filter);
+
+	// References held outside the cache, 0 if path is not cached
+	size_t GetReferenceCount(const std::string& path) const;
+	// GPU memory of a texture handed out by Acquire or AcquireFallback, 0 if it is no longer cached
+	size_t GetSizeInBytes(const ID3D11ShaderResourceView* srv) const;
+
+	// Drop textures no mesh references anymore
+	void ReleaseUnreferenced();
+	void Clear();
+
+	// Writes texture count, shared decodes and bytes saved by sharing to the debug output
+	void ReportStatistics() const;
+	size_t GetBytesSaved() const;
+};
@@ -1,4 +1,5 @@
 #include "TextureLoader.h"
+#include "MipGenerator.h"
 #include <Windows.h>
 
 extern "C" {
@@ -6,7 +7,7 @@ extern "C" {
     void stbi_image_free(void* retval_from_stbi_load);
 }
 
-ID3D11ShaderResourceView* TextureLoader::LoadTexture(ID3D11Device* device, const std::string& filename)
+bool TextureLoader::DecodeImage(const std::string& filename, ImageData& image)
 {
     int width, height, channels;
     unsigned char* imageData = stbi_load(filename.c_str(), &width, &height, &channels, 4);
@@ -15,31 +16,47 @@ ID3D11ShaderResourceView* TextureLoader::LoadTexture(ID3D11Device* device, const
     {
         std::string msg = "Failed to load texture: " + filename + "\n";
         OutputDebugStringA(msg.c_str());
-        return nullptr;
+        return false;
     }
 
+    image.width = width;
+    image.height = height;
+    image.mipLevels = 1;
+    image.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    image.pixels.assign(imageData, imageData + static_cast<size_t>(width) * height * 4);
+    stbi_image_free(imageData);
+
+    return true;
+}
+
+ID3D11ShaderResourceView* TextureLoader::CreateTextureFromImage(ID3D11Device* device, const ImageData& image)
+{
+    if (!image.IsValid())
+        return nullptr;
+
     D3D11_TEXTURE2D_DESC texDesc = {};
-    texDesc.Width = width;
-    texDesc.Height = height;
-    texDesc.MipLevels = 1;
+    texDesc.Width = image.width;
+    texDesc.Height = image.height;
+    texDesc.MipLevels = image.mipLevels;
     texDesc.ArraySize = 1;
-    texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    texDesc.Format = image.format;
     texDesc.SampleDesc.Count = 1;
     texDesc.Usage = D3D11_USAGE_DEFAULT;
     texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
 
-    D3D11_SUBRESOURCE_DATA texData = {};
-    texData.pSysMem = imageData;
-    texData.SysMemPitch = width * 4;
+    std::vector<D3D11_SUBRESOURCE_DATA> texData(image.mipLevels);
+    for (int level = 0; level < image.mipLevels; ++level)
+    {
+        texData[level].pSysMem = image.pixels.data() + image.GetLevelOffset(level);
+        texData[level].SysMemPitch = static_cast<UINT>(image.GetLevelPitch(level));
+    }
 
     ID3D11Texture2D* texture = nullptr;
-    HRESULT hr = device->CreateTexture2D(&texDesc, &texData, &texture);
-    stbi_image_free(imageData);
+    HRESULT hr = device->CreateTexture2D(&texDesc, texData.data(), &texture);
 
     if (FAILED(hr))
     {
-        std::string msg = "Failed to create texture: " + filename + "\n";
-        OutputDebugStringA(msg.c_str());
+        OutputDebugStringA("Failed to create texture\n");
         return nullptr;
     }
 
@@ -49,7 +66,25 @@ ID3D11ShaderResourceView* TextureLoader::LoadTexture(ID3D11Device* device, const
 
     if (FAILED(hr))
     {
-        std::string msg = "Failed to create SRV for texture: " + filename + "\n";
+        OutputDebugStringA("Failed to create SRV for texture\n");
+        return nullptr;
+    }
+
+    return srv;
+}
+
+ID3D11ShaderResourceView* TextureLoader::LoadTexture(ID3D11Device* device, const std::string& filename)
+{
+    ImageData image;
+    if (!DecodeImage(filename, image))
+        return nullptr;
+
+    MipGenerator::GenerateMips(image, MipContent::Color, MipFilter::Lanczos);
+
+    ID3D11ShaderResourceView* srv = CreateTextureFromImage(device, image);
+    if (!srv)
+    {
+        std::string msg = "Failed to create texture: " + filename + "\n";
         OutputDebugStringA(msg.c_str());
         return nullptr;
     }
@@ -1,11 +1,63 @@
 #pragma once
 
 #include <d3d11.h>
+#include <algorithm>
 #include <string>
+#include <vector>
+
+// Decoded pixels, produced on any thread and uploaded on the device thread.
+// RGBA8 after decoding; BC1/BC3/BC5 once compressed or loaded from a baked texture.
+struct ImageData
+{
+    int width = 0;
+    int height = 0;
+    int mipLevels = 1;
+    DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    // All mip levels back to back, level 0 first, each level half the size of the previous (at least 1)
+    std::vector<unsigned char> pixels;
+
+    bool IsValid() const { return width > 0 && height > 0 && !pixels.empty(); }
+    bool IsBlockCompressed() const { return format != DXGI_FORMAT_R8G8B8A8_UNORM; }
+
+    int GetLevelWidth(int level) const { return (std::max)(1, width >> level); }
+    int GetLevelHeight(int level) const { return (std::max)(1, height >> level); }
+
+    // Bytes per row of texels, or per row of 4x4 blocks for the BC formats
+    size_t GetLevelPitch(int level) const
+    {
+        if (!IsBlockCompressed())
+            return static_cast<size_t>(GetLevelWidth(level)) * 4;
+
+        const size_t blockSize = format == DXGI_FORMAT_BC1_UNORM ? 8 : 16;
+        return static_cast<size_t>((GetLevelWidth(level) + 3) / 4) * blockSize;
+    }
+
+    size_t GetLevelSize(int level) const
+    {
+        const int rows = IsBlockCompressed() ? (GetLevelHeight(level) + 3) / 4 : GetLevelHeight(level);
+        return GetLevelPitch(level) * rows;
+    }
+
+    size_t GetLevelOffset(int level) const
+    {
+        size_t offset = 0;
+        for (int i = 0; i < level; ++i)
+        {
+            offset += GetLevelSize(i);
+        }
+        return offset;
+    }
+};
 
 class TextureLoader
 {
 public:
+    // Decode an image file to RGBA8 without touching the device, returns false on failure
+    static bool DecodeImage(const std::string& filename, ImageData& image);
+
+    // Create a texture and SRV from decoded pixels, uploading every mip level the image holds
+    static ID3D11ShaderResourceView* CreateTextureFromImage(ID3D11Device* device, const ImageData& image);
+
     // Load a texture from file and create an SRV
     static ID3D11ShaderResourceView* LoadTexture(ID3D11Device* device, const std::string& filename);
     
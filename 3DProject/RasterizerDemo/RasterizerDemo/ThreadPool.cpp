@@ -0,0 +1,57 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int nrOfThreads)
+{
+	if (nrOfThreads == 0)
+	{
+		nrOfThreads = (std::max)(1u, std::thread::hardware_concurrency());
+	}
+
+	workers.reserve(nrOfThreads);
+	for (unsigned int i = 0; i < nrOfThreads; ++i)
+	{
+		workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		stopping = true;
+	}
+	taskAvailable.notify_all();
+
+	// Workers drain the queue before exiting, so no future is left without a result
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			taskAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+
+			if (tasks.empty())
+				return;
+
+			task = std::move(tasks.front());
+			tasks.pop();
+		}
+
+		task();
+	}
+}
+
+size_t ThreadPool::GetNrOfThreads() const
+{
+	return workers.size();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads pulling tasks from a shared queue.
+// Submit returns a future, exceptions thrown by a task are rethrown from future::get.
+class ThreadPool
+{
+private:
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()>> tasks;
+	std::mutex queueMutex;
+	std::condition_variable taskAvailable;
+	bool stopping = false;
+
+	void WorkerLoop();
+
+public:
+	// 0 uses one thread per hardware thread
+	explicit ThreadPool(unsigned int nrOfThreads = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool& other) = delete;
+	ThreadPool& operator=(const ThreadPool& other) = delete;
+	ThreadPool(ThreadPool&& other) = delete;
+	ThreadPool& operator=(ThreadPool&& other) = delete;
+
+	template<typename Func>
+	std::future<std::invoke_result_t<Func>> Submit(Func&& func);
+
+	size_t GetNrOfThreads() const;
+};
+
+template<typename Func>
+std::future<std::invoke_result_t<Func>> ThreadPool::Submit(Func&& func)
+{
+	using Result = std::invoke_result_t<Func>;
+
+	// packaged_task is move-only, std::function needs a copyable callable
+	auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+	std::future<Result> result = task->get_future();
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		tasks.emplace([task]() { (*task)(); });
+	}
+	taskAvailable.notify_one();
+
+	return result;
+}
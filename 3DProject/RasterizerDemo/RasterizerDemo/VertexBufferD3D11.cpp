@@ -1,6 +1,6 @@
 #include "VertexBufferD3D11.h"
 
-VertexBufferD3D11::VertexBufferD3D11(ID3D11Device* device, UINT sizeOfVertex, UINT nrOfVerticesInBuffer, void* vertexData)
+VertexBufferD3D11::VertexBufferD3D11(ID3D11Device* device, UINT sizeOfVertex, UINT nrOfVerticesInBuffer, const void* vertexData)
 {
 	Initialize(device, sizeOfVertex, nrOfVerticesInBuffer, vertexData);
 
@@ -16,7 +16,7 @@ VertexBufferD3D11::~VertexBufferD3D11()
 
 }
 
-void VertexBufferD3D11::Initialize(ID3D11Device* device, UINT sizeOfVertex, UINT nrOfVerticesInBuffer, void* vertexData)
+void VertexBufferD3D11::Initialize(ID3D11Device* device, UINT sizeOfVertex, UINT nrOfVerticesInBuffer, const void* vertexData)
 {
 	if (buffer)
 	{
@@ -12,7 +12,7 @@ private:
 public:
 	VertexBufferD3D11() = default;
 	VertexBufferD3D11(ID3D11Device* device, UINT sizeOfVertex, 
-		UINT nrOfVerticesInBuffer, void* vertexData);
+		UINT nrOfVerticesInBuffer, const void* vertexData);
 	~VertexBufferD3D11();
 	VertexBufferD3D11(const VertexBufferD3D11& other) = delete;
 	VertexBufferD3D11& operator=(const VertexBufferD3D11& other) = delete;
@@ -20,7 +20,7 @@ public:
 	VertexBufferD3D11& operator=(VertexBufferD3D11&& other) = delete;
 
 	void Initialize(ID3D11Device* device, UINT sizeOfVertex,
-		UINT nrOfVerticesInBuffer, void* vertexData);
+		UINT nrOfVerticesInBuffer, const void* vertexData);
 
 	UINT GetNrOfVertices() const;
 	UINT GetVertexSize() const;
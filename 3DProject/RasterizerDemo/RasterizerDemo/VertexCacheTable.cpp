@@ -0,0 +1,109 @@
+#include "VertexCacheTable.h"
+
+#include <bit>
+
+namespace
+{
+	// Keep the table at most half full so probe sequences stay short
+	constexpr size_t MIN_CAPACITY = 64;
+
+	size_t CapacityFor(size_t expectedEntries)
+	{
+		size_t wanted = expectedEntries * 2;
+		return std::bit_ceil(wanted < MIN_CAPACITY ? MIN_CAPACITY : wanted);
+	}
+}
+
+size_t VertexCacheTable::Hash(uint32_t v, uint32_t t, uint32_t n)
+{
+	// Pack the triple into 64 bits and mix it (murmur3 finalizer)
+	uint64_t key = (static_cast<uint64_t>(v) << 32 | t) ^ (static_cast<uint64_t>(n) * 0x9E3779B97F4A7C15ull);
+	key ^= key >> 33;
+	key *= 0xFF51AFD7ED558CCDull;
+	key ^= key >> 33;
+	key *= 0xC4CEB9FE1A85EC53ull;
+	key ^= key >> 33;
+	return static_cast<size_t>(key);
+}
+
+void VertexCacheTable::Rehash(size_t newCapacity)
+{
+	std::vector<Entry> oldEntries;
+	oldEntries.swap(entries);
+
+	entries.assign(newCapacity, Entry{ 0, 0, 0, EMPTY_SLOT });
+	mask = newCapacity - 1;
+
+	for (const Entry& entry : oldEntries)
+	{
+		if (entry.index == EMPTY_SLOT)
+			continue;
+
+		size_t slot = Hash(entry.v, entry.t, entry.n) & mask;
+		while (entries[slot].index != EMPTY_SLOT)
+		{
+			slot = (slot + 1) & mask;
+		}
+		entries[slot] = entry;
+	}
+}
+
+void VertexCacheTable::Reserve(size_t expectedEntries)
+{
+	size_t capacity = CapacityFor(expectedEntries);
+	if (capacity > entries.size())
+	{
+		Rehash(capacity);
+	}
+}
+
+void VertexCacheTable::Clear()
+{
+	for (Entry& entry : entries)
+	{
+		entry.index = EMPTY_SLOT;
+	}
+	nrOfEntries = 0;
+}
+
+uint32_t VertexCacheTable::FindOrInsert(uint32_t v, uint32_t t, uint32_t n, uint32_t newIndex, bool& inserted)
+{
+	if ((nrOfEntries + 1) * 2 > entries.size())
+	{
+		Rehash(entries.empty() ? MIN_CAPACITY : entries.size() * 2);
+	}
+
+	size_t slot = Hash(v, t, n) & mask;
+	while (true)
+	{
+		Entry& entry = entries[slot];
+		if (entry.index == EMPTY_SLOT)
+		{
+			entry = Entry{ v, t, n, newIndex };
+			nrOfEntries++;
+			inserted = true;
+			return newIndex;
+		}
+		if (entry.v == v && entry.t == t && entry.n == n)
+		{
+			inserted = false;
+			return entry.index;
+		}
+		slot = (slot + 1) & mask;
+	}
+}
+
+size_t VertexCacheTable::GetSize() const
+{
+	return nrOfEntries;
+}
+
+size_t VertexCacheTable::GetCapacity() const
+{
+	return entries.size();
+}
+
+size_t VertexCacheTable::GetMemoryUsage() const
+{
+	return entries.capacity() * sizeof(Entry);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Open-addressing hash table mapping an OBJ (v, t, n) index triple to a vertex index.
+// Keys are stored inline and probed linearly, so a lookup touches one or two cache lines
+// and never allocates once the table has been reserved.
+class VertexCacheTable
+{
+private:
+	struct Entry
+	{
+		uint32_t v;
+		uint32_t t;
+		uint32_t n;
+		uint32_t index;
+	};
+
+	static constexpr uint32_t EMPTY_SLOT = 0xFFFFFFFFu;
+
+	std::vector<Entry> entries;
+	size_t mask = 0;
+	size_t nrOfEntries = 0;
+
+	static size_t Hash(uint32_t v, uint32_t t, uint32_t n);
+	void Rehash(size_t newCapacity);
+
+public:
+	VertexCacheTable() = default;
+	~VertexCacheTable() = default;
+	VertexCacheTable(const VertexCacheTable& other) = default;
+	VertexCacheTable& operator=(const VertexCacheTable& other) = default;
+	VertexCacheTable(VertexCacheTable&& other) noexcept = default;
+	VertexCacheTable& operator=(VertexCacheTable&& other) noexcept = default;
+
+	// Size the table so that expectedEntries can be inserted without rehashing
+	void Reserve(size_t expectedEntries);
+	void Clear();
+
+	// Returns the index stored for the triple, or stores and returns newIndex if the triple is new
+	uint32_t FindOrInsert(uint32_t v, uint32_t t, uint32_t n, uint32_t newIndex, bool& inserted);
+
+	size_t GetSize() const;
+	size_t GetCapacity() const;
+	// Bytes held by the slots, which Clear keeps for reuse
+	size_t GetMemoryUsage() const;
+};
